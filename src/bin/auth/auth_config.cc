@@ -137,6 +137,51 @@ private:
     size_t timeout_;
 };
 
+/// \brief Configuration for the number of query worker threads
+class QueryWorkersConfig : public AuthConfigParser {
+public:
+    QueryWorkersConfig(AuthSrv& server) : server_(server), count_(0)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        if (config->intValue() >= 0) {
+            count_ = config->intValue();
+        } else {
+            bundy_throw(AuthConfigError, "query_workers must be 0 or higher");
+        }
+    }
+
+    virtual void commit() {
+        server_.setQueryWorkerCount(count_);
+    }
+private:
+    AuthSrv& server_;
+    size_t count_;
+};
+
+/// \brief Configuration for the size of the response cache
+class ResponseCacheConfig : public AuthConfigParser {
+public:
+    ResponseCacheConfig(AuthSrv& server) : server_(server), size_(0)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        if (config->intValue() >= 0) {
+            size_ = config->intValue();
+        } else {
+            bundy_throw(AuthConfigError,
+                        "response_cache_size must be 0 or higher");
+        }
+    }
+
+    virtual void commit() {
+        server_.setResponseCacheSize(size_);
+    }
+private:
+    AuthSrv& server_;
+    size_t size_;
+};
+
 } // end of unnamed namespace
 
 AuthConfigParser*
@@ -170,6 +215,10 @@ createAuthConfigParser(AuthSrv& server, const std::string& config_id) {
         return (new VersionConfig());
     } else if (config_id == "tcp_recv_timeout") {
         return (new TCPRecvTimeoutConfig(server));
+    } else if (config_id == "query_workers") {
+        return (new QueryWorkersConfig(server));
+    } else if (config_id == "response_cache_size") {
+        return (new ResponseCacheConfig(server));
     } else {
         bundy_throw(AuthConfigError, "Unknown configuration identifier: " <<
                   config_id);
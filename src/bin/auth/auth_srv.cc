@@ -54,10 +54,16 @@
 #include <auth/statistics.h>
 #include <auth/auth_log.h>
 #include <auth/datasrc_clients_mgr.h>
+#include <auth/query_workers.h>
+#include <auth/response_cache.h>
+
+#include <util/threads/sync.h>
 
 #include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <algorithm>
 #include <cassert>
@@ -86,6 +92,7 @@ using namespace bundy::asiodns;
 using namespace bundy::server_common::portconfig;
 using bundy::auth::statistics::Counters;
 using bundy::auth::statistics::MessageAttributes;
+using bundy::util::thread::Mutex;
 
 namespace {
 // A helper class for cleaning up message renderer.
@@ -233,6 +240,63 @@ private:
 };
 }
 
+namespace {
+// Whether responses to queries answered from the given client list can be
+// stored in the response cache.  It's only safe if all data sources are
+// served from the in-memory cache, whose updates are reflected in the data
+// generation of the client lists manager; other data sources can be
+// updated without notifying us.
+bool
+isCacheable(const ConfigurableClientList& list) {
+    BOOST_FOREACH(const ConfigurableClientList::DataSourceInfo& info,
+                  list.getDataSources()) {
+        if (!info.cache_) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+// For a response found in the response cache, set the parameters used
+// for statistics that are normally derived from the response Message (or
+// the rendering process).  They are retrieved from the header of the cached
+// response.
+void
+setCachedResponseAttributes(const OutputBuffer& buffer, Message& message,
+                            MessageAttributes& stats_attrs)
+{
+    InputBuffer header(buffer.getData(), buffer.getLength());
+    header.setPosition(sizeof(uint16_t)); // skip the ID
+    const uint16_t codes_and_flags = header.readUint16();
+    header.setPosition(header.getPosition() + sizeof(uint16_t)); // QDCOUNT
+    const uint16_t ancount = header.readUint16();
+
+    message.setRcode(Rcode(codes_and_flags & 0x000f));
+    message.setHeaderFlag(Message::HEADERFLAG_AA,
+                          (codes_and_flags & Message::HEADERFLAG_AA) != 0);
+    stats_attrs.setResponseTruncated(
+        (codes_and_flags & Message::HEADERFLAG_TC) != 0);
+    stats_attrs.setResponseAnswerCount(ancount);
+}
+}
+
+// Per-thread resources used in processing DNS messages.  The main thread
+// and each query worker thread have their own object so that they can
+// render responses without locking.  The counters are read by the main
+// thread when statistics are collected, so they are protected by a mutex,
+// which is contended only then.
+class AuthSrv::QueryContext : boost::noncopyable {
+public:
+    MessageRenderer renderer_;
+    auth::Query query_;
+    /// Query counters for statistics
+    Counters counters_;
+    /// Protects counters_
+    Mutex counters_mutex_;
+    /// Cache of rendered responses
+    auth::ResponseCache response_cache_;
+};
+
 class AuthSrvImpl {
 private:
     // prohibit copy
@@ -247,20 +311,32 @@ public:
                             ConstEDNSPtr remote_edns, Message& message,
                             OutputBuffer& buffer,
                             auto_ptr<TSIGContext> tsig_context,
-                            MessageAttributes& stats_attrs);
+                            MessageAttributes& stats_attrs,
+                            AuthSrv::QueryContext& context);
     bool processXfrQuery(const IOMessage& io_message, Message& message,
                          OutputBuffer& buffer,
                          auto_ptr<TSIGContext> tsig_context,
-                         MessageAttributes& stats_attrs);
+                         MessageAttributes& stats_attrs,
+                         AuthSrv::QueryContext& context);
     bool processNotify(const IOMessage& io_message, Message& message,
                        OutputBuffer& buffer,
                        auto_ptr<TSIGContext> tsig_context,
-                       MessageAttributes& stats_attrs);
+                       MessageAttributes& stats_attrs,
+                       AuthSrv::QueryContext& context);
     bool processUpdate(const IOMessage& io_message);
 
     IOService io_service_;
 
-    MessageRenderer renderer_;
+    /// Resources for processing messages in the main thread
+    AuthSrv::QueryContext main_context_;
+
+    /// Resources and lookup callbacks for query worker threads, indexed
+    /// by the worker ID.  They are created on demand and kept until the
+    /// server is destroyed, so the counters are preserved even if the
+    /// workers are restarted.
+    std::vector<boost::shared_ptr<AuthSrv::QueryContext> > worker_contexts_;
+    std::vector<boost::shared_ptr<DNSLookup> > worker_lookups_;
+
     /// Currently non-configurable, but will be.
     static const uint16_t DEFAULT_LOCAL_UDPSIZE = 4096;
 
@@ -268,15 +344,35 @@ public:
     ModuleCCSession* config_session_;
     AbstractSession* xfrin_session_;
 
-    /// Query counters for statistics
-    Counters counters_;
+    /// Protects xfrin_session_, which can be used by the query worker
+    /// threads and the main thread for forwarding NOTIFY.
+    Mutex xfrin_session_mutex_;
 
     /// Addresses we listen on
     AddressList listen_addresses_;
 
+    /// The number of entries of the response cache of each context
+    size_t response_cache_size_;
+
     /// The TSIG keyring
     const boost::shared_ptr<TSIGKeyRing>* keyring_;
 
+    /// The mutex held while the keyring is replaced (can be NULL)
+    Mutex* keyring_mutex_;
+
+    /// \brief Return a reference to the current TSIG keyring.
+    ///
+    /// The keyring can be replaced by the thread receiving configuration
+    /// updates at any time, so the query processing threads use their own
+    /// reference to it.
+    boost::shared_ptr<TSIGKeyRing> getTSIGKeyRing() const {
+        if (keyring_mutex_ == NULL) {
+            return (*keyring_);
+        }
+        Mutex::Locker locker(*keyring_mutex_);
+        return (*keyring_);
+    }
+
     /// The data source client list manager
     auth::DataSrcClientsMgr datasrc_clients_mgr_;
 
@@ -288,6 +384,15 @@ public:
     /// bundy-ddns is not running
     boost::scoped_ptr<SocketSessionForwarderHolder> ddns_forwarder_;
 
+    /// Protects ddns_forwarder_, which is (re)created in the main thread
+    /// but can be used by the query worker threads.
+    Mutex ddns_forwarder_mutex_;
+
+    /// The DNS service that distributes UDP servers over query worker
+    /// threads (if configured).  It's declared after the per-thread
+    /// resources so the workers are stopped before those are destroyed.
+    boost::scoped_ptr<QueryWorkers> query_workers_;
+
     /// \brief Resume the server
     ///
     /// This is a wrapper call for DNSServer::resume(done). Query/Response
@@ -301,9 +406,11 @@ public:
     ///                    with statistics
     /// \param done If true, it indicates there is a response.
     ///             this value will be passed to server->resume(bool)
+    /// \param context The per-thread resources used for the message
     void resumeServer(bundy::asiodns::DNSServer* server,
                       bundy::dns::Message& message,
                       MessageAttributes& stats_attrs,
+                      AuthSrv::QueryContext& context,
                       const bool done);
 
     /// Are we currently subscribed to the SegmentReader group?
@@ -312,15 +419,15 @@ private:
     bool xfrout_connected_;
     AbstractXfroutClient& xfrout_client_;
 
-    auth::Query query_;
 };
 
 AuthSrvImpl::AuthSrvImpl(AbstractXfroutClient& xfrout_client,
                          BaseSocketSessionForwarder& ddns_forwarder) :
     config_session_(NULL),
     xfrin_session_(NULL),
-    counters_(),
+    response_cache_size_(0),
     keyring_(NULL),
+    keyring_mutex_(NULL),
     datasrc_clients_mgr_(io_service_),
     ddns_base_forwarder_(ddns_forwarder),
     ddns_forwarder_(NULL),
@@ -339,9 +446,14 @@ AuthSrvImpl::~AuthSrvImpl() {
 // This is a derived class of \c DNSLookup, to serve as a
 // callback in the asiolink module.  It calls
 // AuthSrv::processMessage() on a single DNS message.
+//
+// Each object is associated with a set of per-thread resources, so
+// different objects can be used in different threads concurrently.
 class MessageLookup : public DNSLookup {
 public:
-    MessageLookup(AuthSrv* srv) : server_(srv) {}
+    MessageLookup(AuthSrv* srv, AuthSrv::QueryContext* context) :
+        server_(srv), context_(context)
+    {}
     virtual void operator()(const IOMessage& io_message,
                             MessagePtr message,
                             MessagePtr, // Not used here
@@ -353,10 +465,12 @@ public:
         // This is not done in processMessage itself (which would be
         // equivalent), to allow tests to inspect the message handling.
         MessageHolder message_holder(*message);
-        server_->processMessage(io_message, *message, *buffer, server);
+        server_->processMessage(io_message, *message, *buffer, server,
+                                *context_);
     }
 private:
     AuthSrv* server_;
+    AuthSrv::QueryContext* context_;
 };
 
 // This is a derived class of \c DNSAnswer, to serve as a callback in the
@@ -380,7 +494,7 @@ AuthSrv::AuthSrv(bundy::xfr::AbstractXfroutClient& xfrout_client,
     dnss_(NULL)
 {
     impl_ = new AuthSrvImpl(xfrout_client, ddns_forwarder);
-    dns_lookup_ = new MessageLookup(this);
+    dns_lookup_ = new MessageLookup(this, &impl_->main_context_);
     dns_answer_ = new MessageAnswer(this);
 }
 
@@ -475,9 +589,30 @@ AuthSrv::getConfigSession() const {
     return (impl_->config_session_);
 }
 
+DNSLookup*
+AuthSrv::getWorkerLookupProvider(size_t worker_id) {
+    while (impl_->worker_lookups_.size() <= worker_id) {
+        boost::shared_ptr<QueryContext> context(new QueryContext);
+        context->response_cache_.setSize(impl_->response_cache_size_);
+        boost::shared_ptr<DNSLookup> lookup(new MessageLookup(this,
+                                                              context.get()));
+        impl_->worker_contexts_.push_back(context);
+        impl_->worker_lookups_.push_back(lookup);
+    }
+    return (impl_->worker_lookups_[worker_id].get());
+}
+
 void
 AuthSrv::processMessage(const IOMessage& io_message, Message& message,
                         OutputBuffer& buffer, DNSServer* server)
+{
+    processMessage(io_message, message, buffer, server, impl_->main_context_);
+}
+
+void
+AuthSrv::processMessage(const IOMessage& io_message, Message& message,
+                        OutputBuffer& buffer, DNSServer* server,
+                        QueryContext& context)
 {
     InputBuffer request_buffer(io_message.getData(), io_message.getDataSize());
     MessageAttributes stats_attrs;
@@ -495,13 +630,13 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
         // Ignore all responses.
         if (message.getHeaderFlag(Message::HEADERFLAG_QR)) {
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_RECEIVED);
-            impl_->resumeServer(server, message, stats_attrs, false);
+            impl_->resumeServer(server, message, stats_attrs, context, false);
             return;
         }
     } catch (const bundy::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_HEADER_PARSE_FAIL)
                   .arg(ex.what());
-        impl_->resumeServer(server, message, stats_attrs, false);
+        impl_->resumeServer(server, message, stats_attrs, context, false);
         return;
     }
 
@@ -518,16 +653,16 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
     } catch (const DNSProtocolError& error) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PROTOCOL_FAILURE)
                   .arg(error.getRcode().toText()).arg(error.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, error.getRcode(),
+        makeErrorMessage(context.renderer_, message, buffer, error.getRcode(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        impl_->resumeServer(server, message, stats_attrs, context, true);
         return;
     } catch (const bundy::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PARSE_FAILED)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        impl_->resumeServer(server, message, stats_attrs, context, true);
         return;
     } // other exceptions will be handled at a higher layer.
 
@@ -544,19 +679,22 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
     // Do we do TSIG?
     // The keyring can be null if we're in test
     if (impl_->keyring_ != NULL && tsig_record != NULL) {
+        // The context copies the key, so the keyring is needed only while
+        // the context is constructed.
+        const boost::shared_ptr<TSIGKeyRing> keyring(impl_->getTSIGKeyRing());
         tsig_context.reset(new TSIGContext(tsig_record->getName(),
                                            tsig_record->getRdata().
                                                 getAlgorithm(),
-                                           **impl_->keyring_));
+                                           *keyring));
         tsig_error = tsig_context->verify(tsig_record, io_message.getData(),
                                           io_message.getDataSize());
         stats_attrs.setRequestTSIG(true, tsig_error != TSIGError::NOERROR());
     }
 
     if (tsig_error != TSIGError::NOERROR()) {
-        makeErrorMessage(impl_->renderer_, message, buffer,
+        makeErrorMessage(context.renderer_, message, buffer,
                          tsig_error.toRcode(), stats_attrs, tsig_context);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        impl_->resumeServer(server, message, stats_attrs, context, true);
         return;
     }
 
@@ -572,22 +710,24 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
         // note: This can only be reliable after TSIG check succeeds.
         if (opcode == Opcode::NOTIFY()) {
             send_answer = impl_->processNotify(io_message, message, buffer,
-                                               tsig_context, stats_attrs);
+                                               tsig_context, stats_attrs,
+                                               context);
         } else if (opcode == Opcode::UPDATE()) {
+            Mutex::Locker locker(impl_->ddns_forwarder_mutex_);
             if (impl_->ddns_forwarder_) {
                 send_answer = impl_->processUpdate(io_message);
             } else {
-                makeErrorMessage(impl_->renderer_, message, buffer,
+                makeErrorMessage(context.renderer_, message, buffer,
                                  Rcode::NOTIMP(), stats_attrs, tsig_context);
             }
         } else if (opcode != Opcode::QUERY()) {
             const IOEndpoint& remote_ep = io_message.getRemoteEndpoint();
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_UNSUPPORTED_OPCODE)
                 .arg(message.getOpcode().toText()).arg(remote_ep);
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(context.renderer_, message, buffer,
                              Rcode::NOTIMP(), stats_attrs, tsig_context);
         } else if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(context.renderer_, message, buffer,
                              Rcode::FORMERR(), stats_attrs, tsig_context);
         } else {
             ConstQuestionPtr question = *message.beginQuestion();
@@ -595,29 +735,31 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
             if (qtype == RRType::AXFR()) {
                 send_answer = impl_->processXfrQuery(io_message, message,
                                                      buffer, tsig_context,
-                                                     stats_attrs);
+                                                     stats_attrs, context);
             } else if (qtype == RRType::IXFR()) {
                 send_answer = impl_->processXfrQuery(io_message, message,
                                                      buffer, tsig_context,
-                                                     stats_attrs);
+                                                     stats_attrs, context);
             } else {
                 send_answer = impl_->processNormalQuery(io_message, edns,
                                                         message, buffer,
                                                         tsig_context,
-                                                        stats_attrs);
+                                                        stats_attrs,
+                                                        context);
             }
         }
     } catch (const std::exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     } catch (...) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE_UNKNOWN);
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     }
-    impl_->resumeServer(server, message, stats_attrs, send_answer);
+    impl_->resumeServer(server, message, stats_attrs, context,
+                        send_answer);
 }
 
 bool
@@ -625,7 +767,8 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
                                 ConstEDNSPtr remote_edns, Message& message,
                                 OutputBuffer& buffer,
                                 auto_ptr<TSIGContext> tsig_context,
-                                MessageAttributes& stats_attrs)
+                                MessageAttributes& stats_attrs,
+                                AuthSrv::QueryContext& context)
 {
     const bool dnssec_ok = remote_edns && remote_edns->getDNSSECAwareness();
     const uint16_t remote_bufsize = remote_edns ? remote_edns->getUDPSize() :
@@ -642,40 +785,85 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
         message.setEDNS(local_edns);
     }
 
+    const bool udp_buffer =
+        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
+    const uint16_t max_length = udp_buffer ? remote_bufsize : 65535;
+
     // Get access to data source client list through the holder and keep
     // the holder until the processing and rendering is done to avoid
     // race with any other thread(s) such as the background loader.
     auth::DataSrcClientsMgr::Holder datasrc_holder(datasrc_clients_mgr_);
 
+    // Try the response cache first.  TSIG signed responses can't be
+    // reused, so we don't use the cache for signed queries.
+    const ConstQuestionPtr question = *message.beginQuestion();
+    ResponseCache& response_cache = context.response_cache_;
+    const bool use_cache = response_cache.getSize() > 0 &&
+        tsig_context.get() == NULL;
+    const uint32_t generation = datasrc_holder.getGeneration();
+    unsigned int cache_options = 0;
+    if (use_cache) {
+        if (message.getHeaderFlag(Message::HEADERFLAG_RD)) {
+            cache_options |= ResponseCache::RECURSION_DESIRED;
+        }
+        if (message.getHeaderFlag(Message::HEADERFLAG_CD)) {
+            cache_options |= ResponseCache::CHECKING_DISABLED;
+        }
+        if (remote_edns) {
+            cache_options |= ResponseCache::EDNS;
+        }
+        if (dnssec_ok) {
+            cache_options |= ResponseCache::DNSSEC_OK;
+        }
+        if (response_cache.lookup(*question, cache_options, max_length,
+                                  generation, message.getQid(), buffer)) {
+            setCachedResponseAttributes(buffer, message, stats_attrs);
+            LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES,
+                      AUTH_SEND_CACHED_RESPONSE).arg(buffer.getLength()).
+                arg(*question);
+            return (true);
+        }
+    }
+
+    bool cacheable = false;
     try {
-        const ConstQuestionPtr question = *message.beginQuestion();
-        const boost::shared_ptr<datasrc::ClientList>
+        const boost::shared_ptr<datasrc::ConfigurableClientList>
             list(datasrc_holder.findClientList(question->getClass()));
         if (list) {
+            cacheable = use_cache && isCacheable(*list);
             const RRType& qtype = question->getType();
             const Name& qname = question->getName();
-            query_.process(*list, qname, qtype, message, dnssec_ok);
+            context.query_.process(*list, qname, qtype, message,
+                                   dnssec_ok);
         } else {
-            makeErrorMessage(renderer_, message, buffer, Rcode::REFUSED(),
+            makeErrorMessage(context.renderer_, message, buffer, Rcode::REFUSED(),
                              stats_attrs);
             return (true);
         }
     } catch (const bundy::Exception& ex) {
         LOG_ERROR(auth_logger, AUTH_PROCESS_FAIL).arg(ex.what());
-        makeErrorMessage(renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
         return (true);
     }
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    const bool udp_buffer =
-        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
-    renderer_.setLengthLimit(udp_buffer ? remote_bufsize : 65535);
-    message.toWire(renderer_, tsig_context.get());
+    MessageRenderer& renderer = context.renderer_;
+    RendererHolder holder(renderer, &buffer, stats_attrs);
+    renderer.setLengthLimit(max_length);
+    message.toWire(renderer, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
 
+    // Only positive and NXDOMAIN responses are cached; others are
+    // unusual, and may be a result of a temporary failure.
+    if (cacheable && (message.getRcode() == Rcode::NOERROR() ||
+                      message.getRcode() == Rcode::NXDOMAIN())) {
+        response_cache.insert(*question, cache_options, max_length,
+                              generation, buffer.getData(),
+                              buffer.getLength());
+    }
+
     LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_NORMAL_RESPONSE)
-              .arg(renderer_.getLength()).arg(message);
+              .arg(renderer.getLength()).arg(message);
     return (true);
     // The message can contain some data from the locked resource. But outside
     // this method, we touch only the RCode of it, so it should be safe.
@@ -688,11 +876,12 @@ bool
 AuthSrvImpl::processXfrQuery(const IOMessage& io_message, Message& message,
                              OutputBuffer& buffer,
                              auto_ptr<TSIGContext> tsig_context,
-                             MessageAttributes& stats_attrs)
+                             MessageAttributes& stats_attrs,
+                             AuthSrv::QueryContext& context)
 {
     if (io_message.getSocket().getProtocol() == IPPROTO_UDP) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_AXFR_UDP);
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -718,7 +907,7 @@ AuthSrvImpl::processXfrQuery(const IOMessage& io_message, Message& message,
 
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_AXFR_PROBLEM)
                   .arg(err.what());
-        makeErrorMessage(renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -730,7 +919,8 @@ bool
 AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
                            OutputBuffer& buffer,
                            std::auto_ptr<TSIGContext> tsig_context,
-                           MessageAttributes& stats_attrs)
+                           MessageAttributes& stats_attrs,
+                           AuthSrv::QueryContext& context)
 {
     const IOEndpoint& remote_ep = io_message.getRemoteEndpoint(); // for logs
 
@@ -739,7 +929,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_QUESTIONS)
                   .arg(message.getRRCount(Message::SECTION_QUESTION));
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -747,7 +937,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (question->getType() != RRType::SOA()) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_RRTYPE)
                   .arg(question->getType().toText());
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -769,7 +959,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (!is_auth) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RECEIVED_NOTIFY_NOTAUTH)
             .arg(question->getName()).arg(question->getClass()).arg(remote_ep);
-        makeErrorMessage(renderer_, message, buffer, Rcode::NOTAUTH(),
+        makeErrorMessage(context.renderer_, message, buffer, Rcode::NOTAUTH(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -791,6 +981,9 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     static const string command_template_end = "\"}]}";
 
     try {
+        // The session can be used by multiple threads.  Since NOTIFY is
+        // relatively rare, we simply serialize the whole exchange.
+        Mutex::Locker locker(xfrin_session_mutex_);
         ConstElementPtr notify_command = Element::fromJSON(
                 command_template_start + question->getName().toText() +
                 command_template_master + remote_ip_address +
@@ -829,8 +1022,8 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     message.setHeaderFlag(Message::HEADERFLAG_AA);
     message.setRcode(Rcode::NOERROR());
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    message.toWire(renderer_, tsig_context.get());
+    RendererHolder holder(context.renderer_, &buffer, stats_attrs);
+    message.toWire(context.renderer_, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
     return (true);
 }
@@ -848,8 +1041,12 @@ AuthSrvImpl::processUpdate(const IOMessage& io_message)
 void
 AuthSrvImpl::resumeServer(DNSServer* server, Message& message,
                           MessageAttributes& stats_attrs,
+                          AuthSrv::QueryContext& context,
                           const bool done) {
-    counters_.inc(stats_attrs, message, done);
+    {
+        Mutex::Locker locker(context.counters_mutex_);
+        context.counters_.inc(stats_attrs, message, done);
+    }
     server->resume(done);
 }
 
@@ -869,7 +1066,20 @@ AuthSrv::updateConfig(ConstElementPtr new_config) {
 }
 
 ConstElementPtr AuthSrv::getStatistics() const {
-    return (impl_->counters_.get());
+    // Combine the counters of the main thread and all workers.  Each
+    // context is locked while its counters are read, as running workers
+    // update them.
+    Counters counters;
+    {
+        Mutex::Locker locker(impl_->main_context_.counters_mutex_);
+        counters.add(impl_->main_context_.counters_);
+    }
+    BOOST_FOREACH(const boost::shared_ptr<QueryContext>& context,
+                  impl_->worker_contexts_) {
+        Mutex::Locker locker(context->counters_mutex_);
+        counters.add(context->counters_);
+    }
+    return (counters.get());
 }
 
 const AddressList&
@@ -881,23 +1091,28 @@ void
 AuthSrv::setListenAddresses(const AddressList& addresses) {
     // For UDP servers we specify the "SYNC_OK" option because in our usage
     // it can act in the synchronous mode.
-    installListenAddresses(addresses, impl_->listen_addresses_, *dnss_,
-                           DNSService::SERVER_SYNC_OK);
+    installListenAddresses(addresses, impl_->listen_addresses_,
+                           *impl_->query_workers_, DNSService::SERVER_SYNC_OK);
 }
 
 void
 AuthSrv::setDNSService(bundy::asiodns::DNSServiceBase& dnss) {
     dnss_ = &dnss;
+    impl_->query_workers_.reset(new QueryWorkers(*this, dnss));
 }
 
 void
-AuthSrv::setTSIGKeyRing(const boost::shared_ptr<TSIGKeyRing>* keyring) {
+AuthSrv::setTSIGKeyRing(const boost::shared_ptr<TSIGKeyRing>* keyring,
+                        Mutex* mutex)
+{
     impl_->keyring_ = keyring;
+    impl_->keyring_mutex_ = mutex;
 }
 
 void
 AuthSrv::createDDNSForwarder() {
     LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_START_DDNS_FORWARDER);
+    Mutex::Locker locker(impl_->ddns_forwarder_mutex_);
     impl_->ddns_forwarder_.reset(
         new SocketSessionForwarderHolder("update",
                                          impl_->ddns_base_forwarder_));
@@ -905,6 +1120,7 @@ AuthSrv::createDDNSForwarder() {
 
 void
 AuthSrv::destroyDDNSForwarder() {
+    Mutex::Locker locker(impl_->ddns_forwarder_mutex_);
     if (impl_->ddns_forwarder_) {
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_STOP_DDNS_FORWARDER);
         impl_->ddns_forwarder_.reset();
@@ -916,6 +1132,63 @@ AuthSrv::setTCPRecvTimeout(size_t timeout) {
     dnss_->setTCPRecvTimeout(timeout);
 }
 
+void
+AuthSrv::setQueryWorkerCount(size_t count) {
+    QueryWorkers& workers = *impl_->query_workers_;
+    if (count == workers.getWorkerCount()) {
+        return;
+    }
+
+    // Release all current servers (stopping the current workers), then
+    // reinstall the same addresses with the new set of workers.
+    const AddressList addresses(impl_->listen_addresses_);
+    installListenAddresses(AddressList(), impl_->listen_addresses_,
+                           workers, DNSService::SERVER_SYNC_OK);
+    workers.setWorkerCount(count);
+    LOG_INFO(auth_logger, AUTH_QUERY_WORKERS_SET).arg(count);
+    installListenAddresses(addresses, impl_->listen_addresses_,
+                           workers, DNSService::SERVER_SYNC_OK);
+}
+
+size_t
+AuthSrv::getQueryWorkerCount() const {
+    return (impl_->query_workers_ ? impl_->query_workers_->getWorkerCount() :
+            0);
+}
+
+void
+AuthSrv::setResponseCacheSize(size_t size) {
+    if (size == impl_->response_cache_size_) {
+        return;
+    }
+
+    // The caches of running workers can't be touched from this thread,
+    // so we temporarily stop the workers (if any) by releasing the servers.
+    QueryWorkers* workers = impl_->query_workers_.get();
+    const AddressList addresses(impl_->listen_addresses_);
+    const bool restart = workers != NULL && workers->getWorkerCount() > 0;
+    if (restart) {
+        installListenAddresses(AddressList(), impl_->listen_addresses_,
+                               *workers, DNSService::SERVER_SYNC_OK);
+    }
+    impl_->response_cache_size_ = size;
+    impl_->main_context_.response_cache_.setSize(size);
+    BOOST_FOREACH(const boost::shared_ptr<QueryContext>& context,
+                  impl_->worker_contexts_) {
+        context->response_cache_.setSize(size);
+    }
+    LOG_INFO(auth_logger, AUTH_RESPONSE_CACHE_SET).arg(size);
+    if (restart) {
+        installListenAddresses(addresses, impl_->listen_addresses_,
+                               *workers, DNSService::SERVER_SYNC_OK);
+    }
+}
+
+size_t
+AuthSrv::getResponseCacheSize() const {
+    return (impl_->response_cache_size_);
+}
+
 namespace {
 
 bool
@@ -111,6 +111,14 @@ public:
     ~AuthSrv();
     //@}
 
+    /// \brief Per-thread resources used in processing DNS messages.
+    ///
+    /// This is an opaque type for the users of this class.  The main
+    /// thread and each query worker thread (see \c setQueryWorkerCount())
+    /// use separate objects of this type so that they don't have to share
+    /// the message renderer, query object and statistics counters.
+    class QueryContext;
+
     /// Stop the server.
     ///
     /// It stops the internal event loop of the server and subsequently
@@ -192,6 +200,23 @@ public:
     /// \brief Return pointer to the DNS Answer callback function
     bundy::asiodns::DNSAnswer* getDNSAnswerProvider() const { return (dns_answer_); }
 
+    /// \brief Return pointer to the DNS Lookup callback for a query worker.
+    ///
+    /// The returned callback works the same way as the one returned by
+    /// \c getDNSLookupProvider(), except that it uses a separate set of
+    /// per-thread resources identified by \c worker_id.  It's intended to
+    /// be used by the DNS servers running in a query worker thread; the
+    /// callbacks for different worker IDs can be used concurrently in
+    /// different threads.
+    ///
+    /// The callback object is created on the first call for the given ID
+    /// and is owned by this \c AuthSrv object.  Subsequent calls with the
+    /// same ID return the same object.  This method must be called from
+    /// the main thread.
+    ///
+    /// \param worker_id The ID of the worker thread, starting from 0.
+    bundy::asiodns::DNSLookup* getWorkerLookupProvider(size_t worker_id);
+
     /// \brief Return data source clients manager.
     ///
     /// \throw None
@@ -240,8 +265,17 @@ public:
     /// reloading routines of tsig keys replace the actual keyring object.
     /// It is expected the pointer will point to some statically-allocated
     /// object, it doesn't take ownership of it.
+    ///
+    /// If the shared pointer can be replaced while queries are processed in
+    /// the worker threads, \c mutex must be the mutex held while replacing
+    /// it.  The workers hold it while taking their own reference to the
+    /// keyring.
+    ///
+    /// \param keyring Pointer to the shared pointer to the keyring.
+    /// \param mutex The mutex protecting the shared pointer, or NULL if it
+    /// is not replaced concurrently.
     void setTSIGKeyRing(const boost::shared_ptr<bundy::dns::TSIGKeyRing>*
-                        keyring);
+                        keyring, bundy::util::thread::Mutex* mutex = NULL);
 
     /// \brief Create the internal forwarder for DDNS update messages
     ///
@@ -272,6 +306,53 @@ public:
     /// open forever.
     void setTCPRecvTimeout(size_t timeout);
 
+    /// \brief Set the number of query worker threads.
+    ///
+    /// If \c count is non 0, UDP queries are handled in \c count separate
+    /// threads, each running its own event loop on its own copy of the
+    /// listening UDP sockets, instead of the main event loop.  TCP
+    /// connections and all other events are still handled in the main
+    /// thread.  If it's 0 (the default), everything is handled in the
+    /// main thread.
+    ///
+    /// If the count is changed, the currently installed listening
+    /// addresses are reinstalled so that the sockets are redistributed
+    /// to the new set of workers.
+    ///
+    /// \c setDNSService() must have been called before this method.
+    ///
+    /// \param count The number of query worker threads.
+    void setQueryWorkerCount(size_t count);
+
+    /// \brief Return the number of query worker threads.
+    ///
+    /// \throw None
+    size_t getQueryWorkerCount() const;
+
+    /// \brief Set the size of the response cache.
+    ///
+    /// If \c size is non 0, the main thread and each query worker thread
+    /// keep a cache of up to \c size rendered responses to normal queries
+    /// (see \c auth::ResponseCache), and subsequent queries with the same
+    /// question are answered directly from the cache as long as the data
+    /// source data haven't been changed.  Responses are cached only if all
+    /// data sources for the class of the query are served from the
+    /// in-memory cache, and TSIG-signed queries always bypass the cache.
+    /// If it's 0 (the default), the response cache is disabled.
+    ///
+    /// Any cached responses are removed when the size is changed.  If
+    /// there are query worker threads, they are restarted in the same way
+    /// as \c setQueryWorkerCount() does.
+    ///
+    /// \throw std::bad_alloc Memory allocation failure
+    /// \param size The number of entries of the response cache.
+    void setResponseCacheSize(size_t size);
+
+    /// \brief Return the size of the response cache.
+    ///
+    /// \throw None
+    size_t getResponseCacheSize() const;
+
     /// \brief Notify the authoritative server that the client lists were
     ///     reconfigured.
     ///
@@ -289,6 +370,16 @@ public:
                      const bundy::data::ConstElementPtr& params);
 
 private:
+    // The lookup callbacks call the version of processMessage() below.
+    friend class MessageLookup;
+
+    // Actual implementation of processMessage(), using the given per-thread
+    // resources.
+    void processMessage(const bundy::asiolink::IOMessage& io_message,
+                        bundy::dns::Message& message,
+                        bundy::util::OutputBuffer& buffer,
+                        bundy::asiodns::DNSServer* server,
+                        QueryContext& context);
     void reconfigureDone(bundy::data::ConstElementPtr request);
     void foreignCommand(const std::string& command, const std::string&,
                         const bundy::data::ConstElementPtr& params);
@@ -0,0 +1,522 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+// This is a benchmark of the query processing of the authoritative server,
+// from parsing a query to rendering the response, for different classes of
+// queries.  Unlike query_bench, it bypasses AuthSrv and its response cache,
+// and calls Query::process() directly on zones loaded in the in-memory data
+// source, so the result shows the cost of the lookup logic itself.
+
+#include <config.h>
+
+#include <bench/benchmark.h>
+#include <bench/benchmark_util.h>
+
+#include <exceptions/exceptions.h>
+
+#include <util/buffer.h>
+
+#include <dns/edns.h>
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+
+#include <cc/data.h>
+
+#include <datasrc/client.h>
+#include <datasrc/client_list.h>
+#include <datasrc/memory/zone_table_segment.h>
+#include <datasrc/memory/zone_writer.h>
+
+#include <log/logger_support.h>
+
+#include <auth/query.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy;
+using namespace bundy::auth;
+using namespace bundy::bench;
+using namespace bundy::data;
+using namespace bundy::datasrc;
+using namespace bundy::dns;
+using namespace bundy::util;
+
+namespace {
+// The number of calls to the global operator new while counting is enabled.
+// Data stored in a mapped memory segment doesn't go through it, but the
+// query processing shouldn't allocate there anyway.
+size_t alloc_count = 0;
+bool count_alloc = false;
+}
+
+// We replace the global operator new to count the allocations made per
+// query.  The array versions use these by default.
+void*
+operator new(size_t size) throw(std::bad_alloc) {
+    if (count_alloc) {
+        ++alloc_count;
+    }
+    void* p = malloc(size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return (p);
+}
+
+void
+operator delete(void* p) throw() {
+    free(p);
+}
+
+namespace {
+// A single query in wire format and how it is transported.
+struct QueryData {
+    vector<uint8_t> wire;
+    bool tcp;
+};
+
+// A class of queries, such as "positive" or "nxdomain".  The class names
+// are arbitrary; they only group queries for the result.
+struct QueryClass {
+    QueryClass(const string& name_param) : name(name_param), weight(1) {}
+    string name;
+    unsigned int weight;        // relative frequency in the mixed run
+    vector<QueryData> queries;
+};
+
+typedef vector<QueryClass> QueryClasses;
+
+// Load the query mix file.  Each line is of the following form:
+//   <class> <qname> <qtype> [dnssec] [tcp]
+// "dnssec" makes it an EDNS query with the DO bit; "tcp" means the response
+// is not limited by the UDP buffer size.  Empty lines and lines beginning
+// with '#' are ignored.
+void
+loadQueryMix(const char* const input_file, QueryClasses& classes) {
+    ifstream ifs(input_file);
+    if (!ifs) {
+        bundy_throw(BenchMarkError, "failed to load query mix file: " <<
+                    input_file);
+    }
+
+    Message query_message(Message::RENDER);
+    MessageRenderer renderer;
+    string line;
+    unsigned int linenum = 0;
+    while (getline(ifs, line)) {
+        ++linenum;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        istringstream iss(line);
+        string class_name, qname, qtype, option;
+        iss >> class_name >> qname >> qtype;
+        if (iss.fail()) {
+            bundy_throw(BenchMarkError, "unexpected input in " << input_file <<
+                        " at line " << linenum);
+        }
+        bool dnssec = false;
+        bool tcp = false;
+        while (iss >> option) {
+            if (option == "dnssec") {
+                dnssec = true;
+            } else if (option == "tcp") {
+                tcp = true;
+            } else {
+                bundy_throw(BenchMarkError, "unknown option '" << option <<
+                            "' in " << input_file << " at line " << linenum);
+            }
+        }
+
+        query_message.clear(Message::RENDER);
+        query_message.setQid(0);
+        query_message.setOpcode(Opcode::QUERY());
+        query_message.setRcode(Rcode::NOERROR());
+        query_message.addQuestion(Question(Name(qname), RRClass::IN(),
+                                           RRType(qtype)));
+        if (dnssec) {
+            EDNSPtr edns(new EDNS());
+            edns->setDNSSECAwareness(true);
+            edns->setUDPSize(4096);
+            query_message.setEDNS(edns);
+        }
+        renderer.clear();
+        query_message.toWire(renderer);
+
+        QueryClasses::iterator it = classes.begin();
+        while (it != classes.end() && it->name != class_name) {
+            ++it;
+        }
+        if (it == classes.end()) {
+            it = classes.insert(it, QueryClass(class_name));
+        }
+        QueryData data;
+        const uint8_t* const wire =
+            static_cast<const uint8_t*>(renderer.getData());
+        data.wire.assign(wire, wire + renderer.getLength());
+        data.tcp = tcp;
+        it->queries.push_back(data);
+    }
+}
+
+// Apply the weights given as "class=weight,class=weight,...".
+void
+setWeights(const string& spec, QueryClasses& classes) {
+    istringstream iss(spec);
+    string item;
+    while (getline(iss, item, ',')) {
+        const size_t pos = item.find('=');
+        if (pos == string::npos) {
+            bundy_throw(BenchMarkError, "bad weight: " << item);
+        }
+        const string class_name = item.substr(0, pos);
+        QueryClasses::iterator it = classes.begin();
+        while (it != classes.end() && it->name != class_name) {
+            ++it;
+        }
+        if (it == classes.end()) {
+            bundy_throw(BenchMarkError, "no query of class " << class_name);
+        }
+        try {
+            it->weight =
+                boost::lexical_cast<unsigned int>(item.substr(pos + 1));
+        } catch (const boost::bad_lexical_cast&) {
+            bundy_throw(BenchMarkError, "bad weight: " << item);
+        }
+    }
+}
+
+inline double
+getTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+// Process the given queries the way AuthSrv does for normal queries, minus
+// the transport, the response cache and TSIG.  If latencies is non NULL,
+// the time spent for each query is appended to it.
+class QueryMixBenchMark {
+public:
+    QueryMixBenchMark(ClientList& client_list,
+                      const vector<const QueryData*>& queries,
+                      vector<double>* latencies) :
+        client_list_(client_list), queries_(queries), latencies_(latencies),
+        message_(Message::PARSE)
+    {}
+    unsigned int run() {
+        vector<const QueryData*>::const_iterator it = queries_.begin();
+        const vector<const QueryData*>::const_iterator it_end =
+            queries_.end();
+        for (; it != it_end; ++it) {
+            if (latencies_ != NULL) {
+                const double start = getTime();
+                processQuery(**it);
+                latencies_->push_back(getTime() - start);
+            } else {
+                processQuery(**it);
+            }
+        }
+        return (queries_.size());
+    }
+private:
+    void processQuery(const QueryData& data) {
+        InputBuffer buffer(&data.wire[0], data.wire.size());
+        message_.clear(Message::PARSE);
+        message_.parseHeader(buffer);
+        message_.fromWire(buffer);
+
+        const ConstEDNSPtr remote_edns = message_.getEDNS();
+        const bool dnssec_ok = remote_edns &&
+            remote_edns->getDNSSECAwareness();
+        const uint16_t remote_bufsize = remote_edns ?
+            remote_edns->getUDPSize() : Message::DEFAULT_MAX_UDPSIZE;
+
+        message_.makeResponse();
+        message_.setHeaderFlag(Message::HEADERFLAG_AA);
+        message_.setRcode(Rcode::NOERROR());
+        if (remote_edns) {
+            EDNSPtr local_edns(new EDNS());
+            local_edns->setDNSSECAwareness(dnssec_ok);
+            local_edns->setUDPSize(4096);
+            message_.setEDNS(local_edns);
+        }
+
+        const ConstQuestionPtr question = *message_.beginQuestion();
+        query_.process(client_list_, question->getName(),
+                       question->getType(), message_, dnssec_ok);
+
+        renderer_.clear();
+        renderer_.setLengthLimit(data.tcp ? 65535 : remote_bufsize);
+        message_.toWire(renderer_);
+    }
+
+    ClientList& client_list_;
+    const vector<const QueryData*>& queries_;
+    vector<double>* latencies_;
+    Message message_;
+    MessageRenderer renderer_;
+    Query query_;
+};
+
+// Build the client list, and load the zones into its in-memory cache in
+// the segment of the given type.
+boost::shared_ptr<ConfigurableClientList>
+createClientList(const vector<pair<string, string> >& zones,
+                 const string& segment_type, const string& mapped_file)
+{
+    string params;
+    for (size_t i = 0; i < zones.size(); ++i) {
+        params += (i == 0 ? "\"" : ", \"") + zones[i].first + "\": \"" +
+            zones[i].second + "\"";
+    }
+    const ConstElementPtr config(Element::fromJSON(
+        "[{\"type\": \"MasterFiles\", \"cache-enable\": true,"
+        "  \"cache-type\": \"" + segment_type + "\","
+        "  \"params\": {" + params + "}}]"));
+
+    boost::shared_ptr<ConfigurableClientList> list(
+        new ConfigurableClientList(RRClass::IN()));
+    // For the local segment, this loads the zones.
+    list->configure(config, true);
+
+    if (segment_type != "local") {
+        // Like the memory manager does, create the segment file, load the
+        // zones into it, and then let the list use it in the read-only
+        // mode as the server does.
+        const ConstElementPtr segment_params(Element::fromJSON(
+            "{\"mapped-file\": \"" + mapped_file + "\"}"));
+        list->resetMemorySegment("MasterFiles",
+                                 memory::ZoneTableSegment::CREATE,
+                                 segment_params);
+        for (size_t i = 0; i < zones.size(); ++i) {
+            const ConfigurableClientList::ZoneWriterPair result =
+                list->getCachedZoneWriter(Name(zones[i].first), false,
+                                          "MasterFiles");
+            if (result.first != ConfigurableClientList::ZONE_SUCCESS) {
+                bundy_throw(BenchMarkError, "failed to load zone " <<
+                            zones[i].first);
+            }
+            result.second->load();
+            result.second->install();
+            result.second->cleanup();
+        }
+        list->resetMemorySegment("MasterFiles",
+                                 memory::ZoneTableSegment::READ_ONLY,
+                                 segment_params);
+    }
+    return (list);
+}
+
+// Run the benchmark for the given queries and print the result.
+void
+runBenchMark(const string& title, ClientList& client_list,
+             const vector<const QueryData*>& queries, int iteration)
+{
+    cout << "Benchmark for " << title << " (" << queries.size()
+         << " queries)" << endl;
+
+    // First, measure the throughput without the overhead of timing each
+    // query, and count the allocations.
+    QueryMixBenchMark target(client_list, queries, NULL);
+    BenchMark<QueryMixBenchMark> benchmark(iteration, target, false);
+    alloc_count = 0;
+    count_alloc = true;
+    benchmark.run();
+    count_alloc = false;
+    const size_t allocs = alloc_count;
+
+    // Then get the latency of each query.
+    vector<double> latencies;
+    latencies.reserve(queries.size() * iteration);
+    QueryMixBenchMark timed_target(client_list, queries, &latencies);
+    BenchMark<QueryMixBenchMark>(iteration, timed_target, false).run();
+
+    cout.precision(6);
+    cout << "Processed " << benchmark.getIteration() << " queries in "
+         << fixed << benchmark.getDuration() << "s";
+    cout.precision(2);
+    cout << " (" << fixed << benchmark.getIterationPerSecond() << "qps)"
+         << endl;
+    if (!latencies.empty()) {
+        const size_t p50 = latencies.size() / 2;
+        const size_t p99 = latencies.size() * 99 / 100;
+        nth_element(latencies.begin(), latencies.begin() + p50,
+                    latencies.end());
+        const double p50_value = latencies[p50];
+        nth_element(latencies.begin(), latencies.begin() + p99,
+                    latencies.end());
+        cout << "Latency: p50=" << p50_value * 1e6 << "us p99="
+             << latencies[p99] * 1e6 << "us" << endl;
+    }
+    if (benchmark.getIteration() > 0) {
+        cout << "Allocations: "
+             << static_cast<double>(allocs) / benchmark.getIteration()
+             << " per query" << endl;
+    }
+    cout << endl;
+}
+
+const int ITERATION_DEFAULT = 1;
+
+void
+usage() {
+    cerr <<
+        "Usage: query_mix_bench [-d] [-n iterations] [-s segment_type]"
+        " [-f mapped_file] [-w weights] query_mixfile origin zone_file"
+        " [origin zone_file...]\n"
+        "  -d Enable debug logging to stdout\n"
+        "  -n Number of iterations per test case (default: "
+         << ITERATION_DEFAULT << ")\n"
+        "  -s Type of memory segment: local|mapped (default: local)\n"
+        "  -f File for the mapped segment (default: query_mix_bench.mapped)\n"
+        "  -w Weights of query classes in the mixed run, e.g.,"
+        " positive=80,nxdomain=20 (default: 1 for all)\n"
+        "  query_mixfile: lines of \"class qname qtype [dnssec] [tcp]\"\n"
+        "  origin, zone_file: zone to load"
+         << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = ITERATION_DEFAULT;
+    string segment_type = "local";
+    string mapped_file = "query_mix_bench.mapped";
+    const char* weights = NULL;
+    bool debug_log = false;
+    while ((ch = getopt(argc, argv, "dn:s:f:w:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 's':
+            segment_type = optarg;
+            break;
+        case 'f':
+            mapped_file = optarg;
+            break;
+        case 'w':
+            weights = optarg;
+            break;
+        case 'd':
+            debug_log = true;
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    argv += optind;
+    if (argc < 3 || (argc % 2) != 1) {
+        usage();
+    }
+    if (segment_type != "local" && segment_type != "mapped") {
+        cerr << "Unknown segment type: " << segment_type << endl;
+        return (1);
+    }
+    const char* const query_mix_file = argv[0];
+    vector<pair<string, string> > zones;
+    for (int i = 1; i < argc; i += 2) {
+        zones.push_back(pair<string, string>(argv[i], argv[i + 1]));
+    }
+
+    // By default disable logging to avoid unwanted noise.
+    initLogger("query-mix-bench",
+               debug_log ? bundy::log::DEBUG : bundy::log::NONE,
+               bundy::log::MAX_DEBUG_LEVEL, NULL);
+
+    try {
+        QueryClasses classes;
+        loadQueryMix(query_mix_file, classes);
+        if (weights != NULL) {
+            setWeights(weights, classes);
+        }
+        const boost::shared_ptr<ConfigurableClientList> list =
+            createClientList(zones, segment_type, mapped_file);
+
+        cout << "Parameters:" << endl;
+        cout << "  Iterations: " << iteration << endl;
+        cout << "  Memory segment: " << segment_type << endl;
+        for (size_t i = 0; i < zones.size(); ++i) {
+            cout << "  Zone: " << zones[i].first << ", file="
+                 << zones[i].second << endl;
+        }
+        cout << "  Query mix: file=" << query_mix_file << endl << endl;
+
+        // Each class separately.
+        for (QueryClasses::const_iterator it = classes.begin();
+             it != classes.end(); ++it) {
+            vector<const QueryData*> queries;
+            for (size_t i = 0; i < it->queries.size(); ++i) {
+                queries.push_back(&it->queries[i]);
+            }
+            runBenchMark("class " + it->name, *list, queries, iteration);
+        }
+
+        // Then all of them, interleaving the classes according to their
+        // weights.
+        vector<const QueryData*> mixed_queries;
+        for (size_t round = 0; ; ++round) {
+            bool added = false;
+            for (QueryClasses::const_iterator it = classes.begin();
+                 it != classes.end(); ++it) {
+                for (unsigned int w = 0; w < it->weight; ++w) {
+                    const size_t i = round * it->weight + w;
+                    if (i < it->queries.size() * it->weight) {
+                        mixed_queries.push_back(
+                            &it->queries[i % it->queries.size()]);
+                        added = true;
+                    }
+                }
+            }
+            if (!added) {
+                break;
+            }
+        }
+        runBenchMark("the mix", *list, mixed_queries, iteration);
+
+        if (segment_type == "mapped") {
+            unlink(mapped_file.c_str());
+        }
+    } catch (const std::exception& ex) {
+        cout << "Test unexpectedly failed: " << ex.what() << endl;
+        return (1);
+    }
+
+    return (0);
+}
@@ -24,6 +24,7 @@
 #include <dns/rrclass.h>
 
 #include <string>
+#include <vector>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
@@ -152,6 +153,24 @@ public:
     }
 };
 
+// Handle the "getmemusage" command.  It returns the memory usage of the
+// in-memory cache of the data sources for each RR class.
+class GetMemUsageCommand : public AuthCommand {
+public:
+    virtual ConstElementPtr exec(AuthSrv& server, bundy::data::ConstElementPtr) {
+        ElementPtr usage = Element::createMap();
+        DataSrcClientsMgr::Holder holder(server.getDataSrcClientsMgr());
+        const vector<RRClass> classes = holder.getClasses();
+        for (vector<RRClass>::const_iterator it = classes.begin();
+             it != classes.end();
+             ++it) {
+            usage->set(it->toText(),
+                       holder.findClientList(*it)->getMemoryUsage());
+        }
+        return (createAnswer(0, usage));
+    }
+};
+
 class StartDDNSForwarderCommand : public AuthCommand {
 public:
     virtual ConstElementPtr exec(AuthSrv& server,
@@ -190,6 +209,8 @@ createAuthCommand(const string& command_id) {
         return (new ShutdownCommand());
     } else if (command_id == "getstats") {
         return (new GetStatsCommand());
+    } else if (command_id == "getmemusage") {
+        return (new GetMemUsageCommand());
     } else if (command_id == "loadzone") {
         return (new LoadZoneCommand());
     } else if (command_id == "start_ddns_forwarder") {
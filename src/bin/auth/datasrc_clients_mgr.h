@@ -17,6 +17,7 @@
 
 #include <util/threads/thread.h>
 #include <util/threads/sync.h>
+#include <util/threads/epoch.h>
 
 #include <log/logger_support.h>
 #include <log/log_dbglevels.h>
@@ -41,12 +42,14 @@
 #include <boost/noncopyable.hpp>
 #include <boost/function.hpp>
 #include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <exception>
 #include <cassert>
 #include <cerrno>
 #include <list>
 #include <utility>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -188,10 +191,23 @@ public:
     /// It's normally expected to create the holder object on the stack
     /// of a small scope and automatically let it be destroyed at the end
     /// of the scope.
+    ///
+    /// The holder doesn't acquire any lock as long as the client lists
+    /// only consist of in-memory cached data sources; it's a read-side
+    /// critical section of the epoch manager shared with the builder, so
+    /// multiple threads can use their own holders concurrently without
+    /// contending with each other.  The builder waits for all existing
+    /// holders to be destroyed before it releases or reorganizes any data
+    /// that can be seen through them.  If the list returned by
+    /// \c findClientList() contains a data source that is not cached in
+    /// memory, the holder acquires the lock of the clients map for the
+    /// rest of its lifetime, as such data sources are generally not
+    /// thread safe.
     class Holder {
     public:
         Holder(DataSrcClientsMgrBase& mgr) :
-            mgr_(mgr), locker_(mgr_.map_mutex_)
+            mgr_(mgr), reader_(mgr_.epoch_),
+            generation_(__sync_add_and_fetch(&mgr_.generation_, 0))
         {}
 
         /// \brief Find a data source client list of a specified RR class.
@@ -216,9 +232,11 @@ public:
                 it = mgr_.clients_map_->find(rrclass);
             if (it == mgr_.clients_map_->end()) {
                 return (boost::shared_ptr<datasrc::ConfigurableClientList>());
-            } else {
-                return (it->second);
             }
+            if (!locker_ && !isCachedOnly(*it->second)) {
+                locker_.reset(new typename MutexType::Locker(mgr_.map_mutex_));
+            }
+            return (it->second);
         }
         /// \brief Return list of classes that are present.
         ///
@@ -238,9 +256,47 @@ public:
             }
             return (result);
         }
+
+        /// \brief Return the current generation of the data source data.
+        ///
+        /// The generation is a counter that is incremented every time the
+        /// data that can be seen through the client lists may have been
+        /// changed: when the lists are reconfigured, a new version of zone
+        /// is installed in memory, or a memory segment is reset.  The
+        /// application can use it to detect whether any data derived from
+        /// the client lists (e.g., cached responses) is still valid.
+        ///
+        /// The returned value is the one at the time the holder was
+        /// constructed; any data seen through the holder is at least as new
+        /// as that generation.
+        ///
+        /// \throw None
+        uint32_t getGeneration() const {
+            return (generation_);
+        }
     private:
+        // Whether all data sources of the list are cached in memory, i.e.,
+        // whether lookups in the list only see data protected by the epoch
+        // manager.
+        static bool isCachedOnly(const datasrc::ConfigurableClientList& list) {
+            BOOST_FOREACH(const datasrc::ConfigurableClientList::DataSourceInfo&
+                          info, list.getDataSources()) {
+                if (!info.cache_) {
+                    return (false);
+                }
+            }
+            return (true);
+        }
+
         DataSrcClientsMgrBase& mgr_;
-        typename MutexType::Locker locker_;
+        // Note: the generation is read inside the critical section, so it
+        // can't change while an exclusive section updates the data.  The
+        // builder also increments it outside an exclusive section, after
+        // atomically replacing a zone, so it's read and updated atomically;
+        // the data we see can't be older than the generation we read.
+        util::thread::EpochManager::Reader reader_;
+        const uint32_t generation_;
+        boost::scoped_ptr<typename MutexType::Locker> locker_;
     };
 
     /// \brief Constructor.
@@ -258,9 +314,10 @@ public:
     DataSrcClientsMgrBase(asiolink::IOService& service) :
         clients_map_(new ClientListsMap),
         fd_guard_(new FDGuard(this)),
-        read_fd_(-1), write_fd_(-1),
+        read_fd_(-1), write_fd_(-1), generation_(0),
         builder_(&command_queue_, &callback_queue_, &cond_, &queue_mutex_,
-                 &clients_map_, &map_mutex_, createFds()),
+                 &clients_map_, &map_mutex_, &epoch_, &generation_,
+                 createFds()),
         builder_thread_(boost::bind(&BuilderType::run, &builder_)),
         wakeup_socket_(service, read_fd_)
     {
@@ -343,8 +400,10 @@ public:
     /// cleaner way to use faked data source clients.  Non test code or
     /// newer tests must not use this.
     void setDataSrcClientLists(datasrc::ClientListMapPtr new_lists) {
+        util::thread::EpochManager::Exclusive exclusive(epoch_);
         typename MutexType::Locker locker(map_mutex_);
         clients_map_ = new_lists;
+        __sync_add_and_fetch(&generation_, 1);
     }
 
     /// \brief Instruct internal thread to (re)load a zone
@@ -546,6 +605,11 @@ private:
     boost::scoped_ptr<FDGuard> fd_guard_; // A guard to close the fds.
     int read_fd_, write_fd_;    // Descriptors for wakeup
     MutexType map_mutex_;       // mutex to protect the clients map
+                                // for non-cached data sources
+    util::thread::EpochManager epoch_; // synchronizes lock-free holders
+                                       // with updates of the clients map
+    uint32_t generation_;       // generation of the data in the clients map,
+                                // updated by the builder only (atomically)
 
     BuilderType builder_;
     ThreadType builder_thread_; // for safety this should be placed last
@@ -600,11 +664,13 @@ public:
                               CondVarType* cond, MutexType* queue_mutex,
                               datasrc::ClientListMapPtr* clients_map,
                               MutexType* map_mutex,
-                              int wake_fd
+                              util::thread::EpochManager* epoch,
+                              uint32_t* generation, int wake_fd
         ) :
         command_queue_(command_queue), callback_queue_(callback_queue),
         cond_(cond), queue_mutex_(queue_mutex),
-        clients_map_(clients_map), map_mutex_(map_mutex), wake_fd_(wake_fd)
+        clients_map_(clients_map), map_mutex_(map_mutex), epoch_(epoch),
+        generation_(generation), wake_fd_(wake_fd)
     {}
 
     /// \brief The main loop.
@@ -638,8 +704,10 @@ private:
                 datasrc::ClientListMapPtr new_clients_map =
                     configureDataSource(config);
                 {
+                    util::thread::EpochManager::Exclusive exclusive(*epoch_);
                     typename MutexType::Locker locker(*map_mutex_);
                     new_clients_map.swap(*clients_map_);
+                    __sync_add_and_fetch(generation_, 1);
                 } // lock is released by leaving scope
                 LOG_INFO(auth_logger,
                          AUTH_DATASRC_CLIENTS_BUILDER_RECONFIGURE_SUCCESS);
@@ -672,18 +740,40 @@ private:
                 name(arg->get("data-source-name")->stringValue());
             const bundy::data::ConstElementPtr& segment_params =
                 arg->get("segment-params");
-            typename MutexType::Locker locker(*map_mutex_);
-            const boost::shared_ptr<bundy::datasrc::ConfigurableClientList>&
-                list = (**clients_map_)[rrclass];
+            boost::shared_ptr<bundy::datasrc::ConfigurableClientList> list;
+            {
+                typename MutexType::Locker locker(*map_mutex_);
+                const datasrc::ClientListMapPtr::element_type::const_iterator
+                    it = (*clients_map_)->find(rrclass);
+                if (it != (*clients_map_)->end()) {
+                    list = it->second;
+                }
+            }
             if (!list) {
                 LOG_FATAL(auth_logger,
                           AUTH_DATASRC_CLIENTS_BUILDER_SEGMENT_UNKNOWN_CLASS)
                     .arg(rrclass);
                 std::terminate();
             }
-            if (!list->resetMemorySegment(name,
+
+            // Map the new segment and bring it into memory while the
+            // current one keeps serving queries; the lists are only
+            // modified in this thread, so it's safe to look at them.  Only
+            // the switch itself needs to block the readers.  The previous
+            // segment is unmapped when generation is destroyed, after the
+            // exclusive section.
+            const datasrc::ConfigurableClientList::MemorySegmentGenerationPtr
+                generation = list->prepareMemorySegment(name,
                     bundy::datasrc::memory::ZoneTableSegment::READ_ONLY,
-                    segment_params)) {
+                    segment_params);
+            bool installed = false;
+            if (generation) {
+                util::thread::EpochManager::Exclusive exclusive(*epoch_);
+                typename MutexType::Locker locker(*map_mutex_);
+                installed = list->installMemorySegment(*generation);
+                __sync_add_and_fetch(generation_, 1);
+            }
+            if (!installed) {
                 LOG_FATAL(auth_logger,
                           AUTH_DATASRC_CLIENTS_BUILDER_SEGMENT_NO_DATASRC)
                     .arg(rrclass).arg(name);
@@ -717,6 +807,8 @@ private:
     MutexType* queue_mutex_;
     datasrc::ClientListMapPtr* clients_map_;
     MutexType* map_mutex_;
+    util::thread::EpochManager* epoch_;
+    uint32_t* generation_;
     int wake_fd_;
 };
 
@@ -878,9 +970,28 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doUpdateZone(
         }
 
         zwriter->load(); // this can take time but doesn't cause a race
-        {   // install() can cause a race and must be in a critical section
+        if (zwriter->isReplacement()) {
+            // Replacing an existing zone is an atomic update of the zone
+            // table, so we don't have to block lock-free readers; we only
+            // have to wait until they stop using the old version before
+            // cleanup().  Readers of non-cached data sources are still
+            // excluded by the lock.
+            {
+                typename MutexType::Locker locker(*map_mutex_);
+                util::thread::EpochManager::barrier();
+                zwriter->install();
+                util::thread::EpochManager::barrier();
+                __sync_add_and_fetch(generation_, 1);
+            }
+            epoch_->synchronize();
+        } else {
+            // install() changes the structure of the zone table (or the zone
+            // data in place, if the writer is incremental), so it must be in
+            // an exclusive critical section.
+            util::thread::EpochManager::Exclusive exclusive(*epoch_);
             typename MutexType::Locker locker(*map_mutex_);
             zwriter->install();
+            __sync_add_and_fetch(generation_, 1);
         }
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS,
                   AUTH_DATASRC_CLIENTS_BUILDER_LOAD_ZONE)
@@ -917,8 +1028,13 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
     datasrc::ConfigurableClientList::ZoneWriterPair writerpair;
     {
         typename MutexType::Locker locker(*map_mutex_);
+        // UPDATEZONE is sent when the zone is updated in the data source
+        // (e.g., by a transfer), so we try to apply only the differences.
+        // LOADZONE always reloads the entire zone, so it can be used to
+        // recover from a broken update.
         writerpair = client_list.getCachedZoneWriter(origin, false,
-                                                     datasrc_name);
+                                                     datasrc_name,
+                                                     command == UPDATEZONE);
     }
 
     switch (writerpair.first) {
@@ -224,7 +224,8 @@ main(int argc, char* argv[]) {
 
         LOG_DEBUG(auth_logger, DBG_AUTH_START, AUTH_LOAD_TSIG);
         bundy::server_common::initKeyring(*config_session);
-        auth_server->setTSIGKeyRing(&bundy::server_common::keyring);
+        auth_server->setTSIGKeyRing(&bundy::server_common::keyring,
+                                    &bundy::server_common::keyring_mutex);
 
         config_session->subscribeNotification(
             "ZoneUpdateListener",
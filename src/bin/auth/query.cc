@@ -24,8 +24,6 @@
 #include <auth/query.h>
 
 #include <boost/foreach.hpp>
-#include <boost/bind.hpp>
-#include <boost/function.hpp>
 
 #include <cassert>
 #include <algorithm>            // for std::max
@@ -396,16 +394,13 @@ Query::process(datasrc::ClientList& client_list,
     // indirectly via delegation).  Look into the zone.
     response_->setHeaderFlag(Message::HEADERFLAG_AA);
     response_->setRcode(Rcode::NOERROR());
-    boost::function0<ZoneFinderContextPtr> find;
+    // Call the finder directly; binding the method to a function object
+    // would copy the query name several times and allocate the binder for
+    // every query.
     const bool qtype_is_any = (*qtype_ == RRType::ANY());
-    if (qtype_is_any) {
-        find = boost::bind(&ZoneFinder::findAll, &zfinder, *qname_,
-                           boost::ref(answers_), dnssec_opt_);
-    } else {
-        find = boost::bind(&ZoneFinder::find, &zfinder, *qname_, *qtype_,
-                           dnssec_opt_);
-    }
-    ZoneFinderContextPtr db_context(find());
+    ZoneFinderContextPtr db_context(
+        qtype_is_any ? zfinder.findAll(*qname_, answers_, dnssec_opt_) :
+        zfinder.find(*qname_, *qtype_, dnssec_opt_));
     switch (db_context->code) {
         case ZoneFinder::DNAME: {
             // First, put the dname into the answer
@@ -0,0 +1,186 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <auth/query_workers.h>
+#include <auth/auth_srv.h>
+#include <auth/auth_log.h>
+
+#include <asiolink/io_error.h>
+#include <util/threads/thread.h>
+
+#include <asio.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+using namespace bundy::asiodns;
+using namespace bundy::asiolink;
+using bundy::util::thread::Thread;
+
+namespace bundy {
+namespace auth {
+
+// A single query worker: an event loop running in its own thread with the
+// DNS (UDP) servers associated with it.
+class QueryWorkers::Worker : boost::noncopyable {
+public:
+    Worker(AuthSrv& server, size_t id) :
+        id_(id),
+        dns_service_(io_service_, server.getWorkerLookupProvider(id),
+                     server.getDNSAnswerProvider())
+    {}
+
+    ~Worker() {
+        stop();
+        // The thread isn't running any more, so we can safely close the
+        // sockets here.
+        dns_service_.clearServers();
+    }
+
+    void addServerUDPFromFD(int fd, int af, ServerFlag options) {
+        // ASIO is built without thread support, so an IO service must
+        // never be touched by two threads at the same time.  We pause the
+        // worker thread while adding the server, and restart it.
+        stop();
+        dns_service_.addServerUDPFromFD(fd, af, options);
+        io_service_.get_io_service().reset();
+        LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_QUERY_WORKER_START).
+            arg(id_);
+        thread_.reset(new Thread(boost::bind(&Worker::run, this)));
+    }
+
+    void stop() {
+        if (thread_) {
+            io_service_.stop();
+            thread_->wait();
+            thread_.reset();
+            LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_QUERY_WORKER_STOP).
+                arg(id_);
+        }
+    }
+
+private:
+    // The main routine of the worker thread.  The event loop is running
+    // until stop() is called; if a handler throws we have no way to recover,
+    // so the worker simply stops serving queries after logging the event.
+    void run() {
+        try {
+            io_service_.run();
+        } catch (const std::exception& ex) {
+            LOG_ERROR(auth_logger, AUTH_QUERY_WORKER_FAILED).arg(id_).
+                arg(ex.what());
+        }
+    }
+
+    const size_t id_;
+    IOService io_service_;
+    DNSService dns_service_;
+    boost::scoped_ptr<Thread> thread_;
+};
+
+QueryWorkers::QueryWorkers(AuthSrv& server, DNSServiceBase& main_service) :
+    server_(server), main_service_(main_service), worker_count_(0)
+{}
+
+QueryWorkers::~QueryWorkers() {
+    // Explicitly stop the threads first; the workers would be destroyed
+    // (and stopped) anyway, but we make the order of shutdown clear.
+    BOOST_FOREACH(const WorkerPtr& worker, workers_) {
+        worker->stop();
+    }
+}
+
+void
+QueryWorkers::setWorkerCount(size_t count) {
+    if (!workers_.empty()) {
+        bundy_throw(bundy::InvalidOperation,
+                    "Query worker count can't be changed while running");
+    }
+    worker_count_ = count;
+}
+
+void
+QueryWorkers::addServerTCPFromFD(int fd, int af) {
+    main_service_.addServerTCPFromFD(fd, af);
+}
+
+void
+QueryWorkers::addServerUDPFromFD(int fd, int af, ServerFlag options) {
+    if (worker_count_ == 0) {
+        main_service_.addServerUDPFromFD(fd, af, options);
+        return;
+    }
+
+    if (workers_.empty()) {
+        for (size_t i = 0; i < worker_count_; ++i) {
+            workers_.push_back(WorkerPtr(new Worker(server_, i)));
+        }
+    }
+
+    // Duplicate the descriptor for all workers first, so we don't leave
+    // the workers in an inconsistent state if it fails.
+    std::vector<int> fds(1, fd);
+    for (size_t i = 1; i < worker_count_; ++i) {
+        const int dup_fd = dup(fd);
+        if (dup_fd == -1) {
+            const int error = errno;
+            for (size_t j = 1; j < fds.size(); ++j) {
+                close(fds[j]);
+            }
+            bundy_throw(IOError, "failed to duplicate UDP socket: " <<
+                        std::strerror(error));
+        }
+        fds.push_back(dup_fd);
+    }
+    for (size_t i = 0; i < worker_count_; ++i) {
+        try {
+            workers_[i]->addServerUDPFromFD(fds[i], af, options);
+        } catch (...) {
+            // The remaining duplicates are still ours.  The original one
+            // (fds[0]) is owned by the socket requestor's user.
+            for (size_t j = std::max(i, static_cast<size_t>(1));
+                 j < fds.size(); ++j) {
+                close(fds[j]);
+            }
+            throw;
+        }
+    }
+}
+
+void
+QueryWorkers::clearServers() {
+    main_service_.clearServers();
+    workers_.clear();
+}
+
+void
+QueryWorkers::setTCPRecvTimeout(size_t timeout) {
+    main_service_.setTCPRecvTimeout(timeout);
+}
+
+IOService&
+QueryWorkers::getIOService() {
+    return (main_service_.getIOService());
+}
+
+} // namespace auth
+} // namespace bundy
@@ -0,0 +1,118 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_QUERY_WORKERS_H
+#define AUTH_QUERY_WORKERS_H 1
+
+#include <asiodns/dns_service.h>
+#include <asiolink/io_service.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+class AuthSrv;
+
+namespace bundy {
+namespace auth {
+
+/// \brief A DNS service that handles UDP queries in worker threads.
+///
+/// This class is a \c DNSServiceBase that can be passed to
+/// \c installListenAddresses() in place of the main \c DNSService of
+/// bundy-auth.  If the worker count is 0, it simply forwards all requests
+/// to the main service.  Otherwise, TCP servers are still added to the main
+/// service, but each UDP socket is served by all worker threads: each worker
+/// runs its own \c IOService in a separate thread with its own
+/// \c SyncUDPServer on a duplicate of the socket's file descriptor, so the
+/// kernel distributes incoming queries among the workers.  Each worker uses
+/// the lookup callback returned by \c AuthSrv::getWorkerLookupProvider(),
+/// so it has its own \c Query, \c MessageRenderer and statistics counters
+/// while sharing the data source clients with the other threads.
+///
+/// The worker threads are started when the first UDP server is added after
+/// construction or \c clearServers(), and stopped (joined) in
+/// \c clearServers() or on destruction.  Since ASIO is built without thread
+/// support, a worker thread is briefly stopped while a new server is added
+/// to it, so that its \c IOService is never used by two threads at the same
+/// time.  All methods of this class must be called from the main thread.
+class QueryWorkers : public bundy::asiodns::DNSServiceBase,
+                     boost::noncopyable
+{
+public:
+    /// \brief Constructor.
+    ///
+    /// \param server The \c AuthSrv object processing the queries.
+    /// \param main_service The DNS service of the main thread.
+    QueryWorkers(AuthSrv& server, bundy::asiodns::DNSServiceBase& main_service);
+
+    /// \brief Destructor.
+    ///
+    /// It stops all running worker threads.
+    virtual ~QueryWorkers();
+
+    /// \brief Set the number of worker threads.
+    ///
+    /// This can be changed only when there are no UDP servers in the
+    /// workers, i.e., right after construction or \c clearServers().
+    ///
+    /// \throw bundy::InvalidOperation the workers have UDP servers.
+    /// \param count The number of worker threads; 0 disables the workers.
+    void setWorkerCount(size_t count);
+
+    /// \brief Return the number of worker threads.
+    size_t getWorkerCount() const { return (worker_count_); }
+
+    /// \brief Add a TCP server to the main service.
+    virtual void addServerTCPFromFD(int fd, int af);
+
+    /// \brief Add a UDP server on \c fd to each worker.
+    ///
+    /// The first worker takes over the ownership of \c fd; the others get
+    /// a duplicate of it.  If the worker count is 0 the server is added to
+    /// the main service.
+    ///
+    /// \throw bundy::asiolink::IOError failed to duplicate the descriptor,
+    /// or any exception from \c DNSService::addServerUDPFromFD().
+    virtual void addServerUDPFromFD(int fd, int af,
+                                    ServerFlag options = SERVER_DEFAULT);
+
+    /// \brief Remove all servers, stopping the worker threads.
+    virtual void clearServers();
+
+    /// \brief Set the TCP receive timeout of the main service.
+    virtual void setTCPRecvTimeout(size_t timeout);
+
+    /// \brief Return the IO service of the main service.
+    virtual bundy::asiolink::IOService& getIOService();
+
+private:
+    class Worker;
+    typedef boost::shared_ptr<Worker> WorkerPtr;
+
+    AuthSrv& server_;
+    bundy::asiodns::DNSServiceBase& main_service_;
+    size_t worker_count_;
+    std::vector<WorkerPtr> workers_;
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_QUERY_WORKERS_H
+
+// Local Variables:
+// mode: c++
+// End:
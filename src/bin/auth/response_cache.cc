@@ -0,0 +1,135 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <auth/response_cache.h>
+
+#include <dns/name.h>
+#include <exceptions/exceptions.h>
+
+#include <cstring>
+
+using namespace bundy::dns;
+using bundy::util::OutputBuffer;
+
+namespace bundy {
+namespace auth {
+
+namespace {
+// Offset of the question section in a DNS message, i.e., the header length.
+const size_t QUESTION_OFFSET = 12;
+}
+
+ResponseCache::ResponseCache(size_t size) :
+    entries_(size), key_buffer_(0)
+{}
+
+void
+ResponseCache::setSize(size_t size) {
+    std::vector<Entry> entries(size);
+    entries_.swap(entries);
+}
+
+void
+ResponseCache::clear() {
+    for (std::vector<Entry>::iterator it = entries_.begin();
+         it != entries_.end(); ++it) {
+        it->valid = false;
+    }
+}
+
+ResponseCache::Entry&
+ResponseCache::findEntry(const Question& question, unsigned int options,
+                         uint16_t max_length)
+{
+    // The key consists of the query name in lower case, the type and class
+    // of the question, the options and the maximum length.  Note that in
+    // the wire format of the name no length octet can be an upper case
+    // letter, so we can simply convert all octets.
+    key_buffer_.clear();
+    const Name& qname = question.getName();
+    const size_t name_len = qname.getLength();
+    for (size_t i = 0; i < name_len; ++i) {
+        const uint8_t c = qname.at(i);
+        key_buffer_.writeUint8((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+    }
+    key_buffer_.writeUint16(question.getType().getCode());
+    key_buffer_.writeUint16(question.getClass().getCode());
+    key_buffer_.writeUint8(options);
+    key_buffer_.writeUint16(max_length);
+
+    // FNV-1a hash of the key
+    const uint8_t* key = static_cast<const uint8_t*>(key_buffer_.getData());
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < key_buffer_.getLength(); ++i) {
+        hash = (hash ^ key[i]) * 16777619U;
+    }
+    return (entries_[hash % entries_.size()]);
+}
+
+bool
+ResponseCache::entryMatches(const Entry& entry, uint32_t generation) const {
+    return (entry.valid && entry.generation == generation &&
+            entry.key.size() == key_buffer_.getLength() &&
+            std::memcmp(&entry.key[0], key_buffer_.getData(),
+                        entry.key.size()) == 0);
+}
+
+bool
+ResponseCache::lookup(const Question& question, unsigned int options,
+                      uint16_t max_length, uint32_t generation, qid_t qid,
+                      OutputBuffer& buffer)
+{
+    if (entries_.empty()) {
+        return (false);
+    }
+    const Entry& entry = findEntry(question, options, max_length);
+    if (!entryMatches(entry, generation)) {
+        return (false);
+    }
+
+    buffer.clear();
+    buffer.writeData(&entry.data[0], entry.data.size());
+    buffer.writeUint16At(qid, 0);
+    const Name& qname = question.getName();
+    for (size_t i = 0; i < qname.getLength(); ++i) {
+        buffer.writeUint8At(qname.at(i), QUESTION_OFFSET + i);
+    }
+    return (true);
+}
+
+void
+ResponseCache::insert(const Question& question, unsigned int options,
+                      uint16_t max_length, uint32_t generation,
+                      const void* data, size_t length)
+{
+    if (entries_.empty()) {
+        return;
+    }
+    if (length < QUESTION_OFFSET + question.getName().getLength()) {
+        bundy_throw(bundy::InvalidParameter,
+                    "Too short response for the response cache: " << length);
+    }
+    Entry& entry = findEntry(question, options, max_length);
+    const uint8_t* key = static_cast<const uint8_t*>(key_buffer_.getData());
+    entry.key.assign(key, key + key_buffer_.getLength());
+    const uint8_t* cp = static_cast<const uint8_t*>(data);
+    entry.data.assign(cp, cp + length);
+    entry.generation = generation;
+    entry.valid = true;
+}
+
+} // namespace auth
+} // namespace bundy
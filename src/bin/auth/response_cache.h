@@ -0,0 +1,157 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_RESPONSE_CACHE_H
+#define AUTH_RESPONSE_CACHE_H 1
+
+#include <dns/message.h>
+#include <dns/question.h>
+#include <util/buffer.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace auth {
+
+/// \brief A cache of rendered responses to normal queries.
+///
+/// This class stores the wire-format data of responses so that subsequent
+/// queries for the same question can be answered without looking up the
+/// data sources and rendering the response again.
+///
+/// The cache is keyed on the question (the query name is compared in a
+/// case-insensitive manner) and some other parameters of the query that
+/// can affect the response, specified as a combination of the \c Option
+/// values and the maximum length of the response.  When a cached response
+/// is returned, its message ID is replaced with that of the query, and so
+/// is the query name in the question section, so the case of the name is
+/// preserved as if the response were rendered for the query (since the
+/// response is rendered with case-insensitive name compression, any other
+/// occurrence of the query name refers to that in the question).
+///
+/// Each response is stored with a "generation" given by the caller, and is
+/// returned only for a lookup with the same generation.  The caller is
+/// expected to pass a value that changes whenever the responses can change,
+/// e.g., when a new version of a zone is loaded, so that any older
+/// responses are effectively invalidated.
+///
+/// The cache is a simple direct-mapped table of a fixed number of entries
+/// (the "size" of the cache); when a new response is stored in an entry that
+/// is in use, the old one is simply replaced.  Memory allocated for an
+/// entry is reused, so once the cache is warmed up, the lookups and
+/// updates normally don't involve any memory allocation.
+///
+/// This class is not thread safe; each thread processing queries is
+/// expected to have its own cache.
+class ResponseCache : boost::noncopyable {
+public:
+    /// \brief Parameters of the query other than the question that affect
+    /// the response.
+    ///
+    /// They can be combined with the bitwise OR operator.
+    enum Option {
+        RECURSION_DESIRED = 0x01,  ///< The RD bit is set in the query
+        CHECKING_DISABLED = 0x02,  ///< The CD bit is set in the query
+        EDNS = 0x04,               ///< The query has an EDNS OPT RR
+        DNSSEC_OK = 0x08           ///< The DO bit is set in the query
+    };
+
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc Memory allocation failure
+    /// \param size The number of entries of the cache.  If it's 0 the cache
+    ///     is disabled: nothing will be stored and lookups always fail.
+    explicit ResponseCache(size_t size = 0);
+
+    /// \brief Return the number of entries of the cache.
+    size_t getSize() const { return (entries_.size()); }
+
+    /// \brief Change the number of entries of the cache.
+    ///
+    /// All cached responses are removed.
+    ///
+    /// \throw std::bad_alloc Memory allocation failure
+    void setSize(size_t size);
+
+    /// \brief Remove all cached responses.
+    void clear();
+
+    /// \brief Look up a cached response for a query.
+    ///
+    /// If a response is found for the given parameters of the query and
+    /// the generation, it's copied to \c buffer (replacing any existing data)
+    /// with the message ID and the name in the question section updated for
+    /// the query.
+    ///
+    /// \throw std::bad_alloc Memory allocation failure
+    /// \param question The question of the query.
+    /// \param options A combination of \c Option for the query.
+    /// \param max_length The maximum length of the response.
+    /// \param generation The current generation of the data.
+    /// \param qid The message ID of the query.
+    /// \param buffer The buffer to store the response in.
+    /// \return true if a response was found; false otherwise (the buffer
+    ///     isn't modified in this case).
+    bool lookup(const dns::Question& question, unsigned int options,
+                uint16_t max_length, uint32_t generation, dns::qid_t qid,
+                util::OutputBuffer& buffer);
+
+    /// \brief Store a response in the cache.
+    ///
+    /// The parameters identifying the query are the same as those for
+    /// \c lookup().  The response must have been rendered for a query with
+    /// the given question and must have a single question.  If the cache is
+    /// disabled, this method does nothing.
+    ///
+    /// \throw bundy::InvalidParameter \c data is too short to contain the
+    ///     question.
+    /// \throw std::bad_alloc Memory allocation failure
+    /// \param data The wire-format data of the response.
+    /// \param length The length of \c data.
+    void insert(const dns::Question& question, unsigned int options,
+                uint16_t max_length, uint32_t generation, const void* data,
+                size_t length);
+
+private:
+    struct Entry {
+        Entry() : valid(false), generation(0) {}
+        bool valid;
+        uint32_t generation;
+        std::vector<uint8_t> key;
+        std::vector<uint8_t> data;
+    };
+
+    // Build the lookup key in key_buffer_ and return the entry for it.
+    Entry& findEntry(const dns::Question& question, unsigned int options,
+                     uint16_t max_length);
+    // Check if the entry holds a valid response for the key in key_buffer_.
+    bool entryMatches(const Entry& entry, uint32_t generation) const;
+
+    std::vector<Entry> entries_;
+    // Placeholder for the key of the current query, reused for all lookups.
+    util::OutputBuffer key_buffer_;
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RESPONSE_CACHE_H
+
+// Local Variables:
+// mode: c++
+// End:
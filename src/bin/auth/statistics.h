@@ -75,6 +75,8 @@ private:
         BIT_ATTRIBUTES_TYPES
     };
     std::bitset<BIT_ATTRIBUTES_TYPES> bit_attributes_;
+    // response attributes
+    boost::optional<unsigned int> res_answer_count_; // number of answer RRs
 public:
     /// \brief The constructor.
     ///
@@ -251,6 +253,28 @@ public:
     void setResponseTSIG(const bool signed_tsig) {
         bit_attributes_[RES_TSIG_SIGNED] = signed_tsig;
     }
+
+    /// \brief Return the number of RRs in the answer section of the response.
+    ///
+    /// \return the number of answer RRs wrapped with boost::optional; it's
+    ///         converted to false if it hasn't been set.
+    /// \throw None
+    const boost::optional<unsigned int>& getResponseAnswerCount() const {
+        return (res_answer_count_);
+    }
+
+    /// \brief Set the number of RRs in the answer section of the response.
+    ///
+    /// This is necessary only when the response is sent without building
+    /// the answer section of the response \c Message, e.g., when it's
+    /// retrieved from the response cache.  If set, it's used in
+    /// \c Counters::inc() instead of the count in the response \c Message.
+    ///
+    /// \param count The number of RRs in the answer section
+    /// \throw None
+    void setResponseAnswerCount(const unsigned int count) {
+        res_answer_count_ = count;
+    }
 };
 
 /// \brief Set of DNS message counters.
@@ -308,6 +332,16 @@ public:
     void inc(const MessageAttributes& msgattrs,
              const bundy::dns::Message& response, const bool done);
 
+    /// \brief Add the counter values of another \c Counters object.
+    ///
+    /// This is used to combine the counters maintained separately by
+    /// query worker threads into a single set of statistics.
+    ///
+    /// This method never throws.
+    ///
+    /// \param other The counters to be added to this object.
+    void add(const Counters& other);
+
     /// \brief Get statistics counters.
     ///
     /// This method is mostly exception free. But it may still throw a
@@ -331,6 +331,46 @@ TEST_F(AuthSrvTest, noClientList) {
     checkStatisticsCounters(stats_after, expect);
 }
 
+// Queries processed by the lookup callbacks for query workers should be
+// handled the same way, and counted in the combined statistics.
+TEST_F(AuthSrvTest, workerLookupProvider) {
+    // The same provider is returned for the same worker, and different
+    // ones for different workers.
+    DNSLookup* lookup0 = server.getWorkerLookupProvider(0);
+    DNSLookup* lookup1 = server.getWorkerLookupProvider(1);
+    EXPECT_NE(static_cast<DNSLookup*>(NULL), lookup0);
+    EXPECT_NE(lookup0, lookup1);
+    EXPECT_EQ(lookup1, server.getWorkerLookupProvider(1));
+    EXPECT_NE(server.getDNSLookupProvider(), lookup0);
+
+    UnitTestUtil::createRequestMessage(request_message, Opcode::QUERY(),
+                                       default_qid, Name("version.bind"),
+                                       RRClass::CH(), RRType::TXT());
+    createRequestPacket(request_message, IPPROTO_UDP);
+    (*lookup1)(*io_message, parse_message, MessagePtr(), response_obuffer,
+               &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::REFUSED(),
+                opcode.getCode(), QR_FLAG, 1, 0, 0, 0);
+
+    // Process another one in the main context
+    createRequestPacket(request_message, IPPROTO_UDP);
+    processMessage();
+    EXPECT_TRUE(dnsserv.hasAnswer());
+
+    ConstElementPtr stats_after = server.getStatistics()->get("zones")->
+        get("_SERVER_");
+    std::map<std::string, int> expect;
+    expect["request.v4"] = 2;
+    expect["request.udp"] = 2;
+    expect["opcode.query"] = 2;
+    expect["responses"] = 2;
+    expect["qrynoauthans"] = 2;
+    expect["authqryrej"] = 2;
+    expect["rcode.refused"] = 2;
+    checkStatisticsCounters(stats_after, expect);
+}
+
 // Unsupported requests.  Should result in NOTIMP.
 TEST_F(AuthSrvTest, unsupportedRequest) {
     unsupportedRequest();
@@ -1276,6 +1316,70 @@ TEST_F(AuthSrvTest, queryWithInMemoryClientDNSSEC) {
                 opcode.getCode(), QR_FLAG | AA_FLAG, 1, 2, 3, 3);
 }
 
+// Subsequent queries for the same question are answered from the response
+// cache, until the data sources are updated.
+TEST_F(AuthSrvTest, responseCache) {
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    EXPECT_EQ(0, server.getResponseCacheSize());
+    server.setResponseCacheSize(16);
+    EXPECT_EQ(16, server.getResponseCacheSize());
+
+    UnitTestUtil::createRequestMessage(request_message, Opcode::QUERY(),
+                                       default_qid, Name("ns1.example"),
+                                       RRClass::IN(), RRType::A());
+    createRequestPacket(request_message, IPPROTO_UDP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    const uint8_t* const data =
+        static_cast<const uint8_t*>(response_obuffer->getData());
+    const std::vector<uint8_t> first(data,
+                                     data + response_obuffer->getLength());
+
+    // The second query has a different ID and the query name in a different
+    // case.  The response should be identical to the first one except for
+    // these.
+    const qid_t qid = default_qid + 1;
+    const Name qname("NS1.Example");
+    UnitTestUtil::createRequestMessage(request_message, Opcode::QUERY(),
+                                       qid, qname, RRClass::IN(),
+                                       RRType::A());
+    createRequestPacket(request_message, IPPROTO_UDP);
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    std::vector<uint8_t> expected(first);
+    expected[0] = qid >> 8;
+    expected[1] = qid & 0xff;
+    for (size_t i = 0; i < qname.getLength(); ++i) {
+        expected[12 + i] = qname.at(i);
+    }
+    matchWireData(&expected[0], expected.size(), response_obuffer->getData(),
+                  response_obuffer->getLength());
+
+    // The statistics should be updated for the cached response, too.
+    ConstElementPtr stats = server.getStatistics()->get("zones")->
+        get("_SERVER_");
+    EXPECT_EQ(2, stats->get("responses")->intValue());
+    EXPECT_EQ(2, stats->get("rcode.noerror")->intValue());
+    EXPECT_EQ(2, stats->get("qrysuccess")->intValue());
+    EXPECT_EQ(2, stats->get("qryauthans")->intValue());
+
+    // Once the data sources are updated, the cached response is no longer
+    // used.  There's no IN data source now, so the query will be refused.
+    updateBuiltin(server);
+    createRequestPacket(request_message, IPPROTO_UDP);
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, qid, Rcode::REFUSED(), opcode.getCode(),
+                QR_FLAG, 1, 0, 0, 0);
+}
+
 TEST_F(AuthSrvTest, chQueryWithInMemoryClient) {
     // Set up the in-memory
     updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
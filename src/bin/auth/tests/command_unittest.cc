@@ -174,4 +174,30 @@ TEST_F(AuthCommandTest, getStats) {
     // statistics are done in its own tests.
     EXPECT_EQ(0, rcode_);
 }
+
+TEST_F(AuthCommandTest, getMemUsage) {
+    // Set up an in-memory cache with a zone.
+    const ConstElementPtr config(Element::fromJSON("{"
+        "\"IN\": [{"
+        "    \"type\": \"MasterFiles\","
+        "    \"params\": {"
+        "        \"example.com\": \"" TEST_DATA_DIR "/example.com.zone\""
+        "    },"
+        "    \"cache-enable\": true"
+        "}]}"));
+    server_.getDataSrcClientsMgr().setDataSrcClientLists(
+        configureDataSource(config));
+
+    result_ = execAuthServerCommand(server_, "getmemusage",
+                                    ConstElementPtr());
+    const ConstElementPtr usage = parseAnswer(rcode_, result_);
+    ASSERT_EQ(0, rcode_) << result_->str();
+    const ConstElementPtr datasrc_usage =
+        usage->get("IN")->get("MasterFiles");
+    ASSERT_TRUE(datasrc_usage);
+    EXPECT_EQ("local", datasrc_usage->get("segment-type")->stringValue());
+    EXPECT_LT(0, datasrc_usage->get("segment-in-use")->intValue());
+    EXPECT_LT(0, datasrc_usage->get("zones")->get("example.com.")->
+              get("total-size")->intValue());
+}
 }
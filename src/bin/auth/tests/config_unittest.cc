@@ -155,4 +155,38 @@ TEST_F(AuthConfigTest, tcpRecvTimeoutConfig) {
                  AuthConfigError);
 }
 
+// Try setting the number of query workers through config
+TEST_F(AuthConfigTest, queryWorkersConfig) {
+    EXPECT_EQ(0, server.getQueryWorkerCount());
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"query_workers\": 4 }"));
+    EXPECT_EQ(4, server.getQueryWorkerCount());
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"query_workers\": 0 }"));
+    EXPECT_EQ(0, server.getQueryWorkerCount());
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"query_workers\": -1 }")),
+                 AuthConfigError);
+    EXPECT_EQ(0, server.getQueryWorkerCount());
+
+    // Without workers, UDP servers are created in the main DNS service
+    // as before.
+    bundy::testutils::portconfig::listenAddressConfig(server);
+    EXPECT_EQ(2, dnss_.getUDPFdParams().size());
+}
+
+TEST_F(AuthConfigTest, responseCacheSizeConfig) {
+    EXPECT_EQ(0, server.getResponseCacheSize());
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"response_cache_size\": 1024 }"));
+    EXPECT_EQ(1024, server.getResponseCacheSize());
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"response_cache_size\": 0 }"));
+    EXPECT_EQ(0, server.getResponseCacheSize());
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"response_cache_size\": -1 }")),
+                 AuthConfigError);
+    EXPECT_EQ(0, server.getResponseCacheSize());
+}
+
 }
@@ -59,9 +59,10 @@ protected:
     DataSrcClientsBuilderTest() :
         clients_map(new std::map<RRClass,
                     boost::shared_ptr<ConfigurableClientList> >),
-        write_end(-1), read_end(-1),
+        write_end(-1), read_end(-1), generation(0),
         builder(&command_queue, &callback_queue, &cond, &queue_mutex,
-                &clients_map, &map_mutex, generateSockets()),
+                &clients_map, &map_mutex, &epoch, &generation,
+                generateSockets()),
         cond(command_queue, delayed_command_queue), rrclass(RRClass::IN()),
         shutdown_cmd(SHUTDOWN, ConstElementPtr(), FinishedCallback()),
         noop_cmd(NOOP, ConstElementPtr(), FinishedCallback())
@@ -83,6 +84,8 @@ protected:
     std::list<Command> delayed_command_queue; // commands available after wait
     std::list<FinishedCallback> callback_queue; // Callbacks from commands
     int write_end, read_end;
+    uint32_t generation;
+    bundy::util::thread::EpochManager epoch;
     TestDataSrcClientsBuilder builder;
     TestCondVar cond;
     TestMutex queue_mutex;
@@ -236,6 +239,8 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_TRUE(builder.handleCommand(reconfig_cmd));
     EXPECT_EQ(1, clients_map->size());
     EXPECT_EQ(1, map_mutex.lock_count);
+    // The data generation should have been updated with the lists
+    EXPECT_EQ(1, generation);
 
     // Store the nonempty clients map we now have
     ClientListMapPtr working_config_clients(clients_map);
@@ -264,6 +269,8 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_TRUE(builder.handleCommand(reconfig_cmd));
     EXPECT_EQ(working_config_clients, clients_map);
     EXPECT_EQ(1, map_mutex.lock_count);
+    // None of the failures should have changed the generation
+    EXPECT_EQ(1, generation);
 
     // Reconfigure again with the same good clients, the result should
     // be a different map than the original, but not an empty one.
@@ -278,6 +285,7 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_TRUE(builder.handleCommand(reconfig_cmd));
     EXPECT_EQ(0, clients_map->size());
     EXPECT_EQ(3, map_mutex.lock_count);
+    EXPECT_EQ(3, generation);
 
     // Also check if it has been cleanly unlocked every time
     EXPECT_EQ(3, map_mutex.unlock_count);
@@ -434,12 +442,15 @@ DataSrcClientsBuilderTest::checkLoadOrUpdateZone(CommandID cmdid) {
                           "{\"class\": \"IN\","
                           " \"origin\": \"example.org\"}"),
                       FinishedCallback());
+    const uint32_t orig_generation = generation;
     EXPECT_TRUE(builder.handleCommand(cmd));
     // And now it should be present too.
     EXPECT_EQ(ZoneFinder::SUCCESS,
               clients_map->find(rrclass)->second->
               find(Name("example.org")).finder_->
               find(Name("www.example.org"), RRType::A())->code);
+    // Installing the new version updates the data generation.
+    EXPECT_EQ(orig_generation + 1, generation);
 
     // An error case: the zone has no configuration. (note .com here)
     const Command nozone_cmd(cmdid, Element::fromJSON(
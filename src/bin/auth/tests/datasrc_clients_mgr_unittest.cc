@@ -158,12 +158,10 @@ TEST(DataSrcClientsMgrTest, holder) {
         EXPECT_FALSE(holder.findClientList(RRClass::IN()));
         EXPECT_FALSE(holder.findClientList(RRClass::CH()));
         EXPECT_TRUE(holder.getClasses().empty());
-        // map should be protected here
-        EXPECT_EQ(1, FakeDataSrcClientsBuilder::map_mutex->lock_count);
-        EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->unlock_count);
+        // The holder is lock-free unless it finds a list containing
+        // a non-cached data source.
+        EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->lock_count);
     }
-    // map lock has been released
-    EXPECT_EQ(1, FakeDataSrcClientsBuilder::map_mutex->unlock_count);
 
     // Put something in, that should become visible.
     ConstElementPtr reconfigure_arg = Element::fromJSON(
@@ -177,6 +175,8 @@ TEST(DataSrcClientsMgrTest, holder) {
         EXPECT_TRUE(holder.findClientList(RRClass::IN()));
         EXPECT_TRUE(holder.findClientList(RRClass::CH()));
         EXPECT_EQ(2, holder.getClasses().size());
+        // All data sources are cached, so still no lock is needed.
+        EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->lock_count);
     }
     // We need to clear command queue by hand
     FakeDataSrcClientsBuilder::command_queue->clear();
@@ -194,10 +194,41 @@ TEST(DataSrcClientsMgrTest, holder) {
         EXPECT_EQ(RRClass::IN(), holder.getClasses()[0]);
     }
 
+    // Holders can be nested as long as they don't need the lock.
+    {
+        TestDataSrcClientsMgr::Holder holder1(mgr);
+        TestDataSrcClientsMgr::Holder holder2(mgr);
+        EXPECT_TRUE(holder1.findClientList(RRClass::IN()));
+        EXPECT_TRUE(holder2.findClientList(RRClass::IN()));
+    }
+    FakeDataSrcClientsBuilder::command_queue->clear();
+
+    // If a list contains a non-cached data source, the holder acquires the
+    // lock on finding it, and keeps it until it's destroyed.
+    reconfigure_arg = Element::fromJSON(
+        "{\"IN\": [{\"type\": \"sqlite3\","
+        "           \"params\": {\"database_file\": \"" TEST_DATA_DIR
+        "/example.sqlite3\"}, \"cache-enable\": false}]}");
+    mgr.reconfigure(reconfigure_arg);
+    {
+        TestDataSrcClientsMgr::Holder holder(mgr);
+        EXPECT_FALSE(holder.findClientList(RRClass::CH()));
+        EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->lock_count);
+        EXPECT_TRUE(holder.findClientList(RRClass::IN()));
+        EXPECT_EQ(1, FakeDataSrcClientsBuilder::map_mutex->lock_count);
+        // Once locked, it won't try to lock it twice.
+        EXPECT_TRUE(holder.findClientList(RRClass::IN()));
+        EXPECT_EQ(1, FakeDataSrcClientsBuilder::map_mutex->lock_count);
+        EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->unlock_count);
+    }
+    EXPECT_EQ(1, FakeDataSrcClientsBuilder::map_mutex->unlock_count);
+
     // Duplicate lock acquisition is prohibited (only test mgr can detect
     // this reliably, so this test may not be that useful)
     TestDataSrcClientsMgr::Holder holder1(mgr);
-    EXPECT_THROW(TestDataSrcClientsMgr::Holder holder2(mgr), bundy::Unexpected);
+    holder1.findClientList(RRClass::IN());
+    TestDataSrcClientsMgr::Holder holder2(mgr);
+    EXPECT_THROW(holder2.findClientList(RRClass::IN()), bundy::Unexpected);
 }
 
 namespace {
@@ -0,0 +1,318 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <auth/auth_srv.h>
+#include <auth/query_workers.h>
+
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <dns/tsig.h>
+#include <dns/tsigkey.h>
+
+#include <util/buffer.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+#include <util/unittests/mock_socketsession.h>
+#include <testutils/mockups.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace bundy::dns;
+using namespace bundy::util;
+using namespace bundy::auth;
+using namespace bundy::asiodns;
+using namespace bundy::testutils;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
+using bundy::util::unittests::MockSocketSessionForwarder;
+
+namespace {
+
+class QueryWorkersTest : public ::testing::Test {
+protected:
+    QueryWorkersTest() :
+        server_(xfrout_, ddns_forwarder_),
+        workers_(server_, dnss_),
+        server_fd_(-1), client_fd_(-1)
+    {
+        // Open a UDP socket on an ephemeral port of the loopback address,
+        // which will be served by the workers, and the client socket.
+        std::memset(&server_addr_, 0, sizeof(server_addr_));
+        server_addr_.sin_family = AF_INET;
+        server_addr_.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        server_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        EXPECT_NE(-1, server_fd_);
+        EXPECT_EQ(0, bind(server_fd_,
+                          reinterpret_cast<const sockaddr*>(&server_addr_),
+                          sizeof(server_addr_)));
+        socklen_t addr_len = sizeof(server_addr_);
+        EXPECT_EQ(0, getsockname(server_fd_,
+                                 reinterpret_cast<sockaddr*>(&server_addr_),
+                                 &addr_len));
+
+        client_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+        EXPECT_NE(-1, client_fd_);
+        // Don't block forever if the workers don't respond
+        const struct timeval tv = { 5, 0 };
+        EXPECT_EQ(0, setsockopt(client_fd_, SOL_SOCKET, SO_RCVTIMEO, &tv,
+                                sizeof(tv)));
+    }
+
+    ~QueryWorkersTest() {
+        workers_.clearServers();
+        if (client_fd_ != -1) {
+            close(client_fd_);
+        }
+    }
+
+    // Send a query for the given qid and return the Rcode of the response
+    // (or throw if there's no valid response).  If the TSIG context is
+    // given, the query is signed and the response is verified with it.
+    Rcode sendQuery(qid_t qid, TSIGContext* tsig_ctx = NULL) {
+        Message query(Message::RENDER);
+        query.setQid(qid);
+        query.setOpcode(Opcode::QUERY());
+        query.setRcode(Rcode::NOERROR());
+        query.addQuestion(Question(Name("example.com"), RRClass::IN(),
+                                   RRType::A()));
+        MessageRenderer renderer;
+        query.toWire(renderer, tsig_ctx);
+        EXPECT_EQ(static_cast<ssize_t>(renderer.getLength()),
+                  sendto(client_fd_, renderer.getData(), renderer.getLength(),
+                         0, reinterpret_cast<const sockaddr*>(&server_addr_),
+                         sizeof(server_addr_)));
+
+        uint8_t data[512];
+        const ssize_t len = recv(client_fd_, data, sizeof(data), 0);
+        EXPECT_LT(0, len);
+        InputBuffer buffer(data, len > 0 ? len : 0);
+        Message response(Message::PARSE);
+        response.fromWire(buffer);
+        EXPECT_EQ(qid, response.getQid());
+        EXPECT_TRUE(response.getHeaderFlag(Message::HEADERFLAG_QR));
+        if (tsig_ctx != NULL) {
+            EXPECT_EQ(TSIGError::NOERROR(),
+                      tsig_ctx->verify(response.getTSIGRecord(), data, len));
+        }
+        return (response.getRcode());
+    }
+
+    MockDNSService dnss_;
+    MockXfroutClient xfrout_;
+    MockSocketSessionForwarder ddns_forwarder_;
+    AuthSrv server_;
+    QueryWorkers workers_;
+    struct sockaddr_in server_addr_;
+    int server_fd_;
+    int client_fd_;
+};
+
+// Without workers everything is passed to the main service.
+TEST_F(QueryWorkersTest, noWorkers) {
+    EXPECT_EQ(0, workers_.getWorkerCount());
+    workers_.addServerTCPFromFD(42, AF_INET);
+    workers_.addServerUDPFromFD(server_fd_, AF_INET,
+                                DNSService::SERVER_SYNC_OK);
+    ASSERT_EQ(1, dnss_.getTCPFdParams().size());
+    EXPECT_EQ(42, dnss_.getTCPFdParams().at(0).first);
+    ASSERT_EQ(1, dnss_.getUDPFdParams().size());
+    EXPECT_EQ(server_fd_, dnss_.getUDPFdParams().at(0).fd);
+    EXPECT_EQ(DNSService::SERVER_SYNC_OK,
+              dnss_.getUDPFdParams().at(0).options);
+
+    workers_.setTCPRecvTimeout(1234);
+    EXPECT_EQ(1234, dnss_.getTCPRecvTimeout());
+
+    // The socket wasn't taken over by anyone in this case.
+    close(server_fd_);
+}
+
+// Queries are answered by the worker threads.
+TEST_F(QueryWorkersTest, serveQueries) {
+    workers_.setWorkerCount(3);
+    EXPECT_EQ(3, workers_.getWorkerCount());
+    workers_.addServerUDPFromFD(server_fd_, AF_INET,
+                                DNSService::SERVER_SYNC_OK);
+    // TCP servers still go to the main service; UDP ones don't.
+    workers_.addServerTCPFromFD(42, AF_INET);
+    EXPECT_EQ(1, dnss_.getTCPFdParams().size());
+    EXPECT_TRUE(dnss_.getUDPFdParams().empty());
+
+    // There's no data source, so the queries should be refused.  Whichever
+    // worker handles it, the responses should be counted in the statistics.
+    for (qid_t qid = 0; qid < 10; ++qid) {
+        EXPECT_EQ(Rcode::REFUSED(), sendQuery(qid));
+    }
+    workers_.clearServers();
+    EXPECT_EQ(10, server_.getStatistics()->get("zones")->get("_SERVER_")->
+              get("responses")->intValue());
+
+    // The count can be changed only after the servers are cleared.
+    workers_.setWorkerCount(1);
+    EXPECT_EQ(1, workers_.getWorkerCount());
+}
+
+// Replaces the keyring with a new one holding the same key, like the
+// configuration updates do, until it's stopped.
+class KeyringReloader {
+public:
+    KeyringReloader(boost::shared_ptr<TSIGKeyRing>& keyring, Mutex& mutex,
+                    const TSIGKey& key) :
+        keyring_(keyring), mutex_(mutex), key_(key), stopped_(false),
+        reloads_(0)
+    {}
+
+    void run() {
+        while (true) {
+            boost::shared_ptr<TSIGKeyRing> load(new TSIGKeyRing);
+            load->add(key_);
+            Mutex::Locker locker(mutex_);
+            if (stopped_) {
+                return;
+            }
+            keyring_.swap(load);
+            ++reloads_;
+            // The old keyring is released here, still with the lock held,
+            // to make the window for a reader using it as wide as possible.
+        }
+    }
+
+    size_t stop() {
+        Mutex::Locker locker(mutex_);
+        stopped_ = true;
+        return (reloads_);
+    }
+
+private:
+    boost::shared_ptr<TSIGKeyRing>& keyring_;
+    Mutex& mutex_;
+    const TSIGKey key_;
+    bool stopped_;
+    size_t reloads_;
+};
+
+// The keyring can be replaced while the workers verify signed queries.
+TEST_F(QueryWorkersTest, reloadKeyringWhileServing) {
+    const TSIGKey key("key.example:c2VjcmV0Cg==:hmac-sha1");
+    boost::shared_ptr<TSIGKeyRing> keyring(new TSIGKeyRing);
+    keyring->add(key);
+    Mutex keyring_mutex;
+    server_.setTSIGKeyRing(&keyring, &keyring_mutex);
+
+    workers_.setWorkerCount(3);
+    workers_.addServerUDPFromFD(server_fd_, AF_INET,
+                                DNSService::SERVER_SYNC_OK);
+
+    KeyringReloader reloader(keyring, keyring_mutex, key);
+    Thread reloader_thread(boost::bind(&KeyringReloader::run, &reloader));
+    // Every query is verified with the key, whichever keyring it's found in.
+    for (qid_t qid = 0; qid < 100; ++qid) {
+        TSIGContext context(key);
+        EXPECT_EQ(Rcode::REFUSED(), sendQuery(qid, &context));
+    }
+    EXPECT_LT(0, reloader.stop());
+    reloader_thread.wait();
+    workers_.clearServers();
+}
+
+// Collects the statistics of the server, like the statistics daemon does,
+// until it's stopped.  It checks the number of responses never decreases.
+class StatisticsReader {
+public:
+    StatisticsReader(const AuthSrv& server) :
+        server_(server), stopped_(false), reads_(0), decreased_(false)
+    {}
+
+    void run() {
+        int64_t last = 0;
+        while (true) {
+            const int64_t responses = server_.getStatistics()->
+                get("zones")->get("_SERVER_")->get("responses")->intValue();
+            Mutex::Locker locker(mutex_);
+            if (stopped_) {
+                return;
+            }
+            decreased_ = decreased_ || (responses < last);
+            last = responses;
+            ++reads_;
+        }
+    }
+
+    size_t stop() {
+        Mutex::Locker locker(mutex_);
+        stopped_ = true;
+        return (reads_);
+    }
+
+    bool decreased() {
+        Mutex::Locker locker(mutex_);
+        return (decreased_);
+    }
+
+private:
+    const AuthSrv& server_;
+    Mutex mutex_;
+    bool stopped_;
+    size_t reads_;
+    bool decreased_;
+};
+
+// The statistics can be collected while the workers update the counters.
+TEST_F(QueryWorkersTest, getStatisticsWhileServing) {
+    workers_.setWorkerCount(3);
+    workers_.addServerUDPFromFD(server_fd_, AF_INET,
+                                DNSService::SERVER_SYNC_OK);
+
+    StatisticsReader reader(server_);
+    Thread reader_thread(boost::bind(&StatisticsReader::run, &reader));
+    for (qid_t qid = 0; qid < 100; ++qid) {
+        EXPECT_EQ(Rcode::REFUSED(), sendQuery(qid));
+    }
+    EXPECT_LT(0, reader.stop());
+    reader_thread.wait();
+    EXPECT_FALSE(reader.decreased());
+    workers_.clearServers();
+    EXPECT_EQ(100, server_.getStatistics()->get("zones")->get("_SERVER_")->
+              get("responses")->intValue());
+}
+
+TEST_F(QueryWorkersTest, setWorkerCountWhileRunning) {
+    workers_.setWorkerCount(2);
+    workers_.addServerUDPFromFD(server_fd_, AF_INET,
+                                DNSService::SERVER_SYNC_OK);
+    EXPECT_THROW(workers_.setWorkerCount(1), bundy::InvalidOperation);
+    EXPECT_EQ(2, workers_.getWorkerCount());
+}
+
+}
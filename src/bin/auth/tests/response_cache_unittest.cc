@@ -0,0 +1,184 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <auth/response_cache.h>
+
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+
+#include <exceptions/exceptions.h>
+#include <util/buffer.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace bundy::dns;
+using namespace bundy::util;
+using bundy::auth::ResponseCache;
+
+namespace {
+
+class ResponseCacheTest : public ::testing::Test {
+protected:
+    ResponseCacheTest() :
+        cache_(16),
+        question_(Name("www.example.com"), RRClass::IN(), RRType::A()),
+        buffer_(0)
+    {
+        // Render a response for the question (its content doesn't matter
+        // for the cache, but we use a real response for readability).
+        Message response(Message::RENDER);
+        response.setQid(1234);
+        response.setOpcode(Opcode::QUERY());
+        response.setRcode(Rcode::NOERROR());
+        response.setHeaderFlag(Message::HEADERFLAG_QR);
+        response.setHeaderFlag(Message::HEADERFLAG_AA);
+        response.addQuestion(question_);
+        MessageRenderer renderer;
+        response.toWire(renderer);
+        const uint8_t* const cp =
+            static_cast<const uint8_t*>(renderer.getData());
+        response_.assign(cp, cp + renderer.getLength());
+    }
+
+    void insert(const Question& question, unsigned int options = 0,
+                uint16_t max_length = 512, uint32_t generation = 0)
+    {
+        cache_.insert(question, options, max_length, generation,
+                      &response_[0], response_.size());
+    }
+
+    bool lookup(const Question& question, unsigned int options = 0,
+                uint16_t max_length = 512, uint32_t generation = 0,
+                qid_t qid = 1234)
+    {
+        return (cache_.lookup(question, options, max_length, generation, qid,
+                              buffer_));
+    }
+
+    ResponseCache cache_;
+    const Question question_;
+    std::vector<uint8_t> response_;
+    OutputBuffer buffer_;
+};
+
+TEST_F(ResponseCacheTest, disabled) {
+    ResponseCache cache;
+    EXPECT_EQ(0, cache.getSize());
+    cache.insert(question_, 0, 512, 0, &response_[0], response_.size());
+    EXPECT_FALSE(cache.lookup(question_, 0, 512, 0, 1234, buffer_));
+}
+
+TEST_F(ResponseCacheTest, lookup) {
+    EXPECT_FALSE(lookup(question_));
+    insert(question_);
+    ASSERT_TRUE(lookup(question_));
+    ASSERT_EQ(response_.size(), buffer_.getLength());
+    EXPECT_EQ(0, std::memcmp(&response_[0], buffer_.getData(),
+                             response_.size()));
+
+    // A different question shouldn't match.
+    EXPECT_FALSE(lookup(Question(Name("www.example.com"), RRClass::IN(),
+                                 RRType::AAAA())));
+    EXPECT_FALSE(lookup(Question(Name("www.example.com"), RRClass::CH(),
+                                 RRType::A())));
+    EXPECT_FALSE(lookup(Question(Name("example.com"), RRClass::IN(),
+                                 RRType::A())));
+}
+
+TEST_F(ResponseCacheTest, failedLookupKeepsBuffer) {
+    buffer_.writeUint32(42);
+    EXPECT_FALSE(lookup(question_));
+    EXPECT_EQ(sizeof(uint32_t), buffer_.getLength());
+}
+
+TEST_F(ResponseCacheTest, queryIDAndCase) {
+    insert(question_);
+    const Question question(Name("WWW.Example.COM"), RRClass::IN(),
+                            RRType::A());
+    ASSERT_TRUE(lookup(question, 0, 512, 0, 0x5678));
+
+    // The response should be parsed as a response to the query, with the
+    // ID and the case of the query name of the query.
+    InputBuffer ibuffer(buffer_.getData(), buffer_.getLength());
+    Message parsed(Message::PARSE);
+    parsed.fromWire(ibuffer);
+    EXPECT_EQ(0x5678, parsed.getQid());
+    ASSERT_EQ(1, parsed.getRRCount(Message::SECTION_QUESTION));
+    EXPECT_EQ("WWW.Example.COM.",
+              (*parsed.beginQuestion())->getName().toText());
+    EXPECT_TRUE(parsed.getHeaderFlag(Message::HEADERFLAG_AA));
+}
+
+TEST_F(ResponseCacheTest, generation) {
+    insert(question_, 0, 512, 1);
+    EXPECT_TRUE(lookup(question_, 0, 512, 1));
+    EXPECT_FALSE(lookup(question_, 0, 512, 2));
+    EXPECT_FALSE(lookup(question_, 0, 512, 0));
+
+    // Inserting a response of the new generation replaces the old one.
+    insert(question_, 0, 512, 2);
+    EXPECT_TRUE(lookup(question_, 0, 512, 2));
+    EXPECT_FALSE(lookup(question_, 0, 512, 1));
+}
+
+TEST_F(ResponseCacheTest, parameters) {
+    insert(question_, ResponseCache::EDNS | ResponseCache::DNSSEC_OK, 4096);
+    EXPECT_TRUE(lookup(question_,
+                       ResponseCache::EDNS | ResponseCache::DNSSEC_OK, 4096));
+    EXPECT_FALSE(lookup(question_, ResponseCache::EDNS, 4096));
+    EXPECT_FALSE(lookup(question_,
+                        ResponseCache::EDNS | ResponseCache::DNSSEC_OK |
+                        ResponseCache::RECURSION_DESIRED, 4096));
+    EXPECT_FALSE(lookup(question_,
+                        ResponseCache::EDNS | ResponseCache::DNSSEC_OK, 1232));
+}
+
+TEST_F(ResponseCacheTest, clearAndResize) {
+    insert(question_);
+    cache_.clear();
+    EXPECT_EQ(16, cache_.getSize());
+    EXPECT_FALSE(lookup(question_));
+
+    insert(question_);
+    cache_.setSize(32);
+    EXPECT_EQ(32, cache_.getSize());
+    EXPECT_FALSE(lookup(question_));
+    insert(question_);
+    EXPECT_TRUE(lookup(question_));
+
+    cache_.setSize(0);
+    insert(question_);
+    EXPECT_FALSE(lookup(question_));
+}
+
+TEST_F(ResponseCacheTest, tooShortResponse) {
+    // The data must at least contain the header and the query name.
+    EXPECT_THROW(cache_.insert(question_, 0, 512, 0, &response_[0],
+                               12 + question_.getName().getLength() - 1),
+                 bundy::InvalidParameter);
+    EXPECT_FALSE(lookup(question_));
+}
+
+}
@@ -35,6 +35,8 @@ TestMutex* FakeDataSrcClientsBuilder::queue_mutex = NULL;
 bundy::datasrc::ClientListMapPtr*
     FakeDataSrcClientsBuilder::clients_map = NULL;
 TestMutex* FakeDataSrcClientsBuilder::map_mutex = NULL;
+util::thread::EpochManager* FakeDataSrcClientsBuilder::epoch = NULL;
+uint32_t* FakeDataSrcClientsBuilder::generation = NULL;
 TestMutex FakeDataSrcClientsBuilder::queue_mutex_copy;
 bool FakeDataSrcClientsBuilder::thread_waited = false;
 FakeDataSrcClientsBuilder::ExceptionFromWait
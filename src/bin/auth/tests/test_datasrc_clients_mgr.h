@@ -143,6 +143,8 @@ public:
     static int wakeup_fd;
     static bundy::datasrc::ClientListMapPtr* clients_map;
     static TestMutex* map_mutex;
+    static util::thread::EpochManager* epoch;
+    static uint32_t* generation;
     static std::list<Command> command_queue_copy;
     static std::list<FinishedCallback> callback_queue_copy;
     static TestCondVar cond_copy;
@@ -162,7 +164,8 @@ public:
         TestCondVar* cond,
         TestMutex* queue_mutex,
         bundy::datasrc::ClientListMapPtr* clients_map,
-        TestMutex* map_mutex, int wakeup_fd)
+        TestMutex* map_mutex, util::thread::EpochManager* epoch,
+        uint32_t* generation, int wakeup_fd)
     {
         FakeDataSrcClientsBuilder::started = false;
         FakeDataSrcClientsBuilder::command_queue = command_queue;
@@ -172,6 +175,8 @@ public:
         FakeDataSrcClientsBuilder::wakeup_fd = wakeup_fd;
         FakeDataSrcClientsBuilder::clients_map = clients_map;
         FakeDataSrcClientsBuilder::map_mutex = map_mutex;
+        FakeDataSrcClientsBuilder::epoch = epoch;
+        FakeDataSrcClientsBuilder::generation = generation;
         FakeDataSrcClientsBuilder::thread_waited = false;
         FakeDataSrcClientsBuilder::thread_throw_on_wait = NOTHROW;
     }
@@ -14,8 +14,10 @@
 
 #include <config/ccsession.h>
 #include <dhcp4/dhcp4_log.h>
+#include <dhcp4/dhcp4_srv.h>
 #include <dhcp/libdhcp++.h>
 #include <dhcp/option_definition.h>
+#include <dhcpsrv/alloc_engine.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcp4/config_parser.h>
 #include <dhcpsrv/dbaccess_parser.h>
@@ -408,7 +410,8 @@ DhcpConfigParser* createGlobalDhcp4ConfigParser(const std::string& config_id) {
         parser  = new OptionDefListParser(config_id,
                                           globalContext()->option_defs_);
     } else if ((config_id.compare("version") == 0) ||
-               (config_id.compare("next-server") == 0)) {
+               (config_id.compare("next-server") == 0) ||
+               (config_id.compare("allocator") == 0)) {
         parser  = new StringParser(config_id,
                                     globalContext()->string_values_);
     } else if (config_id.compare("lease-database") == 0) {
@@ -443,7 +446,7 @@ void commitGlobalOptions() {
 }
 
 bundy::data::ConstElementPtr
-configureDhcp4Server(Dhcpv4Srv&, bundy::data::ConstElementPtr config_set) {
+configureDhcp4Server(Dhcpv4Srv& server, bundy::data::ConstElementPtr config_set) {
     if (!config_set) {
         ConstElementPtr answer = bundy::config::createAnswer(1,
                                  string("Can't parse NULL config"));
@@ -495,6 +498,9 @@ configureDhcp4Server(Dhcpv4Srv&, bundy::data::ConstElementPtr config_set) {
     // the parsers.  It is declared outside the loops so in case of an error,
     // the name of the failing parser can be retrieved in the "catch" clause.
     ConfigPair config_pair;
+    // The address allocation algorithm. It is the default one unless the
+    // configuration selects another.
+    AllocEngine::AllocType alloc_type = AllocEngine::ALLOC_ITERATIVE;
     try {
         // Make parsers grouping.
         const std::map<std::string, ConstElementPtr>& values_map =
@@ -545,6 +551,13 @@ configureDhcp4Server(Dhcpv4Srv&, bundy::data::ConstElementPtr config_set) {
             subnet_parser->build(subnet_config->second);
         }
 
+        // The allocation algorithm is resolved here so that an unknown
+        // name fails the configuration before anything is committed.
+        if (values_map.find("allocator") != values_map.end()) {
+            alloc_type = AllocEngine::allocTypeFromText(
+                globalContext()->string_values_->getParam("allocator"));
+        }
+
     } catch (const bundy::Exception& ex) {
         LOG_ERROR(dhcp4_logger, DHCP4_PARSER_FAIL)
                   .arg(config_pair.first).arg(ex.what());
@@ -581,6 +594,8 @@ configureDhcp4Server(Dhcpv4Srv&, bundy::data::ConstElementPtr config_set) {
             // Apply global options
             commitGlobalOptions();
 
+            server.setAllocType(alloc_type);
+
             // This occurs last as if it succeeds, there is no easy way
             // revert it.  As a result, the failure to commit a subsequent
             // change causes problems when trying to roll back.
@@ -45,8 +45,9 @@ class Dhcpv4Srv;
 /// this function returns appropriate error code.
 ///
 /// This function is called every time a new configuration is received. The
-/// extra parameter is a reference to DHCPv4 server component. It is currently
-/// not used and CfgMgr::instance() is accessed instead.
+/// extra parameter is a reference to DHCPv4 server component. It is used
+/// to select the address allocation algorithm ("allocator"); the rest of
+/// the configuration is stored in CfgMgr::instance().
 ///
 /// This method does not throw. It catches all exceptions and returns them as
 /// reconfiguration statuses. It may return the following response codes:
@@ -55,10 +56,11 @@ class Dhcpv4Srv;
 /// 2 - commit failed (parsing was successful, but failed to store the
 /// values in to server's configuration)
 ///
+/// @param server DHCPv4 server object.
 /// @param config_set a new configuration (JSON) for DHCPv4 server
 /// @return answer that contains result of reconfiguration
 bundy::data::ConstElementPtr
-configureDhcp4Server(Dhcpv4Srv&,
+configureDhcp4Server(Dhcpv4Srv& server,
                      bundy::data::ConstElementPtr config_set);
 
 /// @brief Returns the global context
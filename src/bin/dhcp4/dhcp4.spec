@@ -60,6 +60,12 @@
         "item_default": true
       },
 
+      { "item_name": "allocator",
+        "item_type": "string",
+        "item_optional": true,
+        "item_default": "iterative"
+      },
+
       { "item_name": "option-def",
         "item_type": "list",
         "item_optional": false,
@@ -197,6 +203,12 @@
                 "item_type": "boolean",
                 "item_optional": true,
                 "item_default": true
+            },
+            {
+                "item_name": "lfc-interval",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
             }
         ]
       },
@@ -82,6 +82,9 @@ namespace dhcp {
 
 const std::string Dhcpv4Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 
+const size_t Dhcpv4Srv::MAX_RECLAIMED_LEASES;
+const uint32_t Dhcpv4Srv::RECLAIM_INTERVAL;
+
 Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast,
                      const bool direct_response_desired)
 : shutdown_(true), alloc_engine_(), port_(port),
@@ -118,9 +121,9 @@ Dhcpv4Srv::Dhcpv4Srv(uint16_t port, const char* dbconfig, const bool use_bcast,
             .arg(LeaseMgrFactory::instance().getType())
             .arg(LeaseMgrFactory::instance().getName());
 
-        // Instantiate allocation engine
-        alloc_engine_.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100,
-                                            false /* false = IPv4 */));
+        // Instantiate allocation engine. The configuration may select
+        // another algorithm later.
+        setAllocType(AllocEngine::ALLOC_ITERATIVE);
 
         // Register hook points
         hook_index_pkt4_receive_   = Hooks.hook_index_pkt4_receive_;
@@ -148,6 +151,23 @@ Dhcpv4Srv::shutdown() {
     shutdown_ = true;
 }
 
+void
+Dhcpv4Srv::setAllocType(AllocEngine::AllocType alloc_type) {
+    if (alloc_engine_ && alloc_engine_->getAllocType() == alloc_type) {
+        return;
+    }
+    alloc_engine_.reset(new AllocEngine(alloc_type, 100,
+                                        false /* false = IPv4 */));
+}
+
+AllocEngine::AllocType
+Dhcpv4Srv::getAllocType() const {
+    if (!alloc_engine_) {
+        bundy_throw(InvalidOperation, "no allocation engine");
+    }
+    return (alloc_engine_->getAllocType());
+}
+
 Pkt4Ptr
 Dhcpv4Srv::receivePacket(int timeout) {
     return (IfaceMgr::instance().receive4(timeout));
@@ -160,11 +180,23 @@ Dhcpv4Srv::sendPacket(const Pkt4Ptr& packet) {
 
 bool
 Dhcpv4Srv::run() {
+    time_t next_reclaim_time = time(NULL) + RECLAIM_INTERVAL;
     while (!shutdown_) {
         /// @todo: calculate actual timeout once we have lease database
         //cppcheck-suppress variableScope This is temporary anyway
         const int timeout = 1000;
 
+        // Reclaim expired leases periodically. If the limit of reclaimed
+        // leases has been reached, there may be more of them, so continue
+        // at the next iteration, after processing a packet.
+        const time_t now = time(NULL);
+        if (now >= next_reclaim_time) {
+            if (reclaimExpiredLeases(MAX_RECLAIMED_LEASES) <
+                MAX_RECLAIMED_LEASES) {
+                next_reclaim_time = now + RECLAIM_INTERVAL;
+            }
+        }
+
         // client's message and server's response
         Pkt4Ptr query;
         Pkt4Ptr rsp;
@@ -429,6 +461,46 @@ Dhcpv4Srv::run() {
     return (true);
 }
 
+size_t
+Dhcpv4Srv::reclaimExpiredLeases(size_t max_leases) {
+    Lease4Collection leases;
+    try {
+        leases = LeaseMgrFactory::instance().getExpiredLeases4(max_leases);
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcp4_logger, DHCP4_RECLAIM_LEASES_FAIL).arg(ex.what());
+        return (0);
+    }
+
+    size_t reclaimed = 0;
+    for (Lease4Collection::const_iterator lease = leases.begin();
+         lease != leases.end(); ++lease) {
+        try {
+            if (!LeaseMgrFactory::instance().deleteLease((*lease)->addr_)) {
+                // The lease has been removed in the meantime.
+                continue;
+            }
+            alloc_engine_->leaseRemoved(Lease::TYPE_V4, (*lease)->addr_);
+            LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_LEASE_RECLAIMED)
+                .arg((*lease)->addr_.toText());
+            ++reclaimed;
+
+            if (CfgMgr::instance().ddnsEnabled()) {
+                // Remove existing DNS entries for the lease, if any.
+                queueNameChangeRequest(bundy::dhcp_ddns::CHG_REMOVE, *lease);
+            }
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcp4_logger, DHCP4_LEASE_RECLAIM_FAIL)
+                .arg((*lease)->addr_.toText()).arg(ex.what());
+        }
+    }
+
+    if (reclaimed > 0) {
+        LOG_DEBUG(dhcp4_logger, DBG_DHCP4_BASIC, DHCP4_LEASES_RECLAIMED)
+            .arg(reclaimed);
+    }
+    return (reclaimed);
+}
+
 string
 Dhcpv4Srv::srvidToString(const OptionPtr& srvid) {
     if (!srvid) {
@@ -1341,6 +1413,7 @@ Dhcpv4Srv::processRelease(Pkt4Ptr& release) {
 
             if (success) {
                 // Release successful
+                alloc_engine_->leaseRemoved(Lease::TYPE_V4, lease->addr_);
                 LOG_DEBUG(dhcp4_logger, DBG_DHCP4_DETAIL, DHCP4_RELEASE)
                     .arg(lease->addr_.toText())
                     .arg(client_id ? client_id->toText() : "(no client-id)")
@@ -108,6 +108,45 @@ public:
     /// @brief Instructs the server to shut down.
     void shutdown();
 
+    /// @brief Selects the address allocation algorithm.
+    ///
+    /// The allocation engine is replaced only if it uses a different
+    /// algorithm, so the state of the allocators is kept across
+    /// reconfigurations which don't change it.
+    ///
+    /// @param alloc_type allocation algorithm to use
+    void setAllocType(AllocEngine::AllocType alloc_type);
+
+    /// @brief Returns the address allocation algorithm in use.
+    ///
+    /// @throw InvalidOperation if the server has no allocation engine
+    AllocEngine::AllocType getAllocType() const;
+
+    /// @brief Maximum number of expired leases reclaimed in a single run.
+    static const size_t MAX_RECLAIMED_LEASES = 100;
+
+    /// @brief Interval between the runs of the expired leases reclamation
+    /// (in seconds).
+    static const uint32_t RECLAIM_INTERVAL = 10;
+
+    /// @brief Reclaims expired leases.
+    ///
+    /// The expired leases, the ones which expired first, are removed from
+    /// the lease database and the allocation engine is notified. If the
+    /// server performed DNS updates for a lease, a request to remove the
+    /// DNS entries is sent to bundy-dhcp-ddns.
+    ///
+    /// This is called from the main processing loop every
+    /// @c RECLAIM_INTERVAL seconds, or at each iteration while the number
+    /// of reclaimed leases reaches the limit, so a large number of expired
+    /// leases doesn't delay the processing of client messages much.
+    ///
+    /// @param max_leases Maximum number of leases to be reclaimed, 0 for
+    /// no limit.
+    ///
+    /// @return The number of reclaimed leases.
+    size_t reclaimExpiredLeases(size_t max_leases);
+
     /// @brief Return textual type of packet received by server
     ///
     /// Returns the name of valid packet received by the server (e.g. DISCOVER).
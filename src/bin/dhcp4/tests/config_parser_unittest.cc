@@ -1012,6 +1012,56 @@ TEST_F(Dhcp4ParserTest, echoClientId) {
     CfgMgr::instance().echoClientId(true);
 }
 
+// Check that the address allocation algorithm can be selected and that the
+// server uses it.
+TEST_F(Dhcp4ParserTest, allocator) {
+    ConstElementPtr status;
+
+    const string config_prefix = "{ \"interfaces\": [ \"*\" ],"
+        "\"rebind-timer\": 2000, "
+        "\"renew-timer\": 1000, ";
+    const string config_suffix = "\"subnet4\": [ { "
+        "    \"pool\": [ \"192.0.2.1 - 192.0.2.100\" ],"
+        "    \"subnet\": \"192.0.2.0/24\" } ],"
+        "\"valid-lifetime\": 4000 }";
+
+    // The iterative allocator is the default.
+    EXPECT_EQ(AllocEngine::ALLOC_ITERATIVE, srv_->getAllocType());
+
+    const char* names[] = { "bitmap", "hashed", "random", "iterative" };
+    const AllocEngine::AllocType types[] = {
+        AllocEngine::ALLOC_BITMAP, AllocEngine::ALLOC_HASHED,
+        AllocEngine::ALLOC_RANDOM, AllocEngine::ALLOC_ITERATIVE
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        SCOPED_TRACE(names[i]);
+        ElementPtr json = Element::fromJSON(config_prefix +
+                                            "\"allocator\": \"" + names[i] +
+                                            "\", " + config_suffix);
+        EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+        checkResult(status, 0);
+        EXPECT_EQ(types[i], srv_->getAllocType());
+    }
+
+    // An unknown allocator is rejected and the current one is kept.
+    ElementPtr json = Element::fromJSON(config_prefix +
+                                        "\"allocator\": \"bitmap\", " +
+                                        config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    json = Element::fromJSON(config_prefix + "\"allocator\": \"bogus\", " +
+                             config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 1);
+    EXPECT_EQ(AllocEngine::ALLOC_BITMAP, srv_->getAllocType());
+
+    // Without the parameter the default allocator is used.
+    json = Element::fromJSON(config_prefix + config_suffix);
+    EXPECT_NO_THROW(status = configureDhcp4Server(*srv_, json));
+    checkResult(status, 0);
+    EXPECT_EQ(AllocEngine::ALLOC_ITERATIVE, srv_->getAllocType());
+}
+
 // This test checks if it is possible to override global values
 // on a per subnet basis.
 TEST_F(Dhcp4ParserTest, subnetLocal) {
@@ -1322,6 +1322,49 @@ TEST_F(Dhcpv4SrvTest, ReleaseReject) {
     EXPECT_FALSE(l);
 }
 
+// This test verifies that the expired leases are reclaimed, the ones
+// which expired first, and that the valid leases are left intact.
+TEST_F(Dhcpv4SrvTest, reclaimExpiredLeases) {
+    boost::scoped_ptr<NakedDhcpv4Srv> srv;
+    ASSERT_NO_THROW(srv.reset(new NakedDhcpv4Srv(0)));
+
+    uint8_t mac_addr[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe};
+    const uint32_t valid = 100;
+
+    // Create 4 leases, the first 3 of them expired, the first one most
+    // recently, and the last one still valid.
+    const char* addresses[] = { "192.0.2.100", "192.0.2.101",
+                                "192.0.2.102", "192.0.2.103" };
+    const time_t cltt[] = { time(NULL) - valid - 10,
+                            time(NULL) - valid - 30,
+                            time(NULL) - valid - 20,
+                            time(NULL) - 10 };
+    for (int i = 0; i < 4; ++i) {
+        Lease4Ptr lease(new Lease4(IOAddress(addresses[i]), mac_addr,
+                                   sizeof(mac_addr),
+                                   &client_id_->getDuid()[0],
+                                   client_id_->getDuid().size(),
+                                   valid, 50, 75, cltt[i],
+                                   subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    // Reclaim at most 2 leases. The ones which expired first should be
+    // removed.
+    EXPECT_EQ(2, srv->reclaimExpiredLeases(2));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(IOAddress(addresses[0])));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(IOAddress(addresses[1])));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(IOAddress(addresses[2])));
+
+    // Reclaim the remaining expired lease.
+    EXPECT_EQ(1, srv->reclaimExpiredLeases(Dhcpv4Srv::MAX_RECLAIMED_LEASES));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease4(IOAddress(addresses[0])));
+
+    // The valid lease must be left intact.
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease4(IOAddress(addresses[3])));
+    EXPECT_EQ(0, srv->reclaimExpiredLeases(Dhcpv4Srv::MAX_RECLAIMED_LEASES));
+}
+
 // Checks if received relay agent info option is echoed back to the client
 TEST_F(Dhcpv4SrvTest, relayAgentInfoEcho) {
     IfaceMgrTestConfig test_config(true);
@@ -18,7 +18,9 @@
 #include <dhcp/libdhcp++.h>
 #include <dhcp6/config_parser.h>
 #include <dhcp6/dhcp6_log.h>
+#include <dhcp6/dhcp6_srv.h>
 #include <dhcp/iface_mgr.h>
+#include <dhcpsrv/alloc_engine.h>
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dbaccess_parser.h>
 #include <dhcpsrv/dhcp_config_parser.h>
@@ -639,7 +641,8 @@ DhcpConfigParser* createGlobal6DhcpConfigParser(const std::string& config_id) {
     } else if (config_id.compare("option-def") == 0) {
         parser  = new OptionDefListParser(config_id,
                                           globalContext()->option_defs_);
-    } else if (config_id.compare("version") == 0) {
+    } else if ((config_id.compare("version") == 0) ||
+               (config_id.compare("allocator") == 0)) {
         parser  = new StringParser(config_id,
                                    globalContext()->string_values_);
     } else if (config_id.compare("lease-database") == 0) {
@@ -658,7 +661,7 @@ DhcpConfigParser* createGlobal6DhcpConfigParser(const std::string& config_id) {
 }
 
 bundy::data::ConstElementPtr
-configureDhcp6Server(Dhcpv6Srv&, bundy::data::ConstElementPtr config_set) {
+configureDhcp6Server(Dhcpv6Srv& server, bundy::data::ConstElementPtr config_set) {
     if (!config_set) {
         ConstElementPtr answer = bundy::config::createAnswer(1,
                                  string("Can't parse NULL config"));
@@ -710,6 +713,9 @@ configureDhcp6Server(Dhcpv6Srv&, bundy::data::ConstElementPtr config_set) {
     // the parsers.  It is declared outside the loop so in case of error, the
     // name of the failing parser can be retrieved within the "catch" clause.
     ConfigPair config_pair;
+    // The address allocation algorithm. It is the default one unless the
+    // configuration selects another.
+    AllocEngine::AllocType alloc_type = AllocEngine::ALLOC_ITERATIVE;
     try {
 
         // Make parsers grouping.
@@ -762,6 +768,13 @@ configureDhcp6Server(Dhcpv6Srv&, bundy::data::ConstElementPtr config_set) {
             subnet_parser->build(subnet_config->second);
         }
 
+        // The allocation algorithm is resolved here so that an unknown
+        // name fails the configuration before anything is committed.
+        if (values_map.find("allocator") != values_map.end()) {
+            alloc_type = AllocEngine::allocTypeFromText(
+                globalContext()->string_values_->getParam("allocator"));
+        }
+
     } catch (const bundy::Exception& ex) {
         LOG_ERROR(dhcp6_logger, DHCP6_PARSER_FAIL)
                   .arg(config_pair.first).arg(ex.what());
@@ -793,6 +806,8 @@ configureDhcp6Server(Dhcpv6Srv&, bundy::data::ConstElementPtr config_set) {
                 iface_parser->commit();
             }
 
+            server.setAllocType(alloc_type);
+
             // This occurs last as if it succeeds, there is no easy way to
             // revert it.  As a result, the failure to commit a subsequent
             // change causes problems when trying to roll back.
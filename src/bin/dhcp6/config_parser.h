@@ -32,8 +32,9 @@ class Dhcpv6Srv;
 /// @brief Configures DHCPv6 server
 ///
 /// This function is called every time a new configuration is received. The
-/// extra parameter is a reference to DHCPv6 server component. It is currently
-/// not used and CfgMgr::instance() is accessed instead.
+/// extra parameter is a reference to DHCPv6 server component. It is used
+/// to select the address allocation algorithm ("allocator"); the rest of
+/// the configuration is stored in CfgMgr::instance().
 ///
 /// This method does not throw. It catches all exceptions and returns them as
 /// reconfiguration statuses. It may return the following response codes:
@@ -54,6 +54,12 @@
         "item_default": 4000
       },
 
+      { "item_name": "allocator",
+        "item_type": "string",
+        "item_optional": true,
+        "item_default": "iterative"
+      },
+
       { "item_name": "option-def",
         "item_type": "list",
         "item_optional": false,
@@ -191,6 +197,12 @@
                 "item_type": "boolean",
                 "item_optional": true,
                 "item_default": true
+            },
+            {
+                "item_name": "lfc-interval",
+                "item_type": "integer",
+                "item_optional": true,
+                "item_default": 0
             }
         ]
       },
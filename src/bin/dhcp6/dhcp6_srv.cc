@@ -104,6 +104,9 @@ namespace dhcp {
 
 const std::string Dhcpv6Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 
+const size_t Dhcpv6Srv::MAX_RECLAIMED_LEASES;
+const uint32_t Dhcpv6Srv::RECLAIM_INTERVAL;
+
 /// @brief file name of a server-id file
 ///
 /// Server must store its duid in persistent storage that must not change
@@ -156,8 +159,9 @@ Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
             }
         }
 
-        // Instantiate allocation engine
-        alloc_engine_.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100));
+        // Instantiate allocation engine. The configuration may select
+        // another algorithm later.
+        setAllocType(AllocEngine::ALLOC_ITERATIVE);
 
         /// @todo call loadLibraries() when handling configuration changes
 
@@ -181,6 +185,20 @@ void Dhcpv6Srv::shutdown() {
     shutdown_ = true;
 }
 
+void Dhcpv6Srv::setAllocType(AllocEngine::AllocType alloc_type) {
+    if (alloc_engine_ && alloc_engine_->getAllocType() == alloc_type) {
+        return;
+    }
+    alloc_engine_.reset(new AllocEngine(alloc_type, 100));
+}
+
+AllocEngine::AllocType Dhcpv6Srv::getAllocType() const {
+    if (!alloc_engine_) {
+        bundy_throw(InvalidOperation, "no allocation engine");
+    }
+    return (alloc_engine_->getAllocType());
+}
+
 Pkt6Ptr Dhcpv6Srv::receivePacket(int timeout) {
     return (IfaceMgr::instance().receive6(timeout));
 }
@@ -235,6 +253,7 @@ Dhcpv6Srv::testUnicast(const Pkt6Ptr& pkt) const {
 }
 
 bool Dhcpv6Srv::run() {
+    time_t next_reclaim_time = time(NULL) + RECLAIM_INTERVAL;
     while (!shutdown_) {
         /// @todo Calculate actual timeout to the next event (e.g. lease
         /// expiration) once we have lease database. The idea here is that
@@ -245,6 +264,17 @@ bool Dhcpv6Srv::run() {
         //cppcheck-suppress variableScope This is temporary anyway
         const int timeout = 1000;
 
+        // Reclaim expired leases periodically. If the limit of reclaimed
+        // leases has been reached, there may be more of them, so continue
+        // at the next iteration, after processing a packet.
+        const time_t now = time(NULL);
+        if (now >= next_reclaim_time) {
+            if (reclaimExpiredLeases(MAX_RECLAIMED_LEASES) <
+                MAX_RECLAIMED_LEASES) {
+                next_reclaim_time = now + RECLAIM_INTERVAL;
+            }
+        }
+
         // client's message and server's response
         Pkt6Ptr query;
         Pkt6Ptr rsp;
@@ -560,6 +590,44 @@ bool Dhcpv6Srv::loadServerID(const std::string& file_name) {
     return (true);
 }
 
+size_t
+Dhcpv6Srv::reclaimExpiredLeases(size_t max_leases) {
+    Lease6Collection leases;
+    try {
+        leases = LeaseMgrFactory::instance().getExpiredLeases6(max_leases);
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcp6_logger, DHCP6_RECLAIM_LEASES_FAIL).arg(ex.what());
+        return (0);
+    }
+
+    size_t reclaimed = 0;
+    for (Lease6Collection::const_iterator lease = leases.begin();
+         lease != leases.end(); ++lease) {
+        try {
+            if (!LeaseMgrFactory::instance().deleteLease((*lease)->addr_)) {
+                // The lease has been removed in the meantime.
+                continue;
+            }
+            alloc_engine_->leaseRemoved((*lease)->type_, (*lease)->addr_);
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_LEASE_RECLAIMED)
+                .arg((*lease)->addr_.toText());
+            ++reclaimed;
+
+            // Remove existing DNS entries for the lease, if any.
+            createRemovalNameChangeRequest(*lease);
+        } catch (const std::exception& ex) {
+            LOG_ERROR(dhcp6_logger, DHCP6_LEASE_RECLAIM_FAIL)
+                .arg((*lease)->addr_.toText()).arg(ex.what());
+        }
+    }
+
+    if (reclaimed > 0) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_LEASES_RECLAIMED)
+            .arg(reclaimed);
+    }
+    return (reclaimed);
+}
+
 std::string
 Dhcpv6Srv::duidToString(const OptionPtr& opt) {
     stringstream tmp;
@@ -2054,6 +2122,9 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, const Pkt6Ptr& query,
 
     if (!skip) {
         success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        if (success) {
+            alloc_engine_->leaseRemoved(lease->type_, lease->addr_);
+        }
     }
 
     // Here the success should be true if we removed lease successfully
@@ -2198,6 +2269,9 @@ Dhcpv6Srv::releaseIA_PD(const DuidPtr& duid, const Pkt6Ptr& query,
 
     if (!skip) {
         success = LeaseMgrFactory::instance().deleteLease(lease->addr_);
+        if (success) {
+            alloc_engine_->leaseRemoved(lease->type_, lease->addr_);
+        }
     } else {
         // Callouts decided to skip the next processing step. The next
         // processing step would to send the packet, so skip at this
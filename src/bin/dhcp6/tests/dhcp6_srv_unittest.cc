@@ -998,6 +998,56 @@ TEST_F(Dhcpv6SrvTest, pdReleaseReject) {
     testReleaseReject(Lease::TYPE_PD, IOAddress("2001:db8:1:2::"));
 }
 
+// This test verifies that the expired address and prefix leases are
+// reclaimed, the ones which expired first, and that the valid leases are
+// left intact.
+TEST_F(Dhcpv6SrvTest, reclaimExpiredLeases) {
+    NakedDhcpv6Srv srv(0);
+
+    // Generate client-id also duid_
+    OptionPtr clientid = generateClientId();
+
+    const uint32_t valid = 504;
+    const Lease::Type types[] = { Lease::TYPE_NA, Lease::TYPE_PD,
+                                  Lease::TYPE_NA, Lease::TYPE_NA };
+    const uint8_t prefix_lens[] = { 128, 64, 128, 128 };
+    const char* addresses[] = { "2001:db8:1:1::cafe:babe", "2001:db8:1:2::",
+                                "2001:db8:1:1::dead", "2001:db8:1:1::beef" };
+    // The first 3 leases are expired, the first one most recently, and the
+    // last one is still valid.
+    const time_t cltt[] = { time(NULL) - valid - 10,
+                            time(NULL) - valid - 30,
+                            time(NULL) - valid - 20,
+                            time(NULL) - 10 };
+    for (int i = 0; i < 4; ++i) {
+        Lease6Ptr lease(new Lease6(types[i], IOAddress(addresses[i]), duid_,
+                                   234, 501, valid, 502, 503,
+                                   subnet_->getID(), prefix_lens[i]));
+        lease->cltt_ = cltt[i];
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    // Reclaim at most 2 leases. The ones which expired first should be
+    // removed.
+    EXPECT_EQ(2, srv.reclaimExpiredLeases(2));
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(types[0],
+                                                      IOAddress(addresses[0])));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(types[1],
+                                                       IOAddress(addresses[1])));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(types[2],
+                                                       IOAddress(addresses[2])));
+
+    // Reclaim the remaining expired lease.
+    EXPECT_EQ(1, srv.reclaimExpiredLeases(Dhcpv6Srv::MAX_RECLAIMED_LEASES));
+    EXPECT_FALSE(LeaseMgrFactory::instance().getLease6(types[0],
+                                                       IOAddress(addresses[0])));
+
+    // The valid lease must be left intact.
+    EXPECT_TRUE(LeaseMgrFactory::instance().getLease6(types[3],
+                                                      IOAddress(addresses[3])));
+    EXPECT_EQ(0, srv.reclaimExpiredLeases(Dhcpv6Srv::MAX_RECLAIMED_LEASES));
+}
+
 // This test verifies if the status code option is generated properly.
 TEST_F(Dhcpv6SrvTest, StatusCode) {
     NakedDhcpv6Srv srv(0);
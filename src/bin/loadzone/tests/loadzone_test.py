@@ -83,6 +83,12 @@ class TestLoadZoneRunner(unittest.TestCase):
         self.assertEqual('INFO', self.__runner._log_severity) # default
         self.assertEqual(0, self.__runner._log_debuglevel)
         self.assertFalse(self.__runner._empty_zone)
+        self.assertIsNone(self.__runner._snapshot_file)
+
+    def test_parse_args_snapshot(self):
+        runner = LoadZoneRunner(['-s', 'example.snapshot'] + self.__args)
+        runner._parse_args()
+        self.assertEqual('example.snapshot', runner._snapshot_file)
 
     def test_set_loglevel(self):
         runner = LoadZoneRunner(['-d', '1'] + self.__args)
@@ -104,6 +110,10 @@ class TestLoadZoneRunner(unittest.TestCase):
                 ['-e', 'example', 'example.zone'])._parse_args)
         self.assertRaises(BadArgument, LoadZoneRunner(['-e'])._parse_args)
 
+        # Snapshot can't be written for an empty zone
+        self.assertRaises(BadArgument, LoadZoneRunner(
+                ['-e', '-s', 'example.snapshot', 'example'])._parse_args)
+
         # Bad zone name
         args = ['example.org', 'example.zone'] # otherwise valid args
         self.assertRaises(BadArgument,
@@ -207,6 +217,34 @@ class TestLoadZoneRunner(unittest.TestCase):
         self.__check_zone_soa(NEW_SOA_TXT)   # but load is completed
         self.assertEqual(3, self.__runner._loaded_rrs)
 
+    def test_load_with_snapshot(self):
+        '''successful loading, also writing a snapshot.'''
+        self.__common_load_setup()
+        snapshot_file = TESTDATA_WRITE_PATH + 'example.org.snapshot'
+        self.__runner._snapshot_file = snapshot_file
+        self.__runner._do_load()
+        self.__check_zone_soa(NEW_SOA_TXT)
+
+        # The snapshot has the new version of the zone.
+        clist = ConfigurableClientList(RRClass.IN)
+        clist.configure('[{"type": "MasterFiles", "cache-enable": true, ' +
+                        '"params": {"example.org": "' + snapshot_file +
+                        '"}}]', True)
+        client = clist.find(TEST_ZONE_NAME, True, False)[0]
+        result, finder = client.find_zone(TEST_ZONE_NAME)
+        self.assertEqual(client.SUCCESS, result)
+        result, rrset, _ = finder.find(TEST_ZONE_NAME, RRType.SOA)
+        self.assertEqual(NEW_SOA_TXT, rrset.to_text())
+        os.unlink(snapshot_file)
+
+    def test_load_snapshot_fail(self):
+        '''failure of writing a snapshot doesn't cancel the load.'''
+        self.__common_load_setup()
+        self.__runner._snapshot_file = TESTDATA_WRITE_PATH + \
+            'nosuchdir/example.org.snapshot'
+        self.assertRaises(LoadFailure, self.__runner._do_load)
+        self.__check_zone_soa(NEW_SOA_TXT)
+
     def test_report_progress(self):
         '''Check the output format of report_progress.
 
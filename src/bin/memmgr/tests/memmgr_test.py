@@ -604,6 +604,31 @@ class TestMemmgr(unittest.TestCase):
             'loadzone', {'class': 'IN', 'datasource': 'noname',
                          'origin': 'zone'}))[0])
 
+    def test_memory_usage(self):
+        "Check the memory_usage command"
+
+        # there's no datasrc info
+        self.assertEqual((0, {}), parse_answer(
+                self.__mgr._mod_command_handler('memory_usage', {})))
+
+        class MockClientList:
+            def get_memory_usage(self):
+                return {'name': {'segment-type': 'mapped'}}
+
+        sgmt_info = MockSegmentInfo()
+        dsrc_info = MockDataSrcInfo(sgmt_info)
+        dsrc_info.clients_map = {bundy.dns.RRClass.IN: MockClientList()}
+        self.__mgr._datasrc_info_list.append(dsrc_info)
+        self.assertEqual((0, {'IN': {'name': {'segment-type': 'mapped'}}}),
+                         parse_answer(self.__mgr._mod_command_handler(
+                    'memory_usage', {})))
+
+        # While the segment is being updated the usage isn't available.
+        sgmt_info.add_event('test')
+        self.assertEqual((0, {'IN': None}),
+                         parse_answer(self.__mgr._mod_command_handler(
+                    'memory_usage', {})))
+
     def test_reader_notification(self):
         "Test module membership notification callback."
 
@@ -26,7 +26,10 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <vector>
 
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -34,21 +37,85 @@
 #include <unistd.h>             // for some IPC/network system calls
 #include <errno.h>
 
+// The batch mode needs both recvmmsg() and sendmmsg().
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+#define SYNC_UDP_SERVER_BATCH 1
+#endif
+
 using namespace std;
 using namespace bundy::asiolink;
 
 namespace bundy {
 namespace asiodns {
 
+// Buffers used in the batch mode: for each packet in the batch, space for
+// the received data, the sender address and the rendered answer, and the
+// message headers for recvmmsg() and sendmmsg() referring to them.  The
+// headers for receiving are set up once on construction; those for sending
+// are filled for each batch as only some of the packets may be answered.
+struct SyncUDPServer::BatchBuffers {
+#ifdef SYNC_UDP_SERVER_BATCH
+    BatchBuffers(const size_t size) :
+        data(size * MAX_LENGTH), senders(size), output_buffers(size),
+        recv_iovs(size), send_iovs(size), recv_msgs(size), send_msgs(size)
+    {
+        for (size_t i = 0; i < size; ++i) {
+            output_buffers[i].reset(new bundy::util::OutputBuffer(0));
+            recv_iovs[i].iov_base = &data[i * MAX_LENGTH];
+            recv_iovs[i].iov_len = MAX_LENGTH;
+            recv_msgs[i].msg_hdr.msg_iov = &recv_iovs[i];
+            recv_msgs[i].msg_hdr.msg_iovlen = 1;
+            recv_msgs[i].msg_hdr.msg_name = &senders[i];
+            send_msgs[i].msg_hdr.msg_iov = &send_iovs[i];
+            send_msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    // Reset the fields that are updated by recvmmsg().
+    void prepareReceive() {
+        for (size_t i = 0; i < recv_msgs.size(); ++i) {
+            recv_msgs[i].msg_hdr.msg_namelen = sizeof(senders[i]);
+            recv_msgs[i].msg_hdr.msg_flags = 0;
+            recv_msgs[i].msg_len = 0;
+        }
+    }
+
+    std::vector<uint8_t> data;
+    std::vector<struct sockaddr_storage> senders;
+    std::vector<bundy::util::OutputBufferPtr> output_buffers;
+    std::vector<struct iovec> recv_iovs;
+    std::vector<struct iovec> send_iovs;
+    std::vector<struct mmsghdr> recv_msgs;
+    std::vector<struct mmsghdr> send_msgs;
+#endif
+};
+
+#ifdef SYNC_UDP_SERVER_BATCH
+namespace {
+// Convert the sender address of a received packet into the ASIO form.
+void
+setEndpoint(asio::ip::udp::endpoint& endpoint, const void* addr,
+            const socklen_t addr_len)
+{
+    const size_t len = min(static_cast<size_t>(addr_len),
+                           endpoint.capacity());
+    memcpy(endpoint.data(), addr, len);
+    endpoint.resize(len);
+}
+}
+#endif
+
 SyncUDPServerPtr
 SyncUDPServer::create(asio::io_service& io_service, const int fd,
-                      const int af, DNSLookup* lookup)
+                      const int af, DNSLookup* lookup, const size_t batch_size)
 {
-    return (SyncUDPServerPtr(new SyncUDPServer(io_service, fd, af, lookup)));
+    return (SyncUDPServerPtr(new SyncUDPServer(io_service, fd, af, lookup,
+                                               batch_size)));
 }
 
 SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
-                             const int af, DNSLookup* lookup) :
+                             const int af, DNSLookup* lookup,
+                             const size_t batch_size) :
     output_buffer_(new bundy::util::OutputBuffer(0)),
     query_(new bundy::dns::Message(bundy::dns::Message::PARSE)),
     udp_endpoint_(sender_), lookup_callback_(lookup),
@@ -62,6 +129,10 @@ SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
         bundy_throw(InvalidParameter, "null lookup callback given to "
                   "SyncUDPServer");
     }
+    if (batch_size == 0) {
+        bundy_throw(InvalidParameter, "batch size of SyncUDPServer must not "
+                    "be 0");
+    }
     LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_FD_ADD_UDP).arg(fd);
     try {
         socket_.reset(new asio::ip::udp::socket(io_service));
@@ -73,10 +144,26 @@ SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
         bundy_throw(IOError, exception.what());
     }
     udp_socket_.reset(new UDPSocket<DummyIOCallback>(*socket_));
+#ifdef SYNC_UDP_SERVER_BATCH
+    if (batch_size > 1) {
+        batch_.reset(new BatchBuffers(batch_size));
+    }
+#endif
 }
 
+SyncUDPServer::~SyncUDPServer() {}
+
 void
 SyncUDPServer::scheduleRead() {
+    if (batch_) {
+        // In the batch mode we only wait until the socket becomes readable,
+        // and then read the packets by ourselves.
+        socket_->async_receive(
+            asio::null_buffers(),
+            boost::bind(&SyncUDPServer::handleReadBatch, shared_from_this(),
+                        _1));
+        return;
+    }
     socket_->async_receive_from(
         asio::mutable_buffers_1(data_, MAX_LENGTH), sender_,
         boost::bind(&SyncUDPServer::handleRead, shared_from_this(), _1, _2));
@@ -146,6 +233,129 @@ SyncUDPServer::handleRead(const asio::error_code& ec, const size_t length) {
     scheduleRead();
 }
 
+#ifdef SYNC_UDP_SERVER_BATCH
+void
+SyncUDPServer::handleReadBatch(const asio::error_code& ec) {
+    if (stopped_) {
+        // See handleRead().
+        assert(socket_ && !socket_->is_open());
+        return;
+    }
+    if (ec) {
+        using namespace asio::error;
+        const asio::error_code::value_type err_val = ec.value();
+
+        if (err_val == operation_aborted || err_val == bad_descriptor) {
+            return;
+        }
+        if (err_val != would_block && err_val != try_again &&
+            err_val != interrupted) {
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_RECEIVE_FAIL).arg(ec.message());
+        }
+        scheduleRead();
+        return;
+    }
+
+    // Get as many packets as we can without blocking.  The socket was
+    // reported readable, but it's still possible that there's nothing to
+    // read (e.g., it was taken by another thread sharing the socket).
+    batch_->prepareReceive();
+    int count;
+    do {
+        count = recvmmsg(socket_->native(), &batch_->recv_msgs[0],
+                         batch_->recv_msgs.size(), MSG_DONTWAIT, NULL);
+    } while (count < 0 && errno == EINTR);
+    if (count < 0) {
+        const int error = errno;
+        if (error != EAGAIN && error != EWOULDBLOCK) {
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_RECEIVE_FAIL).
+                arg(strerror(error));
+        }
+        scheduleRead();
+        return;
+    }
+
+    // Process the packets one by one, just like handleRead() does for
+    // a single packet, collecting the answers to be sent.
+    size_t answer_count = 0;
+    for (size_t i = 0; i < static_cast<size_t>(count); ++i) {
+        const struct mmsghdr& msg = batch_->recv_msgs[i];
+        if (msg.msg_len == 0) {
+            continue;
+        }
+        setEndpoint(sender_, &batch_->senders[i], msg.msg_hdr.msg_namelen);
+        const bundy::util::OutputBufferPtr& buffer =
+            batch_->output_buffers[i];
+        buffer->clear();
+        done_ = false;
+        resume_called_ = false;
+
+        const IOMessage message(&batch_->data[i * MAX_LENGTH], msg.msg_len,
+                                *udp_socket_, udp_endpoint_);
+        (*lookup_callback_)(message, query_, answer_, buffer, this);
+
+        if (!resume_called_) {
+            bundy_throw(bundy::Unexpected,
+                        "No resume called from the lookup callback");
+        }
+        if (stopped_) {
+            // The server was stopped in the callback.  The socket is closed
+            // so we can't send anything any more.
+            return;
+        }
+        if (done_) {
+            struct iovec& iov = batch_->send_iovs[answer_count];
+            iov.iov_base = const_cast<void*>(buffer->getData());
+            iov.iov_len = buffer->getLength();
+            struct msghdr& hdr = batch_->send_msgs[answer_count].msg_hdr;
+            hdr.msg_name = &batch_->senders[i];
+            hdr.msg_namelen = msg.msg_hdr.msg_namelen;
+            ++answer_count;
+        }
+    }
+    sendBatchAnswers(answer_count);
+
+    scheduleRead();
+}
+
+void
+SyncUDPServer::sendBatchAnswers(const size_t count) {
+    size_t sent = 0;
+    while (sent < count) {
+        const int result = sendmmsg(socket_->native(),
+                                    &batch_->send_msgs[sent], count - sent, 0);
+        if (result > 0) {
+            sent += result;
+        } else if (result < 0 && errno == EINTR) {
+            continue;
+        } else {
+            // sendmmsg() fails only if the first message can't be sent.
+            // Log it and skip that one like handleRead() does.
+            const int error = errno;
+            const struct msghdr& hdr = batch_->send_msgs[sent].msg_hdr;
+            asio::ip::udp::endpoint endpoint;
+            setEndpoint(endpoint, hdr.msg_name, hdr.msg_namelen);
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_SEND_FAIL).
+                arg(endpoint.address().to_string()).
+                arg(result < 0 ? strerror(error) : "no data sent");
+            ++sent;
+        }
+    }
+}
+#else
+// The batch mode is never enabled in this case, and these will never be
+// called.
+void
+SyncUDPServer::handleReadBatch(const asio::error_code&) {
+    assert(false);
+}
+
+void
+SyncUDPServer::sendBatchAnswers(const size_t) {
+    assert(false);
+}
+#endif
+
 void
 SyncUDPServer::operator()(asio::error_code, size_t) {
     // To start the server, we just schedule reading of data when they
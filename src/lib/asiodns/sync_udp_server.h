@@ -54,6 +54,15 @@ typedef boost::shared_ptr<SyncUDPServer> SyncUDPServerPtr;
 /// accidentally destroyed while waiting for events.  To enforce this style
 /// of creation, a static factory method is provided, and the constructor is
 /// hidden as a private.
+///
+/// On systems that support the \c recvmmsg() and \c sendmmsg() system calls
+/// the server can work in the "batch" mode: when the socket becomes
+/// readable, it receives up to a given number of queued packets with a
+/// single system call, calls the lookup callback for each of them in turn,
+/// and then sends all the answers with another single system call.  This
+/// saves a few system calls and event loop dispatches per query under
+/// heavy load; the behavior as seen from the lookup callback is the same as
+/// in the normal mode.
 class SyncUDPServer : public DNSServer,
                       public boost::enable_shared_from_this<SyncUDPServer>,
                       boost::noncopyable
@@ -63,9 +72,15 @@ private:
     ///
     /// This is hidden as private (see the class description).
     SyncUDPServer(asio::io_service& io_service, const int fd, const int af,
-                  DNSLookup* lookup);
+                  DNSLookup* lookup, const size_t batch_size);
 
 public:
+    /// \brief The default maximum number of packets handled at once.
+    static const size_t DEFAULT_BATCH_SIZE = 32;
+
+    /// \brief Destructor.
+    ~SyncUDPServer();
+
     /// \brief Factory of SyncUDPServer object in the form of shared_ptr.
     ///
     /// Due to the nature of this server, it's meaningless if the lookup
@@ -82,13 +97,19 @@ public:
     /// \param af address family, either AF_INET or AF_INET6
     /// \param lookup the callbackprovider for DNS lookup events (must not be
     ///        NULL)
+    /// \param batch_size the maximum number of packets received and answered
+    ///        at once in the batch mode.  If it's 1, or the system doesn't
+    ///        support the batch mode, packets are handled one by one.
     ///
     /// \throw bundy::InvalidParameter if af is neither AF_INET nor AF_INET6
     /// \throw bundy::InvalidParameter lookup is NULL
+    /// \throw bundy::InvalidParameter batch_size is 0
     /// \throw bundy::asiolink::IOError when a low-level error happens, like the
     ///     fd is not a valid descriptor.
     static SyncUDPServerPtr create(asio::io_service& io_service, const int fd,
-                                   const int af, DNSLookup* lookup);
+                                   const int af, DNSLookup* lookup,
+                                   const size_t batch_size =
+                                   DEFAULT_BATCH_SIZE);
 
     /// \brief Start the SyncUDPServer.
     ///
@@ -176,6 +197,11 @@ private:
     // Placeholder for error code object.  It will be passed to ASIO library
     // to have it set in case of error.
     asio::error_code ec_;
+    // Buffers for the batch mode.  It's NULL if the server works in the
+    // normal mode.  The definition is hidden in the implementation as it
+    // depends on system specific structures.
+    struct BatchBuffers;
+    boost::scoped_ptr<BatchBuffers> batch_;
 
     // Auxiliary functions
 
@@ -185,6 +211,11 @@ private:
     // Callback from the socket's read call (called when there's an error or
     // when a new packet comes).
     void handleRead(const asio::error_code& ec, const size_t length);
+    // Callback from the socket in the batch mode (called when there's an
+    // error or when the socket becomes readable).
+    void handleReadBatch(const asio::error_code& ec);
+    // Send the first "count" answers prepared in batch_ (batch mode only).
+    void sendBatchAnswers(const size_t count);
 };
 
 } // namespace asiodns
@@ -756,6 +756,40 @@ TEST_F(SyncServerTest, nullLookupCallback) {
                  bundy::InvalidParameter);
 }
 
+// Batch size of 0 doesn't make sense.
+TEST_F(SyncServerTest, zeroBatchSize) {
+    EXPECT_THROW(SyncUDPServer::create(service, 0, AF_INET, lookup_, 0),
+                 bundy::InvalidParameter);
+}
+
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+// In the batch mode, all packets queued at the socket are handled in
+// a single event, and all of them are answered.
+TEST_F(SyncServerTest, batchMode) {
+    ip::udp::socket client(service, ip::udp::v6());
+    const ip::udp::endpoint server(server_address_, server_port);
+    const size_t PACKET_COUNT = 5;
+    for (size_t i = 0; i < PACKET_COUNT; ++i) {
+        const char data[] = { 'q', static_cast<char>('0' + i) };
+        client.send_to(buffer(data, sizeof(data)), server);
+    }
+
+    (*udp_server_)();
+    EXPECT_EQ(1, service.run_one());
+
+    // The answers should have been sent by now, in the order of the
+    // queries.
+    for (size_t i = 0; i < PACKET_COUNT; ++i) {
+        ASSERT_LT(0, client.available());
+        char data[2];
+        EXPECT_EQ(sizeof(data), client.receive(buffer(data, sizeof(data))));
+        EXPECT_EQ('q', data[0]);
+        EXPECT_EQ(static_cast<char>('0' + i), data[1]);
+    }
+    EXPECT_EQ(0, client.available());
+}
+#endif
+
 TEST_F(SyncServerTest, resetUDPServerBeforeEvent) {
     // Reset the UDP server object after starting and before it would get
     // an event from io_service (in this case abort event).  The following
@@ -16,11 +16,14 @@
 #include <datasrc/client.h>
 #include <datasrc/memory/load_action.h>
 #include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/zone_finder.h>
 
 #include <util/memory_segment.h>
 
 #include <dns/name.h>
 #include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <dns/rdataclass.h>
 
 #include <cc/data.h>
 #include <exceptions/exceptions.h>
@@ -30,6 +33,7 @@
 #include <cassert>
 #include <map>
 #include <string>
+#include <vector>
 
 using namespace bundy::data;
 
@@ -53,6 +57,12 @@ getSegmentTypeFromConf(const Element& conf) {
     }
     return (conf.get("cache-type")->stringValue());
 }
+
+bool
+getShareRdataFromConf(const Element& conf) {
+    return (conf.contains("cache-share-rdata") &&
+            conf.get("cache-share-rdata")->boolValue());
+}
 }
 
 CacheConfig::CacheConfig(const std::string& datasrc_type,
@@ -61,6 +71,7 @@ CacheConfig::CacheConfig(const std::string& datasrc_type,
                          bool allowed) :
     enabled_(allowed && getEnabledFromConf(datasrc_conf)),
     segment_type_(getSegmentTypeFromConf(datasrc_conf)),
+    share_rdata_(getShareRdataFromConf(datasrc_conf)),
     datasrc_client_(datasrc_client)
 {
     ConstElementPtr params = datasrc_conf.get("params");
@@ -133,18 +144,21 @@ namespace {
 class IteratorLoader {
 public:
     IteratorLoader(const dns::RRClass& rrclass, const dns::Name& name,
-                   const ZoneIteratorPtr& iterator) :
+                   const ZoneIteratorPtr& iterator, bool share_rdata) :
         rrclass_(rrclass),
         name_(name),
-        iterator_(iterator)
+        iterator_(iterator),
+        share_rdata_(share_rdata)
     {}
     memory::ZoneData* operator()(util::MemorySegment& segment) {
-        return (memory::loadZoneData(segment, rrclass_, name_, *iterator_));
+        return (memory::loadZoneData(segment, rrclass_, name_, *iterator_,
+                                     share_rdata_));
     }
 private:
     const dns::RRClass rrclass_;
     const dns::Name name_;
     ZoneIteratorPtr iterator_;
+    const bool share_rdata_;
 };
 
 // We can't use the loadZoneData function directly in boost::bind, since
@@ -152,11 +166,80 @@ private:
 // reliably and fails. So we simply wrap it into an unique name.
 memory::ZoneData*
 loadZoneDataFromFile(util::MemorySegment& segment, const dns::RRClass& rrclass,
-                     const dns::Name& name, const std::string& filename)
+                     const dns::Name& name, const std::string& filename,
+                     bool share_rdata)
 {
-    return (memory::loadZoneData(segment, rrclass, name, filename));
+    return (memory::loadZoneData(segment, rrclass, name, filename,
+                                 share_rdata));
+}
+
+// Get the SOA serial from the given SOA RRset.  Returns false if it's not
+// a valid SOA.
+bool
+getSerial(const dns::ConstRRsetPtr& soa, uint32_t& serial) {
+    if (!soa || soa->getRdataCount() != 1) {
+        return (false);
+    }
+    serial = dynamic_cast<const dns::rdata::generic::SOA&>(
+        soa->getRdataIterator()->getCurrent()).getSerial().getValue();
+    return (true);
 }
 
+// The DiffAction for the data source client.  It retrieves the differences
+// from the version of the zone data in memory to the current version in the
+// data source from the journal of the data source.  Like IteratorLoader,
+// it holds an iterator, which is only used to get the current SOA of the
+// zone; this way we don't have to use the client for lookups at the time
+// of load, which could race with other users of the client.
+class JournalDiffLoader {
+public:
+    JournalDiffLoader(const DataSourceClient& client,
+                      const dns::RRClass& rrclass, const dns::Name& name,
+                      const ZoneIteratorPtr& iterator) :
+        client_(client),
+        rrclass_(rrclass),
+        name_(name),
+        iterator_(iterator)
+    {}
+    bool operator()(const memory::ZoneData& zone_data,
+                    std::vector<dns::ConstRRsetPtr>& diffs)
+    {
+        memory::InMemoryZoneFinder mem_finder(zone_data, rrclass_);
+        uint32_t old_serial, new_serial;
+        if (!getSerial(mem_finder.findAtOrigin(dns::RRType::SOA(), false,
+                                               ZoneFinder::FIND_DEFAULT)->
+                       rrset, old_serial) ||
+            !getSerial(iterator_->getSOA(), new_serial)) {
+            return (false);
+        }
+        if (old_serial == new_serial) {
+            return (true);      // nothing to update
+        }
+
+        // The journal reader uses its own connection to the data source
+        // (if it matters), so this is safe without a lock.
+        std::pair<ZoneJournalReader::Result, ZoneJournalReaderPtr> reader;
+        try {
+            reader = client_.getJournalReader(name_, old_serial, new_serial);
+        } catch (const bundy::NotImplemented&) {
+            return (false);
+        }
+        if (reader.first != ZoneJournalReader::SUCCESS) {
+            return (false);
+        }
+        dns::ConstRRsetPtr rrset;
+        while ((rrset = reader.second->getNextDiff()) != NULL) {
+            diffs.push_back(rrset);
+        }
+        return (true);
+    }
+private:
+    const DataSourceClient& client_;
+    const dns::RRClass rrclass_;
+    const dns::Name name_;
+    ZoneIteratorPtr iterator_;
+};
+
 } // unnamed namespace
 
 memory::LoadAction
@@ -172,7 +255,7 @@ CacheConfig::getLoadAction(const dns::RRClass& rrclass,
     if (!found->second.empty()) {
         // This is "MasterFiles" data source.
         return (boost::bind(loadZoneDataFromFile, _1, rrclass, zone_name,
-                            found->second));
+                            found->second, share_rdata_));
     }
 
     // Otherwise there must be a "source" data source (ensured by constructor)
@@ -192,7 +275,28 @@ CacheConfig::getLoadAction(const dns::RRClass& rrclass,
 
     // Wrap the iterator into the correct functor (which keeps it alive as
     // long as it is needed).
-    return (IteratorLoader(rrclass, zone_name, iterator));
+    return (IteratorLoader(rrclass, zone_name, iterator, share_rdata_));
+}
+
+memory::DiffAction
+CacheConfig::getDiffAction(const dns::RRClass& rrclass,
+                           const dns::Name& zone_name) const
+{
+    // The differences are only available from the journal of a data source;
+    // master files are always loaded entirely.
+    Zones::const_iterator found = zone_config_.find(zone_name);
+    if (found == zone_config_.end() || !found->second.empty()) {
+        return (memory::DiffAction());
+    }
+    assert(datasrc_client_);
+
+    ZoneIteratorPtr iterator(datasrc_client_->getIterator(zone_name));
+    if (!iterator) {
+        bundy_throw(Unexpected, "getting DiffAction for " << zone_name
+                  << "/" << rrclass << " resulted in Null zone iterator");
+    }
+    return (JournalDiffLoader(*datasrc_client_, rrclass, zone_name,
+                              iterator));
 }
 
 } // namespace internal
@@ -144,6 +144,14 @@ public:
     /// \throw None
     const std::string& getSegmentType() const { return (segment_type_); }
 
+    /// \brief Return if identical RDATA are shared in the cached zones.
+    ///
+    /// It's given via the "cache-share-rdata" configuration item, and
+    /// defaults to false (see \c memory::ZoneData::enableRdataSharing()).
+    ///
+    /// \throw None
+    bool isRdataShared() const { return (share_rdata_); }
+
     /// \brief Return a \c LoadAction functor to load zone data into memory.
     ///
     /// This method returns an appropriate \c LoadAction functor that can be
@@ -173,6 +181,32 @@ public:
     memory::LoadAction getLoadAction(const dns::RRClass& rrclass,
                                      const dns::Name& zone_name) const;
 
+    /// \brief Return a \c DiffAction functor to update zone data in memory.
+    ///
+    /// This method returns a \c DiffAction functor that can be passed to
+    /// a \c memory::ZoneWriter object so it can update the zone data
+    /// currently in memory with the differences stored in the journal of
+    /// the underlying data source, instead of loading the entire zone.
+    /// The functor doesn't provide the differences (so the zone will be
+    /// loaded entirely) if the data source doesn't support journaling or
+    /// doesn't have the differences for the versions.
+    ///
+    /// If the specified zone is not configured to be cached, or the zone
+    /// is loaded from a master file, it returns an empty functor.
+    ///
+    /// \throw NoSuchZone The specified zone doesn't exist in the
+    /// underlying data source storing the original data to be cached.
+    /// \throw DataSourceError Other, unexpected but possible error happens
+    /// in the underlying data source.
+    /// \throw Unexpected Unexpected error happens in the underlying data
+    /// source.
+    ///
+    /// \param rrclass The RR class of the zone
+    /// \param zone_name The origin name of the zone
+    /// \return A \c DiffAction functor or an empty functor (see above).
+    memory::DiffAction getDiffAction(const dns::RRClass& rrclass,
+                                     const dns::Name& zone_name) const;
+
     /// \brief Read only iterator type over configured cached zones.
     ///
     /// \note This initial version exposes the internal data structure (i.e.
@@ -200,6 +234,7 @@ public:
 private:
     const bool enabled_; // if the use of in-memory zone table is enabled
     const std::string segment_type_;
+    const bool share_rdata_; // if identical RDATA are shared in the zones
     // client of underlying data source, will be NULL for MasterFile datasrc
     const DataSourceClient* datasrc_client_;
 
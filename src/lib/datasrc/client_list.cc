@@ -23,27 +23,34 @@
 #include <datasrc/memory/zone_writer.h>
 #include <datasrc/memory/zone_data_loader.h>
 #include <datasrc/memory/zone_data_updater.h>
+#include <datasrc/memory/zone_data_usage.h>
+#include <datasrc/memory/zone_table.h>
 #include <datasrc/logger.h>
 #include <datasrc/zone_table_accessor_cache.h>
 #include <dns/masterload.h>
 #include <util/memory_segment_local.h>
+#include <util/thread_arena.h>
 
 #include <memory>
 #include <set>
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/scoped_ptr.hpp>
 
 using namespace bundy::data;
 using namespace bundy::dns;
 using namespace std;
 using bundy::util::MemorySegment;
+using bundy::util::ArenaAllocator;
 using boost::lexical_cast;
 using boost::shared_ptr;
 using boost::dynamic_pointer_cast;
 using bundy::datasrc::memory::InMemoryClient;
 using bundy::datasrc::memory::ZoneTableSegment;
 using bundy::datasrc::memory::ZoneDataUpdater;
+using bundy::datasrc::memory::ZoneDataUsage;
+using bundy::datasrc::memory::ZoneTable;
 
 namespace bundy {
 namespace datasrc {
@@ -228,12 +235,14 @@ genKeeper(const ConfigurableClientList::DataSourceInfo* info) {
     if (info == NULL) {
         return (boost::shared_ptr<ClientList::FindResult::LifeKeeper>());
     }
+    // A keeper is created for every lookup, so it's allocated from the
+    // per-thread arena.
     if (info->cache_) {
-        return (boost::shared_ptr<ClientList::FindResult::LifeKeeper>(
-            new CacheKeeper(info->cache_)));
+        return (boost::allocate_shared<CacheKeeper>(
+            ArenaAllocator<CacheKeeper>(), info->cache_));
     } else {
-        return (boost::shared_ptr<ClientList::FindResult::LifeKeeper>(
-            new ContainerKeeper(info->container_)));
+        return (boost::allocate_shared<ContainerKeeper>(
+            ArenaAllocator<ContainerKeeper>(), info->container_));
     }
 }
 
@@ -347,10 +356,49 @@ ConfigurableClientList::resetMemorySegment
     return false;
 }
 
+ConfigurableClientList::MemorySegmentGenerationPtr
+ConfigurableClientList::prepareMemorySegment
+    (const std::string& datasrc_name,
+     ZoneTableSegment::MemorySegmentOpenMode mode,
+     ConstElementPtr config_params) const
+{
+    BOOST_FOREACH(const DataSourceInfo& info, data_sources_) {
+        if (info.name_ == datasrc_name && info.ztable_segment_) {
+            MemorySegmentGenerationPtr generation(new MemorySegmentGeneration);
+            generation->datasrc_name_ = datasrc_name;
+            generation->ztable_segment_.reset(ZoneTableSegment::create(
+                rrclass_, info.ztable_segment_->getImplType()));
+            generation->ztable_segment_->reset(mode, config_params);
+            if (!generation->ztable_segment_->isWritable()) {
+                generation->ztable_segment_->prefault();
+            }
+            generation->cache_.reset(new InMemoryClient(
+                datasrc_name, generation->ztable_segment_, rrclass_));
+            return (generation);
+        }
+    }
+    return (MemorySegmentGenerationPtr());
+}
+
+bool
+ConfigurableClientList::installMemorySegment
+    (MemorySegmentGeneration& generation)
+{
+    BOOST_FOREACH(DataSourceInfo& info, data_sources_) {
+        if (info.name_ == generation.datasrc_name_ && info.ztable_segment_) {
+            info.ztable_segment_.swap(generation.ztable_segment_);
+            info.cache_.swap(generation.cache_);
+            return (true);
+        }
+    }
+    return (false);
+}
+
 ConfigurableClientList::ZoneWriterPair
 ConfigurableClientList::getCachedZoneWriter(const Name& name,
                                             bool catch_load_error,
-                                            const std::string& datasrc_name)
+                                            const std::string& datasrc_name,
+                                            bool incremental)
 {
     if (!allow_cache_) {
         return (ZoneWriterPair(CACHE_DISABLED, ZoneWriterPtr()));
@@ -389,7 +437,11 @@ ConfigurableClientList::getCachedZoneWriter(const Name& name,
                                    new memory::ZoneWriter(
                                        *info.ztable_segment_,
                                        load_action, name, rrclass_,
-                                       catch_load_error))));
+                                       catch_load_error,
+                                       incremental ?
+                                       info.getCacheConfig()->
+                                       getDiffAction(rrclass_, name) :
+                                       memory::DiffAction()))));
     }
 
     // We can't find the specified zone.  If a specific data source was
@@ -437,6 +489,78 @@ ConfigurableClientList::getStatus() const {
     return (result);
 }
 
+namespace {
+// Element::create() is ambiguous for size_t on some platforms.
+ElementPtr
+createSize(size_t size) {
+    return (Element::create(static_cast<long long int>(size)));
+}
+
+ElementPtr
+createZoneUsage(const ZoneDataUsage& usage) {
+    ElementPtr zone_usage = Element::createMap();
+    zone_usage->set("node-count", createSize(usage.node_count));
+    zone_usage->set("node-size", createSize(usage.node_size));
+    zone_usage->set("label-size", createSize(usage.label_size));
+    zone_usage->set("index-size", createSize(usage.index_size));
+    zone_usage->set("rdataset-count", createSize(usage.rdataset_count));
+    zone_usage->set("rdataset-size", createSize(usage.rdataset_size));
+    zone_usage->set("shared-rdata-size", createSize(usage.shared_rdata_size));
+    zone_usage->set("nsec3-size", createSize(usage.nsec3_size));
+    zone_usage->set("other-size", createSize(usage.other_size));
+    zone_usage->set("total-size", createSize(usage.getTotalSize()));
+    return (zone_usage);
+}
+}
+
+ConstElementPtr
+ConfigurableClientList::getMemoryUsage() const {
+    ElementPtr memory_usage = Element::createMap();
+    BOOST_FOREACH(const DataSourceInfo& info, data_sources_) {
+        if (!info.ztable_segment_ || !info.ztable_segment_->isUsable()) {
+            continue;
+        }
+        ZoneTableSegment& segment = *info.ztable_segment_;
+        const MemorySegment::Usage sgmt_usage =
+            segment.getMemorySegment().getUsage();
+        const ZoneTable* table = segment.getHeader().getTable();
+        const size_t table_size = table->getMemorySize();
+        size_t accounted_size = table_size;
+
+        ElementPtr zones = Element::createMap();
+        for (internal::CacheConfig::ConstZoneIterator it =
+                 info.getCacheConfig()->begin();
+             it != info.getCacheConfig()->end();
+             ++it) {
+            const Name& zone_name = it->first;
+            const ZoneTable::FindResult zresult = table->findZone(zone_name);
+            ZoneDataUsage usage;
+            if (zresult.code == result::SUCCESS && zresult.zone_data != NULL) {
+                usage = getZoneDataUsage(*zresult.zone_data, rrclass_);
+                accounted_size += usage.getTotalSize();
+            }
+            zones->set(zone_name.toText(), createZoneUsage(usage));
+        }
+
+        ElementPtr datasrc_usage = Element::createMap();
+        datasrc_usage->set("segment-type",
+                           Element::create(segment.getImplType()));
+        datasrc_usage->set("segment-size", createSize(sgmt_usage.size));
+        datasrc_usage->set("segment-in-use", createSize(sgmt_usage.in_use));
+        datasrc_usage->set("segment-peak-in-use",
+                           createSize(sgmt_usage.peak_in_use));
+        datasrc_usage->set("zone-table-size",
+                           createSize(table_size));
+        datasrc_usage->set("overhead",
+                           createSize(sgmt_usage.in_use > accounted_size ?
+                                      sgmt_usage.in_use - accounted_size :
+                                      0));
+        datasrc_usage->set("zones", zones);
+        memory_usage->set(info.name_, datasrc_usage);
+    }
+    return (memory_usage);
+}
+
 ConstZoneTableAccessorPtr
 ConfigurableClientList::getZoneTableAccessor(const std::string& datasrc_name,
                                              bool use_cache) const
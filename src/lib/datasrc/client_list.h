@@ -391,6 +391,66 @@ public:
          memory::ZoneTableSegment::MemorySegmentOpenMode mode,
          bundy::data::ConstElementPtr config_params);
 
+    /// \brief A memory segment prepared to replace that of a data source.
+    ///
+    /// This is created by \c prepareMemorySegment() and passed to
+    /// \c installMemorySegment().  Applications should not touch its
+    /// members.
+    struct MemorySegmentGeneration {
+        std::string datasrc_name_;
+        boost::shared_ptr<memory::ZoneTableSegment> ztable_segment_;
+        boost::shared_ptr<memory::InMemoryClient> cache_;
+    };
+
+    /// \brief Convenience type shortcut
+    typedef boost::shared_ptr<MemorySegmentGeneration>
+        MemorySegmentGenerationPtr;
+
+    /// \brief Open a new memory segment for a data source without
+    /// switching to it.
+    ///
+    /// This is the first half of a two-step alternative to
+    /// \c resetMemorySegment().  It creates a new zone table segment of
+    /// the same type as the current one of the data source, opens it with
+    /// the given parameters, and, if it's read-only, brings it into memory
+    /// (see \c ZoneTableSegment::prefault()).  None of these touch the
+    /// data currently in use, so this method can be called while other
+    /// threads keep looking up zones in the list, and the possibly time
+    /// consuming work doesn't block them.  The new segment takes effect
+    /// once passed to \c installMemorySegment().
+    ///
+    /// This is mainly intended for switching to a new version of a mapped
+    /// file written by another process.
+    ///
+    /// \param datasrc_name The name of the data source whose segment to
+    /// replace
+    /// \param mode The open mode for the new memory segment
+    /// \param config_params The configuration for the new memory segment.
+    /// \return The prepared segment, or NULL if the data source wasn't
+    /// found or doesn't have a cache.
+    /// \throw Whatever ZoneTableSegment::reset() throws.  The list isn't
+    /// modified in that case.
+    MemorySegmentGenerationPtr prepareMemorySegment
+        (const std::string& datasrc_name,
+         memory::ZoneTableSegment::MemorySegmentOpenMode mode,
+         bundy::data::ConstElementPtr config_params) const;
+
+    /// \brief Switch a data source to a segment prepared by
+    /// \c prepareMemorySegment().
+    ///
+    /// This only exchanges a few pointers, so it's cheap.  It must still be
+    /// serialized with lookups in the list like other modifications.
+    /// On return, \c generation holds the previous segment of the data
+    /// source; it's released (and, for a mapped segment, unmapped) when the
+    /// caller drops it and all results of earlier lookups are gone, so the
+    /// caller can do it outside any critical section.
+    ///
+    /// \param generation The segment returned by \c prepareMemorySegment()
+    /// \return If the data source was found (it can have been removed by
+    /// reconfiguration since the segment was prepared).
+    /// \throw None
+    bool installMemorySegment(MemorySegmentGeneration& generation);
+
     /// \brief Convenience type shortcut
     typedef boost::shared_ptr<memory::ZoneWriter> ZoneWriterPtr;
 
@@ -437,6 +497,10 @@ public:
     /// load errors (see \c ZoneWriter constructor documentation).
     /// \param datasrc_name If not empty, the name of the data source
     /// to be used for loading the zone (see above).
+    /// \param incremental If true, the writer updates the zone already in
+    /// memory with the differences from the journal of the data source
+    /// if possible, instead of loading the entire zone (see the
+    /// \c ZoneWriter description).
     /// \return The result has two parts. The first one is a status indicating
     ///     if it worked or not (and in case it didn't, also why). If the
     ///     status is ZONE_SUCCESS, the second part contains a shared pointer
@@ -446,7 +510,8 @@ public:
     ///      containing the zone might throw is propagated.
     ZoneWriterPair getCachedZoneWriter(const dns::Name& zone,
                                        bool catch_load_error,
-                                       const std::string& datasrc_name = "");
+                                       const std::string& datasrc_name = "",
+                                       bool incremental = false);
 
     /// \brief Implementation of the ClientList::find.
     virtual FindResult find(const dns::Name& zone,
@@ -527,6 +592,28 @@ public:
     /// it is exception free.
     std::vector<DataSourceStatus> getStatus() const;
 
+    /// \brief Get memory usage of the in-memory cache of data sources.
+    ///
+    /// It returns a map element keyed by the names of the data sources
+    /// whose cache is in use.  Each value is a map of the following items:
+    /// - "segment-type": The type of the memory segment.
+    /// - "segment-size", "segment-in-use", "segment-peak-in-use": The
+    ///   numbers returned by \c util::MemorySegment::getUsage().
+    /// - "zone-table-size": The size of the zone table itself.
+    /// - "overhead": The part of "segment-in-use" not accounted for by
+    ///   the zone table and the zones, such as allocator overhead and
+    ///   data of zones no longer in the configuration.
+    /// - "zones": A map of the configured zones to their usage (see
+    ///   \c memory::ZoneDataUsage); the sizes of a zone that isn't
+    ///   loaded are all 0.
+    ///
+    /// All sizes are in bytes.  This walks through the entire data of
+    /// the cache, so it's not expected to be called frequently.
+    ///
+    /// This may throw standard exceptions, such as std::bad_alloc.
+    /// Otherwise, it is exception free.
+    data::ConstElementPtr getMemoryUsage() const;
+
     /// \brief Access to the data source clients.
     ///
     /// It can be used to examine the loaded list of data sources clients
@@ -35,6 +35,8 @@
 #include <boost/static_assert.hpp>
 
 #include <ostream>
+#include <utility>
+#include <vector>
 #include <algorithm>
 #include <cassert>
 
@@ -261,6 +263,14 @@ public:
     /// non-terminal domains, but it is possible (yet probably meaningless)
     /// empty nodes anywhere.
     bool isEmpty() const { return (!data_); }
+
+    /// \brief Return the size of the memory allocated for the node.
+    ///
+    /// It includes the space reserved for the labels, but not the data
+    /// stored in the node.
+    size_t getMemorySize() const {
+        return (sizeof(DomainTreeNode<T>) + labels_capacity_);
+    }
     //@}
 
     /// \name Setter functions.
@@ -736,6 +746,14 @@ private:
     // So we can change this implementation without affecting its users if
     // a future change to LabelSequence breaks this assumption.
     BOOST_STATIC_ASSERT((1 << 9) > dns::LabelSequence::MAX_SERIALIZED_LENGTH);
+
+    /// \brief Identifier of the search index of the subdomain tree.
+    ///
+    /// This is only meaningful while the \c DomainTree has a search index
+    /// (see \c DomainTree::buildIndex()); 0 means the subdomain tree isn't
+    /// indexed.  It fits in the padding after the flags on 64-bit machines,
+    /// so it doesn't increase the size of the node.
+    uint32_t down_index_;
 };
 
 template <typename T>
@@ -746,7 +764,8 @@ DomainTreeNode<T>::DomainTreeNode(size_t labels_capacity) :
     down_(NULL),
     data_(NULL),
     flags_(FLAG_RED | FLAG_SUBTREE_ROOT),
-    labels_capacity_(labels_capacity)
+    labels_capacity_(labels_capacity),
+    down_index_(0)
 {
 }
 
@@ -834,7 +853,7 @@ DomainTreeNode<T>::abstractSuccessor(TT* node,
     // subtree.
     if ((node->*right).get() != NULL) {
         node = (node->*right).get();
-        const DomainTreeNode<T>* left_n;
+        TT* left_n;
         while ((left_n = (node->*left).get()) != NULL) {
             node = left_n;
         }
@@ -844,7 +863,7 @@ DomainTreeNode<T>::abstractSuccessor(TT* node,
     // Otherwise go up until we find the first left branch on our path to
     // root.  If found, the parent of the branch is the successor.
     // Otherwise, we return the null node
-    const DomainTreeNode<T>* parent = node->getParent();
+    TT* parent = node->getParent();
     while ((!node->isSubTreeRoot()) &&
            (node == (parent->*right).get())) {
         node = parent;
@@ -1338,6 +1357,7 @@ private:
                            const bundy::dns::LabelSequence& target_labels_orig,
                            TTN** target,
                            TTN* node,
+                           uint32_t index_id,
                            DomainTreeNodeChain<T>& node_path,
                            bool (*callback)(const DomainTreeNode<T>&, CBARG),
                            CBARG callback_arg);
@@ -1658,19 +1678,32 @@ public:
     /// \c MemorySegment, or the direct caller may not have to worry about it
     /// if this condition is guaranteed at a higher level.
     ///
+    /// If \c in_order is true, the caller expects the names to be inserted
+    /// mostly in the DNSSEC order (as is usually the case when a whole zone
+    /// is loaded from a zone file or a zone transfer).  A name inserted in
+    /// that order is always larger than any existing name on each level
+    /// of the tree, so before searching a level from its root, the name is
+    /// first compared with the largest node of the level; if it belongs
+    /// right of or under that node, the search is skipped.  Otherwise the
+    /// level is searched in the normal way, so names given out of order
+    /// are still inserted correctly, at the cost of one more comparison
+    /// per level.  The resulting tree is the same either way.
+    ///
     /// \param mem_sgmt A \c MemorySegment object for allocating memory of
     /// a new node to be inserted.  Must be the same segment as that used
     /// for creating the tree itself.
     /// \param name The name to be inserted into the tree.
     /// \param inserted_node This is an output parameter and is set to the
     ///     node.
+    /// \param in_order Whether the names are expected to be inserted in
+    ///     the DNSSEC order.
     ///
     /// \return
     ///  - SUCCESS The node was added.
     ///  - ALREADYEXISTS There was already a node of that name, so it was not
     ///     added.
     Result insert(util::MemorySegment& mem_sgmt, const bundy::dns::Name& name,
-                  DomainTreeNode<T>** inserted_node);
+                  DomainTreeNode<T>** inserted_node, bool in_order = false);
 
     /// \brief Delete a tree node.
     ///
@@ -1709,10 +1742,91 @@ public:
     void swap(DomainTree<T>& other) {
         std::swap(root_, other.root_);
         std::swap(node_count_, other.node_count_);
+        std::swap(level_indexes_, other.level_indexes_);
+        std::swap(level_index_count_, other.level_index_count_);
+        std::swap(root_index_, other.root_index_);
+        std::swap(index_ready_, other.index_ready_);
     }
     //@}
 
+    /// \name Search index
+    ///
+    /// \brief Read-optimized search structure for \c find().
+    ///
+    /// Looking up a name in a large level of the tree (e.g., the
+    /// delegations of a TLD zone) means following many left/right pointers
+    /// to nodes scattered all over memory, and comparing the labels stored
+    /// in each of them.  Once the tree isn't going to be modified, such as
+    /// after loading a zone, a search index can be built for it: for each
+    /// level that has at least \c INDEX_MIN_NODES nodes, a sorted array
+    /// of (key, node) pairs, where the key is a prefix of the rightmost
+    /// label of the node in its canonical (lower case) form.  Since no
+    /// two nodes of a level share the rightmost label, \c find() can then
+    /// locate the only candidate node of each level by a binary search of
+    /// a compact array, mostly comparing integers, and compares the labels
+    /// only once per level.
+    ///
+    /// The index is only used by \c find(), and it doesn't change the
+    /// result of it, including the search context recorded in the node
+    /// chain (the compared node may be a different one, but \c
+    /// previousNode() will then locate the same node).  Other operations
+    /// still work on the red-black trees.  Any modification of the tree
+    /// structure (\c insert() creating a node, \c remove() and
+    /// \c removeAllNodes()) discards the index; it can be built again
+    /// by \c buildIndex().
+    //@{
+    /// \brief Minimum number of nodes of a level to build an index for.
+    ///
+    /// Smaller levels are searched in the red-black tree just as fast.
+    static const size_t INDEX_MIN_NODES = 16;
+
+    /// \brief Build the search index of the tree.
+    ///
+    /// If the tree already has an index, it's rebuilt.
+    ///
+    /// This method involves memory allocation from the segment.  If it
+    /// fails \c std::bad_alloc will be thrown and the tree will be left
+    /// without an index.  It can also propagate the \c MemorySegmentGrown
+    /// exception; in that case the caller should re-get the address of the
+    /// tree (see \c insert()) and call this method again.
+    ///
+    /// \param mem_sgmt The \c MemorySegment used to create the tree.
+    void buildIndex(util::MemorySegment& mem_sgmt);
+
+    /// \brief Release the search index of the tree, if any.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment used to create the tree.
+    void destroyIndex(util::MemorySegment& mem_sgmt);
+
+    /// \brief Return whether the tree currently has a search index.
+    ///
+    /// \throw none
+    bool hasIndex() const { return (index_ready_); }
+
+    /// \brief Return the size of the memory allocated for the search index.
+    ///
+    /// It's 0 if the tree doesn't have an index.
+    ///
+    /// \throw none
+    size_t getIndexSize() const;
+    //@}
+
+    /// \brief Return the size of the memory allocated for the tree.
+    ///
+    /// It includes the tree itself, all of its nodes with their labels
+    /// and the search index, but not the data stored in the nodes.
+    /// This walks through all nodes of the tree, so it's not expected to
+    /// be used in a performance sensitive path.
+    ///
+    /// \throw none
+    size_t getMemorySize() const;
+
 private:
+    /// \brief Helper method for getMemorySize()
+    size_t getMemorySizeHelper(const DomainTreeNode<T>* node) const;
+
     /// \name DomainTree balance functions
     //@{
     void
@@ -1762,10 +1876,62 @@ private:
                      const bundy::dns::LabelSequence& new_prefix,
                      const bundy::dns::LabelSequence& new_suffix);
 
+    /// Return the leftmost (smallest) node of the level of the given node.
+    static DomainTreeNode<T>* leftmostNode(DomainTreeNode<T>* node);
+
+    /// Return the search key of the rightmost label of the given labels.
+    static uint64_t getIndexKey(const bundy::dns::LabelSequence& labels,
+                                bundy::dns::LabelSequence& rightmost);
+
+    /// Return the node of the indexed level that is compared with the
+    /// given labels in \c find().  It's the node having the same rightmost
+    /// label if any; otherwise the closest larger node, or the largest one
+    /// if all nodes of the level are smaller.
+    DomainTreeNode<T>* findInIndex(
+        uint32_t index_id,
+        const bundy::dns::LabelSequence& target_labels) const;
+
+    /// Return the index identifier of the subdomain tree of the node,
+    /// or 0 if it isn't indexed.
+    uint32_t getDownIndex(const DomainTreeNode<T>* node) const {
+        return (index_ready_ ? node->down_index_ : 0);
+    }
+    //@}
+
+    /// \name Search index data
+    ///
+    /// Each level index is a \c LevelIndex header followed by \c count
+    /// entries in a single memory block.  The identifier of an index
+    /// (stored in \c DomainTreeNode::down_index_ and \c root_index_) is
+    /// its position in \c level_indexes_ plus 1.
+    //@{
+    struct LevelIndexEntry {
+        uint64_t key;
+        typename DomainTreeNode<T>::DomainTreeNodePtr node;
+    };
+    struct LevelIndex {
+        size_t count;
+        LevelIndexEntry* getEntries() {
+            return (reinterpret_cast<LevelIndexEntry*>(this + 1));
+        }
+        const LevelIndexEntry* getEntries() const {
+            return (reinterpret_cast<const LevelIndexEntry*>(this + 1));
+        }
+    };
+    typedef boost::interprocess::offset_ptr<LevelIndex> LevelIndexPtr;
     //@}
 
     typename DomainTreeNode<T>::DomainTreeNodePtr root_;
 
+    /// The table of level indexes; NULL if the tree doesn't have an index.
+    boost::interprocess::offset_ptr<LevelIndexPtr> level_indexes_;
+
+    /// The number of entries of \c level_indexes_.
+    uint32_t level_index_count_;
+
+    /// The index identifier of the top level, or 0 if it isn't indexed.
+    uint32_t root_index_;
+
     /// the node count of current tree.
     ///
     /// Note: uint32_t may look awkward, but we intentionally choose it so
@@ -1776,13 +1942,20 @@ private:
 
     /// search policy for domaintree
     const bool needsReturnEmptyNode_;
+
+    /// Whether the search index is complete and can be used by \c find().
+    bool index_ready_;
 };
 
 template <typename T>
 DomainTree<T>::DomainTree(bool returnEmptyNode) :
     root_(NULL),
+    level_indexes_(NULL),
+    level_index_count_(0),
+    root_index_(0),
     node_count_(0),
-    needsReturnEmptyNode_(returnEmptyNode)
+    needsReturnEmptyNode_(returnEmptyNode),
+    index_ready_(false)
 {
 }
 
@@ -1832,6 +2005,7 @@ DomainTree<T>::findImpl(TT* tree,
                         const bundy::dns::LabelSequence& target_labels_orig,
                         TTN** target,
                         TTN* node,
+                        uint32_t index_id,
                         DomainTreeNodeChain<T>& node_path,
                         bool (*callback)(const DomainTreeNode<T>&, CBARG),
                         CBARG callback_arg)
@@ -1846,6 +2020,10 @@ DomainTree<T>::findImpl(TT* tree,
     dns::LabelSequence target_labels(target_labels_orig);
 
     while (node != NULL) {
+        if (index_id != 0) {
+            // The level is indexed; jump to the only node that can match.
+            node = tree->findInIndex(index_id, target_labels);
+        }
         node_path.last_compared_ = node;
         node_path.last_comparison_ = target_labels.compare(node->getLabels());
         const bundy::dns::NameComparisonResult::NameRelation relation =
@@ -1859,6 +2037,12 @@ DomainTree<T>::findImpl(TT* tree,
             }
             break;
         } else if (relation == bundy::dns::NameComparisonResult::NONE) {
+            if (index_id != 0) {
+                // No node of the level matches.  The compared one is
+                // adjacent to the searched name, which is all previousNode()
+                // needs.
+                break;
+            }
             // If the two labels have no hierarchical relationship in terms
             // of matching, we should continue the binary search.
             node = (node_path.last_comparison_.getOrder() < 0) ?
@@ -1878,6 +2062,7 @@ DomainTree<T>::findImpl(TT* tree,
                 node_path.push(node);
                 target_labels.stripRight(
                     node_path.last_comparison_.getCommonLabels());
+                index_id = tree->getDownIndex(node);
                 node = node->getDown();
             } else {
                 break;
@@ -1904,9 +2089,10 @@ DomainTree<T>::find(const bundy::dns::LabelSequence& target_labels_orig,
     }
 
     DomainTreeNode<T>* node = root_.get();
+    const uint32_t index_id = index_ready_ ? root_index_ : 0;
 
     return (findImpl<DomainTree<T>, DomainTreeNode<T>, CBARG >
-            (this, target_labels_orig, target, node, node_path,
+            (this, target_labels_orig, target, node, index_id, node_path,
              callback, callback_arg));
 }
 
@@ -1920,18 +2106,21 @@ DomainTree<T>::find(const bundy::dns::LabelSequence& target_labels_orig,
                     CBARG callback_arg) const
 {
     const DomainTreeNode<T>* node;
+    uint32_t index_id;
 
     if (!node_path.isEmpty()) {
         // Get the top node in the node chain
         node = node_path.top();
+        index_id = getDownIndex(node);
         // Start searching from its down pointer
         node = node->getDown();
     } else {
         node = root_.get();
+        index_id = index_ready_ ? root_index_ : 0;
     }
 
     return (findImpl<const DomainTree<T>, const DomainTreeNode<T>, CBARG >
-            (this, target_labels_orig, target, node, node_path,
+            (this, target_labels_orig, target, node, index_id, node_path,
              callback, callback_arg));
 }
 
@@ -2153,7 +2342,7 @@ template <typename T>
 typename DomainTree<T>::Result
 DomainTree<T>::insert(util::MemorySegment& mem_sgmt,
                       const bundy::dns::Name& target_name,
-                      DomainTreeNode<T>** new_node)
+                      DomainTreeNode<T>** new_node, bool in_order)
 {
     DomainTreeNode<T>* parent = NULL;
     DomainTreeNode<T>* current = root_.get();
@@ -2165,6 +2354,39 @@ DomainTree<T>::insert(util::MemorySegment& mem_sgmt,
     // in the separate local buffer.
     uint8_t labels_buf[dns::LabelSequence::MAX_SERIALIZED_LENGTH];
     while (current != NULL) {
+        if (in_order && parent == NULL && current->getRight() != NULL) {
+            // We are at the root of a level.  If the name is given in
+            // order, it's most likely larger than or under the largest node
+            // of the level; check that node first.
+            DomainTreeNode<T>* largest = current->getRight();
+            while (largest->getRight() != NULL) {
+                largest = largest->getRight();
+            }
+            const bundy::dns::NameComparisonResult compare_result =
+                target_labels.compare(dns::LabelSequence(
+                                          largest->getLabels(), labels_buf));
+            const bundy::dns::NameComparisonResult::NameRelation relation =
+                compare_result.getRelation();
+            if (relation == bundy::dns::NameComparisonResult::EQUAL) {
+                if (new_node != NULL) {
+                    *new_node = largest;
+                }
+                return (ALREADYEXISTS);
+            } else if (relation == bundy::dns::NameComparisonResult::NONE &&
+                       compare_result.getOrder() > 0) {
+                parent = largest;
+                order = compare_result.getOrder();
+                break;
+            } else if (relation ==
+                       bundy::dns::NameComparisonResult::SUBDOMAIN) {
+                up_node = largest;
+                target_labels.stripRight(compare_result.getCommonLabels());
+                current = largest->getDown();
+                continue;
+            }
+            // Otherwise search the level from its root.
+        }
+
         const dns::LabelSequence current_labels(
             dns::LabelSequence(current->getLabels(), labels_buf));
         const bundy::dns::NameComparisonResult compare_result =
@@ -2196,6 +2418,7 @@ DomainTree<T>::insert(util::MemorySegment& mem_sgmt,
                                       compare_result.getCommonLabels());
             dns::LabelSequence new_prefix = current_labels;
             new_prefix.stripRight(compare_result.getCommonLabels());
+            destroyIndex(mem_sgmt);
             nodeFission(mem_sgmt, *current, new_prefix, common_ancestor);
             current = current->getParent();
         }
@@ -2203,6 +2426,7 @@ DomainTree<T>::insert(util::MemorySegment& mem_sgmt,
 
     typename DomainTreeNode<T>::DomainTreeNodePtr* current_root =
         (up_node != NULL) ? &(up_node->down_) : &root_;
+    destroyIndex(mem_sgmt);
     // Once a new node is created, no exception will be thrown until the end
     // of the function, so we can simply create and hold a new node pointer.
     DomainTreeNode<T>* node = DomainTreeNode<T>::create(mem_sgmt,
@@ -2249,6 +2473,9 @@ DomainTree<T>::remove(util::MemorySegment& mem_sgmt, DomainTreeNode<T>* node,
         return;
     }
 
+    // The node is going to be removed from its level.
+    destroyIndex(mem_sgmt);
+
     while (true) {
         // Save subtree root's parent for use later.
         DomainTreeNode<T>* upper_node = node->getUpperNode();
@@ -2358,6 +2585,7 @@ void
 DomainTree<T>::removeAllNodes(util::MemorySegment& mem_sgmt,
                               DataDeleter deleter)
 {
+    destroyIndex(mem_sgmt);
     deleteHelper(mem_sgmt, root_.get(), deleter);
     root_ = NULL;
 }
@@ -2409,6 +2637,206 @@ DomainTree<T>::nodeFission(util::MemorySegment& mem_sgmt,
     ++node_count_;
 }
 
+template <typename T>
+DomainTreeNode<T>*
+DomainTree<T>::leftmostNode(DomainTreeNode<T>* node) {
+    while (node->getLeft() != NULL) {
+        node = node->getLeft();
+    }
+    return (node);
+}
+
+template <typename T>
+uint64_t
+DomainTree<T>::getIndexKey(const bundy::dns::LabelSequence& labels,
+                           bundy::dns::LabelSequence& rightmost)
+{
+    rightmost = labels;
+    rightmost.stripLeft(labels.getLabelCount() - 1);
+
+    // The key is the first 8 octets of the label in lower case, in the
+    // network byte order and padded with 0, so comparing keys gives the
+    // same result as comparing the labels unless they are equal.
+    size_t len;
+    const uint8_t* data = rightmost.getData(&len);
+    const size_t label_len = data[0];
+    uint64_t key = 0;
+    for (size_t i = 0; i < sizeof(key); ++i) {
+        uint8_t c = 0;
+        if (i < label_len) {
+            c = data[i + 1];
+            if (c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+        }
+        key = (key << 8) | c;
+    }
+    return (key);
+}
+
+template <typename T>
+DomainTreeNode<T>*
+DomainTree<T>::findInIndex(uint32_t index_id,
+                           const bundy::dns::LabelSequence& target_labels)
+    const
+{
+    const LevelIndex& index = *level_indexes_[index_id - 1];
+    const LevelIndexEntry* const entries = index.getEntries();
+    dns::LabelSequence target_label(target_labels);
+    const uint64_t target_key = getIndexKey(target_labels, target_label);
+
+    // Find the first entry not smaller than the target.  Labels are only
+    // compared when the keys are equal, which is rare unless they match.
+    size_t lo = 0;
+    size_t hi = index.count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const LevelIndexEntry& entry = entries[mid];
+        bool less = entry.key < target_key;
+        if (entry.key == target_key) {
+            dns::LabelSequence label(target_labels);
+            getIndexKey(entry.node->getLabels(), label);
+            less = label.compare(target_label).getOrder() < 0;
+        }
+        if (less) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (entries[lo < index.count ? lo : index.count - 1].node.get());
+}
+
+template <typename T>
+void
+DomainTree<T>::buildIndex(util::MemorySegment& mem_sgmt) {
+    destroyIndex(mem_sgmt);
+    if (root_ == NULL) {
+        index_ready_ = true;
+        return;
+    }
+
+    // Collect the levels of the tree (as their leftmost nodes) that are
+    // large enough to be indexed.
+    std::vector<std::pair<DomainTreeNode<T>*, size_t> > levels;
+    std::vector<DomainTreeNode<T>*> pending(1, leftmostNode(root_.get()));
+    while (!pending.empty()) {
+        DomainTreeNode<T>* const first = pending.back();
+        pending.pop_back();
+        size_t count = 0;
+        for (DomainTreeNode<T>* node = first; node != NULL;
+             node = node->successor()) {
+            ++count;
+            if (node->getDown() != NULL) {
+                pending.push_back(leftmostNode(node->getDown()));
+            }
+        }
+        if (count >= INDEX_MIN_NODES) {
+            levels.push_back(std::make_pair(first, count));
+        }
+    }
+    if (levels.empty()) {
+        index_ready_ = true;
+        return;
+    }
+
+    // Allocate the table and the indexes.  Each piece of memory is
+    // recorded in the tree as soon as it's allocated, so destroyIndex()
+    // can release it if a subsequent allocation fails.
+    void* p = mem_sgmt.allocate(sizeof(LevelIndexPtr) * levels.size());
+    LevelIndexPtr* table = static_cast<LevelIndexPtr*>(p);
+    for (size_t i = 0; i < levels.size(); ++i) {
+        new(&table[i]) LevelIndexPtr(NULL);
+    }
+    level_indexes_ = table;
+    level_index_count_ = levels.size();
+    for (size_t i = 0; i < levels.size(); ++i) {
+        p = mem_sgmt.allocate(sizeof(LevelIndex) +
+                              sizeof(LevelIndexEntry) * levels[i].second);
+        LevelIndex* index = static_cast<LevelIndex*>(p);
+        index->count = levels[i].second;
+        level_indexes_[i] = index;
+    }
+
+    // Fill in the indexes.  Nodes of a level are visited in the order of
+    // their rightmost labels, so the entries are sorted.  Then set the
+    // index identifier of all nodes (the ones of non-indexed levels may
+    // have a stale one).
+    for (size_t i = 0; i < levels.size(); ++i) {
+        LevelIndexEntry* entries = level_indexes_[i]->getEntries();
+        DomainTreeNode<T>* node = levels[i].first;
+        for (size_t j = 0; j < levels[i].second; ++j) {
+            dns::LabelSequence label(node->getLabels());
+            LevelIndexEntry* entry = new(&entries[j]) LevelIndexEntry;
+            entry->key = getIndexKey(node->getLabels(), label);
+            entry->node = node;
+            node = node->successor();
+        }
+    }
+    pending.assign(1, leftmostNode(root_.get()));
+    root_index_ = 0;
+    while (!pending.empty()) {
+        DomainTreeNode<T>* const first = pending.back();
+        pending.pop_back();
+        for (DomainTreeNode<T>* node = first; node != NULL;
+             node = node->successor()) {
+            node->down_index_ = 0;
+            if (node->getDown() != NULL) {
+                pending.push_back(leftmostNode(node->getDown()));
+            }
+        }
+    }
+    for (size_t i = 0; i < levels.size(); ++i) {
+        DomainTreeNode<T>* const upper = levels[i].first->getUpperNode();
+        if (upper == NULL) {
+            root_index_ = i + 1;
+        } else {
+            upper->down_index_ = i + 1;
+        }
+    }
+    index_ready_ = true;
+}
+
+template <typename T>
+void
+DomainTree<T>::destroyIndex(util::MemorySegment& mem_sgmt) {
+    index_ready_ = false;
+    if (level_indexes_ == NULL) {
+        return;
+    }
+    LevelIndexPtr* table = level_indexes_.get();
+    for (size_t i = 0; i < level_index_count_; ++i) {
+        LevelIndex* index = table[i].get();
+        if (index != NULL) {
+            mem_sgmt.deallocate(index,
+                                sizeof(LevelIndex) +
+                                sizeof(LevelIndexEntry) * index->count);
+        }
+    }
+    mem_sgmt.deallocate(table, sizeof(LevelIndexPtr) * level_index_count_);
+    level_indexes_ = NULL;
+    level_index_count_ = 0;
+    root_index_ = 0;
+}
+
+
+template <typename T>
+size_t
+DomainTree<T>::getIndexSize() const {
+    if (level_indexes_ == NULL) {
+        return (0);
+    }
+    size_t size = sizeof(LevelIndexPtr) * level_index_count_;
+    const LevelIndexPtr* table = level_indexes_.get();
+    for (size_t i = 0; i < level_index_count_; ++i) {
+        const LevelIndex* index = table[i].get();
+        if (index != NULL) {
+            size += sizeof(LevelIndex) +
+                sizeof(LevelIndexEntry) * index->count;
+        }
+    }
+    return (size);
+}
 
 /// \brief Fix Red-Black tree properties after an ordinary BST
 /// insertion.
@@ -2917,6 +3345,26 @@ DomainTree<T>::getHeight() const {
     return (getHeightHelper(root_.get()));
 }
 
+template <typename T>
+size_t
+DomainTree<T>::getMemorySizeHelper(const DomainTreeNode<T>* node) const {
+    if (node == NULL) {
+        return (0);
+    }
+
+    return (node->getMemorySize() +
+            getMemorySizeHelper(node->getLeft()) +
+            getMemorySizeHelper(node->getRight()) +
+            getMemorySizeHelper(node->getDown()));
+}
+
+template <typename T>
+size_t
+DomainTree<T>::getMemorySize() const {
+    return (sizeof(DomainTree<T>) + getMemorySizeHelper(root_.get()) +
+            getIndexSize());
+}
+
 template <typename T>
 bool
 DomainTree<T>::checkPropertiesHelper(const DomainTreeNode<T>* node) const {
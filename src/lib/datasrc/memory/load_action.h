@@ -15,8 +15,12 @@
 #ifndef LOAD_ACTION_H
 #define LOAD_ACTION_H
 
+#include <dns/rrset.h>
+
 #include <boost/function.hpp>
 
+#include <vector>
+
 namespace bundy {
 // Forward declarations
 namespace util{
@@ -40,6 +44,23 @@ class ZoneData;
 /// It must not return NULL.
 typedef boost::function<ZoneData*(util::MemorySegment&)> LoadAction;
 
+/// \brief Callback to get differences to be applied to loaded zone data
+///
+/// This is called from the ZoneWriter when it can update the zone data
+/// that is currently loaded in memory instead of loading the entire zone.
+/// The callback is given the currently loaded \c ZoneData, and should
+/// store the differences between its version and the latest version of
+/// the zone in the passed vector, in the form of an IXFR sequence (each
+/// difference sequence begins with the SOA of the older version, followed
+/// by the deleted RRs, the SOA of the newer version and the added RRs).
+/// If the loaded version is the latest, the vector should be left empty.
+///
+/// It returns false if the differences are not available (e.g., the
+/// data source doesn't have a journal for the versions); the zone is then
+/// loaded entirely by the \c LoadAction.
+typedef boost::function<bool(const ZoneData&,
+                             std::vector<dns::ConstRRsetPtr>&)> DiffAction;
+
 }
 }
 }
@@ -30,6 +30,10 @@
 #include <dns/rdataclass.h>
 #include <dns/rrclass.h>
 
+#include <util/thread_arena.h>
+
+#include <boost/make_shared.hpp>
+
 #include <utility>
 
 using namespace bundy::dns;
@@ -72,7 +76,10 @@ InMemoryClient::findZone(const bundy::dns::Name& zone_name) const {
 
     ZoneFinderPtr finder;
     if (result.code != result::NOTFOUND && result.zone_data) {
-        finder.reset(new InMemoryZoneFinder(*result.zone_data, getClass()));
+        // This is called for every query; avoid the global allocator.
+        finder = boost::allocate_shared<InMemoryZoneFinder>(
+            ArenaAllocator<InMemoryZoneFinder>(), *result.zone_data,
+            getClass());
     }
 
     return (DataSourceClient::FindResult(result.code, finder, result.flags));
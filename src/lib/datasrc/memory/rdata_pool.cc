@@ -0,0 +1,169 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/rdata_pool.h>
+
+#include <cassert>
+#include <cstring>
+#include <new>                  // for the placement new
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+namespace {
+// The initial number of buckets of the hash table.
+const uint32_t INITIAL_BUCKET_COUNT = 64;
+
+// 32-bit FNV-1a hash of the data.
+uint32_t
+hashData(const void* data, size_t data_len) {
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < data_len; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    return (hash);
+}
+}
+
+RdataPool*
+RdataPool::create(util::MemorySegment& mem_sgmt) {
+    void* p = mem_sgmt.allocate(sizeof(RdataPool));
+    return (new(p) RdataPool);
+}
+
+void
+RdataPool::destroy(util::MemorySegment& mem_sgmt, RdataPool* pool) {
+    if (pool->buckets_) {
+        for (uint32_t i = 0; i < pool->bucket_count_; ++i) {
+            Entry* entry = pool->buckets_[i].get();
+            while (entry != NULL) {
+                // Only unreferenced blocks can be left.
+                assert(entry->refcount_ == 0);
+                Entry* next = entry->next_.get();
+                const size_t len = entry->len_;
+                entry->~Entry();
+                mem_sgmt.deallocate(entry, sizeof(Entry) + len);
+                entry = next;
+            }
+        }
+        mem_sgmt.deallocate(pool->buckets_.get(),
+                            sizeof(EntryPtr) * pool->bucket_count_);
+    }
+    pool->~RdataPool();
+    mem_sgmt.deallocate(pool, sizeof(RdataPool));
+}
+
+size_t
+RdataPool::getMemorySize() const {
+    size_t size = sizeof(RdataPool);
+    if (buckets_) {
+        size += sizeof(EntryPtr) * bucket_count_;
+        for (uint32_t i = 0; i < bucket_count_; ++i) {
+            for (const Entry* entry = buckets_[i].get();
+                 entry != NULL;
+                 entry = entry->next_.get()) {
+                size += sizeof(Entry) + entry->len_;
+            }
+        }
+    }
+    return (size);
+}
+
+void
+RdataPool::grow(util::MemorySegment& mem_sgmt) {
+    const uint32_t new_count = bucket_count_ == 0 ? INITIAL_BUCKET_COUNT :
+        bucket_count_ * 2;
+    // This is the only allocation; once it succeeds nothing can throw.
+    EntryPtr* new_buckets = static_cast<EntryPtr*>(
+        mem_sgmt.allocate(sizeof(EntryPtr) * new_count));
+    for (uint32_t i = 0; i < new_count; ++i) {
+        new(&new_buckets[i]) EntryPtr();
+    }
+    if (buckets_) {
+        for (uint32_t i = 0; i < bucket_count_; ++i) {
+            Entry* entry = buckets_[i].get();
+            while (entry != NULL) {
+                Entry* next = entry->next_.get();
+                EntryPtr& bucket = new_buckets[entry->hash_ & (new_count - 1)];
+                entry->next_ = bucket;
+                bucket = entry;
+                entry = next;
+            }
+        }
+        mem_sgmt.deallocate(buckets_.get(), sizeof(EntryPtr) * bucket_count_);
+    }
+    buckets_ = new_buckets;
+    bucket_count_ = new_count;
+}
+
+RdataPool::Entry*
+RdataPool::intern(util::MemorySegment& mem_sgmt, const void* data,
+                  size_t data_len)
+{
+    const uint32_t hash = hashData(data, data_len);
+    if (buckets_) {
+        for (Entry* entry = buckets_[hash & (bucket_count_ - 1)].get();
+             entry != NULL;
+             entry = entry->next_.get()) {
+            if (entry->hash_ == hash && entry->len_ == data_len &&
+                std::memcmp(entry->getData(), data, data_len) == 0) {
+                return (entry);
+            }
+        }
+    }
+
+    // Not found; make a new block.  Each of the allocations below can
+    // throw, but the pool is consistent whenever they do.
+    if (entry_count_ >= bucket_count_) {
+        grow(mem_sgmt);
+    }
+    void* p = mem_sgmt.allocate(sizeof(Entry) + data_len);
+    Entry* entry = new(p) Entry(this, hash, data_len);
+    std::memcpy(static_cast<uint8_t*>(p) + sizeof(Entry), data, data_len);
+    EntryPtr& bucket = buckets_[hash & (bucket_count_ - 1)];
+    entry->next_ = bucket;
+    bucket = entry;
+    ++entry_count_;
+    return (entry);
+}
+
+void
+RdataPool::removeReference(util::MemorySegment& mem_sgmt, Entry* entry) {
+    assert(entry->refcount_ > 0);
+    if (--entry->refcount_ == 0) {
+        entry->pool_->removeEntry(mem_sgmt, entry);
+    }
+}
+
+void
+RdataPool::removeEntry(util::MemorySegment& mem_sgmt, Entry* entry) {
+    for (EntryPtr* link = &buckets_[entry->hash_ & (bucket_count_ - 1)];
+         *link;
+         link = &(*link)->next_) {
+        if (link->get() == entry) {
+            *link = entry->next_;
+            break;
+        }
+    }
+    --entry_count_;
+    const size_t len = entry->len_;
+    entry->~Entry();
+    mem_sgmt.deallocate(entry, sizeof(Entry) + len);
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
@@ -0,0 +1,177 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_MEMORY_RDATA_POOL_H
+#define DATASRC_MEMORY_RDATA_POOL_H 1
+
+#include <util/memory_segment.h>
+
+#include <boost/interprocess/offset_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+/// \brief A pool of shared, encoded RDATA.
+///
+/// Large zones often contain many RRsets of identical RDATA, such as the
+/// same set of NS or MX records for many names.  \c RdataPool allows
+/// \c RdataSet objects of the same zone to share a single copy of such
+/// data: it keeps encoded RDATA blocks in a hash table keyed by their
+/// content, and each block is reference counted by the \c RdataSet
+/// objects using it (see \c RdataSet::create()).
+///
+/// A block is removed from the pool and deallocated when the last
+/// \c RdataSet that refers to it is destroyed, so the pool itself doesn't
+/// have to be known at that time.  The pool must outlive all \c RdataSet
+/// objects that refer to its blocks.
+///
+/// Like \c RdataSet, this class is designed so an instance can be stored
+/// in a shared memory region; it only contains plain data and offset
+/// pointers.
+class RdataPool : boost::noncopyable {
+public:
+    /// \brief A shared block of encoded RDATA.
+    ///
+    /// The encoded data immediately follow this header.
+    class Entry : boost::noncopyable {
+    public:
+        /// \brief Return the pointer to the encoded data.
+        const void* getData() const { return (this + 1); }
+
+        /// \brief Return the length of the encoded data in bytes.
+        size_t getLength() const { return (len_); }
+
+        /// \brief Return the number of \c RdataSet objects referring
+        /// to this block.
+        size_t getRefCount() const { return (refcount_); }
+
+    private:
+        friend class RdataPool;
+
+        Entry(RdataPool* pool, uint32_t hash, size_t len) :
+            pool_(pool), refcount_(0), hash_(hash), len_(len)
+        {}
+        ~Entry() {}
+
+        const boost::interprocess::offset_ptr<RdataPool> pool_;
+        boost::interprocess::offset_ptr<Entry> next_;
+        uint32_t refcount_;
+        const uint32_t hash_;
+        const uint32_t len_;
+    };
+
+    /// \brief Allocate and construct an empty \c RdataPool.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the new
+    /// \c RdataPool (and its blocks) is allocated.
+    static RdataPool* create(util::MemorySegment& mem_sgmt);
+
+    /// \brief Destruct and deallocate \c RdataPool.
+    ///
+    /// All \c RdataSet objects referring to blocks of the pool must have
+    /// been destroyed.  Any blocks left unreferenced in the pool (see
+    /// \c intern()) are deallocated.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// \c pool.
+    /// \param pool A non NULL pointer to a valid \c RdataPool object.
+    static void destroy(util::MemorySegment& mem_sgmt, RdataPool* pool);
+
+    /// \brief Find or add a block of the given encoded data.
+    ///
+    /// If the pool already has a block of the same content, it's returned;
+    /// otherwise a new block is made with a copy of the data.  This method
+    /// doesn't add a reference to the block; the caller is expected to call
+    /// \c addReference() once it has successfully made a reference.  If it
+    /// fails to do so (e.g., due to \c MemorySegmentGrown), the block stays
+    /// in the pool unreferenced, where it can be found again by a retry.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt The \c MemorySegment used to create the pool.
+    /// \param data The encoded RDATA.
+    /// \param data_len The length of \c data in bytes.
+    ///
+    /// \return A pointer to the block of the data.
+    Entry* intern(util::MemorySegment& mem_sgmt, const void* data,
+                  size_t data_len);
+
+    /// \brief Add a reference to a block.
+    ///
+    /// \throw none
+    static void addReference(Entry* entry) {
+        ++entry->refcount_;
+    }
+
+    /// \brief Remove a reference to a block.
+    ///
+    /// If it was the last reference, the block is removed from its pool
+    /// and deallocated.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment used to create the pool.
+    /// \param entry The block, which must have been referenced by
+    /// \c addReference().
+    static void removeReference(util::MemorySegment& mem_sgmt, Entry* entry);
+
+    /// \brief Return the number of blocks in the pool.
+    size_t getEntryCount() const { return (entry_count_); }
+
+    /// \brief Return the size of the memory allocated for the pool.
+    ///
+    /// It includes the pool itself, its hash table and all its blocks.
+    /// This walks through the entire pool, so it's not expected to be
+    /// used in a performance sensitive path.
+    ///
+    /// \throw none
+    size_t getMemorySize() const;
+
+private:
+    typedef boost::interprocess::offset_ptr<Entry> EntryPtr;
+
+    RdataPool() : bucket_count_(0), entry_count_(0) {}
+    ~RdataPool() {}
+
+    // Double the number of buckets (or allocate the first ones).
+    void grow(util::MemorySegment& mem_sgmt);
+    // Unlink the entry from the pool and deallocate it.
+    void removeEntry(util::MemorySegment& mem_sgmt, Entry* entry);
+
+    boost::interprocess::offset_ptr<EntryPtr> buckets_;
+    uint32_t bucket_count_;
+    uint32_t entry_count_;
+};
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_MEMORY_RDATA_POOL_H
+
+// Local Variables:
+// mode: c++
+// End:
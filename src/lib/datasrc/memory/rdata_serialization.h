@@ -92,6 +92,14 @@ namespace bundy {
 namespace datasrc {
 namespace memory {
 
+/// \brief Version of the encoding of RDATA.
+///
+/// Encoded data can be saved to a file and restored by another process
+/// (see \c RdataSet::create()).  This must be incremented whenever the
+/// encoding changes, including the serialized form of names used in it,
+/// so that data saved in an older encoding are rejected, not misread.
+const uint16_t RDATA_ENCODING_VERSION = 1;
+
 /// \brief General error in RDATA encoding.
 ///
 /// This is thrown when \c RdataEncoder encounters a rare, unsupported
@@ -29,8 +29,10 @@
 
 #include <stdint.h>
 #include <algorithm>
+#include <cassert>
 #include <cstring>
 #include <new>                  // for the placement new
+#include <vector>
 
 using namespace bundy::dns;
 using namespace bundy::dns::rdata;
@@ -117,14 +119,43 @@ sanityChecks(const ConstRRsetPtr& rrset, const ConstRRsetPtr &sig_rrset,
 
 } // Anonymous namespace
 
+RdataSet*
+RdataSet::createShared(util::MemorySegment& mem_sgmt, const RRType& rrtype,
+                       size_t rdata_count, size_t rrsig_count,
+                       const RRTTL& rrttl, const void* data, size_t data_len,
+                       RdataPool* pool)
+{
+    assert(isShareable(pool, rrsig_count, data_len));
+
+    // If allocating the RdataSet fails with MemorySegmentGrown, the entry
+    // is left in the pool unreferenced, and will be found on retry.
+    RdataPool::Entry* entry = pool->intern(mem_sgmt, data, data_len);
+    void* p = mem_sgmt.allocate(sizeof(RdataSet) + sizeof(SharedData));
+    RdataSet* rdataset = new(p) RdataSet(rrtype, rdata_count,
+                                         MANY_RRSIG_COUNT, rrttl);
+    SharedData* shared = new(rdataset->getSharedData()) SharedData;
+    shared->sig_rdata_count = 0;
+    shared->entry = entry;
+    RdataPool::addReference(entry);
+    return (rdataset);
+}
+
 RdataSet*
 RdataSet::packSet(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
                   size_t rdata_count, size_t rrsig_count, const RRType& rrtype,
-                  const RRTTL& rrttl)
+                  const RRTTL& rrttl, RdataPool* pool)
 {
+    const size_t data_len = encoder.getStorageLength();
+    if (isShareable(pool, rrsig_count, data_len)) {
+        // The encoder requires the buffer to be aligned for uint16_t.
+        std::vector<uint16_t> buf((data_len + 1) / sizeof(uint16_t));
+        encoder.encode(&buf[0], data_len);
+        return (createShared(mem_sgmt, rrtype, rdata_count, rrsig_count,
+                             rrttl, &buf[0], data_len, pool));
+    }
+
     const size_t ext_rrsig_count_len =
         rrsig_count >= MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
-    const size_t data_len = encoder.getStorageLength();
     void* p = mem_sgmt.allocate(sizeof(RdataSet) + ext_rrsig_count_len +
                                 data_len);
     RdataSet* rdataset = new(p) RdataSet(rrtype, rdata_count, rrsig_count,
@@ -139,7 +170,7 @@ RdataSet::packSet(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
 RdataSet*
 RdataSet::create(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
                  ConstRRsetPtr rrset, ConstRRsetPtr sig_rrset,
-                 const RdataSet* old_rdataset)
+                 const RdataSet* old_rdataset, RdataPool* pool)
 {
     const std::pair<RRClass, RRType>& rrparams =
         sanityChecks(rrset, sig_rrset, old_rdataset);
@@ -194,7 +225,7 @@ RdataSet::create(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
     }
 
     return (packSet(mem_sgmt, encoder, rdata_count, rrsig_count, rrtype,
-                    rrttl));
+                    rrttl, pool));
 }
 
 namespace {
@@ -249,7 +280,7 @@ RdataSet*
 RdataSet::subtract(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
                    const dns::ConstRRsetPtr& rrset,
                    const dns::ConstRRsetPtr& sig_rrset,
-                   const RdataSet& old_rdataset)
+                   const RdataSet& old_rdataset, RdataPool* pool)
 {
     const std::pair<RRClass, RRType>& rrparams =
         sanityChecks(rrset, sig_rrset, &old_rdataset);
@@ -285,24 +316,90 @@ RdataSet::subtract(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
         return (NULL); // It is left empty
     }
     return (packSet(mem_sgmt, encoder, rdata_count, rrsig_count, rrtype,
-                    restoreTTL(old_rdataset.getTTLData())));
+                    restoreTTL(old_rdataset.getTTLData()), pool));
+}
+
+RdataSet*
+RdataSet::create(util::MemorySegment& mem_sgmt, const RRClass& rrclass,
+                 const RRType& type, size_t rdata_count,
+                 size_t sig_rdata_count, const void* ttl_data,
+                 const void* data, size_t data_len, RdataPool* pool)
+{
+    if (rdata_count > MAX_RDATA_COUNT) {
+        bundy_throw(RdataSetError, "Too many RDATAs for RdataSet: "
+                  << rdata_count << ", must be <= " << MAX_RDATA_COUNT);
+    }
+    if (sig_rdata_count > MAX_RRSIG_COUNT) {
+        bundy_throw(RdataSetError, "Too many RRSIGs for RdataSet: "
+                  << sig_rdata_count << ", must be <= " << MAX_RRSIG_COUNT);
+    }
+    if (isShareable(pool, sig_rdata_count, data_len)) {
+        RdataSet* rdataset =
+            createShared(mem_sgmt, type, rdata_count, sig_rdata_count,
+                         restoreTTL(ttl_data), data, data_len, pool);
+        // The pool entry keeps its own length, so it's safe to destroy.
+        if (rdataset->getDataLength(rrclass) != data_len) {
+            destroy(mem_sgmt, rdataset, rrclass);
+            bundy_throw(RdataSetError, "Length of encoded RDATA doesn't "
+                        "match the data: " << data_len);
+        }
+        return (rdataset);
+    }
+
+    const size_t ext_rrsig_count_len =
+        sig_rdata_count >= MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
+    const size_t size = sizeof(RdataSet) + ext_rrsig_count_len + data_len;
+    void* p = mem_sgmt.allocate(size);
+    RdataSet* rdataset = new(p) RdataSet(type, rdata_count, sig_rdata_count,
+                                         restoreTTL(ttl_data));
+    if (sig_rdata_count >= MANY_RRSIG_COUNT) {
+        *rdataset->getExtSIGCountBuf() = sig_rdata_count;
+    }
+    if (data_len > 0) {
+        std::memcpy(rdataset->getDataBuf(), data, data_len);
+    }
+    // destroy() would calculate the size from the encoded data, so if it
+    // doesn't match, release the object here with the size we allocated.
+    if (rdataset->getDataLength(rrclass) != data_len) {
+        rdataset->~RdataSet();
+        mem_sgmt.deallocate(p, size);
+        bundy_throw(RdataSetError, "Length of encoded RDATA doesn't match "
+                    "the data: " << data_len);
+    }
+    return (rdataset);
+}
+
+size_t
+RdataSet::getDataLength(RRClass rrclass) const {
+    return (RdataReader(rrclass, type,
+                        reinterpret_cast<const uint8_t*>(getDataBuf()),
+                        getRdataCount(), getSigRdataCount(),
+                        &RdataReader::emptyNameAction,
+                        &RdataReader::emptyDataAction).getSize());
+}
+
+size_t
+RdataSet::getMemorySize(RRClass rrclass) const {
+    if (isShared()) {
+        return (sizeof(RdataSet) + sizeof(SharedData));
+    }
+    const size_t ext_rrsig_count_len =
+        sig_rdata_count_ == MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
+    return (sizeof(RdataSet) + ext_rrsig_count_len + getDataLength(rrclass));
 }
 
 void
 RdataSet::destroy(util::MemorySegment& mem_sgmt, RdataSet* rdataset,
                   RRClass rrclass)
 {
-    const size_t data_len =
-        RdataReader(rrclass, rdataset->type,
-                    reinterpret_cast<const uint8_t*>(rdataset->getDataBuf()),
-                    rdataset->getRdataCount(), rdataset->getSigRdataCount(),
-                    &RdataReader::emptyNameAction,
-                    &RdataReader::emptyDataAction).getSize();
-    const size_t ext_rrsig_count_len =
-        rdataset->sig_rdata_count_ == MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
+    const size_t size = rdataset->getMemorySize(rrclass);
+    if (rdataset->isShared()) {
+        RdataPool::removeReference(mem_sgmt,
+                                   rdataset->getSharedData()->entry.get());
+        rdataset->getSharedData()->~SharedData();
+    }
     rdataset->~RdataSet();
-    mem_sgmt.deallocate(rdataset,
-                        sizeof(RdataSet) + ext_rrsig_count_len + data_len);
+    mem_sgmt.deallocate(rdataset, size);
 }
 
 namespace {
@@ -17,6 +17,8 @@
 
 #include <util/memory_segment.h>
 
+#include <datasrc/memory/rdata_pool.h>
+
 #include <dns/rrclass.h>
 #include <dns/rrtype.h>
 #include <dns/rrset.h>
@@ -107,6 +109,12 @@ public:
 /// (optional) uint16_t: number of RRSIGs, if it's larger than 6 (see above)
 /// encoded RDATA (generated by RdataEncoder) \endverbatim
 ///
+/// If an \c RdataPool is given on creation, the encoded RDATA of an
+/// \c RdataSet without RRSIGs can instead be stored in the pool and shared
+/// with other \c RdataSet objects of the same content (see \c create()).
+/// In that case the region following the main object only holds a
+/// reference to the shared data.
+///
 /// This is shown here only for reference purposes.  The application must not
 /// assume any particular format of data in this region directly; it must
 /// get access to it via public interfaces provided in the main \c RdataSet
@@ -176,12 +184,20 @@ public:
     /// it cannot contain more than 65535 RRSIGs.  If the given RRset(s) fail
     /// to meet this condition, an \c RdataSetError exception will be thrown.
     ///
+    /// If \c pool is non NULL and the resulting \c RdataSet doesn't contain
+    /// RRSIGs, the encoded RDATA are stored in the pool, so any other
+    /// \c RdataSet of the same encoded RDATA created with the same pool
+    /// shares a single copy of them.  Small RDATA (such as those of a
+    /// single A RR) are always stored inline, as a reference to the shared
+    /// copy would be larger than the data itself.  Sharing is transparent
+    /// to the users of the \c RdataSet, but the pool must outlive it.
+    ///
     /// This method ensures there'll be no memory leak on exception.
     /// But addresses allocated from \c mem_sgmt could be relocated if
     /// \c util::MemorySegmentGrown is thrown; the caller or its upper layer
     /// must be aware of that possibility and update any such addresses
-    /// accordingly.  On successful return, this method ensures there's no
-    /// address relocation.
+    /// (including \c pool) accordingly.  On successful return, this method
+    /// ensures there's no address relocation.
     ///
     /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
     ///     relocating data.
@@ -199,13 +215,63 @@ public:
     /// created.  Can be NULL if rrset is not.
     /// \param old_rdataset If non NULL, create RdataSet merging old_rdataset
     /// into given rrset and sig_rrset.
+    /// \param pool If non NULL, the pool to share the encoded RDATA with
+    /// other \c RdataSet objects.  It must have been created in \c mem_sgmt.
     ///
     /// \return A pointer to the created \c RdataSet.
     static RdataSet* create(util::MemorySegment& mem_sgmt,
                             RdataEncoder& encoder,
                             dns::ConstRRsetPtr rrset,
                             dns::ConstRRsetPtr sig_rrset,
-                            const RdataSet* old_rdataset = NULL);
+                            const RdataSet* old_rdataset = NULL,
+                            RdataPool* pool = NULL);
+
+    /// \brief Allocate and construct \c RdataSet from encoded data.
+    ///
+    /// This is a lower level version of \c create().  Instead of encoding
+    /// RRsets, it copies RDATA that were already encoded by \c RdataEncoder
+    /// (in the form returned by \c getDataBuf() of another \c RdataSet,
+    /// possibly created in a different process) into the new object.  It's
+    /// intended to be used to restore a saved copy of \c RdataSet objects
+    /// without the cost of parsing and encoding RDATA again.
+    ///
+    /// \c data must be a valid encoding for the given RR type and counts on
+    /// the same kind of machine (the encoding is in host byte order) with
+    /// the same \c RDATA_ENCODING_VERSION.  This method only checks that
+    /// \c data_len is the length of the data as calculated from the
+    /// encoded lengths (see \c getDataLength()), so the object can be
+    /// safely destroyed; otherwise the behavior of any later operation on
+    /// the created object is undefined.
+    ///
+    /// Like the other version, the memory segment may grow and relocate
+    /// addresses allocated from it.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw RdataSetError Number of RDATAs exceed the limits, or
+    ///     \c data_len doesn't match the encoded data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the new
+    /// \c RdataSet is allocated.
+    /// \param rrclass The RR class of the \c RdataSet.
+    /// \param type The RR type of the \c RdataSet.
+    /// \param rdata_count The number of (non RRSIG) RDATAs in \c data.
+    /// \param sig_rdata_count The number of RRSIG RDATAs in \c data.
+    /// \param ttl_data 32-bit TTL in the network byte order, in the form
+    /// returned by \c getTTLData().
+    /// \param data The encoded RDATA.
+    /// \param data_len The length of \c data in bytes.
+    /// \param pool If non NULL, the pool to share the encoded RDATA with
+    /// other \c RdataSet objects (see the other version).
+    ///
+    /// \return A pointer to the created \c RdataSet.
+    static RdataSet* create(util::MemorySegment& mem_sgmt,
+                            const dns::RRClass& rrclass,
+                            const dns::RRType& type, size_t rdata_count,
+                            size_t sig_rdata_count, const void* ttl_data,
+                            const void* data, size_t data_len,
+                            RdataPool* pool = NULL);
 
     /// \brief Subtract some RDATAs and RRSIGs from an RdataSet
     ///
@@ -246,13 +312,16 @@ public:
     /// \param sig_rrset An RRSIG RRset containing the RRSIGs that are not
     /// to be present in the result. Can be NULL if rrset is not.
     /// \param old_rdataset The data from which to subtract.
+    /// \param pool If non NULL, the pool to share the encoded RDATA with
+    /// other \c RdataSet objects (see \c create()).
     ///
     /// \return A pointer to the created \c RdataSet.
     static RdataSet* subtract(util::MemorySegment& mem_sgmt,
                               RdataEncoder& encoder,
                               const dns::ConstRRsetPtr& rrset,
                               const dns::ConstRRsetPtr& sig_rrset,
-                              const RdataSet& old_rdataset);
+                              const RdataSet& old_rdataset,
+                              RdataPool* pool = NULL);
 
     /// \brief Destruct and deallocate \c RdataSet
     ///
@@ -266,6 +335,10 @@ public:
     /// (when given) or of \c sig_rrset (when \c rrset isn't given) at the
     /// \c create() time.
     ///
+    /// If the \c RdataSet shares its RDATA in an \c RdataPool, the reference
+    /// to the shared data is released, and the data are deallocated if
+    /// it was the last reference.
+    ///
     /// \throw none
     ///
     /// \param mem_sgmt The \c MemorySegment that allocated memory for
@@ -358,11 +431,39 @@ private:
     // field for the real number of RRSIGs.  It's 2^3 - 1 = 7.
     static const size_t MANY_RRSIG_COUNT = (1 << 3) - 1;
 
+    // The reference to the encoded RDATA in an RdataPool, stored
+    // immediately after an RdataSet sharing them.  The RdataSet is
+    // constructed as having MANY_RRSIG_COUNT RRSIGs, so the first field
+    // takes the place of the real RRSIG count.  It's always 0, which is
+    // otherwise impossible in that place, and marks the RdataSet as shared.
+    struct SharedData {
+        uint16_t sig_rdata_count;
+        boost::interprocess::offset_ptr<RdataPool::Entry> entry;
+    };
+
     // Common code for packing the result in create and subtract.
     static RdataSet* packSet(util::MemorySegment& mem_sgmt,
                              RdataEncoder& encoder, size_t rdata_count,
                              size_t rrsig_count, const dns::RRType& rrtype,
-                             const dns::RRTTL& rrttl);
+                             const dns::RRTTL& rrttl, RdataPool* pool);
+
+    // Whether an RdataSet of the given content should share its data in
+    // the pool.  A reference to the shared data isn't smaller than small
+    // data, and RRSIGs are specific to the owner name, so such RdataSets
+    // are never shared.
+    static bool isShareable(const RdataPool* pool, size_t rrsig_count,
+                            size_t data_len)
+    {
+        return (pool != NULL && rrsig_count == 0 &&
+                data_len > sizeof(SharedData));
+    }
+
+    // Allocate an RdataSet sharing the given data in the pool.
+    static RdataSet* createShared(util::MemorySegment& mem_sgmt,
+                                  const dns::RRType& rrtype,
+                                  size_t rdata_count, size_t rrsig_count,
+                                  const dns::RRTTL& rrttl, const void* data,
+                                  size_t data_len, RdataPool* pool);
 
 public:
     /// \brief Return the bare pointer to the next node.
@@ -412,6 +513,36 @@ public:
         return (getDataBuf<const void, const RdataSet>(this));
     }
 
+    /// \brief Return if the encoded RDATAs are shared in an \c RdataPool.
+    ///
+    /// \throw none
+    bool isShared() const {
+        return (sig_rdata_count_ == MANY_RRSIG_COUNT &&
+                *getExtSIGCountBuf() == 0);
+    }
+
+    /// \brief Return the length of the memory region for encoded RDATAs.
+    ///
+    /// Since \c RdataSet doesn't hold the RR class, the caller needs to
+    /// provide it (see \c destroy()).
+    ///
+    /// \throw none
+    ///
+    /// \param rrclass The RR class of the \c RdataSet.
+    /// \return The length of the data at \c getDataBuf() in bytes.
+    size_t getDataLength(dns::RRClass rrclass) const;
+
+    /// \brief Return the size of the memory allocated for the \c RdataSet.
+    ///
+    /// This is the size of the block that \c destroy() releases.  If the
+    /// encoded RDATAs are shared (see \c isShared()), it doesn't include
+    /// them; they are owned by the \c RdataPool.
+    ///
+    /// \throw none
+    ///
+    /// \param rrclass The RR class of the \c RdataSet.
+    size_t getMemorySize(dns::RRClass rrclass) const;
+
 private:
     /// \brief Accessor to the memory region for encoded RDATAs, mutable
     /// version.
@@ -428,6 +559,10 @@ private:
     static RetType* getDataBuf(ThisType* rdataset) {
         if (rdataset->sig_rdata_count_ < MANY_RRSIG_COUNT) {
             return (rdataset + 1);
+        } else if (rdataset->isShared()) {
+            // The shared data are never modified through the RdataSet.
+            return (const_cast<void*>(
+                        rdataset->getSharedData()->entry->getData()));
         } else {
             return (rdataset->getExtSIGCountBuf() + 1);
         }
@@ -444,6 +579,16 @@ private:
         return (reinterpret_cast<uint16_t*>(this + 1));
     }
 
+    /// \brief Accessor to the reference to shared RDATA.
+    ///
+    /// These are used only internally and defined as private.
+    const SharedData* getSharedData() const {
+        return (reinterpret_cast<const SharedData*>(this + 1));
+    }
+    SharedData* getSharedData() {
+        return (reinterpret_cast<SharedData*>(this + 1));
+    }
+
     // Shared by both mutable and immutable versions of find()
     template <typename RdataSetType>
     static RdataSetType*
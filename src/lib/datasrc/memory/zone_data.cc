@@ -19,6 +19,7 @@
 #include <dns/rdataclass.h>
 
 #include "rdataset.h"
+#include "rdata_pool.h"
 #include "rdata_serialization.h"
 #include "zone_data.h"
 #include "segment_object_holder.h"
@@ -129,15 +130,36 @@ NSEC3Data::destroy(util::MemorySegment& mem_sgmt, NSEC3Data* data,
 
 void
 NSEC3Data::insertName(util::MemorySegment& mem_sgmt, const Name& name,
-                      ZoneNode** node)
+                      ZoneNode** node, bool in_order)
 {
-    const ZoneTree::Result result = nsec3_tree_->insert(mem_sgmt, name, node);
+    const ZoneTree::Result result = nsec3_tree_->insert(mem_sgmt, name, node,
+                                                        in_order);
 
     // This should be ensured by the API:
     assert((result == ZoneTree::SUCCESS ||
             result == ZoneTree::ALREADYEXISTS) && node != NULL);
 }
 
+ZoneNode*
+NSEC3Data::findName(const Name& name) {
+    ZoneNode* node = NULL;
+    if (nsec3_tree_->find(name, &node) != ZoneTree::EXACTMATCH) {
+        return (NULL);
+    }
+    return (node);
+}
+
+void
+NSEC3Data::removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node) {
+    assert(node->isEmpty());
+    nsec3_tree_->remove(mem_sgmt, node, nullDeleter);
+}
+
+void
+NSEC3Data::buildIndex(util::MemorySegment& mem_sgmt) {
+    nsec3_tree_->buildIndex(mem_sgmt);
+}
+
 namespace {
 // A helper to convert a TTL value in network byte order and set it in
 // ZoneData::min_ttl_.  We can use util::OutputBuffer, but copy the logic
@@ -200,20 +222,59 @@ ZoneData::destroy(util::MemorySegment& mem_sgmt, ZoneData* zone_data,
     if (zone_data->nsec3_data_) {
         NSEC3Data::destroy(mem_sgmt, zone_data->nsec3_data_.get(), zone_class);
     }
+    // The pool must be destroyed after all RdataSets referring to it.
+    if (zone_data->rdata_pool_) {
+        RdataPool::destroy(mem_sgmt, zone_data->rdata_pool_.get());
+    }
     mem_sgmt.deallocate(zone_data, sizeof(ZoneData));
 }
 
 void
 ZoneData::insertName(util::MemorySegment& mem_sgmt, const Name& name,
-                     ZoneNode** node)
+                     ZoneNode** node, bool in_order)
 {
-    const ZoneTree::Result result = zone_tree_->insert(mem_sgmt, name, node);
+    const ZoneTree::Result result = zone_tree_->insert(mem_sgmt, name, node,
+                                                       in_order);
 
     // This should be ensured by the API:
     assert((result == ZoneTree::SUCCESS ||
             result == ZoneTree::ALREADYEXISTS) && node != NULL);
 }
 
+ZoneNode*
+ZoneData::findName(const Name& name) {
+    ZoneNode* node = NULL;
+    if (zone_tree_->find(name, &node) != ZoneTree::EXACTMATCH) {
+        return (NULL);
+    }
+    return (node);
+}
+
+void
+ZoneData::removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node) {
+    assert(node->isEmpty());
+    if (node == origin_node_.get()) {
+        return;
+    }
+    assert(!origin_node_->isEmpty());
+    zone_tree_->remove(mem_sgmt, node, nullDeleter);
+}
+
+void
+ZoneData::buildIndex(util::MemorySegment& mem_sgmt) {
+    zone_tree_->buildIndex(mem_sgmt);
+    if (nsec3_data_) {
+        nsec3_data_->buildIndex(mem_sgmt);
+    }
+}
+
+void
+ZoneData::enableRdataSharing(util::MemorySegment& mem_sgmt) {
+    if (!rdata_pool_) {
+        rdata_pool_ = RdataPool::create(mem_sgmt);
+    }
+}
+
 void
 ZoneData::setMinTTL(uint32_t min_ttl_val) {
     setTTLInNetOrder(min_ttl_val, &min_ttl_);
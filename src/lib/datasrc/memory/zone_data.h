@@ -210,8 +210,39 @@ public:
     /// \param node A pointer to \c ZoneNode pointer in which the created or
     /// found node for the name is stored.  Must not be NULL (the method does
     /// not check that condition).
+    /// \param in_order Whether names are expected to be inserted in the
+    /// DNSSEC order (see \c DomainTree::insert()).
     void insertName(util::MemorySegment& mem_sgmt, const dns::Name& name,
-                    ZoneNode** node);
+                    ZoneNode** node, bool in_order = false);
+
+    /// \brief Find a name in the NSEC3 name space.
+    ///
+    /// It returns the node for the given name if it exists in the name
+    /// space (it may be empty); otherwise it returns NULL.
+    ///
+    /// \throw none
+    ///
+    /// \param name The name to be searched for.
+    ZoneNode* findName(const dns::Name& name);
+
+    /// \brief Remove an empty node from the NSEC3 name space.
+    ///
+    /// The given node must be a node in the NSEC3 name space that doesn't
+    /// have any data.  Upper nodes that become unnecessary as a result
+    /// are also removed.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt Memory segment from which the node was allocated.
+    /// \param node The node to be removed.
+    void removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node);
+
+    /// \brief Build the search index of the NSEC3 name space.
+    ///
+    /// See \c ZoneData::buildIndex().
+    ///
+    /// \param mem_sgmt Memory segment from which the data was allocated.
+    void buildIndex(util::MemorySegment& mem_sgmt);
 
 private:
     // Common subroutine for the public versions of create().
@@ -525,6 +556,13 @@ public:
     /// \throw none
     const NSEC3Data* getNSEC3Data() const { return (nsec3_data_.get()); }
 
+    /// \brief Return the \c RdataPool of the zone (const version).
+    ///
+    /// It's NULL unless \c enableRdataSharing() was called.
+    ///
+    /// \throw none
+    const RdataPool* getRdataPool() const { return (rdata_pool_.get()); }
+
     /// \brief Return a pointer to the zone's minimum TTL data.
     ///
     /// The returned pointer points to a memory region that is valid at least
@@ -586,8 +624,79 @@ public:
     /// \param node A pointer to \c ZoneNode pointer in which the created or
     /// found node for the name is stored.  Must not be NULL (the method does
     /// not check that condition).
+    /// \param in_order Whether names are expected to be inserted in the
+    /// DNSSEC order (see \c DomainTree::insert()).
     void insertName(util::MemorySegment& mem_sgmt, const dns::Name& name,
-                    ZoneNode** node);
+                    ZoneNode** node, bool in_order = false);
+
+    /// \brief Find a name in the zone's name space.
+    ///
+    /// It returns the node for the given name if it exists in the zone's
+    /// "normal" name space (it may be an empty node); otherwise it returns
+    /// NULL.  Like \c insertName(), this is one of the few interfaces
+    /// allowing write access to the tree nodes.
+    ///
+    /// \throw none
+    ///
+    /// \param name The name to be searched for.
+    ZoneNode* findName(const dns::Name& name);
+
+    /// \brief Remove an empty node from the zone's name space.
+    ///
+    /// The given node must be a node of this zone that doesn't have any
+    /// data.  Upper nodes that become empty leaves as a result are also
+    /// removed, so the caller must make sure the origin node has some data
+    /// (otherwise the origin node itself could be removed); this method
+    /// asserts that condition.  If \c node is the origin node, this method
+    /// does nothing.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt Memory segment from which the node was allocated.
+    /// \param node The node to be removed.
+    void removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node);
+
+    /// \brief Build the search indexes of the zone's name spaces.
+    ///
+    /// This builds the read-optimized search index (see
+    /// \c DomainTree::buildIndex()) of the zone tree and, if the zone is
+    /// NSEC3-signed, of the NSEC3 tree.  It should be called once the zone
+    /// is fully loaded or updated; any later insertion or removal of names
+    /// discards the index of the modified tree.
+    ///
+    /// \throw std::bad_alloc Memory allocation fails
+    /// \throw MemorySegmentGrown The memory segment has grown; the caller
+    /// should re-get the address of this object and call it again.
+    ///
+    /// \param mem_sgmt Memory segment from which the zone data was allocated.
+    void buildIndex(util::MemorySegment& mem_sgmt);
+
+    /// \brief Make the zone share identical RDATA among its RRsets.
+    ///
+    /// This associates an \c RdataPool with the zone data, so \c RdataSet
+    /// objects of the zone created with it (see \c getRdataPool()) store
+    /// a single copy of identical RDATA.  It saves memory for zones with
+    /// many identical RRsets, such as the same NS or MX RRsets for many
+    /// delegations, at the cost of some extra memory for each RRset of
+    /// unique RDATA.  The pool is destroyed with the zone data.
+    ///
+    /// If sharing is already enabled, this method does nothing.
+    ///
+    /// \throw std::bad_alloc Memory allocation fails
+    /// \throw MemorySegmentGrown The memory segment has grown; the caller
+    /// should re-get the address of this object and call it again.
+    ///
+    /// \param mem_sgmt Memory segment from which the zone data was allocated.
+    void enableRdataSharing(util::MemorySegment& mem_sgmt);
+
+    /// \brief Return the \c RdataPool of the zone.
+    ///
+    /// It's NULL unless \c enableRdataSharing() was called.  It should be
+    /// passed to \c RdataSet::create() for \c RdataSet objects to be stored
+    /// in this zone data.
+    ///
+    /// \throw none
+    RdataPool* getRdataPool() { return (rdata_pool_.get()); }
 
     /// \brief Specify whether or not the zone is signed in terms of DNSSEC.
     ///
@@ -665,6 +774,7 @@ private:
     const boost::interprocess::offset_ptr<ZoneTree> zone_tree_;
     const boost::interprocess::offset_ptr<ZoneNode> origin_node_;
     boost::interprocess::offset_ptr<NSEC3Data> nsec3_data_;
+    boost::interprocess::offset_ptr<RdataPool> rdata_pool_;
     uint32_t min_ttl_;
 };
 
@@ -15,6 +15,7 @@
 #include <datasrc/master_loader_callbacks.h>
 #include <datasrc/memory/zone_data_loader.h>
 #include <datasrc/memory/zone_data_updater.h>
+#include <datasrc/memory/zone_data_snapshot.h>
 #include <datasrc/memory/logger.h>
 #include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/memory/util_internal.h>
@@ -31,6 +32,10 @@
 #include <boost/noncopyable.hpp>
 
 #include <map>
+#include <utility>
+#include <vector>
+
+#include <unistd.h> // for sysconf()
 
 using namespace bundy::dns;
 using namespace bundy::dns::rdata;
@@ -71,7 +76,9 @@ public:
     ZoneDataLoader(util::MemorySegment& mem_sgmt,
                    const bundy::dns::RRClass& rrclass,
                    const bundy::dns::Name& zone_name, ZoneData& zone_data) :
-        updater_(mem_sgmt, rrclass, zone_name, zone_data)
+        // Zone files and transfers are usually (mostly) in the DNSSEC order,
+        // which the updater can exploit.
+        updater_(mem_sgmt, rrclass, zone_name, zone_data, true)
     {}
 
     void addFromLoad(const bundy::dns::ConstRRsetPtr& rrset);
@@ -180,13 +187,17 @@ ZoneData*
 loadZoneDataInternal(util::MemorySegment& mem_sgmt,
                      const bundy::dns::RRClass& rrclass,
                      const Name& zone_name,
-                     boost::function<void(LoadCallback)> rrset_installer)
+                     boost::function<void(LoadCallback)> rrset_installer,
+                     bool share_rdata)
 {
     while (true) { // Try as long as it takes to load and grow the segment
         bool created = false;
         try {
             SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt, rrclass);
             holder.set(ZoneData::create(mem_sgmt, zone_name));
+            if (share_rdata) {
+                holder.get()->enableRdataSharing(mem_sgmt);
+            }
 
             // Nothing from this point on should throw MemorySegmentGrown.
             // It is handled inside here.
@@ -218,6 +229,16 @@ loadZoneDataInternal(util::MemorySegment& mem_sgmt,
                           << zone_name << "/" << rrclass);
             }
 
+            // The zone won't be modified any more; build the search index.
+            // The segment can grow while building it, in which case we
+            // retry with the (possibly relocated) zone data.
+            while (true) {
+                try {
+                    holder.get()->buildIndex(mem_sgmt);
+                    break;
+                } catch (const util::MemorySegmentGrown&) {}
+            }
+
             return (holder.release());
         } catch (const util::MemorySegmentGrown&) {
             assert(!created);
@@ -237,11 +258,17 @@ masterLoaderWrapper(const char* const filename, const Name& origin,
     bool load_ok = false;       // (we don't use it)
     dns::RRCollator collator(boost::bind(callback, _1));
 
+    // The parallel mode only pays off if there's more than one processor
+    // to parse the file with.
+    const dns::MasterLoader::Options options =
+        sysconf(_SC_NPROCESSORS_ONLN) > 1 ? dns::MasterLoader::PARALLEL :
+        dns::MasterLoader::DEFAULT;
+
     try {
         dns::MasterLoader(filename, origin, zone_class,
                           createMasterLoaderCallbacks(origin, zone_class,
                                                       &load_ok),
-                          collator.getCallback()).load();
+                          collator.getCallback(), options).load();
         collator.flush();
     } catch (const dns::MasterLoaderError& e) {
         bundy_throw(ZoneLoaderException, e.what());
@@ -257,14 +284,53 @@ generateRRsetFromIterator(ZoneIterator* iterator, LoadCallback callback) {
     }
 }
 
+// Add or remove an RR (or RRset) in an IXFR sequence to/from the zone.
+// Returns true if the zone is actually changed.
+bool
+applyDifference(ZoneDataUpdater& updater, bool adding,
+                const ConstRRsetPtr& rrset)
+{
+    const bool is_rrsig = rrset->getType() == RRType::RRSIG();
+    const ConstRRsetPtr data = is_rrsig ? ConstRRsetPtr() : rrset;
+    const ConstRRsetPtr sig = is_rrsig ? rrset : ConstRRsetPtr();
+    return (adding ? updater.add(data, sig) : updater.remove(data, sig));
+}
+
+// Split an RRset into RRsets of a single RR each.  The differences are
+// applied RR by RR, so only the RRs that actually changed the zone are
+// reverted on failure, even if the RRs of a difference are partly in the
+// zone already.
+void
+splitRRset(const ConstRRsetPtr& rrset, std::vector<ConstRRsetPtr>& rrs) {
+    if (rrset->getRdataCount() <= 1) {
+        rrs.push_back(rrset);
+        return;
+    }
+    for (RdataIteratorPtr it = rrset->getRdataIterator(); !it->isLast();
+         it->next()) {
+        RRsetPtr rr(new RRset(rrset->getName(), rrset->getClass(),
+                              rrset->getType(), rrset->getTTL()));
+        rr->addRdata(it->getCurrent());
+        rrs.push_back(rr);
+    }
+}
+
 } // end of unnamed namespace
 
 ZoneData*
 loadZoneData(util::MemorySegment& mem_sgmt,
              const bundy::dns::RRClass& rrclass,
              const bundy::dns::Name& zone_name,
-             const std::string& zone_file)
+             const std::string& zone_file,
+             bool share_rdata)
 {
+    // A snapshot written by bundy-loadzone can be used instead of a master
+    // file, and is much faster to load.
+    if (isZoneDataSnapshot(zone_file)) {
+        return (loadZoneDataSnapshot(mem_sgmt, rrclass, zone_name,
+                                     zone_file, share_rdata));
+    }
+
     LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_LOAD_FROM_FILE).
         arg(zone_name).arg(rrclass).arg(zone_file);
 
@@ -272,21 +338,83 @@ loadZoneData(util::MemorySegment& mem_sgmt,
                                  boost::bind(masterLoaderWrapper,
                                              zone_file.c_str(),
                                              zone_name, rrclass,
-                                             _1)));
+                                             _1),
+                                 share_rdata));
 }
 
 ZoneData*
 loadZoneData(util::MemorySegment& mem_sgmt,
              const bundy::dns::RRClass& rrclass,
              const bundy::dns::Name& zone_name,
-             ZoneIterator& iterator)
+             ZoneIterator& iterator,
+             bool share_rdata)
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_LOAD_FROM_DATASRC).
         arg(zone_name).arg(rrclass);
 
     return (loadZoneDataInternal(mem_sgmt, rrclass, zone_name,
                                  boost::bind(generateRRsetFromIterator,
-                                             &iterator, _1)));
+                                             &iterator, _1),
+                                 share_rdata));
+}
+
+void
+updateZoneData(util::MemorySegment& mem_sgmt,
+               const bundy::dns::RRClass& rrclass,
+               const bundy::dns::Name& zone_name,
+               ZoneData& zone_data,
+               const std::vector<ConstRRsetPtr>& diffs)
+{
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_UPDATE_ZONE).
+        arg(zone_name).arg(rrclass).arg(diffs.size());
+
+    ZoneDataUpdater updater(mem_sgmt, rrclass, zone_name, zone_data);
+
+    // Changes actually made to the zone (whether it's added, and the
+    // single-RR RRset), so we can revert them on failure.
+    typedef std::pair<bool, ConstRRsetPtr> Change;
+    std::vector<Change> changes;
+    std::vector<ConstRRsetPtr> rrs;
+    try {
+        // Each SOA switches between the deletion and addition parts of the
+        // sequence; it starts with the deletion.
+        bool adding = true;
+        BOOST_FOREACH(const ConstRRsetPtr& rrset, diffs) {
+            if (rrset->getType() == RRType::SOA()) {
+                adding = !adding;
+            }
+            rrs.clear();
+            splitRRset(rrset, rrs);
+            BOOST_FOREACH(const ConstRRsetPtr& rr, rrs) {
+                if (applyDifference(updater, adding, rr)) {
+                    changes.push_back(Change(adding, rr));
+                }
+            }
+        }
+
+        const RdataSet* rdataset = zone_data.getOriginNode()->getData();
+        if (RdataSet::find(rdataset, RRType::SOA()) == NULL ||
+            RdataSet::find(rdataset, RRType::NS()) == NULL) {
+            bundy_throw(ZoneValidationError,
+                        "Zone would lack SOA or NS after update: "
+                        << zone_name << "/" << rrclass);
+        }
+        updater.removeEmptyNodes();
+    } catch (const std::exception& ex) {
+        LOG_ERROR(logger, DATASRC_MEMORY_MEM_UPDATE_FAILED).
+            arg(zone_name).arg(rrclass).arg(ex.what());
+        for (std::vector<Change>::const_reverse_iterator it =
+                 changes.rbegin();
+             it != changes.rend();
+             ++it) {
+            applyDifference(updater, !it->first, it->second);
+        }
+        updater.removeEmptyNodes();
+        zone_data.buildIndex(mem_sgmt);
+        throw;
+    }
+    // The update discarded the search index; rebuild it.
+    zone_data.buildIndex(mem_sgmt);
 }
 
 } // namespace memory
@@ -20,8 +20,11 @@
 #include <datasrc/zone_iterator.h>
 #include <dns/name.h>
 #include <dns/rrclass.h>
+#include <dns/rrset.h>
 #include <util/memory_segment.h>
 
+#include <vector>
+
 namespace bundy {
 namespace datasrc {
 namespace memory {
@@ -44,14 +47,24 @@ struct ZoneValidationError : public ZoneLoaderException {
 /// RRsets are passed by the master loader. Throws \c EmptyZone if an
 /// empty zone would be created due to the \c loadZoneData().
 ///
+/// \c zone_file can also be a zone snapshot (see
+/// \c saveZoneDataSnapshot()), in which case it's loaded by
+/// \c loadZoneDataSnapshot() and \c ZoneSnapshotError is thrown if it
+/// can't be loaded.
+///
+/// If \c share_rdata is true, identical RDATA of the zone are stored only
+/// once (see \c ZoneData::enableRdataSharing()).
+///
 /// \param mem_sgmt The memory segment.
 /// \param rrclass The RRClass.
 /// \param zone_name The name of the zone that is being loaded.
 /// \param zone_file Filename which contains the zone data for \c zone_name.
+/// \param share_rdata Whether to share identical RDATA in the zone data.
 ZoneData* loadZoneData(util::MemorySegment& mem_sgmt,
                        const bundy::dns::RRClass& rrclass,
                        const bundy::dns::Name& zone_name,
-                       const std::string& zone_file);
+                       const std::string& zone_file,
+                       bool share_rdata = false);
 
 /// \brief Create and return a ZoneData instance populated from the
 /// \c iterator.
@@ -65,10 +78,47 @@ ZoneData* loadZoneData(util::MemorySegment& mem_sgmt,
 /// \param rrclass The RRClass.
 /// \param zone_name The name of the zone that is being loaded.
 /// \param iterator Iterator that returns RRsets to load into the zone.
+/// \param share_rdata Whether to share identical RDATA in the zone data
+/// (see the other version).
 ZoneData* loadZoneData(util::MemorySegment& mem_sgmt,
                        const bundy::dns::RRClass& rrclass,
                        const bundy::dns::Name& zone_name,
-                       ZoneIterator& iterator);
+                       ZoneIterator& iterator,
+                       bool share_rdata = false);
+
+/// \brief Apply differences to a ZoneData instance.
+///
+/// This updates the given \c zone_data in place with the differences given
+/// in the form of an IXFR sequence: each difference sequence begins with
+/// the SOA of the older version, followed by the RRs to be deleted, the
+/// SOA of the newer version and the RRs to be added.  Each RR (or RRset)
+/// in \c diffs must belong to \c zone_name.
+///
+/// Deleting a record that doesn't exist in the zone or adding a record
+/// that already exists is silently ignored.  If the update fails in the
+/// middle, or the resulting zone doesn't have the SOA and NS at the origin,
+/// the changes made so far are reverted and the exception is propagated.
+/// Unlike \c loadZoneData(), this function doesn't check the entire zone
+/// for validity, so the caller is responsible for making sure the diffs
+/// are consistent with the zone.
+///
+/// Since \c zone_data is modified in place, the caller must make sure no
+/// one else is using the zone data during the update.
+///
+/// \throw ZoneDataUpdater::AddError Invalid or inconsistent data are added
+/// \throw ZoneValidationError The zone would be invalid after the update
+/// \throw std::bad_alloc Memory allocation failure
+///
+/// \param mem_sgmt The memory segment from which zone_data was allocated.
+/// \param rrclass The RRClass.
+/// \param zone_name The name of the zone that is being updated.
+/// \param zone_data The zone data to be updated.
+/// \param diffs The differences to be applied.
+void updateZoneData(util::MemorySegment& mem_sgmt,
+                    const bundy::dns::RRClass& rrclass,
+                    const bundy::dns::Name& zone_name,
+                    ZoneData& zone_data,
+                    const std::vector<bundy::dns::ConstRRsetPtr>& diffs);
 
 } // namespace memory
 } // namespace datasrc
@@ -0,0 +1,652 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_data_snapshot.h>
+#include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/rdataset.h>
+#include <datasrc/memory/rdata_serialization.h>
+#include <datasrc/memory/logger.h>
+#include <datasrc/memory/segment_object_holder.h>
+#include <datasrc/client.h>
+
+#include <dns/labelsequence.h>
+#include <dns/rdataclass.h>
+#include <util/buffer.h>
+#include <util/hash/sha1.h>
+#include <util/memory_segment_local.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace bundy::dns;
+using namespace bundy::dns::rdata;
+using bundy::util::InputBuffer;
+using bundy::util::OutputBuffer;
+using namespace bundy::util::hash;
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+using detail::SegmentObjectHolder;
+
+namespace {
+
+// The snapshot file consists of a fixed size header followed by the
+// payload.  All integers are stored in the network byte order, except
+// those within the RDATA encoding (which is copied from and to RdataSets
+// as it is).
+//
+// Header:
+//   magic (8 bytes)
+//   format version (32 bits)
+//   byte order mark (32 bits, in the host byte order of the writer)
+//   RR class (16 bits)
+//   version of the RDATA encoding (16 bits, RDATA_ENCODING_VERSION)
+//   minimum TTL of the zone (32 bits)
+//   number of nodes in the zone tree (32 bits)
+//   number of nodes in the NSEC3 tree (32 bits)
+//   payload length (64 bits)
+//   SHA-1 digest of the payload (20 bytes)
+//   reserved (4 bytes, 0)
+// Payload:
+//   origin name (8-bit length, wire format)
+//   NSEC3PARAM (16-bit length, wire format RDATA; length is 0 if the zone
+//     isn't NSEC3-signed)
+//   nodes of the zone tree, followed by those of the NSEC3 tree
+// Node:
+//   owner name (8-bit length, wire format)
+//   settable flags (32 bits)
+//   number of RdataSets (16 bits)
+//   for each RdataSet:
+//     RR type (16 bits)
+//     number of RDATAs (16 bits)
+//     number of RRSIGs (16 bits)
+//     TTL (32 bits)
+//     length of the encoded RDATA (32 bits)
+//     encoded RDATA
+const char SNAPSHOT_MAGIC[8] = { 'B', 'Z', 'O', 'N', 'E', 'S', 'N', 'P' };
+const uint32_t SNAPSHOT_VERSION = 2;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const size_t HEADER_LENGTH = 64;
+const size_t DIGEST_OFFSET = 40;
+
+const ZoneNode::Flags SAVED_FLAGS[] = {
+    ZoneNode::FLAG_CALLBACK, ZoneNode::FLAG_USER1, ZoneNode::FLAG_USER2,
+    ZoneNode::FLAG_USER3
+};
+const size_t NUM_SAVED_FLAGS = sizeof(SAVED_FLAGS) / sizeof(SAVED_FLAGS[0]);
+
+// Feed data of any size to SHA-1, whose interface takes an unsigned int.
+void
+updateDigest(SHA1Context* ctx, const void* data, size_t len) {
+    const uint8_t* cp = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        const size_t chunk_len = std::min<size_t>(len, 1 << 30);
+        SHA1Input(ctx, cp, chunk_len);
+        cp += chunk_len;
+        len -= chunk_len;
+    }
+}
+
+// A helper to write a snapshot file.  The payload is built in a buffer,
+// which is written to the file and added to the digest each time it gets
+// large enough, so the memory footprint doesn't depend on the zone size.
+// The header is written last, once the digest is known.
+class SnapshotWriter : boost::noncopyable {
+public:
+    SnapshotWriter(const std::string& filename) :
+        filename_(filename), tmp_filename_(filename + ".tmp"),
+        fd_(-1), buffer_(BUFFER_LENGTH), payload_len_(0)
+    {
+        fd_ = open(tmp_filename_.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+                   S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd_ < 0) {
+            bundy_throw(ZoneSnapshotError, "Failed to create zone snapshot "
+                      << tmp_filename_ << ": " << std::strerror(errno));
+        }
+        SHA1Reset(&sha1_);
+        // Leave space for the header.
+        const uint8_t header[HEADER_LENGTH] = { 0 };
+        write(header, sizeof(header));
+    }
+
+    ~SnapshotWriter() {
+        // The file is left only if commit() was called.
+        if (fd_ >= 0) {
+            close(fd_);
+            unlink(tmp_filename_.c_str());
+        }
+    }
+
+    OutputBuffer& getBuffer() { return (buffer_); }
+
+    // Called at a convenient point between data items.
+    void flushIfNeeded() {
+        if (buffer_.getLength() >= BUFFER_LENGTH) {
+            flushPayload();
+        }
+    }
+
+    void commit(const OutputBuffer& header) {
+        flushPayload();
+        uint8_t digest[SHA1_HASHSIZE];
+        SHA1Result(&sha1_, digest);
+
+        OutputBuffer full_header(HEADER_LENGTH);
+        full_header.writeData(header.getData(), header.getLength());
+        full_header.writeUint32(payload_len_ >> 32);
+        full_header.writeUint32(payload_len_ & 0xffffffff);
+        assert(full_header.getLength() == DIGEST_OFFSET);
+        full_header.writeData(digest, sizeof(digest));
+        full_header.writeUint32(0); // reserved
+        assert(full_header.getLength() == HEADER_LENGTH);
+
+        if (lseek(fd_, 0, SEEK_SET) != 0) {
+            fail("seek");
+        }
+        write(full_header.getData(), full_header.getLength());
+        if (fsync(fd_) != 0) {
+            fail("sync");
+        }
+        if (close(fd_) != 0) {
+            fd_ = -1;
+            unlink(tmp_filename_.c_str());
+            bundy_throw(ZoneSnapshotError, "Failed to close zone snapshot "
+                      << tmp_filename_ << ": " << std::strerror(errno));
+        }
+        fd_ = -1;
+        if (std::rename(tmp_filename_.c_str(), filename_.c_str()) != 0) {
+            const int error = errno;
+            unlink(tmp_filename_.c_str());
+            bundy_throw(ZoneSnapshotError, "Failed to rename zone snapshot "
+                      << tmp_filename_ << " to " << filename_ << ": "
+                      << std::strerror(error));
+        }
+    }
+
+private:
+    static const size_t BUFFER_LENGTH = 64 * 1024;
+
+    void flushPayload() {
+        updateDigest(&sha1_, buffer_.getData(), buffer_.getLength());
+        write(buffer_.getData(), buffer_.getLength());
+        payload_len_ += buffer_.getLength();
+        buffer_.clear();
+    }
+
+    void write(const void* data, size_t len) {
+        const char* cp = static_cast<const char*>(data);
+        while (len > 0) {
+            const ssize_t written = ::write(fd_, cp, len);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail("write");
+            }
+            cp += written;
+            len -= written;
+        }
+    }
+
+    void fail(const char* what) {
+        bundy_throw(ZoneSnapshotError, "Failed to " << what
+                  << " zone snapshot " << tmp_filename_ << ": "
+                  << std::strerror(errno));
+    }
+
+    const std::string filename_;
+    const std::string tmp_filename_;
+    int fd_;
+    OutputBuffer buffer_;
+    SHA1Context sha1_;
+    uint64_t payload_len_;
+};
+
+void
+writeName(OutputBuffer& buffer, const LabelSequence& labels) {
+    size_t len;
+    const uint8_t* data = labels.getData(&len);
+    buffer.writeUint8(len);
+    buffer.writeData(data, len);
+}
+
+// Write all nodes of the given tree, and return the number of them.
+uint32_t
+writeTree(SnapshotWriter& writer, const ZoneTree& tree, const Name& origin,
+          const RRClass& rrclass)
+{
+    ZoneChain chain;
+    const ZoneNode* node = NULL;
+    if (tree.find(origin, &node, chain) != ZoneTree::EXACTMATCH) {
+        bundy_throw(Unexpected, "In-memory zone corrupted, missing origin node");
+    }
+
+    uint32_t count = 0;
+    uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    for (; node != NULL; node = tree.nextNode(chain)) {
+        OutputBuffer& buffer = writer.getBuffer();
+        writeName(buffer, node->getAbsoluteLabels(labels_buf));
+        uint32_t flags = 0;
+        for (size_t i = 0; i < NUM_SAVED_FLAGS; ++i) {
+            if (node->getFlag(SAVED_FLAGS[i])) {
+                flags |= SAVED_FLAGS[i];
+            }
+        }
+        buffer.writeUint32(flags);
+
+        const size_t count_pos = buffer.getLength();
+        buffer.writeUint16(0);
+        uint16_t rdataset_count = 0;
+        for (const RdataSet* rdataset = node->getData();
+             rdataset != NULL;
+             rdataset = rdataset->getNext(), ++rdataset_count) {
+            const size_t data_len = rdataset->getDataLength(rrclass);
+            buffer.writeUint16(rdataset->type.getCode());
+            buffer.writeUint16(rdataset->getRdataCount());
+            buffer.writeUint16(rdataset->getSigRdataCount());
+            buffer.writeData(rdataset->getTTLData(), sizeof(uint32_t));
+            buffer.writeUint32(data_len);
+            buffer.writeData(rdataset->getDataBuf(), data_len);
+        }
+        buffer.writeUint16At(rdataset_count, count_pos);
+
+        writer.flushIfNeeded();
+        ++count;
+    }
+    return (count);
+}
+
+// A read-only mapping of a snapshot file, unmapped on destruction.
+class SnapshotFile : boost::noncopyable {
+public:
+    SnapshotFile(const std::string& filename) : data_(NULL), len_(0) {
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            bundy_throw(ZoneSnapshotError, "Failed to open zone snapshot "
+                      << filename << ": " << std::strerror(errno));
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < HEADER_LENGTH) {
+            close(fd);
+            bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                      << " is too short");
+        }
+        void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            bundy_throw(ZoneSnapshotError, "Failed to map zone snapshot "
+                      << filename << ": " << std::strerror(errno));
+        }
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t*>(map);
+        len_ = st.st_size;
+    }
+    ~SnapshotFile() {
+        munmap(const_cast<uint8_t*>(data_), len_);
+    }
+    const uint8_t* getData() const { return (data_); }
+    size_t getLength() const { return (len_); }
+private:
+    const uint8_t* data_;
+    size_t len_;
+};
+
+// The saved form of an RdataSet, referring to the mapped file.
+struct SavedRdataSet {
+    uint16_t type;
+    size_t rdata_count;
+    size_t sig_rdata_count;
+    const void* ttl_data;
+    const void* data;
+    size_t data_len;
+};
+
+// An InputBuffer that can also return a pointer to the data in the
+// buffer, so large data can be used without copying them.
+class SnapshotBuffer : public InputBuffer {
+public:
+    SnapshotBuffer(const uint8_t* data, size_t len) :
+        InputBuffer(data, len), data_(data)
+    {}
+
+    // Return a pointer to the next len bytes of the buffer and skip them.
+    const uint8_t* skipData(size_t len) {
+        const uint8_t* data = data_ + getPosition();
+        setPosition(getPosition() + len);
+        return (data);
+    }
+
+private:
+    const uint8_t* const data_;
+};
+
+Name
+readName(SnapshotBuffer& buffer) {
+    const size_t len = buffer.readUint8();
+    InputBuffer name_buffer(buffer.skipData(len), len);
+    return (Name(name_buffer));
+}
+
+// Read a node of the snapshot and add it to the zone data (or its NSEC3
+// data, if nsec3 is true).
+void
+readNode(util::MemorySegment& mem_sgmt, const RRClass& rrclass,
+         SegmentObjectHolder<ZoneData, RRClass>& holder, SnapshotBuffer& buffer,
+         bool nsec3, std::vector<SavedRdataSet>& rdatasets)
+{
+    const Name name(readName(buffer));
+    const uint32_t flags = buffer.readUint32();
+    const size_t rdataset_count = buffer.readUint16();
+    rdatasets.clear();
+    for (size_t i = 0; i < rdataset_count; ++i) {
+        SavedRdataSet saved;
+        saved.type = buffer.readUint16();
+        saved.rdata_count = buffer.readUint16();
+        saved.sig_rdata_count = buffer.readUint16();
+        saved.ttl_data = buffer.skipData(sizeof(uint32_t));
+        saved.data_len = buffer.readUint32();
+        saved.data = buffer.skipData(saved.data_len);
+        rdatasets.push_back(saved);
+    }
+
+    // The segment can grow (and relocate the zone data) on any allocation.
+    // If it does, get the node again and add the rest of the RdataSets.
+    size_t added = 0;
+    while (true) {
+        try {
+            ZoneData* zone_data = holder.get();
+            ZoneNode* node = NULL;
+            // The names were saved in the tree order.
+            if (nsec3) {
+                zone_data->getNSEC3Data()->insertName(mem_sgmt, name, &node,
+                                                      true);
+            } else {
+                zone_data->insertName(mem_sgmt, name, &node, true);
+            }
+            for (; added < rdatasets.size(); ++added) {
+                const SavedRdataSet& saved = rdatasets[added];
+                RdataSet* rdataset =
+                    RdataSet::create(mem_sgmt, rrclass, RRType(saved.type),
+                                     saved.rdata_count,
+                                     saved.sig_rdata_count, saved.ttl_data,
+                                     saved.data, saved.data_len,
+                                     zone_data->getRdataPool());
+                // Keep the order of the saved RdataSets.
+                RdataSet* last = node->getData();
+                if (last == NULL) {
+                    node->setData(rdataset);
+                } else {
+                    while (last->getNext() != NULL) {
+                        last = last->getNext();
+                    }
+                    last->next = rdataset;
+                }
+            }
+            for (size_t i = 0; i < NUM_SAVED_FLAGS; ++i) {
+                node->setFlag(SAVED_FLAGS[i], (flags & SAVED_FLAGS[i]) != 0);
+            }
+            return;
+        } catch (const util::MemorySegmentGrown&) {}
+    }
+}
+
+void
+readNSEC3Data(util::MemorySegment& mem_sgmt,
+              SegmentObjectHolder<ZoneData, RRClass>& holder,
+              const Name& zone_name, SnapshotBuffer& buffer)
+{
+    const size_t len = buffer.readUint16();
+    if (len == 0) {
+        return;
+    }
+    InputBuffer rdata_buffer(buffer.skipData(len), len);
+    const generic::NSEC3PARAM nsec3param(rdata_buffer, len);
+    while (true) {
+        try {
+            // NSEC3Data::create() doesn't leave anything on exception,
+            // and the rest doesn't grow the segment.
+            NSEC3Data* nsec3_data =
+                NSEC3Data::create(mem_sgmt, zone_name, nsec3param);
+            holder.get()->setNSEC3Data(nsec3_data);
+            return;
+        } catch (const util::MemorySegmentGrown&) {}
+    }
+}
+
+ZoneData*
+loadSnapshotInternal(util::MemorySegment& mem_sgmt, const RRClass& rrclass,
+                     const Name& zone_name, const std::string& filename,
+                     bool share_rdata)
+{
+    const SnapshotFile file(filename);
+    SnapshotBuffer header(file.getData(), HEADER_LENGTH);
+    if (std::memcmp(header.skipData(sizeof(SNAPSHOT_MAGIC)), SNAPSHOT_MAGIC,
+                    sizeof(SNAPSHOT_MAGIC)) != 0) {
+        bundy_throw(ZoneSnapshotError, filename << " is not a zone snapshot");
+    }
+    const uint32_t version = header.readUint32();
+    if (version != SNAPSHOT_VERSION) {
+        bundy_throw(ZoneSnapshotError, "Unsupported version of zone snapshot "
+                  << filename << ": " << version);
+    }
+    uint32_t byte_order;
+    std::memcpy(&byte_order, header.skipData(sizeof(byte_order)),
+                sizeof(byte_order));
+    if (byte_order != BYTE_ORDER_MARK) {
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " was written on a machine of different byte order");
+    }
+    const RRClass snapshot_class(header.readUint16());
+    if (snapshot_class != rrclass) {
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " is for RR class " << snapshot_class << ", not "
+                  << rrclass);
+    }
+    const uint16_t encoding_version = header.readUint16();
+    if (encoding_version != RDATA_ENCODING_VERSION) {
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " uses an unsupported RDATA encoding: "
+                  << encoding_version);
+    }
+    const uint32_t min_ttl = header.readUint32();
+    const uint32_t node_count = header.readUint32();
+    const uint32_t nsec3_node_count = header.readUint32();
+    uint64_t payload_len = header.readUint32();
+    payload_len = (payload_len << 32) | header.readUint32();
+    if (payload_len != file.getLength() - HEADER_LENGTH) {
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " is truncated");
+    }
+
+    const uint8_t* const payload = file.getData() + HEADER_LENGTH;
+    SHA1Context sha1;
+    SHA1Reset(&sha1);
+    updateDigest(&sha1, payload, payload_len);
+    uint8_t digest[SHA1_HASHSIZE];
+    SHA1Result(&sha1, digest);
+    if (std::memcmp(digest, header.skipData(sizeof(digest)),
+                    sizeof(digest)) != 0) {
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " is corrupted (checksum mismatch)");
+    }
+
+    SnapshotBuffer buffer(payload, payload_len);
+    const Name origin(readName(buffer));
+    if (origin != zone_name) {
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " is for zone " << origin << ", not " << zone_name);
+    }
+
+    while (true) { // Try as long as it takes to create the zone data
+        bool created = false;
+        try {
+            SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt, rrclass);
+            holder.set(ZoneData::create(mem_sgmt, zone_name));
+            if (share_rdata) {
+                holder.get()->enableRdataSharing(mem_sgmt);
+            }
+            // Each of the following handles MemorySegmentGrown by itself.
+            created = true;
+
+            readNSEC3Data(mem_sgmt, holder, zone_name, buffer);
+            if (nsec3_node_count > 0 && holder.get()->getNSEC3Data() == NULL) {
+                bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                          << " has NSEC3 names without NSEC3 parameters");
+            }
+            std::vector<SavedRdataSet> rdatasets;
+            for (uint32_t i = 0; i < node_count; ++i) {
+                readNode(mem_sgmt, rrclass, holder, buffer, false, rdatasets);
+            }
+            for (uint32_t i = 0; i < nsec3_node_count; ++i) {
+                readNode(mem_sgmt, rrclass, holder, buffer, true, rdatasets);
+            }
+            if (buffer.getPosition() != buffer.getLength()) {
+                bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                          << " has garbage at the end");
+            }
+            holder.get()->setMinTTL(min_ttl);
+
+            while (true) {
+                try {
+                    holder.get()->buildIndex(mem_sgmt);
+                    break;
+                } catch (const util::MemorySegmentGrown&) {}
+            }
+
+            return (holder.release());
+        } catch (const util::MemorySegmentGrown&) {
+            assert(!created);
+        }
+    }
+}
+
+} // end of unnamed namespace
+
+bool
+isZoneDataSnapshot(const std::string& filename) {
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return (false);
+    }
+    const ssize_t len = read(fd, magic, sizeof(magic));
+    close(fd);
+    return (len == sizeof(magic) &&
+            std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0);
+}
+
+void
+saveZoneDataSnapshot(const ZoneData& zone_data, const RRClass& rrclass,
+                     const std::string& filename)
+{
+    if (zone_data.isEmpty()) {
+        bundy_throw(ZoneSnapshotError, "Can't save an empty zone");
+    }
+    uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    const LabelSequence origin_labels =
+        zone_data.getOriginNode()->getAbsoluteLabels(labels_buf);
+    const Name origin(origin_labels.toText());
+
+    SnapshotWriter writer(filename);
+    OutputBuffer& buffer = writer.getBuffer();
+    writeName(buffer, origin_labels);
+    const NSEC3Data* nsec3_data = zone_data.getNSEC3Data();
+    if (nsec3_data != NULL) {
+        buffer.writeUint16(5 + nsec3_data->getSaltLen());
+        buffer.writeUint8(nsec3_data->hashalg);
+        buffer.writeUint8(nsec3_data->flags);
+        buffer.writeUint16(nsec3_data->iterations);
+        buffer.writeUint8(nsec3_data->getSaltLen());
+        buffer.writeData(nsec3_data->getSaltData(),
+                         nsec3_data->getSaltLen());
+    } else {
+        buffer.writeUint16(0);
+    }
+    const uint32_t node_count =
+        writeTree(writer, zone_data.getZoneTree(), origin, rrclass);
+    const uint32_t nsec3_node_count = nsec3_data == NULL ? 0 :
+        writeTree(writer, nsec3_data->getNSEC3Tree(), origin, rrclass);
+
+    // The fixed part of the header up to the payload length; the rest is
+    // completed by the writer.
+    OutputBuffer header(DIGEST_OFFSET);
+    header.writeData(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.writeUint32(SNAPSHOT_VERSION);
+    header.writeData(&BYTE_ORDER_MARK, sizeof(BYTE_ORDER_MARK));
+    header.writeUint16(rrclass.getCode());
+    header.writeUint16(RDATA_ENCODING_VERSION);
+    header.writeData(zone_data.getMinTTLData(), sizeof(uint32_t));
+    header.writeUint32(node_count);
+    header.writeUint32(nsec3_node_count);
+    writer.commit(header);
+}
+
+void
+saveZoneDataSnapshot(const DataSourceClient& client, const RRClass& rrclass,
+                     const Name& zone_name, const std::string& filename)
+{
+    util::MemorySegmentLocal mem_sgmt;
+    ZoneIteratorPtr iterator(client.getIterator(zone_name));
+    ZoneData* zone_data = loadZoneData(mem_sgmt, rrclass, zone_name,
+                                       *iterator);
+    try {
+        saveZoneDataSnapshot(*zone_data, rrclass, filename);
+    } catch (...) {
+        ZoneData::destroy(mem_sgmt, zone_data, rrclass);
+        throw;
+    }
+    ZoneData::destroy(mem_sgmt, zone_data, rrclass);
+}
+
+ZoneData*
+loadZoneDataSnapshot(util::MemorySegment& mem_sgmt, const RRClass& rrclass,
+                     const Name& zone_name, const std::string& filename,
+                     bool share_rdata)
+{
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_LOAD_FROM_SNAPSHOT).
+        arg(zone_name).arg(rrclass).arg(filename);
+
+    try {
+        return (loadSnapshotInternal(mem_sgmt, rrclass, zone_name, filename,
+                                     share_rdata));
+    } catch (const util::InvalidBufferPosition&) {
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " is truncated");
+    } catch (const dns::Exception& ex) {
+        // Broken name or NSEC3PARAM
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " is broken: " << ex.what());
+    } catch (const RdataSetError& ex) {
+        // Encoded RDATA that don't match their length
+        bundy_throw(ZoneSnapshotError, "Zone snapshot " << filename
+                  << " is broken: " << ex.what());
+    }
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
@@ -0,0 +1,137 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_ZONE_DATA_SNAPSHOT_H
+#define DATASRC_ZONE_DATA_SNAPSHOT_H 1
+
+#include <datasrc/exceptions.h>
+#include <datasrc/memory/zone_data.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <util/memory_segment.h>
+
+#include <string>
+
+namespace bundy {
+namespace datasrc {
+class DataSourceClient;
+
+namespace memory {
+
+/// \brief Zone snapshot is broken or doesn't match the zone.
+///
+/// This is thrown if a zone snapshot file can't be written, or if it can't
+/// be loaded because it's corrupted, it was written by an incompatible
+/// version or on a different kind of machine, or it's a snapshot of a
+/// different zone.
+struct ZoneSnapshotError : public ZoneLoaderException {
+    ZoneSnapshotError(const char* file, size_t line, const char* what) :
+        ZoneLoaderException(file, line, what)
+    {}
+};
+
+/// \brief Check if a file is a zone snapshot.
+///
+/// A zone snapshot is a binary image of a \c ZoneData, written by
+/// \c saveZoneDataSnapshot().  This function only checks the identifying
+/// header of the file, so the file may still fail to load.  It returns
+/// false if the file can't be read.
+///
+/// \throw None
+///
+/// \param filename The name of the file to check.
+bool isZoneDataSnapshot(const std::string& filename);
+
+/// \brief Save a \c ZoneData in a zone snapshot file.
+///
+/// The snapshot contains all names of the zone (including the NSEC3 name
+/// space) with their flags, the \c RdataSet objects in their internal
+/// encoding and the NSEC3 parameters, so \c loadZoneDataSnapshot() can
+/// restore the zone data without parsing or validating any RDATA.  The
+/// snapshot is protected by a SHA-1 digest of its content.
+///
+/// The encoded RDATA are stored in the host byte order, so a snapshot can
+/// only be loaded on a machine with the same byte order as the one that
+/// wrote it; \c loadZoneDataSnapshot() rejects it otherwise.
+///
+/// The snapshot is first written to a temporary file, which is then
+/// renamed to \c filename, so an existing snapshot is atomically replaced
+/// and a reader never sees a partially written one.
+///
+/// \throw ZoneSnapshotError The zone data is empty or the file can't be
+/// written
+/// \throw std::bad_alloc Memory allocation failure
+///
+/// \param zone_data The zone data to be saved.  It must not be empty (see
+/// \c ZoneData::isEmpty()).
+/// \param rrclass The RRClass of the zone.
+/// \param filename The name of the snapshot file.
+void saveZoneDataSnapshot(const ZoneData& zone_data,
+                          const bundy::dns::RRClass& rrclass,
+                          const std::string& filename);
+
+/// \brief Save a zone of a data source in a zone snapshot file.
+///
+/// This is a convenience wrapper of the other version.  It loads the
+/// zone from the given data source client into a temporary local memory
+/// segment with \c loadZoneData() (so the zone is validated the same way
+/// as it is when loaded into memory directly) and saves it.
+///
+/// \throw DataSourceError The zone can't be found in the data source
+/// \throw ZoneLoaderException The zone is invalid
+/// \throw ZoneSnapshotError The file can't be written
+/// \throw std::bad_alloc Memory allocation failure
+///
+/// \param client The data source client to get the zone from.
+/// \param rrclass The RRClass of the zone.
+/// \param zone_name The name of the zone.
+/// \param filename The name of the snapshot file.
+void saveZoneDataSnapshot(const DataSourceClient& client,
+                          const bundy::dns::RRClass& rrclass,
+                          const bundy::dns::Name& zone_name,
+                          const std::string& filename);
+
+/// \brief Create and return a ZoneData instance from a zone snapshot.
+///
+/// The snapshot file is mapped into memory, its header and digest are
+/// verified, and the zone data are rebuilt in \c mem_sgmt by copying
+/// the saved names and \c RdataSet encodings.  As the snapshot is expected
+/// to be made from a zone that was successfully loaded, the zone content
+/// isn't checked again.
+///
+/// \throw ZoneSnapshotError The file can't be read, is corrupted or is
+/// incompatible, or the snapshot isn't for the given zone
+/// \throw std::bad_alloc Memory allocation failure
+///
+/// \param mem_sgmt The memory segment.
+/// \param rrclass The RRClass.
+/// \param zone_name The name of the zone that is being loaded.
+/// \param filename The name of the snapshot file.
+/// \param share_rdata Whether to share identical RDATA in the zone data
+/// (see \c ZoneData::enableRdataSharing()).
+ZoneData* loadZoneDataSnapshot(util::MemorySegment& mem_sgmt,
+                               const bundy::dns::RRClass& rrclass,
+                               const bundy::dns::Name& zone_name,
+                               const std::string& filename,
+                               bool share_rdata = false);
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_ZONE_DATA_SNAPSHOT_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -49,14 +49,15 @@ ZoneDataUpdater::addWildcards(const Name& name) {
             // Ensure a separate level exists for the "wildcarding"
             // name, and mark the node as "wild".
             ZoneNode* node;
-            zone_data_->insertName(mem_sgmt_, wname.split(1), &node);
+            zone_data_->insertName(mem_sgmt_, wname.split(1), &node,
+                                   in_order_);
             node->setFlag(ZoneData::WILDCARD_NODE);
 
             // Ensure a separate level exists for the wildcard name.
             // Note: for 'name' itself we do this later anyway, but the
             // overhead should be marginal because wildcard names should
             // be rare.
-            zone_data_->insertName(mem_sgmt_, wname, &node);
+            zone_data_->insertName(mem_sgmt_, wname, &node, in_order_);
         }
     }
 }
@@ -246,7 +247,17 @@ ZoneDataUpdater::setupNSEC3(const ConstRRsetPtr rrset) {
     }
 }
 
-void
+namespace {
+// Total number of RDATAs and RRSIGs in the given RdataSet (which can be
+// NULL).
+size_t
+getRdataCount(const RdataSet* rdataset) {
+    return (rdataset == NULL ? 0 :
+            rdataset->getRdataCount() + rdataset->getSigRdataCount());
+}
+}
+
+bool
 ZoneDataUpdater::addNSEC3(const Name& name, const ConstRRsetPtr& rrset,
                           const ConstRRsetPtr& rrsig)
 {
@@ -268,29 +279,33 @@ ZoneDataUpdater::addNSEC3(const Name& name, const ConstRRsetPtr& rrset,
     }
 
     ZoneNode* node;
-    nsec3_data->insertName(mem_sgmt_, name, &node);
+    nsec3_data->insertName(mem_sgmt_, name, &node, in_order_);
 
     // Create a new RdataSet, merging any existing NSEC3 data for this
     // name.
     RdataSet* old_rdataset = node->getData();
+    const size_t old_count = getRdataCount(old_rdataset);
     RdataSet* rdataset = RdataSet::create(mem_sgmt_, encoder_, rrset, rrsig,
-                                          old_rdataset);
+                                          old_rdataset,
+                                          zone_data_->getRdataPool());
+    const size_t new_count = getRdataCount(rdataset);
     old_rdataset = node->setData(rdataset);
     if (old_rdataset != NULL) {
         RdataSet::destroy(mem_sgmt_, old_rdataset, rrclass_);
     }
+    return (new_count != old_count);
 }
 
-void
+bool
 ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
                              const ConstRRsetPtr& rrset,
                              const ConstRRsetPtr& rrsig)
 {
     if (rrtype == RRType::NSEC3()) {
-        addNSEC3(name, rrset, rrsig);
+        return (addNSEC3(name, rrset, rrsig));
     } else {
         ZoneNode* node;
-        zone_data_->insertName(mem_sgmt_, name, &node);
+        zone_data_->insertName(mem_sgmt_, name, &node, in_order_);
 
         RdataSet* rdataset_head = node->getData();
 
@@ -305,8 +320,11 @@ ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
         // Create a new RdataSet, merging any existing data for this
         // type.
         RdataSet* old_rdataset = RdataSet::find(rdataset_head, rrtype, true);
+        const size_t old_count = getRdataCount(old_rdataset);
         RdataSet* rdataset_new = RdataSet::create(mem_sgmt_, encoder_,
-                                                  rrset, rrsig, old_rdataset);
+                                                  rrset, rrsig, old_rdataset,
+                                                  zone_data_->getRdataPool());
+        const size_t new_count = getRdataCount(rdataset_new);
         if (old_rdataset == NULL) {
             // There is no existing RdataSet. Prepend the new RdataSet
             // to the list.
@@ -369,10 +387,12 @@ ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
                 dynamic_cast<const generic::SOA&>(
                     rrset->getRdataIterator()->getCurrent()).getMinimum());
         }
+
+        return (new_count != old_count);
     }
 }
 
-void
+bool
 ZoneDataUpdater::addInternal(const bundy::dns::Name& name,
                      const bundy::dns::RRType& rrtype,
                      const bundy::dns::ConstRRsetPtr& rrset,
@@ -387,10 +407,10 @@ ZoneDataUpdater::addInternal(const bundy::dns::Name& name,
         addWildcards(name);
     }
 
-    addRdataSet(name, rrtype, rrset, rrsig);
+    return (addRdataSet(name, rrtype, rrset, rrsig));
 }
 
-void
+bool
 ZoneDataUpdater::add(const ConstRRsetPtr& rrset,
                      const ConstRRsetPtr& sig_rrset)
 {
@@ -418,9 +438,10 @@ ZoneDataUpdater::add(const ConstRRsetPtr& rrset,
     // Store the address, it may change during growth and the address inside
     // would get updated.
     bool added = false;
+    bool changed = false;
     do {
         try {
-            addInternal(name, rrtype, rrset, sig_rrset);
+            changed = addInternal(name, rrtype, rrset, sig_rrset);
             added = true;
         } catch (const bundy::util::MemorySegmentGrown&) {
             // The segment has grown. So, we update the base pointer (because
@@ -431,6 +452,161 @@ ZoneDataUpdater::add(const ConstRRsetPtr& rrset,
         }
         // Retry if it didn't add due to the growth
     } while (!added);
+
+    return (changed);
+}
+
+bool
+ZoneDataUpdater::removeInternal(const Name& name, const RRType& rrtype,
+                                const ConstRRsetPtr& rrset,
+                                const ConstRRsetPtr& rrsig)
+{
+    const bool is_nsec3 = (rrtype == RRType::NSEC3());
+    NSEC3Data* nsec3_data = zone_data_->getNSEC3Data();
+    if (is_nsec3 && nsec3_data == NULL) {
+        return (false);
+    }
+    ZoneNode* node = is_nsec3 ? nsec3_data->findName(name) :
+        zone_data_->findName(name);
+    if (node == NULL) {
+        return (false);
+    }
+    RdataSet* rdataset_head = node->getData();
+    RdataSet* old_rdataset = RdataSet::find(rdataset_head, rrtype, true);
+    if (old_rdataset == NULL) {
+        return (false);
+    }
+
+    // Create a new RdataSet without the removed data.  It's NULL if nothing
+    // is left.
+    RdataSet* rdataset_new = RdataSet::subtract(mem_sgmt_, encoder_, rrset,
+                                                rrsig, *old_rdataset,
+                                                zone_data_->getRdataPool());
+    if (getRdataCount(rdataset_new) == getRdataCount(old_rdataset)) {
+        // None of the given data was in the zone.
+        RdataSet::destroy(mem_sgmt_, rdataset_new, rrclass_);
+        return (false);
+    }
+
+    // Replace the old RdataSet in the list with the new one (or just unlink
+    // it if nothing is left), and destroy the old one.
+    for (RdataSet* cur = rdataset_head, *prev = NULL;
+         cur != NULL;
+         prev = cur, cur = cur->getNext()) {
+        if (cur == old_rdataset) {
+            RdataSet* next = cur->getNext();
+            if (rdataset_new != NULL) {
+                rdataset_new->next = next;
+                next = rdataset_new;
+            }
+            if (prev == NULL) {
+                node->setData(next);
+            } else {
+                prev->next = next;
+            }
+            break;
+        }
+    }
+    RdataSet::destroy(mem_sgmt_, old_rdataset, rrclass_);
+
+    if (node->isEmpty()) {
+        empty_names_.push_back(std::make_pair(name, is_nsec3));
+    }
+    if (is_nsec3) {
+        return (true);
+    }
+
+    // Update the node and zone attributes that depend on the removed type.
+    const bool is_origin = (node == zone_data_->getOriginNode());
+    rdataset_head = node->getData();
+    if (rrtype == RRType::NS() || rrtype == RRType::DNAME()) {
+        node->setFlag(ZoneNode::FLAG_CALLBACK,
+                      (!is_origin &&
+                       RdataSet::find(rdataset_head, RRType::NS()) != NULL) ||
+                      RdataSet::find(rdataset_head, RRType::DNAME()) != NULL);
+    }
+    if (rrtype == RRType::NSEC() && is_origin &&
+        RdataSet::find(rdataset_head, RRType::NSEC()) == NULL &&
+        zone_data_->getNSEC3Data() == NULL) {
+        zone_data_->setSigned(false);
+    }
+    return (true);
+}
+
+bool
+ZoneDataUpdater::remove(const ConstRRsetPtr& rrset,
+                        const ConstRRsetPtr& sig_rrset)
+{
+    if (!rrset && !sig_rrset) {
+        bundy_throw(NullRRset,
+                  "ZoneDataUpdater::remove is given 2 NULL pointers");
+    }
+
+    const Name& name = rrset ? rrset->getName() : sig_rrset->getName();
+    const RRType& rrtype = rrset ? rrset->getType() :
+        getCoveredType(sig_rrset);
+
+    LOG_DEBUG(logger, DBG_TRACE_DATA, DATASRC_MEMORY_MEM_REMOVE_RRSET).
+        arg(name).
+        arg(rrset ? rrtype.toText() : "RRSIG(" + rrtype.toText() + ")").
+        arg(zone_name_);
+
+    // Same as add(): subtracting the data can make the segment grow.
+    while (true) {
+        try {
+            return (removeInternal(name, rrtype, rrset, sig_rrset));
+        } catch (const bundy::util::MemorySegmentGrown&) {
+            zone_data_ =
+                static_cast<ZoneData*>(
+                    mem_sgmt_.getNamedAddress("updater_zone_data").second);
+        }
+    }
+}
+
+void
+ZoneDataUpdater::removeEmptyNodes() {
+    if (zone_data_->getOriginNode()->isEmpty()) {
+        bundy_throw(bundy::InvalidOperation,
+                  "Empty nodes can't be removed while the origin is empty: "
+                  << zone_name_);
+    }
+
+    for (std::vector<std::pair<Name, bool> >::const_iterator it =
+             empty_names_.begin();
+         it != empty_names_.end();
+         ++it) {
+        const Name& name = it->first;
+        if (it->second) {
+            NSEC3Data* nsec3_data = zone_data_->getNSEC3Data();
+            ZoneNode* node = nsec3_data ? nsec3_data->findName(name) : NULL;
+            if (node != NULL && node->isEmpty()) {
+                nsec3_data->removeNode(mem_sgmt_, node);
+            }
+            continue;
+        }
+
+        // The node may have been removed already as an upper node of
+        // another one, or data may have been added to it again.
+        ZoneNode* node = zone_data_->findName(name);
+        if (node != NULL && node->isEmpty()) {
+            zone_data_->removeNode(mem_sgmt_, node);
+        }
+
+        // If a wildcard name has gone, the "wildcarding" level no longer
+        // needs the mark (see addWildcards()).
+        Name wname(name);
+        for (unsigned int l = wname.getLabelCount();
+             l > zone_name_.getLabelCount();
+             --l, wname = wname.split(1)) {
+            if (wname.isWildcard() && zone_data_->findName(wname) == NULL) {
+                ZoneNode* wild_node = zone_data_->findName(wname.split(1));
+                if (wild_node != NULL) {
+                    wild_node->setFlag(ZoneData::WILDCARD_NODE, false);
+                }
+            }
+        }
+    }
+    empty_names_.clear();
 }
 
 } // namespace memory
@@ -26,6 +26,9 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <utility>
+#include <vector>
+
 namespace bundy {
 namespace datasrc {
 namespace memory {
@@ -35,7 +38,8 @@ namespace memory {
 /// This class provides an \c add() method that can be used to add
 /// RRsets to a ZoneData instance. The RRsets are first validated for
 /// correctness and consistency, and their data is made into RdataSets
-/// which are added to the ZoneData for the zone.
+/// which are added to the ZoneData for the zone.  It also provides
+/// \c remove() to remove records from the zone for incremental updates.
 ///
 /// The way to use this is to make a ZoneDataUpdater instance, and call
 /// add() on it as follows:
@@ -57,22 +61,34 @@ public:
 
     /// The constructor.
     ///
+    /// If \c in_order is true, the RRsets are expected to be added mostly
+    /// in the DNSSEC order of their owner names, as is usually the case
+    /// for a whole zone loaded from a zone file or a zone transfer.  The
+    /// names are then inserted into the zone with the in-order fast path
+    /// of \c DomainTree::insert(), which skips most of the tree search for
+    /// names in that order.  RRsets out of that order are still added
+    /// correctly, only slightly more slowly than with \c in_order being
+    /// false.
+    ///
     /// \param mem_sgmt The memory segment used for the zone data.
     /// \param rrclass The RRclass of the zone data.
     /// \param zone_name The Name of the zone under which records will be
     ///                  added.
     /// \param zone_data The ZoneData object which is populated with
     ///                  record data.
+    /// \param in_order Whether RRsets are expected to be added in the
+    ///                 DNSSEC order.
     /// \throw InvalidOperation if there's already a zone data updater
     ///    on the given memory segment. Currently, at most one zone data
     ///    updater may exist on the same memory segment.
     ZoneDataUpdater(util::MemorySegment& mem_sgmt,
                     const bundy::dns::RRClass& rrclass,
                     const bundy::dns::Name& zone_name,
-                    ZoneData& zone_data) :
+                    ZoneData& zone_data, bool in_order = false) :
        mem_sgmt_(mem_sgmt),
        rrclass_(rrclass),
        zone_name_(zone_name),
+       in_order_(in_order),
        hash_(NULL),
        zone_data_(&zone_data)
     {
@@ -90,6 +106,9 @@ public:
     }
 
     /// The destructor.
+    ///
+    /// Nodes left empty by \c remove() and not cleaned up by
+    /// \c removeEmptyNodes() stay in the zone as empty nodes.
     ~ZoneDataUpdater() {
         mem_sgmt_.clearNamedAddress("updater_zone_data");
         delete hash_;
@@ -154,9 +173,55 @@ public:
     /// \param rrset The RRset to be added.
     /// \param sig_rrset An associated RRSIG RRset for the \c rrset. It
     ///                  can be empty if there is no RRSIG for the \c rrset.
-    void add(const bundy::dns::ConstRRsetPtr& rrset,
+    /// \return true if any RDATA (or RRSIG) is added to the zone; false if
+    /// all of them already existed in the zone.
+    bool add(const bundy::dns::ConstRRsetPtr& rrset,
              const bundy::dns::ConstRRsetPtr& sig_rrset);
 
+    /// \brief Remove an RRset from the zone.
+    ///
+    /// This is the counterpart of \c add().  It removes the RDATAs of
+    /// \c rrset and the RRSIGs of \c sig_rrset from the zone data.  RDATAs
+    /// that don't exist in the zone are ignored.  If no RDATA or RRSIG
+    /// remains for the type, the type is removed from the owner name.
+    ///
+    /// An owner name that has no data as a result of the removal is not
+    /// removed from the zone immediately; a sequence of updates can make
+    /// the zone temporarily inconsistent (for example, the origin can be
+    /// left empty while its SOA and NS are being replaced), and removing
+    /// names in such a state could break the structure of the zone.  The
+    /// caller is expected to call \c removeEmptyNodes() once the zone is
+    /// consistent again.
+    ///
+    /// Like \c add(), at least one of \c rrset and \c sig_rrset must be
+    /// non NULL.  They must be of the same owner name (and the RRSIGs
+    /// must cover the type of \c rrset if both are given).
+    ///
+    /// \throw NullRRset Both \c rrset and sig_rrset is NULL
+    /// \throw bundy::BadValue The given RRsets are inconsistent.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param rrset The RRset to be removed.
+    /// \param sig_rrset An RRSIG RRset to be removed.
+    /// \return true if any RDATA (or RRSIG) is removed from the zone; false
+    /// if none of them existed in the zone.
+    bool remove(const bundy::dns::ConstRRsetPtr& rrset,
+                const bundy::dns::ConstRRsetPtr& sig_rrset);
+
+    /// \brief Remove names left empty by \c remove().
+    ///
+    /// It removes the names that have become empty as a result of
+    /// \c remove() calls and are still empty (and don't have a subdomain)
+    /// from the zone, so that they don't exist in the zone from the DNS
+    /// point of view.  Related wildcard markers are also cleared.
+    ///
+    /// This must only be called when the zone origin has some data;
+    /// otherwise this method throws \c bundy::InvalidOperation without
+    /// removing anything.
+    ///
+    /// \throw bundy::InvalidOperation The zone origin is empty.
+    void removeEmptyNodes();
+
 private:
     // Add the necessary magic for any wildcard contained in 'name'
     // (including itself) to be found in the zone.
@@ -173,11 +238,16 @@ private:
     // contained in 'name' (e.g., '*.foo.example' in 'bar.*.foo.example').
     void addWildcards(const bundy::dns::Name& name);
 
-    void addInternal(const bundy::dns::Name& name,
+    bool addInternal(const bundy::dns::Name& name,
                      const bundy::dns::RRType& rrtype,
                      const bundy::dns::ConstRRsetPtr& rrset,
                      const bundy::dns::ConstRRsetPtr& rrsig);
 
+    bool removeInternal(const bundy::dns::Name& name,
+                        const bundy::dns::RRType& rrtype,
+                        const bundy::dns::ConstRRsetPtr& rrset,
+                        const bundy::dns::ConstRRsetPtr& rrsig);
+
     // Does some checks in context of the data that are already in the
     // zone.  Currently checks for forbidden combinations of RRsets in
     // the same domain (CNAME+anything, DNAME+NS).  If such condition is
@@ -193,10 +263,10 @@ private:
     const bundy::dns::NSEC3Hash* getNSEC3Hash();
     template <typename T>
     void setupNSEC3(const bundy::dns::ConstRRsetPtr rrset);
-    void addNSEC3(const bundy::dns::Name& name,
+    bool addNSEC3(const bundy::dns::Name& name,
                   const bundy::dns::ConstRRsetPtr& rrset,
                   const bundy::dns::ConstRRsetPtr& rrsig);
-    void addRdataSet(const bundy::dns::Name& name,
+    bool addRdataSet(const bundy::dns::Name& name,
                      const bundy::dns::RRType& rrtype,
                      const bundy::dns::ConstRRsetPtr& rrset,
                      const bundy::dns::ConstRRsetPtr& rrsig);
@@ -204,9 +274,13 @@ private:
     util::MemorySegment& mem_sgmt_;
     const bundy::dns::RRClass rrclass_;
     const bundy::dns::Name& zone_name_;
+    const bool in_order_;
     RdataEncoder encoder_;
     const bundy::dns::NSEC3Hash* hash_;
     ZoneData* zone_data_;
+    // Names that have become empty by remove(), with whether they are in
+    // the NSEC3 name space.
+    std::vector<std::pair<bundy::dns::Name, bool> > empty_names_;
 };
 
 } // namespace memory
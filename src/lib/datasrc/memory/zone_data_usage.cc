@@ -0,0 +1,89 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_data_usage.h>
+#include <datasrc/memory/rdata_pool.h>
+#include <datasrc/memory/rdataset.h>
+
+#include <dns/labelsequence.h>
+
+using namespace bundy::dns;
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+namespace {
+// Add the sizes of all RdataSets of the tree.  All nodes that can have
+// RdataSets are at or under the origin, so the walk starts from there.
+void
+addRdataSetUsage(const ZoneTree& tree, const LabelSequence& origin,
+                 const RRClass& rrclass, size_t& count, size_t& size)
+{
+    ZoneChain chain;
+    const ZoneNode* node = NULL;
+    if (tree.find<void*>(origin, &node, chain, NULL, NULL) !=
+        ZoneTree::EXACTMATCH) {
+        return;
+    }
+    for (; node != NULL; node = tree.nextNode(chain)) {
+        for (const RdataSet* rdataset = node->getData();
+             rdataset != NULL;
+             rdataset = rdataset->getNext()) {
+            ++count;
+            size += rdataset->getMemorySize(rrclass);
+        }
+    }
+}
+}
+
+ZoneDataUsage
+getZoneDataUsage(const ZoneData& zone_data, const RRClass& rrclass) {
+    ZoneDataUsage usage;
+    uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    const LabelSequence origin =
+        zone_data.getOriginNode()->getAbsoluteLabels(labels_buf);
+
+    const ZoneTree& tree = zone_data.getZoneTree();
+    usage.node_count = tree.getNodeCount();
+    usage.node_size = sizeof(ZoneNode) * usage.node_count;
+    usage.index_size = tree.getIndexSize();
+    usage.label_size = tree.getMemorySize() - sizeof(ZoneTree) -
+        usage.node_size - usage.index_size;
+    addRdataSetUsage(tree, origin, rrclass, usage.rdataset_count,
+                     usage.rdataset_size);
+
+    const RdataPool* pool = zone_data.getRdataPool();
+    if (pool != NULL) {
+        usage.shared_rdata_size = pool->getMemorySize();
+    }
+
+    const NSEC3Data* nsec3_data = zone_data.getNSEC3Data();
+    if (nsec3_data != NULL) {
+        const ZoneTree& nsec3_tree = nsec3_data->getNSEC3Tree();
+        size_t nsec3_rdataset_count = 0;
+        size_t nsec3_rdataset_size = 0;
+        addRdataSetUsage(nsec3_tree, origin, rrclass, nsec3_rdataset_count,
+                         nsec3_rdataset_size);
+        usage.nsec3_size = sizeof(NSEC3Data) + 1 + nsec3_data->getSaltLen() +
+            nsec3_tree.getMemorySize() + nsec3_rdataset_size;
+    }
+
+    usage.other_size = sizeof(ZoneData) + sizeof(ZoneTree);
+    return (usage);
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
@@ -0,0 +1,81 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_ZONE_DATA_USAGE_H
+#define DATASRC_ZONE_DATA_USAGE_H 1
+
+#include <datasrc/memory/zone_data.h>
+#include <dns/rrclass.h>
+
+#include <cstddef>
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+/// \brief Memory usage of a zone.
+///
+/// This is the result of \c getZoneDataUsage().  The sizes are in bytes
+/// and are of disjoint categories, so their sum (\c getTotalSize()) is
+/// the total memory allocated for the zone data.  They don't include
+/// the overhead of the memory segment itself (such as the allocation
+/// headers or fragmentation of free space).
+struct ZoneDataUsage {
+    /// \brief Constructor.  All counters are initialized to 0.
+    ZoneDataUsage() :
+        node_count(0), node_size(0), label_size(0), index_size(0),
+        rdataset_count(0), rdataset_size(0), shared_rdata_size(0),
+        nsec3_size(0), other_size(0)
+    {}
+
+    /// \brief Return the sum of all sizes.
+    size_t getTotalSize() const {
+        return (node_size + label_size + index_size + rdataset_size +
+                shared_rdata_size + nsec3_size + other_size);
+    }
+
+    size_t node_count;          ///< Number of nodes of the zone tree
+    size_t node_size;           ///< Size of the nodes, excluding labels
+    size_t label_size;          ///< Size of the labels of the nodes
+    size_t index_size;          ///< Size of the search index of the tree
+    size_t rdataset_count;      ///< Number of \c RdataSet objects
+    size_t rdataset_size;       ///< Size of the \c RdataSet objects
+    size_t shared_rdata_size;   ///< Size of the shared RDATA, if any
+    size_t nsec3_size;          ///< Size of all NSEC3 related data
+    size_t other_size;          ///< Size of the \c ZoneData and tree headers
+};
+
+/// \brief Calculate the memory usage of a zone.
+///
+/// This walks through all data of the zone, including the NSEC3 name
+/// space, so it takes time proportional to the size of the zone.  It's
+/// intended for reporting purposes, and not expected to be used in
+/// a performance sensitive path.
+///
+/// \throw None
+///
+/// \param zone_data The zone data.
+/// \param rrclass The RR class of the zone.
+ZoneDataUsage getZoneDataUsage(const ZoneData& zone_data,
+                               const bundy::dns::RRClass& rrclass);
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_ZONE_DATA_USAGE_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -29,9 +29,11 @@
 #include <datasrc/memory/logger.h>
 
 #include <util/buffer.h>
+#include <util/thread_arena.h>
 
 #include <boost/scoped_ptr.hpp>
-#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/ref.hpp>
 
 #include <algorithm>
 #include <vector>
@@ -41,6 +43,7 @@
 using namespace bundy::dns;
 using namespace bundy::datasrc::memory;
 using namespace bundy::datasrc;
+using bundy::util::ArenaAllocator;
 
 namespace bundy {
 namespace datasrc {
@@ -92,8 +95,8 @@ typedef std::pair<const ZoneNode*, const RdataSet*> ConstNodeRRset;
 /// Creates a TreeNodeRRsetPtr for the given RdataSet at the given Node, for
 /// the given RRClass
 ///
-/// We should probably have some pool so these  do not need to be allocated
-/// dynamically.
+/// These are created for every query, so they (together with the reference
+/// counter of the pointer) are allocated from the per-thread arena.
 ///
 /// \param node The ZoneNode found by the find() calls
 /// \param rdataset The RdataSet to create the RRsetPtr for
@@ -112,17 +115,21 @@ createTreeNodeRRset(const ZoneNode* node,
 {
     const bool dnssec = ((options & ZoneFinder::FIND_DNSSEC) != 0);
     if (node && rdataset) {
+        const ArenaAllocator<TreeNodeRRset> allocator;
         if (realname) {
-            return (TreeNodeRRsetPtr(new TreeNodeRRset(*realname, rrclass,
-                                                       node, rdataset,
-                                                       dnssec)));
+            return (boost::allocate_shared<TreeNodeRRset>(allocator,
+                                                          *realname, rrclass,
+                                                          node, rdataset,
+                                                          dnssec));
         } else if (ttl_data) {
             assert(!realname);  // these two cases should be mixed in our use
-            return (TreeNodeRRsetPtr(new TreeNodeRRset(rrclass, node, rdataset,
-                                                       dnssec, ttl_data)));
+            return (boost::allocate_shared<TreeNodeRRset>(allocator, rrclass,
+                                                          node, rdataset,
+                                                          dnssec, ttl_data));
         } else {
-            return (TreeNodeRRsetPtr(new TreeNodeRRset(rrclass, node, rdataset,
-                                                       dnssec)));
+            return (boost::allocate_shared<TreeNodeRRset>(allocator, rrclass,
+                                                          node, rdataset,
+                                                          dnssec));
         }
     } else {
         return (TreeNodeRRsetPtr());
@@ -625,13 +632,39 @@ private:
             options = options | ZoneFinder::FIND_GLUE_OK;
         }
 
+        // The callback is passed by reference so that the reader doesn't
+        // have to allocate a copy of it.
+        AdditionalFinder finder(*this, requested_types, result, options);
         RdataReader(rrclass_, rdset->type, rdset->getDataBuf(),
                     rdset->getRdataCount(), rdset->getSigRdataCount(),
-                    boost::bind(&Context::findAdditional, this,
-                                &requested_types, &result, options, _1, _2),
+                    boost::ref(finder),
                     &RdataReader::emptyDataAction).iterate();
     }
 
+    // RdataReader callback for additional section processing, calling
+    // findAdditional() with the parameters of getAdditionalForRdataset().
+    class AdditionalFinder {
+    public:
+        AdditionalFinder(const Context& context,
+                         const std::vector<RRType>& requested_types,
+                         std::vector<ConstRRsetPtr>& result,
+                         ZoneFinder::FindOptions options) :
+            context_(context), requested_types_(requested_types),
+            result_(result), options_(options)
+        {}
+        void operator()(const LabelSequence& name_labels,
+                        RdataNameAttributes attr)
+        {
+            context_.findAdditional(&requested_types_, &result_, options_,
+                                    name_labels, attr);
+        }
+    private:
+        const Context& context_;
+        const std::vector<RRType>& requested_types_;
+        std::vector<ConstRRsetPtr>& result_;
+        const ZoneFinder::FindOptions options_;
+    };
+
     // RdataReader callback for additional section processing.
     void
     findAdditional(const std::vector<RRType>* requested_types,
@@ -736,14 +769,24 @@ InMemoryZoneFinder::Context::findAdditional(
     }
 }
 
+ZoneFinderContextPtr
+InMemoryZoneFinder::createContext(const FindOptions options,
+                                  const ZoneFinderResultContext& result)
+{
+    // Contexts are created for every query, so they are allocated from the
+    // per-thread arena.  The finder is passed via a reference wrapper, as
+    // allocate_shared() may only forward const references.
+    return (boost::allocate_shared<Context>(ArenaAllocator<Context>(),
+                                            boost::ref(*this), options,
+                                            rrclass_, result));
+}
+
 boost::shared_ptr<ZoneFinder::Context>
 InMemoryZoneFinder::find(const bundy::dns::Name& name,
                          const bundy::dns::RRType& type,
                          const FindOptions options)
 {
-    return (ZoneFinderContextPtr(new Context(*this, options, rrclass_,
-                                             findInternal(name, type,
-                                                          NULL, options))));
+    return (createContext(options, findInternal(name, type, NULL, options)));
 }
 
 boost::shared_ptr<ZoneFinder::Context>
@@ -751,11 +794,8 @@ InMemoryZoneFinder::findAll(const bundy::dns::Name& name,
                             std::vector<bundy::dns::ConstRRsetPtr>& target,
                             const FindOptions options)
 {
-    return (ZoneFinderContextPtr(new Context(*this, options, rrclass_,
-                                             findInternal(name,
-                                                          RRType::ANY(),
-                                                          &target,
-                                                          options))));
+    return (createContext(options, findInternal(name, RRType::ANY(),
+                                                &target, options)));
 }
 
 // The implementation is a special case of the generic findInternal: we know
@@ -779,21 +819,18 @@ InMemoryZoneFinder::findAtOrigin(const bundy::dns::RRType& type,
     if (found != NULL) {
         LOG_DEBUG(logger, DBG_TRACE_DATA, DATASRC_MEMORY_FIND_TYPE_AT_ORIGIN).
             arg(type).arg(getOrigin()).arg(rrclass_);
-        return (ZoneFinderContextPtr(
-                    new Context(*this, options, rrclass_,
-                                createFindResult(rrclass_, zone_data_, SUCCESS,
-                                                 node, found, options, false,
-                                                 NULL, use_minttl))));
+        return (createContext(options,
+                              createFindResult(rrclass_, zone_data_, SUCCESS,
+                                               node, found, options, false,
+                                               NULL, use_minttl)));
     }
-    return (ZoneFinderContextPtr(
-                    new Context(*this, options, rrclass_,
-                                createFindResult(rrclass_, zone_data_, NXRRSET,
-                                                 node,
-                                                 getNSECForNXRRSET(zone_data_,
-                                                                   options,
-                                                                   node),
-                                                 options, false, NULL,
-                                                 use_minttl))));
+    return (createContext(options,
+                          createFindResult(rrclass_, zone_data_, NXRRSET,
+                                           node,
+                                           getNSECForNXRRSET(zone_data_,
+                                                             options, node),
+                                           options, false, NULL,
+                                           use_minttl)));
 }
 
 ZoneFinderResultContext
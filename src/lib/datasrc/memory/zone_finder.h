@@ -109,6 +109,11 @@ private:
         const FindOptions options =
         FIND_DEFAULT);
 
+    /// Create the finder context for the result of a search
+    ZoneFinderContextPtr createContext(
+        const FindOptions options,
+        const internal::ZoneFinderResultContext& result);
+
     const ZoneData& zone_data_;
     const bundy::dns::RRClass rrclass_;
 };
@@ -14,6 +14,7 @@
 
 #include <datasrc/memory/zone_table.h>
 #include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_data_usage.h>
 #include <datasrc/memory/domaintree.h>
 #include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/memory/logger.h>
@@ -82,6 +83,12 @@ ZoneTable::destroy(util::MemorySegment& mem_sgmt, ZoneTable* ztable, int)
     mem_sgmt.deallocate(ztable, sizeof(ZoneTable));
 }
 
+size_t
+ZoneTable::getMemorySize() const {
+    return (sizeof(ZoneTable) + zones_->getMemorySize() +
+            getZoneDataUsage(*null_zone_data_, rrclass_).getTotalSize());
+}
+
 ZoneTable::AddResult
 ZoneTable::addZone(util::MemorySegment& mem_sgmt,
                    const Name& zone_name, ZoneData* content)
@@ -159,6 +159,15 @@ public:
     /// \throw None.
     size_t getZoneCount() const { return (zone_count_); }
 
+    /// \brief Return the size of the memory allocated for the table.
+    ///
+    /// It includes the table itself, its tree and the placeholder for
+    /// broken zones, but not the data of the zones stored in the table
+    /// (see \c getZoneDataUsage() for them).
+    ///
+    /// \throw None.
+    size_t getMemorySize() const;
+
     /// \brief Add a new zone to the \c ZoneTable.
     ///
     /// This method adds a given zone data to the internal table.
@@ -337,6 +337,17 @@ public:
     /// Note that after calling \c clear(), this method will return
     /// false until the segment is reset successfully again.
     virtual bool isUsable() const = 0;
+
+    /// \brief Bring the whole segment into memory.
+    ///
+    /// An application that opens a new segment to replace one that is in
+    /// use can call this before the switch, so lookups in the new segment
+    /// don't suffer from page faults right after it.  This is meaningful
+    /// only for implementations backed by files (such as the "mapped"
+    /// type); the default implementation does nothing.
+    ///
+    /// \throw None
+    virtual void prefault() const {}
 };
 
 } // namespace memory
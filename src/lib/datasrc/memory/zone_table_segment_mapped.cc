@@ -375,6 +375,13 @@ ZoneTableSegmentMapped::isUsable() const {
     return (mem_sgmt_);
 }
 
+void
+ZoneTableSegmentMapped::prefault() const {
+    if (mem_sgmt_) {
+        mem_sgmt_->prefault();
+    }
+}
+
 bool
 ZoneTableSegmentMapped::isWritable() const {
     if (!isUsable()) {
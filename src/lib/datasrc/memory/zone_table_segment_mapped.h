@@ -112,6 +112,13 @@ public:
     /// See the base class for the description.
     virtual bool isUsable() const;
 
+    /// \brief Bring the currently open mapped file into memory.
+    ///
+    /// This does nothing if no file is open.
+    ///
+    /// \throw None
+    virtual void prefault() const;
+
 private:
     void sync();
 
@@ -14,6 +14,7 @@
 
 #include <datasrc/memory/zone_writer.h>
 #include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_data_loader.h>
 #include <datasrc/memory/zone_table_segment.h>
 #include <datasrc/memory/segment_object_holder.h>
 
@@ -24,6 +25,7 @@
 #include <datasrc/exceptions.h>
 
 #include <memory>
+#include <vector>
 
 using std::auto_ptr;
 
@@ -43,15 +45,17 @@ checkZoneTableSegment(ZoneTableSegment& segment) {
 struct ZoneWriter::Impl {
     Impl(ZoneTableSegment& segment, const LoadAction& load_action,
          const dns::Name& origin, const dns::RRClass& rrclass,
-         bool throw_on_load_error) :
+         bool throw_on_load_error, const DiffAction& diff_action) :
         // We validate segment first so we can use it to initialize
         // data_holder_ safely.
         segment_(checkZoneTableSegment(segment)),
         load_action_(load_action),
+        diff_action_(diff_action),
         origin_(origin),
         rrclass_(rrclass),
         state_(ZW_UNUSED),
-        catch_load_error_(throw_on_load_error)
+        catch_load_error_(throw_on_load_error),
+        incremental_(false)
     {
         while (true) {
             try {
@@ -64,6 +68,7 @@ struct ZoneWriter::Impl {
 
     ZoneTableSegment& segment_;
     const LoadAction load_action_;
+    const DiffAction diff_action_;
     const dns::Name origin_;
     const dns::RRClass rrclass_;
     enum State {
@@ -74,6 +79,8 @@ struct ZoneWriter::Impl {
     };
     State state_;
     const bool catch_load_error_;
+    bool incremental_;          // true if we update the zone data in place
+    std::vector<dns::ConstRRsetPtr> diffs_; // differences in incremental mode
     typedef detail::SegmentObjectHolder<ZoneData, dns::RRClass> ZoneDataHolder;
     boost::scoped_ptr<ZoneDataHolder> data_holder_;
 };
@@ -82,8 +89,10 @@ ZoneWriter::ZoneWriter(ZoneTableSegment& segment,
                        const LoadAction& load_action,
                        const dns::Name& origin,
                        const dns::RRClass& rrclass,
-                       bool throw_on_load_error) :
-    impl_(new Impl(segment, load_action, origin, rrclass, throw_on_load_error))
+                       bool throw_on_load_error,
+                       const DiffAction& diff_action) :
+    impl_(new Impl(segment, load_action, origin, rrclass, throw_on_load_error,
+                   diff_action))
 {
 }
 
@@ -101,6 +110,25 @@ ZoneWriter::load(std::string* error_msg) {
     }
 
     try {
+        // Try to get the differences first if we can update the zone in
+        // place.  The zone data in a mapped segment could be remapped while
+        // being updated, so we always load the entire zone in that case.
+        if (impl_->diff_action_ &&
+            impl_->segment_.getImplType() == "local") {
+            const ZoneTable* table = impl_->segment_.getHeader().getTable();
+            const ZoneTable::FindResult result(
+                table != NULL ? table->findZone(impl_->origin_) :
+                ZoneTable::FindResult(result::NOTFOUND, NULL));
+            if (result.code == result::SUCCESS && result.zone_data != NULL &&
+                !result.zone_data->isEmpty() &&
+                impl_->diff_action_(*result.zone_data, impl_->diffs_)) {
+                impl_->incremental_ = true;
+                impl_->state_ = Impl::ZW_LOADED;
+                return;
+            }
+            impl_->diffs_.clear();
+        }
+
         ZoneData* zone_data =
             impl_->load_action_(impl_->segment_.getMemorySegment());
 
@@ -130,6 +158,27 @@ ZoneWriter::install() {
         bundy_throw(bundy::InvalidOperation, "No data to install");
     }
 
+    if (impl_->incremental_) {
+        // The zone must still be there as the application is expected to
+        // serialize the updates of the zone table.
+        const ZoneTable* table = impl_->segment_.getHeader().getTable();
+        const ZoneTable::FindResult result(table->findZone(impl_->origin_));
+        if (result.code != result::SUCCESS || result.zone_data == NULL) {
+            bundy_throw(bundy::Unexpected, "Zone to be updated disappeared: "
+                        << impl_->origin_);
+        }
+        if (!impl_->diffs_.empty()) {
+            // The zone table only gives us read-only access to the zone
+            // data, but it's owned by the segment we are writing to.
+            updateZoneData(impl_->segment_.getMemorySegment(),
+                           impl_->rrclass_, impl_->origin_,
+                           const_cast<ZoneData&>(*result.zone_data),
+                           impl_->diffs_);
+        }
+        impl_->state_ = Impl::ZW_INSTALLED;
+        return;
+    }
+
     // Check the internal integrity assumption: we should have non NULL
     // zone data or we've allowed load error to create an empty zone.
     assert(impl_->data_holder_.get() || impl_->catch_load_error_);
@@ -158,6 +207,27 @@ ZoneWriter::install() {
     }
 }
 
+bool
+ZoneWriter::isReplacement() const {
+    if (impl_->state_ != Impl::ZW_LOADED) {
+        bundy_throw(bundy::InvalidOperation, "No data to install");
+    }
+    if (impl_->segment_.getImplType() != "local" || impl_->incremental_) {
+        return (false);
+    }
+    const ZoneTable* table = impl_->segment_.getHeader().getTable();
+    return (table != NULL &&
+            table->findZone(impl_->origin_).code == result::SUCCESS);
+}
+
+bool
+ZoneWriter::isIncremental() const {
+    if (impl_->state_ == Impl::ZW_UNUSED) {
+        bundy_throw(bundy::InvalidOperation, "Zone hasn't been loaded");
+    }
+    return (impl_->incremental_);
+}
+
 void
 ZoneWriter::cleanup() {
     // We eat the data (if any) now.
@@ -36,6 +36,17 @@ class ZoneTableSegment;
 /// in a different thread. The install() operation is the only one that needs
 /// to be done in a critical section.
 ///
+/// If a \c DiffAction is given on construction, the writer tries to update
+/// the zone data currently in memory with the differences from its version
+/// to the latest version, instead of loading the entire zone into new
+/// zone data (we call it "incremental" mode).  This is only possible for
+/// the "local" memory segment type, and only if the zone is already
+/// loaded and the action can provide the differences; otherwise the zone
+/// is loaded by the \c LoadAction as usual.  In incremental mode, load()
+/// only retrieves the differences and install() applies them to the zone
+/// data in place.  So install() is not necessarily fast in this mode, and
+/// the zone data must not be used by anyone else during install().
+///
 /// This class provides strong exception guarantee for each public
 /// method. That is, when any of the methods throws, the entire state
 /// stays the same as before the call.
@@ -61,9 +72,13 @@ public:
     /// \param rrclass The class of the zone.
     /// \param catch_load_error true if loading errors are to be caught
     /// internally; false otherwise.
+    /// \param diff_action The callback used to get differences to update
+    /// the zone data in memory.  If empty, the zone is always loaded by
+    /// \c load_action.
     ZoneWriter(ZoneTableSegment& segment,
                const LoadAction& load_action, const dns::Name& name,
-               const dns::RRClass& rrclass, bool catch_load_error);
+               const dns::RRClass& rrclass, bool catch_load_error,
+               const DiffAction& diff_action = DiffAction());
 
     /// \brief Destructor.
     ~ZoneWriter();
@@ -114,10 +129,45 @@ public:
     /// This may throw in rare cases.  If it throws, you still need to
     /// call cleanup().
     ///
+    /// In incremental mode, this applies the differences retrieved in
+    /// load() to the zone data in place.  If it fails, the zone data is
+    /// unchanged and the exception (e.g., \c ZoneValidationError) is
+    /// propagated.
+    ///
     /// \throw bundy::InvalidOperation if called without previous load() or for
     ///     the second time or cleanup() was called already.
     void install();
 
+    /// \brief Check if install() only replaces an existing version of zone.
+    ///
+    /// This returns true if \c install() will simply replace the data of
+    /// the zone already in the zone table in place, without changing the
+    /// structure of the table or reallocating the memory segment.  In that
+    /// case the replacement is a single atomic update of a pointer, so
+    /// readers of the table that don't hold any lock can only see either
+    /// the old or the new version of the zone; the application can then
+    /// install the new version without blocking them, as long as it waits
+    /// for them to finish using the old version before calling
+    /// \c cleanup().
+    ///
+    /// This is only true for the "local" memory segment type; mapped
+    /// segments can be remapped on modification and must be updated under
+    /// exclusive access in any case.  It's also false in incremental mode,
+    /// as the zone data is then modified in place.
+    ///
+    /// This method must be called after load() and before install().
+    ///
+    /// \throw bundy::InvalidOperation if called without previous load() or
+    ///     after install() or cleanup().
+    bool isReplacement() const;
+
+    /// \brief Check if the writer updates the zone data incrementally.
+    ///
+    /// This must be called after load().
+    ///
+    /// \throw bundy::InvalidOperation if called without previous load().
+    bool isIncremental() const;
+
     /// \brief Clean up resources.
     ///
     /// This releases all resources held by owned zone data. That means the
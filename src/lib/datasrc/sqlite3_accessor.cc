@@ -29,6 +29,9 @@
 #include <datasrc/factory.h>
 #include <datasrc/database.h>
 #include <util/filename.h>
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
 
 using namespace std;
 using namespace bundy::data;
@@ -181,6 +184,7 @@ struct SQLite3Parameters {
     {
         for (int i = 0; i < NUM_STATEMENTS; ++i) {
             statements_[i] = NULL;
+            context_statements_[i] = NULL;
         }
     }
 
@@ -191,19 +195,39 @@ struct SQLite3Parameters {
     getStatement(int id) {
         assert(id < NUM_STATEMENTS);
         if (statements_[id] == NULL) {
-            assert(db_ != NULL);
-            sqlite3_stmt* prepared = NULL;
-            if (sqlite3_prepare_v2(db_, text_statements[id], -1, &prepared,
-                                   NULL) != SQLITE_OK) {
-                bundy_throw(SQLite3Error, "Could not prepare SQLite statement: "
-                          << text_statements[id] <<
-                          ": " << sqlite3_errmsg(db_));
-            }
-            statements_[id] = prepared;
+            statements_[id] = prepareStatement(id);
         }
         return (statements_[id]);
     }
 
+    // Iterator contexts can't use getStatement(), as each of them needs its
+    // own statement as long as it lives (and there can be more than one at
+    // a time).  Instead they take a statement with this method and give it
+    // back with releaseContextStatement(), which keeps one statement per ID
+    // for the next context, so we don't have to prepare it every time.
+    sqlite3_stmt*
+    acquireContextStatement(int id) {
+        assert(id < NUM_STATEMENTS);
+        sqlite3_stmt* const stmt = context_statements_[id];
+        if (stmt != NULL) {
+            context_statements_[id] = NULL;
+            return (stmt);
+        }
+        return (prepareStatement(id));
+    }
+
+    void
+    releaseContextStatement(int id, sqlite3_stmt* stmt) {
+        assert(id < NUM_STATEMENTS);
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        if (context_statements_[id] == NULL) {
+            context_statements_[id] = stmt;
+        } else {
+            sqlite3_finalize(stmt);
+        }
+    }
+
     void
     finalizeStatements() {
         for (int i = 0; i < NUM_STATEMENTS; ++i) {
@@ -211,6 +235,10 @@ struct SQLite3Parameters {
                 sqlite3_finalize(statements_[i]);
                 statements_[i] = NULL;
             }
+            if (context_statements_[i] != NULL) {
+                sqlite3_finalize(context_statements_[i]);
+                context_statements_[i] = NULL;
+            }
         }
     }
 
@@ -222,9 +250,75 @@ struct SQLite3Parameters {
     int updated_zone_id;        // valid only when in_transaction is true
     string updated_zone_origin_; // ditto, and only needed to handle NSEC3s
 private:
+    sqlite3_stmt*
+    prepareStatement(int id) {
+        assert(db_ != NULL);
+        sqlite3_stmt* prepared = NULL;
+        if (sqlite3_prepare_v2(db_, text_statements[id], -1, &prepared,
+                               NULL) != SQLITE_OK) {
+            bundy_throw(SQLite3Error, "Could not prepare SQLite statement: "
+                      << text_statements[id] <<
+                      ": " << sqlite3_errmsg(db_));
+        }
+        return (prepared);
+    }
+
     // statements_ are private and must be accessed via getStatement() outside
-    // of this structure.
+    // of this structure.  Likewise, context_statements_ are only accessed
+    // via acquire/releaseContextStatement().
     sqlite3_stmt* statements_[NUM_STATEMENTS];
+    sqlite3_stmt* context_statements_[NUM_STATEMENTS];
+};
+
+// The idle connections of a WAL mode accessor and its clones.  A clone
+// destroyed outside of a transaction puts its connection (with the prepared
+// statements) here, and the next clone takes it instead of opening the
+// database again.  Accessors of the same pool can be used in different
+// threads, so the pool is protected by a mutex.
+struct SQLite3ConnectionPool : boost::noncopyable {
+    // The maximum number of idle connections kept in the pool.  We don't
+    // need many, as a connection is only idle between the destruction of
+    // a clone and the creation of the next one.
+    static const size_t MAX_IDLE_CONNECTIONS = 8;
+
+    SQLite3ConnectionPool() {
+        // So release() doesn't have to allocate memory
+        idle_.reserve(MAX_IDLE_CONNECTIONS);
+    }
+
+    ~SQLite3ConnectionPool() {
+        for (size_t i = 0; i < idle_.size(); ++i) {
+            idle_[i].finalizeStatements();
+            sqlite3_close(idle_[i].db_);
+        }
+    }
+
+    // Move an idle connection to params, if any.  Returns whether there was.
+    bool acquire(SQLite3Parameters& params) {
+        bundy::util::thread::Mutex::Locker locker(mutex_);
+        if (idle_.empty()) {
+            return (false);
+        }
+        params = idle_.back();
+        idle_.pop_back();
+        return (true);
+    }
+
+    // Move the connection in params to the pool unless it's full.  Returns
+    // whether it was moved; otherwise params are left intact.
+    bool release(SQLite3Parameters& params) {
+        bundy::util::thread::Mutex::Locker locker(mutex_);
+        if (idle_.size() >= MAX_IDLE_CONNECTIONS) {
+            return (false);
+        }
+        idle_.push_back(params);
+        params = SQLite3Parameters(); // clear everything
+        return (true);
+    }
+
+private:
+    bundy::util::thread::Mutex mutex_;
+    std::vector<SQLite3Parameters> idle_;
 };
 
 // This is a helper class to encapsulate the code logic of executing
@@ -297,20 +391,45 @@ private:
 };
 
 SQLite3Accessor::SQLite3Accessor(const std::string& filename,
-                                 const string& rrclass) :
+                                 const string& rrclass, bool wal_mode) :
     dbparameters_(new SQLite3Parameters),
     filename_(filename),
     class_(rrclass),
     database_name_("sqlite3_" +
-                   bundy::util::Filename(filename).nameAndExtension())
+                   bundy::util::Filename(filename).nameAndExtension()),
+    pool_(wal_mode ? new SQLite3ConnectionPool : NULL)
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_SQLITE_NEWCONN);
 
     open(filename);
 }
 
+SQLite3Accessor::SQLite3Accessor(
+    const std::string& filename, const string& rrclass,
+    const boost::shared_ptr<SQLite3ConnectionPool>& pool) :
+    dbparameters_(new SQLite3Parameters),
+    filename_(filename),
+    class_(rrclass),
+    database_name_("sqlite3_" +
+                   bundy::util::Filename(filename).nameAndExtension()),
+    pool_(pool)
+{
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_SQLITE_NEWCONN);
+
+    if (pool_->acquire(*dbparameters_)) {
+        LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_SQLITE_CONNREUSE).
+            arg(filename);
+    } else {
+        open(filename);
+    }
+}
+
 boost::shared_ptr<DatabaseAccessor>
 SQLite3Accessor::clone() {
+    if (pool_) {
+        return (boost::shared_ptr<DatabaseAccessor>(
+                    new SQLite3Accessor(filename_, class_, pool_)));
+    }
     return (boost::shared_ptr<DatabaseAccessor>(new SQLite3Accessor(filename_,
                                                                     class_)));
 }
@@ -545,6 +664,33 @@ checkAndSetupSchema(Initializer* initializer, const std::string& name) {
     initializer->params_.minor_version_ = schema_version.second;
 }
 
+// Switch the database to the write-ahead logging journal mode.  This is
+// persistent in the database file, so it's a no-op unless it's the first
+// time for the file.  Note that it's not available for in-memory databases.
+void
+setupWAL(Initializer* initializer, const std::string& name) {
+    sqlite3* const db = initializer->params_.db_;
+
+    sqlite3_stmt* const stmt = prepare(db, "PRAGMA journal_mode=WAL");
+    const int rc = sqlite3_step(stmt);
+    string mode;
+    if (rc == SQLITE_ROW) {
+        const unsigned char* const text = sqlite3_column_text(stmt, 0);
+        if (text != NULL) {
+            mode = reinterpret_cast<const char*>(text);
+        }
+    }
+    const string errmsg = (rc == SQLITE_ROW) ? "journal mode is " + mode :
+        sqlite3_errmsg(db);
+    sqlite3_finalize(stmt);
+
+    if (mode != "wal") {
+        bundy_throw(SQLite3Error, "Unable to use write-ahead logging for "
+                    "SQLite database file " << name << ": " << errmsg);
+    }
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_SQLITE_WAL).arg(name);
+}
+
 }
 
 void
@@ -562,6 +708,9 @@ SQLite3Accessor::open(const std::string& name) {
     }
 
     checkAndSetupSchema(&initializer, name);
+    if (pool_) {
+        setupWAL(&initializer, name);
+    }
     initializer.move(dbparameters_.get());
 }
 
@@ -569,7 +718,20 @@ SQLite3Accessor::~SQLite3Accessor() {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_SQLITE_DROPCONN)
         .arg(database_name_);
     if (dbparameters_->db_ != NULL) {
-        close();
+        // In the WAL mode keep the connection for later clones, unless it's
+        // in the middle of a transaction (which would be a bug of the
+        // caller, but we'd rather not pass it to someone else).
+        bool released = false;
+        if (pool_ && !dbparameters_->in_transaction) {
+            try {
+                released = pool_->release(*dbparameters_);
+            } catch (...) {
+                // We only lose the chance of reusing the connection.
+            }
+        }
+        if (!released) {
+            close();
+        }
     }
 }
 
@@ -697,20 +859,21 @@ public:
         accessor_(accessor),
         statement_(NULL),
         statement2_(NULL),
+        statement_id_(NUM_STATEMENTS),
+        statement2_id_(NUM_STATEMENTS),
         rc_(SQLITE_OK),
         rc2_(SQLITE_OK),
         name_("")
     {
         // We create the statements now and then just keep getting data
         // from them.
-        statement_ = prepare(accessor->dbparameters_->db_,
-                             text_statements[ITERATE_NSEC3]);
+        acquireStatement(ITERATE_NSEC3);
         bindZoneId(id);
 
         std::swap(statement_, statement2_);
+        std::swap(statement_id_, statement2_id_);
 
-        statement_ = prepare(accessor->dbparameters_->db_,
-                             text_statements[ITERATE_RECORDS]);
+        acquireStatement(ITERATE_RECORDS);
         bindZoneId(id);
     }
 
@@ -730,6 +893,8 @@ public:
         accessor_(accessor),
         statement_(NULL),
         statement2_(NULL),
+        statement_id_(NUM_STATEMENTS),
+        statement2_id_(NUM_STATEMENTS),
         rc_(SQLITE_OK),
         rc2_(SQLITE_OK),
         name_(name)
@@ -738,21 +903,18 @@ public:
         // prepare a statement to get data from it.
         switch (qtype) {
             case QT_ANY:
-                statement_ = prepare(accessor->dbparameters_->db_,
-                                     text_statements[ANY]);
+                acquireStatement(ANY);
                 bindZoneId(id);
                 bindName(name_);
                 break;
             case QT_SUBDOMAINS:
-                statement_ = prepare(accessor->dbparameters_->db_,
-                                     text_statements[ANY_SUB]);
+                acquireStatement(ANY_SUB);
                 bindZoneId(id);
                 // Done once, this should not be very inefficient.
                 bindName(bundy::dns::Name(name_).reverse().toText() + "%");
                 break;
             case QT_NSEC3:
-                statement_ = prepare(accessor->dbparameters_->db_,
-                                     text_statements[NSEC3]);
+                acquireStatement(NSEC3);
                 bindZoneId(id);
                 bindName(name_);
                 break;
@@ -798,6 +960,7 @@ public:
                 break;
             }
             std::swap(statement_, statement2_);
+            std::swap(statement_id_, statement2_id_);
             std::swap(rc_, rc2_);
         }
         finalize();
@@ -843,13 +1006,21 @@ private:
         }
     }
 
+    void acquireStatement(StatementID id) {
+        statement_ = accessor_->dbparameters_->acquireContextStatement(id);
+        statement_id_ = id;
+    }
+
+    // Give the statements back to the accessor for reuse
     void finalize() {
         if (statement_ != NULL) {
-             sqlite3_finalize(statement_);
+             accessor_->dbparameters_->releaseContextStatement(statement_id_,
+                                                               statement_);
              statement_ = NULL;
         }
         if (statement2_ != NULL) {
-             sqlite3_finalize(statement2_);
+             accessor_->dbparameters_->releaseContextStatement(statement2_id_,
+                                                               statement2_);
              statement2_ = NULL;
         }
     }
@@ -858,6 +1029,8 @@ private:
     boost::shared_ptr<const SQLite3Accessor> accessor_;
     sqlite3_stmt* statement_;
     sqlite3_stmt* statement2_;
+    StatementID statement_id_;
+    StatementID statement2_id_;
     int rc_;
     int rc2_;
     const std::string name_;
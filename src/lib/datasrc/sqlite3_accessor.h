@@ -23,6 +23,7 @@
 
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <string>
 
 #include <cc/data.h>
@@ -72,6 +73,7 @@ public:
 };
 
 struct SQLite3Parameters;
+struct SQLite3ConnectionPool;
 
 /// \brief Concrete implementation of DatabaseAccessor for SQLite3 databases
 ///
@@ -85,6 +87,18 @@ public:
     ///
     /// This opens the database and becomes ready to serve data from there.
     ///
+    /// In the WAL mode, the database file is switched to the write-ahead
+    /// logging journal mode of SQLite3 (which is persistent, so other
+    /// accessors of the same file use it too).  In this mode readers don't
+    /// block a writer, so an update (e.g., by xfrin or DDNS) can commit
+    /// while other accessors are in the middle of reading the database,
+    /// and they keep seeing the old version until they start a new read.
+    /// Also, the connections of the clones of the accessor are kept in a
+    /// pool with their prepared statements when the clones are destroyed,
+    /// and reused by later clones, so creating an iterator or a finder
+    /// context (which clones the accessor) doesn't open the database and
+    /// prepare the statements again.
+    ///
     /// \exception SQLite3Error will be thrown if the given database file
     /// doesn't work (it is broken, doesn't exist and can't be created, etc).
     ///
@@ -93,7 +107,10 @@ public:
     ///    specifying which class of data it should serve (while the database
     ///    file can contain multiple classes of data, a single accessor can
     ///    work with only one class).
-    SQLite3Accessor(const std::string& filename, const std::string& rrclass);
+    /// \param wal_mode If true, switch the database to the write-ahead
+    ///    logging journal mode (see below).
+    SQLite3Accessor(const std::string& filename, const std::string& rrclass,
+                    bool wal_mode = false);
 
     /// \brief Destructor
     ///
@@ -102,6 +119,8 @@ public:
 
     /// This implementation internally opens a new sqlite3 database for the
     /// same file name specified in the constructor of the original accessor.
+    /// In the WAL mode, an idle connection from the pool of the original
+    /// accessor is used if there is one.
     virtual boost::shared_ptr<DatabaseAccessor> clone();
 
     /// \brief Look up a zone
@@ -264,6 +283,12 @@ private:
     const std::string class_;
     /// \brief Database name
     const std::string database_name_;
+    /// \brief Idle connections shared with the clones (only in WAL mode)
+    const boost::shared_ptr<SQLite3ConnectionPool> pool_;
+
+    /// \brief Constructor of clones in the WAL mode
+    SQLite3Accessor(const std::string& filename, const std::string& rrclass,
+                    const boost::shared_ptr<SQLite3ConnectionPool>& pool);
 
     /// \brief Opens the database
     void open(const std::string& filename);
@@ -281,7 +306,9 @@ private:
 /// \brief Creates an instance of the SQlite3 datasource client
 ///
 /// Currently the configuration passed here must be a MapElement, containing
-/// one item called "database_file", whose value is a string
+/// one item called "database_file", whose value is a string, and optionally
+/// a boolean item called "use_wal", which enables the WAL mode of the
+/// accessor (see the \c SQLite3Accessor constructor) if true.
 ///
 /// This configuration setup is currently under discussion and will change in
 /// the near future.
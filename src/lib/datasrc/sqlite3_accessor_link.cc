@@ -33,6 +33,7 @@ namespace datasrc {
 namespace {
 
 const char* const CONFIG_ITEM_DATABASE_FILE = "database_file";
+const char* const CONFIG_ITEM_USE_WAL = "use_wal";
 
 void
 addError(ElementPtr errors, const std::string& error) {
@@ -70,6 +71,14 @@ checkConfig(ConstElementPtr config, ElementPtr errors) {
                      " in SQLite3 backend is empty");
             result = false;
         }
+        if (config->contains(CONFIG_ITEM_USE_WAL) &&
+            (!config->get(CONFIG_ITEM_USE_WAL) ||
+             config->get(CONFIG_ITEM_USE_WAL)->getType() !=
+             Element::boolean)) {
+            addError(errors, "value of " + string(CONFIG_ITEM_USE_WAL) +
+                     " in SQLite3 backend is not a boolean");
+            result = false;
+        }
     }
 
     return (result);
@@ -91,9 +100,12 @@ createInstance(const std::string& datasrc_name,
     }
     const std::string dbfile =
         config->get(CONFIG_ITEM_DATABASE_FILE)->stringValue();
+    const bool use_wal = config->contains(CONFIG_ITEM_USE_WAL) &&
+        config->get(CONFIG_ITEM_USE_WAL)->boolValue();
     try {
         boost::shared_ptr<DatabaseAccessor> sqlite3_accessor(
-            new SQLite3Accessor(dbfile, "IN")); // XXX: avoid hardcode RR class
+            // XXX: avoid hardcode RR class
+            new SQLite3Accessor(dbfile, "IN", use_wal));
         return (new DatabaseClient(datasrc_name, bundy::dns::RRClass::IN(),
                                    sqlite3_accessor));
     } catch (const std::exception& exc) {
@@ -26,6 +26,7 @@
 #include <gtest/gtest.h>
 
 #include <iterator>             // for std::distance
+#include <vector>
 
 using namespace bundy::datasrc;
 using namespace bundy::data;
@@ -33,7 +34,9 @@ using namespace bundy::dns;
 using bundy::datasrc::unittest::MockDataSourceClient;
 using bundy::datasrc::internal::CacheConfig;
 using bundy::datasrc::internal::CacheConfigError;
+using bundy::datasrc::memory::DiffAction;
 using bundy::datasrc::memory::LoadAction;
+using bundy::datasrc::memory::RdataPool;
 using bundy::datasrc::memory::ZoneData;
 
 namespace {
@@ -288,6 +291,33 @@ TEST_F(CacheConfigTest, getLoadActionWithMock) {
                  bundy::Unexpected);
 }
 
+TEST_F(CacheConfigTest, getDiffAction) {
+    // Master files don't have differences.
+    const CacheConfig master_conf("MasterFiles", 0, *master_config_, true);
+    EXPECT_FALSE(master_conf.getDiffAction(RRClass::IN(), Name::ROOT_NAME()));
+
+    const ConstElementPtr config(Element::fromJSON(
+                                     "{\"cache-enable\": true,"
+                                     " \"cache-zones\": [\"example.org\","
+                                     " \"example.net\"]}"));
+    const CacheConfig cache_conf("mock", &mock_client_, *config, true);
+    EXPECT_FALSE(cache_conf.getDiffAction(RRClass::IN(), Name("example.com")));
+    EXPECT_THROW(cache_conf.getDiffAction(RRClass::IN(), Name("example.net")),
+                 NoSuchZone);
+
+    // The zone in memory is of the same version as the data source, so
+    // there's no difference.
+    ZoneData* zone_data =
+        cache_conf.getLoadAction(RRClass::IN(), Name("example.org"))(msgmt_);
+    const DiffAction action = cache_conf.getDiffAction(RRClass::IN(),
+                                                       Name("example.org"));
+    ASSERT_TRUE(action);
+    std::vector<ConstRRsetPtr> diffs;
+    EXPECT_TRUE(action(*zone_data, diffs));
+    EXPECT_TRUE(diffs.empty());
+    ZoneData::destroy(msgmt_, zone_data, RRClass::IN());
+}
+
 TEST_F(CacheConfigTest, getSegmentType) {
     // Default type
     EXPECT_EQ("local",
@@ -309,4 +339,28 @@ TEST_F(CacheConfigTest, getSegmentType) {
                  bundy::data::TypeError);
 }
 
+TEST_F(CacheConfigTest, shareRdata) {
+    // Disabled by default
+    const CacheConfig cache_conf("MasterFiles", 0, *master_config_, true);
+    EXPECT_FALSE(cache_conf.isRdataShared());
+    ZoneData* zone_data =
+        cache_conf.getLoadAction(RRClass::IN(), Name::ROOT_NAME())(msgmt_);
+    EXPECT_EQ(static_cast<RdataPool*>(NULL), zone_data->getRdataPool());
+    ZoneData::destroy(msgmt_, zone_data, RRClass::IN());
+
+    // If enabled, zones are loaded with an RdataPool.
+    ConstElementPtr config(Element::fromJSON(
+                               "{\"cache-enable\": true,"
+                               " \"cache-share-rdata\": true,"
+                               " \"params\": "
+                               "  {\".\": \"" TEST_DATA_DIR "/root.zone\"}"
+                               "}"));
+    const CacheConfig shared_conf("MasterFiles", 0, *config, true);
+    EXPECT_TRUE(shared_conf.isRdataShared());
+    zone_data =
+        shared_conf.getLoadAction(RRClass::IN(), Name::ROOT_NAME())(msgmt_);
+    EXPECT_NE(static_cast<RdataPool*>(NULL), zone_data->getRdataPool());
+    ZoneData::destroy(msgmt_, zone_data, RRClass::IN());
+}
+
 }
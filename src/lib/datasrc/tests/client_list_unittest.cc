@@ -929,6 +929,45 @@ TEST_P(ListTest, masterFiles) {
     EXPECT_EQ(0, list_->getDataSources().size());
 }
 
+TEST_P(ListTest, memoryUsage) {
+    EXPECT_TRUE(list_->getMemoryUsage()->mapValue().empty());
+
+    const ConstElementPtr elem(Element::fromJSON("["
+        "{"
+        "   \"type\": \"type1\","
+        "   \"cache-enable\": false,"
+        "   \"params\": {}"
+        "},"
+        "{"
+        "   \"type\": \"MasterFiles\","
+        "   \"cache-enable\": true,"
+        "   \"params\": {"
+        "       \".\": \"" TEST_DATA_DIR "/root.zone\""
+        "   }"
+        "}]"));
+    list_->configure(elem, true);
+
+    // Data sources without cache aren't reported.
+    const ConstElementPtr usage(list_->getMemoryUsage());
+    EXPECT_EQ(1, usage->mapValue().size());
+    const ConstElementPtr ds_usage(usage->get("MasterFiles"));
+    ASSERT_TRUE(ds_usage);
+    EXPECT_EQ("local", ds_usage->get("segment-type")->stringValue());
+    const ConstElementPtr zone_usage(ds_usage->get("zones")->get("."));
+    ASSERT_TRUE(zone_usage);
+    EXPECT_LT(0, zone_usage->get("rdataset-count")->intValue());
+    EXPECT_LT(0, zone_usage->get("total-size")->intValue());
+
+    // The local segment allocates exactly what is requested, so the zone
+    // table and the zone account for all memory in use.
+    EXPECT_EQ(ds_usage->get("segment-in-use")->intValue(),
+              ds_usage->get("zone-table-size")->intValue() +
+              zone_usage->get("total-size")->intValue());
+    EXPECT_EQ(0, ds_usage->get("overhead")->intValue());
+    EXPECT_LE(ds_usage->get("segment-in-use")->intValue(),
+              ds_usage->get("segment-peak-in-use")->intValue());
+}
+
 // Test the names are set correctly and collission is detected.
 TEST_P(ListTest, names) {
     // Explicit name
@@ -1138,6 +1177,57 @@ TEST_P(ListTest, reloadSuccess) {
     EXPECT_EQ(GetParam()->getType(), statii_after[0].getSegmentType());
 }
 
+// Switch a data source to a new memory segment in two steps.
+TEST_P(ListTest, prepareAndInstallMemorySegment) {
+    list_->configure(config_elem_zones_, true);
+
+    // Unknown data source or one without a cache.
+    EXPECT_FALSE(list_->prepareMemorySegment("Something",
+                                             memory::ZoneTableSegment::CREATE,
+                                             Element::create()));
+    EXPECT_FALSE(list_->prepareMemorySegment("test_type",
+                                             memory::ZoneTableSegment::CREATE,
+                                             Element::create()));
+
+    // The rest only works for a segment that can be reopened.
+    if (GetParam()->getType() != "mapped") {
+        return;
+    }
+
+    const Name name("example.org");
+    prepareCache(0, name);
+    const boost::shared_ptr<memory::ZoneTableSegment> old_segment(
+        list_->getDataSources()[0].ztable_segment_);
+
+    // Preparing doesn't affect the current segment.
+    const ConstElementPtr params(
+        Element::fromJSON("{\"mapped-file\": \"" + getMappedFilename(0) +
+                          "\"}"));
+    ConfigurableClientList::MemorySegmentGenerationPtr generation(
+        list_->prepareMemorySegment("test_type",
+                                    memory::ZoneTableSegment::READ_ONLY,
+                                    params));
+    ASSERT_TRUE(generation);
+    EXPECT_EQ(old_segment, list_->getDataSources()[0].ztable_segment_);
+    EXPECT_TRUE(list_->getDataSources()[0].ztable_segment_->isWritable());
+
+    // Installing it switches to the new one, and the old one is handed back.
+    EXPECT_TRUE(list_->installMemorySegment(*generation));
+    EXPECT_NE(old_segment, list_->getDataSources()[0].ztable_segment_);
+    EXPECT_FALSE(list_->getDataSources()[0].ztable_segment_->isWritable());
+    EXPECT_EQ(old_segment, generation->ztable_segment_);
+    EXPECT_EQ(SEGMENT_INUSE, list_->getStatus()[0].getSegmentState());
+    positiveResult(list_->find(name), ds_[0], name, true, "new segment",
+                   true);
+
+    // The data source can disappear by reconfiguration in the meantime.
+    generation = list_->prepareMemorySegment(
+        "test_type", memory::ZoneTableSegment::READ_ONLY, params);
+    ASSERT_TRUE(generation);
+    list_->configure(Element::fromJSON("[]"), true);
+    EXPECT_FALSE(list_->installMemorySegment(*generation));
+}
+
 // The cache is not enabled. The load should be rejected.
 //
 // FIXME: This test is broken by #2853 and needs to be fixed or
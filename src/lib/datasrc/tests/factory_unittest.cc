@@ -144,6 +144,11 @@ TEST(FactoryTest, sqlite3ClientBadConfig) {
                  DataSourceError);
 
     config->set("database_file", Element::create(SQLITE_DBFILE_EXAMPLE_ORG));
+    config->set("use_wal", Element::create("yes"));
+    ASSERT_THROW(DataSourceClientContainer("sqlite3", "sqlite3", config),
+                 DataSourceError);
+
+    config->set("use_wal", Element::create(false));
     DataSourceClientContainer dsc("sqlite3", "sqlite3", config);
 
     DataSourceClient::FindResult result1(
@@ -280,6 +280,69 @@ TEST_F(DomainTreeTest, checkDistanceSorted) {
     EXPECT_TRUE(mytree.checkProperties());
 }
 
+TEST_F(DomainTreeTest, insertInOrder) {
+    // The in-order fast path doesn't change the resulting tree, whether
+    // or not the names are actually given in order.  Insert the names in
+    // the same (unordered) sequence as the test tree; the dump should be
+    // identical.
+    TreeHolder tree_holder(mem_sgmt_, TestDomainTree::create(mem_sgmt_));
+    TestDomainTree& tree = *tree_holder.get();
+    for (int i = 0; i < name_count; ++i) {
+        EXPECT_EQ(TestDomainTree::SUCCESS,
+                  tree.insert(mem_sgmt_, Name(domain_names[i]), &dtnode,
+                              true));
+        dtnode->setData(new int(i + 1));
+    }
+    std::ostringstream expected_dump, dump;
+    dtree.dumpTree(expected_dump);
+    tree.dumpTree(dump);
+    EXPECT_EQ(expected_dump.str(), dump.str());
+    EXPECT_TRUE(tree.checkProperties());
+
+    // Names in the DNSSEC order, with some of them repeated.  They end up
+    // in the same nodes as with the normal insertion.
+    TreeHolder sorted_tree_holder(mem_sgmt_,
+                                  TestDomainTree::create(mem_sgmt_));
+    TestDomainTree& sorted_tree = *sorted_tree_holder.get();
+    for (int i = 0; i < ordered_names_count; ++i) {
+        EXPECT_EQ(TestDomainTree::SUCCESS,
+                  sorted_tree.insert(mem_sgmt_, Name(ordered_names[i]),
+                                     &dtnode, true));
+        dtnode->setData(new int(i + 1));
+        TestDomainTreeNode* node = NULL;
+        EXPECT_EQ(TestDomainTree::ALREADYEXISTS,
+                  sorted_tree.insert(mem_sgmt_, Name(ordered_names[i]),
+                                     &node, true));
+        EXPECT_EQ(dtnode, node);
+    }
+    EXPECT_EQ(dtree.getNodeCount(), sorted_tree.getNodeCount());
+    EXPECT_TRUE(sorted_tree.checkProperties());
+    for (int i = 0; i < ordered_names_count; ++i) {
+        TestDomainTreeNode* node = NULL;
+        EXPECT_EQ(TestDomainTree::EXACTMATCH,
+                  sorted_tree.find(Name(ordered_names[i]), &node));
+        ASSERT_NE(static_cast<TestDomainTreeNode*>(NULL), node);
+        EXPECT_EQ(i + 1, *node->getData());
+    }
+}
+
+TEST_F(DomainTreeTest, checkDistanceInOrder) {
+    // Same as checkDistanceSorted, but using the in-order fast path.
+    TreeHolder mytree_holder(mem_sgmt_, TestDomainTree::create(mem_sgmt_));
+    TestDomainTree& mytree = *mytree_holder.get();
+    const int log_num_nodes = 16;
+
+    for (int i = 0; i < (1 << log_num_nodes); i++) {
+        const string namestr(boost::str(boost::format("name%08x.") % i));
+        EXPECT_EQ(TestDomainTree::SUCCESS,
+                  mytree.insert(mem_sgmt_, Name(namestr), &dtnode, true));
+        EXPECT_EQ(static_cast<int*>(NULL), dtnode->setData(new int(i + 1)));
+    }
+
+    EXPECT_GE(2 * log_num_nodes, mytree.getHeight());
+    EXPECT_TRUE(mytree.checkProperties());
+}
+
 TEST_F(DomainTreeTest, setGetData) {
     // set new data to an existing node.  It should have some data.
     int* newdata = new int(11);
@@ -1732,4 +1795,151 @@ TEST_F(DomainTreeTest, getAbsoluteLabels) {
     EXPECT_TRUE(cdtnode->getAbsoluteLabels(buf).isAbsolute());
     EXPECT_EQ(".", cdtnode->getAbsoluteLabels(buf).toText());
 }
+
+// Names for the search index tests.  The levels below example and
+// sub.example are large enough to be indexed; the labels are chosen so
+// that some share the first 8 octets (which is the key of the index).
+void
+insertIndexTestNames(util::MemorySegment& mem_sgmt, TestDomainTree& tree) {
+    TestDomainTreeNode* node;
+    tree.insert(mem_sgmt, Name("example"), &node);
+    node->setData(new int(0));
+    for (int i = 0; i < 100; ++i) {
+        const std::string label = (i % 2 == 0) ?
+            (boost::format("n%03d") % i).str() :
+            (boost::format("longlabel%d") % i).str();
+        tree.insert(mem_sgmt, Name(label + ".example"), &node);
+        node->setData(new int(i));
+        if (i % 5 == 0) {
+            tree.insert(mem_sgmt, Name(label + ".sub.example"), &node);
+            node->setData(new int(i));
+        }
+    }
+    tree.insert(mem_sgmt, Name("www.n010.example"), &node);
+    node->setData(new int(0));
+}
+
+std::string
+getAbsoluteText(const TestDomainTreeNode* node) {
+    uint8_t buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    return (node->getAbsoluteLabels(buf).toText());
+}
+
+// Search the given name in both trees and check they give the same result,
+// including the context needed by previousNode().
+void
+checkIndexedFind(TestDomainTree& tree, TestDomainTree& indexed_tree,
+                 const Name& name)
+{
+    SCOPED_TRACE(name.toText());
+    TestDomainTreeNodeChain chain;
+    TestDomainTreeNodeChain indexed_chain;
+    const TestDomainTreeNode* node = NULL;
+    const TestDomainTreeNode* indexed_node = NULL;
+    ASSERT_EQ(tree.find(name, &node, chain),
+              indexed_tree.find(name, &indexed_node, indexed_chain));
+    EXPECT_EQ(node == NULL, indexed_node == NULL);
+    if (node != NULL) {
+        EXPECT_EQ(getAbsoluteText(node), getAbsoluteText(indexed_node));
+    }
+    EXPECT_EQ(chain.getLevelCount(), indexed_chain.getLevelCount());
+    EXPECT_EQ(chain.getLastComparisonResult().getRelation(),
+              indexed_chain.getLastComparisonResult().getRelation());
+
+    // Walk back a few nodes from the searched name.
+    for (int i = 0; i < 3; ++i) {
+        node = tree.previousNode(chain);
+        indexed_node = indexed_tree.previousNode(indexed_chain);
+        ASSERT_EQ(node == NULL, indexed_node == NULL);
+        if (node == NULL) {
+            break;
+        }
+        EXPECT_EQ(getAbsoluteText(node), getAbsoluteText(indexed_node));
+    }
+}
+
+TEST_F(DomainTreeTest, searchIndex) {
+    util::MemorySegmentLocal mem_sgmt;
+    TestDomainTree* tree = TestDomainTree::create(mem_sgmt);
+    TestDomainTree* indexed_tree = TestDomainTree::create(mem_sgmt);
+    insertIndexTestNames(mem_sgmt, *tree);
+    insertIndexTestNames(mem_sgmt, *indexed_tree);
+
+    EXPECT_FALSE(indexed_tree->hasIndex());
+    indexed_tree->buildIndex(mem_sgmt);
+    EXPECT_TRUE(indexed_tree->hasIndex());
+    // Building it again replaces the index.
+    indexed_tree->buildIndex(mem_sgmt);
+    EXPECT_TRUE(indexed_tree->hasIndex());
+
+    const char* const names[] = {
+        // existing names
+        "n000.example", "n098.example", "longlabel1.example",
+        "longlabel99.example", "n010.sub.example", "www.n010.example",
+        "example", "sub.example",
+        // case insensitivity
+        "N042.EXAMPLE", "LongLabel37.Example",
+        // partial matches
+        "foo.n002.example", "foo.www.n010.example", "a.b.sub.example",
+        // non existent names in the middle, before and after all names
+        "n001.example", "longlabel.example", "longlabel100.example",
+        "longlabel2.example", "a.example", "zzz.example", "0.sub.example",
+        "z.sub.example", "n011.sub.example", "longlabe.example",
+        // outside of the tree
+        "example.org", "org", "."
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        checkIndexedFind(*tree, *indexed_tree, Name(names[i]));
+    }
+
+    // Search from the middle of the tree with a node chain.
+    TestDomainTreeNodeChain chain;
+    const TestDomainTreeNode* node;
+    bool flag;
+    const Name example("example");
+    EXPECT_EQ(TestDomainTree::EXACTMATCH,
+              indexed_tree->find(LabelSequence(example), &node, chain,
+                                 testCallback, &flag));
+    const Name n008("n008.example");
+    LabelSequence ls(n008);
+    ls.stripRight(2);
+    EXPECT_EQ(TestDomainTree::EXACTMATCH,
+              indexed_tree->find(ls, &node, chain, testCallback, &flag));
+    EXPECT_EQ("n008.example.", getAbsoluteText(node));
+
+    // Modifying the tree structure discards the index, but it's still
+    // searched correctly.
+    TestDomainTreeNode* new_node;
+    indexed_tree->insert(mem_sgmt, Name("n001.example"), &new_node);
+    EXPECT_FALSE(indexed_tree->hasIndex());
+    new_node->setData(new int(1));
+    EXPECT_EQ(TestDomainTree::EXACTMATCH,
+              indexed_tree->find(Name("n001.example"), &node));
+    indexed_tree->buildIndex(mem_sgmt);
+    EXPECT_EQ(TestDomainTree::EXACTMATCH,
+              indexed_tree->find(Name("n001.example"), &node));
+    indexed_tree->remove(mem_sgmt, new_node, deleteData);
+    EXPECT_FALSE(indexed_tree->hasIndex());
+    indexed_tree->buildIndex(mem_sgmt);
+    checkIndexedFind(*tree, *indexed_tree, Name("n001.example"));
+
+    // Inserting an existing name doesn't change the structure.
+    indexed_tree->insert(mem_sgmt, Name("n002.example"), &new_node);
+    EXPECT_TRUE(indexed_tree->hasIndex());
+
+    // Small trees are not indexed, but the index can still be "built".
+    TestDomainTree* small_tree = TestDomainTree::create(mem_sgmt);
+    small_tree->buildIndex(mem_sgmt);
+    EXPECT_TRUE(small_tree->hasIndex());
+    small_tree->insert(mem_sgmt, Name("example"), &new_node);
+    EXPECT_FALSE(small_tree->hasIndex());
+    small_tree->buildIndex(mem_sgmt);
+    EXPECT_EQ(TestDomainTree::NOTFOUND,
+              small_tree->find(Name("example"), &node));
+
+    TestDomainTree::destroy(mem_sgmt, small_tree, deleteData);
+    TestDomainTree::destroy(mem_sgmt, indexed_tree, deleteData);
+    TestDomainTree::destroy(mem_sgmt, tree, deleteData);
+    EXPECT_TRUE(mem_sgmt.allMemoryDeallocated());
+}
 }
@@ -0,0 +1,94 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/rdata_pool.h>
+
+#include <util/memory_segment_local.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+using namespace bundy::datasrc::memory;
+
+namespace {
+
+class RdataPoolTest : public ::testing::Test {
+protected:
+    RdataPoolTest() : pool_(RdataPool::create(mem_sgmt_)) {}
+    ~RdataPoolTest() {
+        RdataPool::destroy(mem_sgmt_, pool_);
+        EXPECT_TRUE(mem_sgmt_.allMemoryDeallocated());
+    }
+
+    RdataPool::Entry* intern(const std::string& data) {
+        return (pool_->intern(mem_sgmt_, data.c_str(), data.size()));
+    }
+
+    bundy::util::MemorySegmentLocal mem_sgmt_;
+    RdataPool* pool_;
+};
+
+TEST_F(RdataPoolTest, intern) {
+    RdataPool::Entry* entry = intern("some data");
+    EXPECT_EQ(1, pool_->getEntryCount());
+    EXPECT_EQ(0, entry->getRefCount());
+    EXPECT_EQ(9, entry->getLength());
+    EXPECT_EQ(0, std::memcmp("some data", entry->getData(), 9));
+
+    // The same data are found in the pool, while different ones (including
+    // a prefix of the data) are separately stored.
+    EXPECT_EQ(entry, intern("some data"));
+    EXPECT_NE(entry, intern("some dat"));
+    EXPECT_NE(entry, intern("other data"));
+    EXPECT_EQ(3, pool_->getEntryCount());
+}
+
+TEST_F(RdataPoolTest, reference) {
+    RdataPool::Entry* entry = intern("some data");
+    RdataPool::addReference(entry);
+    RdataPool::addReference(intern("some data"));
+    EXPECT_EQ(2, entry->getRefCount());
+
+    RdataPool::removeReference(mem_sgmt_, entry);
+    EXPECT_EQ(1, entry->getRefCount());
+    EXPECT_EQ(1, pool_->getEntryCount());
+
+    // Removing the last reference removes the entry from the pool.
+    RdataPool::removeReference(mem_sgmt_, entry);
+    EXPECT_EQ(0, pool_->getEntryCount());
+}
+
+TEST_F(RdataPoolTest, manyEntries) {
+    // Enough entries to make the pool grow its buckets several times.
+    // The entries must still be found after that.
+    RdataPool::Entry* entries[1000];
+    for (int i = 0; i < 1000; ++i) {
+        entries[i] = intern("data " + std::string(i % 50, 'x') +
+                            static_cast<char>('A' + i / 50));
+        RdataPool::addReference(entries[i]);
+    }
+    EXPECT_EQ(1000, pool_->getEntryCount());
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(entries[i], intern("data " + std::string(i % 50, 'x') +
+                                     static_cast<char>('A' + i / 50)));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        RdataPool::removeReference(mem_sgmt_, entries[i]);
+    }
+    EXPECT_EQ(0, pool_->getEntryCount());
+}
+
+}
@@ -27,6 +27,7 @@
 #include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/memory/rdata_serialization.h>
 #include <datasrc/memory/rdataset.h>
+#include <datasrc/memory/rdata_pool.h>
 
 #include <testutils/dnsmessage_test.h>
 
@@ -35,6 +36,7 @@
 #include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <cstring>
 #include <vector>
 #include <string>
 
@@ -152,6 +154,17 @@ checkRdataSet(const RdataSet& rdataset,
     EXPECT_TRUE(it == expected_data.end());
 }
 
+// RdataSet::create() without a pool, which can be passed to boost::bind
+// (which doesn't know about default parameters).
+RdataSet*
+createRdataSet(bundy::util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
+               ConstRRsetPtr rrset, ConstRRsetPtr sig_rrset,
+               const RdataSet* old_rdataset)
+{
+    return (RdataSet::create(mem_sgmt, encoder, rrset, sig_rrset,
+                             old_rdataset));
+}
+
 TEST_F(RdataSetTest, create) {
     // A simple case of creating an RdataSet.  Confirming the resulting
     // fields have the expected values, and then destroying it (TearDown()
@@ -448,7 +461,7 @@ RdataSetTest::checkCreateManyRRs(CreateFn create_fn, size_t n_old_rdata) {
 }
 
 TEST_F(RdataSetTest, createManyRRs) {
-    checkCreateManyRRs(boost::bind(&RdataSet::create, _1, _2, _3, _4,
+    checkCreateManyRRs(boost::bind(createRdataSet, _1, _2, _3, _4,
                                    static_cast<const RdataSet*>(NULL)), 0);
 }
 
@@ -457,7 +470,7 @@ TEST_F(RdataSetTest, mergeCreateManyRRs) {
     SegmentObjectHolder<RdataSet, RRClass> holder(mem_sgmt_, RRClass::IN());
     holder.set(RdataSet::create(mem_sgmt_, encoder_, rrset, ConstRRsetPtr()));
 
-    checkCreateManyRRs(boost::bind(&RdataSet::create, _1, _2, _3, _4,
+    checkCreateManyRRs(boost::bind(createRdataSet, _1, _2, _3, _4,
                                    holder.get()), rrset->getRdataCount());
 }
 
@@ -540,7 +553,7 @@ RdataSetTest::checkCreateManyRRSIGs(CreateFn create_fn, size_t n_old_sig) {
 }
 
 TEST_F(RdataSetTest, createManyRRSIGs) {
-    checkCreateManyRRSIGs(boost::bind(&RdataSet::create, _1, _2, _3, _4,
+    checkCreateManyRRSIGs(boost::bind(createRdataSet, _1, _2, _3, _4,
                                       static_cast<const RdataSet*>(NULL)), 0);
 }
 
@@ -553,7 +566,7 @@ TEST_F(RdataSetTest, mergeCreateManyRRSIGs) {
     SegmentObjectHolder<RdataSet, RRClass> holder(mem_sgmt_, rrclass);
     holder.set(RdataSet::create(mem_sgmt_, encoder_, ConstRRsetPtr(), rrsig));
 
-    checkCreateManyRRSIGs(boost::bind(&RdataSet::create, _1, _2, _3, _4,
+    checkCreateManyRRSIGs(boost::bind(createRdataSet, _1, _2, _3, _4,
                                       holder.get()), rrsig->getRdataCount());
 }
 
@@ -610,7 +623,7 @@ RdataSetTest::checkBadCreate(CreateFn create_fn) {
 }
 
 TEST_F(RdataSetTest, badCreate) {
-    checkBadCreate(boost::bind(&RdataSet::create, _1, _2, _3, _4,
+    checkBadCreate(boost::bind(createRdataSet, _1, _2, _3, _4,
                                static_cast<const RdataSet*>(NULL)));
 }
 
@@ -622,7 +635,7 @@ TEST_F(RdataSetTest, badMergeCreate) {
                          textToRRset("www.example.com. 0 IN AAAA 2001:db8::1"),
                          ConstRRsetPtr()));
 
-    checkBadCreate(boost::bind(&RdataSet::create, _1, _2, _3, _4,
+    checkBadCreate(boost::bind(createRdataSet, _1, _2, _3, _4,
                                holder.get()));
 
     // Type mismatch: this case is specific to the merge create.
@@ -751,4 +764,132 @@ TEST_F(RdataSetTest, badParams) {
                                     ConstRRsetPtr(), *holder.get()),
                  bundy::BadValue);
 }
+
+// Shortcut to get the data of a mutable RdataSet (the mutable version of
+// getDataBuf() is private).
+const void*
+getDataBuf(const RdataSet* rdataset) {
+    return (rdataset->getDataBuf());
+}
+
+TEST_F(RdataSetTest, createShared) {
+    RdataPool* pool = RdataPool::create(mem_sgmt_);
+    const ConstRRsetPtr ns_rrset(
+        textToRRset("example.com. 3600 IN NS ns1.example.com.\n"
+                    "example.com. 3600 IN NS ns2.example.com."));
+    const ConstRRsetPtr ns_sig(
+        textToRRset("example.com. 3600 IN RRSIG NS 5 2 3600 20120814220826 "
+                    "20120715220826 1234 example.com. FAKE"));
+
+    // Create an unshared RdataSet for comparison.
+    RdataSet* rdataset = RdataSet::create(mem_sgmt_, encoder_, ns_rrset,
+                                          ConstRRsetPtr());
+    EXPECT_FALSE(rdataset->isShared());
+    const size_t data_len = rdataset->getDataLength(rrclass);
+
+    // Two RdataSets of the same data share them in the pool.
+    RdataSet* rdataset1 = RdataSet::create(mem_sgmt_, encoder_, ns_rrset,
+                                           ConstRRsetPtr(), NULL, pool);
+    RdataSet* rdataset2 = RdataSet::create(mem_sgmt_, encoder_, ns_rrset,
+                                           ConstRRsetPtr(), NULL, pool);
+    EXPECT_TRUE(rdataset1->isShared());
+    EXPECT_TRUE(rdataset2->isShared());
+    EXPECT_EQ(1, pool->getEntryCount());
+    EXPECT_EQ(getDataBuf(rdataset1), getDataBuf(rdataset2));
+
+    // Sharing is transparent to the user of the RdataSet.
+    EXPECT_EQ(RRType::NS(), rdataset1->type);
+    EXPECT_EQ(2, rdataset1->getRdataCount());
+    EXPECT_EQ(0, rdataset1->getSigRdataCount());
+    EXPECT_EQ(RRTTL(3600), restoreTTL(rdataset1->getTTLData()));
+    EXPECT_EQ(data_len, rdataset1->getDataLength(rrclass));
+    EXPECT_EQ(0, std::memcmp(getDataBuf(rdataset), getDataBuf(rdataset1),
+                             data_len));
+
+    // The raw version of create() shares the data, too.
+    RdataSet* rdataset3 = RdataSet::create(mem_sgmt_, rrclass, RRType::NS(),
+                                           2, 0, rdataset->getTTLData(),
+                                           getDataBuf(rdataset), data_len,
+                                           pool);
+    EXPECT_TRUE(rdataset3->isShared());
+    EXPECT_EQ(getDataBuf(rdataset1), getDataBuf(rdataset3));
+    EXPECT_EQ(1, pool->getEntryCount());
+
+    // Merging and subtracting data make new shared data.
+    RdataSet* rdataset4 =
+        RdataSet::create(mem_sgmt_, encoder_,
+                         textToRRset("example.com. 3600 IN NS "
+                                     "ns3.example.com."),
+                         ConstRRsetPtr(), rdataset1, pool);
+    EXPECT_TRUE(rdataset4->isShared());
+    EXPECT_EQ(3, rdataset4->getRdataCount());
+    EXPECT_EQ(2, pool->getEntryCount());
+    RdataSet* rdataset5 =
+        RdataSet::subtract(mem_sgmt_, encoder_,
+                           textToRRset("example.com. 3600 IN NS "
+                                       "ns3.example.com."),
+                           ConstRRsetPtr(), *rdataset4, pool);
+    EXPECT_EQ(2, rdataset5->getRdataCount());
+    EXPECT_EQ(getDataBuf(rdataset1), getDataBuf(rdataset5));
+    EXPECT_EQ(2, pool->getEntryCount());
+
+    // Data that are smaller than the reference, and RdataSets with RRSIGs,
+    // are never shared.
+    RdataSet* rdataset6 = RdataSet::create(mem_sgmt_, encoder_, a_rrset_,
+                                           ConstRRsetPtr(), NULL, pool);
+    EXPECT_FALSE(rdataset6->isShared());
+    checkRdataSet(*rdataset6, def_rdata_txt_, vector<string>());
+    RdataSet* rdataset7 = RdataSet::create(mem_sgmt_, encoder_, ns_rrset,
+                                           ns_sig, NULL, pool);
+    EXPECT_FALSE(rdataset7->isShared());
+    EXPECT_EQ(1, rdataset7->getSigRdataCount());
+    EXPECT_EQ(2, pool->getEntryCount());
+
+    // The shared data are removed with the last RdataSet referring to them.
+    RdataSet::destroy(mem_sgmt_, rdataset4, rrclass);
+    EXPECT_EQ(1, pool->getEntryCount());
+    RdataSet::destroy(mem_sgmt_, rdataset1, rrclass);
+    RdataSet::destroy(mem_sgmt_, rdataset2, rrclass);
+    RdataSet::destroy(mem_sgmt_, rdataset3, rrclass);
+    EXPECT_EQ(1, pool->getEntryCount());
+    RdataSet::destroy(mem_sgmt_, rdataset5, rrclass);
+    EXPECT_EQ(0, pool->getEntryCount());
+
+    RdataSet::destroy(mem_sgmt_, rdataset, rrclass);
+    RdataSet::destroy(mem_sgmt_, rdataset6, rrclass);
+    RdataSet::destroy(mem_sgmt_, rdataset7, rrclass);
+    RdataPool::destroy(mem_sgmt_, pool);
+}
+
+TEST_F(RdataSetTest, createRawBadLength) {
+    RdataPool* pool = RdataPool::create(mem_sgmt_);
+    const ConstRRsetPtr ns_rrset(
+        textToRRset("example.com. 3600 IN NS ns1.example.com.\n"
+                    "example.com. 3600 IN NS ns2.example.com."));
+    RdataSet* rdataset = RdataSet::create(mem_sgmt_, encoder_, ns_rrset,
+                                          ConstRRsetPtr());
+    const size_t data_len = rdataset->getDataLength(rrclass);
+    vector<uint8_t> data(data_len + 1);
+    std::memcpy(&data[0], getDataBuf(rdataset), data_len);
+
+    // A length that doesn't match the encoded data is rejected, whether
+    // the data would be shared or not, and nothing is leaked (checked in
+    // TearDown()).
+    EXPECT_THROW(RdataSet::create(mem_sgmt_, rrclass, RRType::NS(), 2, 0,
+                                  rdataset->getTTLData(), &data[0],
+                                  data_len + 1),
+                 RdataSetError);
+    EXPECT_THROW(RdataSet::create(mem_sgmt_, rrclass, RRType::NS(), 2, 0,
+                                  rdataset->getTTLData(), &data[0],
+                                  data_len + 1, pool),
+                 RdataSetError);
+    EXPECT_THROW(RdataSet::create(mem_sgmt_, rrclass, RRType::NS(), 2, 0,
+                                  rdataset->getTTLData(), &data[0],
+                                  data_len - 1),
+                 RdataSetError);
+    EXPECT_EQ(0, pool->getEntryCount());
+
+    RdataSet::destroy(mem_sgmt_, rdataset, rrclass);
+    RdataPool::destroy(mem_sgmt_, pool);
+}
 }
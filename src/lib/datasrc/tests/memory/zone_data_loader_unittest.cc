@@ -16,11 +16,15 @@
 
 #include <datasrc/memory/zone_data_loader.h>
 #include <datasrc/memory/rdataset.h>
+#include <datasrc/memory/rdata_pool.h>
 #include <datasrc/memory/zone_data.h>
 #include <datasrc/memory/zone_data_updater.h>
+#include <datasrc/memory/zone_finder.h>
 #include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/zone_iterator.h>
 
+#include <testutils/dnsmessage_test.h>
+
 #include <util/buffer.h>
 
 #include <dns/name.h>
@@ -35,8 +39,13 @@
 
 #include <gtest/gtest.h>
 
+#include <boost/lexical_cast.hpp>
+
+#include <vector>
+
 using namespace bundy::dns;
 using namespace bundy::datasrc::memory;
+using bundy::testutils::textToRRset;
 #ifdef USE_SHARED_MEMORY
 using bundy::util::MemorySegmentMapped;
 #endif
@@ -86,6 +95,151 @@ TEST_F(ZoneDataLoaderTest, zoneMinTTL) {
     EXPECT_EQ(RRTTL(1200), RRTTL(b));
 }
 
+TEST_F(ZoneDataLoaderTest, shareRdata) {
+    // By default RDATA aren't shared.
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                              TEST_DATA_DIR "/example.org.zone");
+    EXPECT_EQ(static_cast<RdataPool*>(NULL), zone_data_->getRdataPool());
+    ZoneData::destroy(mem_sgmt_, zone_data_, zclass_);
+    zone_data_ = NULL;
+
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                              TEST_DATA_DIR "/example.org.zone", true);
+    ASSERT_NE(static_cast<RdataPool*>(NULL), zone_data_->getRdataPool());
+    EXPECT_LT(0, zone_data_->getRdataPool()->getEntryCount());
+    const RdataSet* rdataset =
+        RdataSet::find(zone_data_->getOriginNode()->getData(), RRType::NS());
+    ASSERT_NE(static_cast<RdataSet*>(NULL), rdataset);
+    EXPECT_TRUE(rdataset->isShared());
+    EXPECT_EQ(2, rdataset->getRdataCount());
+
+    // Teardown checks all shared data are released with the zone data.
+}
+
+class ZoneDataUpdateTest : public ZoneDataLoaderTest {
+protected:
+    ZoneDataUpdateTest() : origin_("example.org") {}
+
+    void SetUp() {
+        zone_data_ = loadZoneData(mem_sgmt_, zclass_, origin_,
+                                  TEST_DATA_DIR "/example.org-empty.zone");
+    }
+
+    // Append a diff in the form of a single-RR text.
+    void addDiff(const char* text) {
+        diffs_.push_back(textToRRset(text, zclass_, origin_));
+    }
+
+    void addSOADiff(uint32_t serial) {
+        diffs_.push_back(textToRRset(
+                             "example.org. 3600 IN SOA ns1.example.org. "
+                             "bugs.x.w.example.org. " +
+                             boost::lexical_cast<std::string>(serial) +
+                             " 3600 300 3600000 3600", zclass_, origin_));
+    }
+
+    uint32_t getSerial() {
+        InMemoryZoneFinder finder(*zone_data_, zclass_);
+        const ConstRRsetPtr soa =
+            finder.findAtOrigin(RRType::SOA(), false,
+                                bundy::datasrc::ZoneFinder::FIND_DEFAULT)->
+            rrset;
+        EXPECT_EQ(1, soa->getRdataCount());
+        return (dynamic_cast<const rdata::generic::SOA&>(
+                    soa->getRdataIterator()->getCurrent()).
+                getSerial().getValue());
+    }
+
+    bool nameExists(const char* name) {
+        const ZoneNode* node = zone_data_->findName(Name(name));
+        return (node != NULL && !node->isEmpty());
+    }
+
+    const Name origin_;
+    std::vector<ConstRRsetPtr> diffs_;
+};
+
+TEST_F(ZoneDataUpdateTest, update) {
+    addSOADiff(71);
+    addSOADiff(72);
+    addDiff("www.example.org. 3600 IN A 192.0.2.1");
+    addDiff("www.example.org. 3600 IN A 192.0.2.2");
+    updateZoneData(mem_sgmt_, zclass_, origin_, *zone_data_, diffs_);
+    EXPECT_EQ(72, getSerial());
+    EXPECT_TRUE(nameExists("www.example.org"));
+
+    // Multiple sequences; the name that has become empty is removed.
+    diffs_.clear();
+    addSOADiff(72);
+    addDiff("www.example.org. 3600 IN A 192.0.2.1");
+    addSOADiff(73);
+    addDiff("ftp.example.org. 3600 IN A 192.0.2.3");
+    addSOADiff(73);
+    addDiff("www.example.org. 3600 IN A 192.0.2.2");
+    addSOADiff(74);
+    updateZoneData(mem_sgmt_, zclass_, origin_, *zone_data_, diffs_);
+    EXPECT_EQ(74, getSerial());
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              zone_data_->findName(Name("www.example.org")));
+    EXPECT_TRUE(nameExists("ftp.example.org"));
+
+    // Empty differences are okay (nothing happens).
+    diffs_.clear();
+    updateZoneData(mem_sgmt_, zclass_, origin_, *zone_data_, diffs_);
+    EXPECT_EQ(74, getSerial());
+}
+
+TEST_F(ZoneDataUpdateTest, invalidUpdate) {
+    // The zone would lose the NS.  The changes are reverted.
+    addSOADiff(71);
+    addDiff("example.org. 3600 IN NS ns1.example.org.");
+    addSOADiff(72);
+    addDiff("www.example.org. 3600 IN A 192.0.2.1");
+    EXPECT_THROW(updateZoneData(mem_sgmt_, zclass_, origin_, *zone_data_,
+                                diffs_),
+                 ZoneValidationError);
+    EXPECT_EQ(71, getSerial());
+    EXPECT_TRUE(RdataSet::find(zone_data_->getOriginNode()->getData(),
+                               RRType::NS()) != NULL);
+    EXPECT_FALSE(nameExists("www.example.org"));
+
+    // Adding inconsistent data fails in the middle of the sequence.
+    diffs_.clear();
+    addSOADiff(71);
+    addSOADiff(72);
+    addDiff("www.example.org. 3600 IN A 192.0.2.1");
+    addDiff("www.example.org. 3600 IN CNAME example.org.");
+    EXPECT_THROW(updateZoneData(mem_sgmt_, zclass_, origin_, *zone_data_,
+                                diffs_),
+                 ZoneDataUpdater::AddError);
+    EXPECT_EQ(71, getSerial());
+    EXPECT_FALSE(nameExists("www.example.org"));
+
+    // A difference of multiple RRs, some of which are in the zone already.
+    // Only the RRs that were actually added are removed on failure.
+    diffs_.clear();
+    addSOADiff(71);
+    addSOADiff(72);
+    addDiff("www.example.org. 3600 IN A 192.0.2.1");
+    updateZoneData(mem_sgmt_, zclass_, origin_, *zone_data_, diffs_);
+    diffs_.clear();
+    addSOADiff(72);
+    addSOADiff(73);
+    diffs_.push_back(textToRRset("www.example.org. 3600 IN A 192.0.2.1\n"
+                                 "www.example.org. 3600 IN A 192.0.2.2",
+                                 zclass_, origin_));
+    addDiff("www.example.org. 3600 IN CNAME example.org.");
+    EXPECT_THROW(updateZoneData(mem_sgmt_, zclass_, origin_, *zone_data_,
+                                diffs_),
+                 ZoneDataUpdater::AddError);
+    EXPECT_EQ(72, getSerial());
+    const ZoneNode* node = zone_data_->findName(Name("www.example.org"));
+    ASSERT_NE(static_cast<const ZoneNode*>(NULL), node);
+    const RdataSet* rdataset = RdataSet::find(node->getData(), RRType::A());
+    ASSERT_NE(static_cast<const RdataSet*>(NULL), rdataset);
+    EXPECT_EQ(1, rdataset->getRdataCount());
+}
+
 // Load bunch of small zones, hoping some of the relocation will happen
 // during the memory creation, not only Rdata creation.
 // Note: this doesn't even compile unless USE_SHARED_MEMORY is defined.
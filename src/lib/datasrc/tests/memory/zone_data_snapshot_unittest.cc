@@ -0,0 +1,314 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <datasrc/memory/zone_data_snapshot.h>
+#include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/rdataset.h>
+#include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_finder.h>
+
+#include <dns/labelsequence.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#ifdef USE_SHARED_MEMORY
+#include <util/memory_segment_mapped.h>
+#endif
+
+#include <datasrc/tests/memory/memory_segment_mock.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace bundy::dns;
+using namespace bundy::datasrc;
+using namespace bundy::datasrc::memory;
+#ifdef USE_SHARED_MEMORY
+using bundy::util::MemorySegmentMapped;
+#endif
+
+namespace {
+
+const char* const snapshot_file = TEST_DATA_BUILDDIR "/test.snapshot";
+
+// Dump the content of a zone tree in a textual form, so two trees can be
+// compared.  The encoded RDATA are compared as binary.
+void
+dumpTree(const ZoneTree& tree, const Name& origin, const RRClass& rrclass,
+         std::vector<std::string>& dump)
+{
+    ZoneChain chain;
+    const ZoneNode* node = NULL;
+    ASSERT_EQ(ZoneTree::EXACTMATCH, tree.find(origin, &node, chain));
+    uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    for (; node != NULL; node = tree.nextNode(chain)) {
+        std::ostringstream oss;
+        oss << node->getAbsoluteLabels(labels_buf) << " "
+            << node->getFlag(ZoneNode::FLAG_CALLBACK)
+            << node->getFlag(ZoneNode::FLAG_USER1)
+            << node->getFlag(ZoneNode::FLAG_USER2)
+            << node->getFlag(ZoneNode::FLAG_USER3);
+        for (const RdataSet* rdataset = node->getData();
+             rdataset != NULL;
+             rdataset = rdataset->getNext()) {
+            uint32_t ttl;
+            std::memcpy(&ttl, rdataset->getTTLData(), sizeof(ttl));
+            oss << " " << rdataset->type << "/"
+                << rdataset->getRdataCount() << "/"
+                << rdataset->getSigRdataCount() << "/" << ttl << "/"
+                << std::string(static_cast<const char*>(
+                                   rdataset->getDataBuf()),
+                               rdataset->getDataLength(rrclass));
+        }
+        dump.push_back(oss.str());
+    }
+}
+
+class ZoneDataSnapshotTest : public ::testing::Test {
+protected:
+    ZoneDataSnapshotTest() :
+        zclass_(RRClass::IN()), origin_("example.org"),
+        zone_data_(NULL), loaded_data_(NULL)
+    {}
+    void TearDown() {
+        if (zone_data_ != NULL) {
+            ZoneData::destroy(mem_sgmt_, zone_data_, zclass_);
+        }
+        if (loaded_data_ != NULL) {
+            ZoneData::destroy(mem_sgmt_, loaded_data_, zclass_);
+        }
+        EXPECT_TRUE(mem_sgmt_.allMemoryDeallocated()); // catch any leak here.
+        std::remove(snapshot_file);
+    }
+
+    // Load the zone from the master file, save it and load the snapshot.
+    void roundTrip(const char* zone_file) {
+        zone_data_ = loadZoneData(mem_sgmt_, zclass_, origin_, zone_file);
+        saveZoneDataSnapshot(*zone_data_, zclass_, snapshot_file);
+        EXPECT_TRUE(isZoneDataSnapshot(snapshot_file));
+        loaded_data_ = loadZoneDataSnapshot(mem_sgmt_, zclass_, origin_,
+                                            snapshot_file);
+    }
+
+    // Check the loaded zone data are identical to the original.
+    void checkLoadedData() {
+        std::vector<std::string> expected, actual;
+        dumpTree(zone_data_->getZoneTree(), origin_, zclass_, expected);
+        dumpTree(loaded_data_->getZoneTree(), origin_, zclass_, actual);
+        EXPECT_EQ(expected, actual);
+
+        EXPECT_EQ(zone_data_->isSigned(), loaded_data_->isSigned());
+        EXPECT_EQ(zone_data_->isNSEC3Signed(), loaded_data_->isNSEC3Signed());
+        EXPECT_EQ(0, std::memcmp(zone_data_->getMinTTLData(),
+                                 loaded_data_->getMinTTLData(),
+                                 sizeof(uint32_t)));
+        const NSEC3Data* nsec3_data = zone_data_->getNSEC3Data();
+        const NSEC3Data* loaded_nsec3_data = loaded_data_->getNSEC3Data();
+        if (nsec3_data != NULL) {
+            ASSERT_NE(static_cast<const NSEC3Data*>(NULL), loaded_nsec3_data);
+            EXPECT_EQ(nsec3_data->hashalg, loaded_nsec3_data->hashalg);
+            EXPECT_EQ(nsec3_data->flags, loaded_nsec3_data->flags);
+            EXPECT_EQ(nsec3_data->iterations, loaded_nsec3_data->iterations);
+            ASSERT_EQ(nsec3_data->getSaltLen(),
+                      loaded_nsec3_data->getSaltLen());
+            EXPECT_EQ(0, std::memcmp(nsec3_data->getSaltData(),
+                                     loaded_nsec3_data->getSaltData(),
+                                     nsec3_data->getSaltLen()));
+            expected.clear();
+            actual.clear();
+            dumpTree(nsec3_data->getNSEC3Tree(), origin_, zclass_, expected);
+            dumpTree(loaded_nsec3_data->getNSEC3Tree(), origin_, zclass_,
+                     actual);
+            EXPECT_EQ(expected, actual);
+        }
+    }
+
+    // Overwrite a byte of the snapshot file.
+    void corrupt(size_t offset) {
+        std::fstream file(snapshot_file,
+                          std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(offset);
+        const char c = file.get() ^ 0xff;
+        file.seekp(offset);
+        file.put(c);
+    }
+
+    const RRClass zclass_;
+    const Name origin_;
+    test::MemorySegmentMock mem_sgmt_;
+    ZoneData* zone_data_;
+    ZoneData* loaded_data_;
+};
+
+TEST_F(ZoneDataSnapshotTest, roundTrip) {
+    // This zone has delegations and wildcards.
+    roundTrip(TEST_DATA_DIR "/example.org.zone");
+    checkLoadedData();
+
+    // The loaded zone is usable for lookups, including those relying on
+    // node flags.
+    InMemoryZoneFinder finder(*loaded_data_, zclass_);
+    EXPECT_EQ(ZoneFinder::DELEGATION,
+              finder.find(Name("www.a.example.org"), RRType::A())->code);
+    EXPECT_EQ(ZoneFinder::SUCCESS,
+              finder.find(Name("x.wild.example.org"), RRType::A())->code);
+    EXPECT_EQ(ZoneFinder::SUCCESS,
+              finder.find(Name("ns1.example.org"), RRType::AAAA())->code);
+}
+
+TEST_F(ZoneDataSnapshotTest, roundTripNSEC3) {
+    roundTrip(TEST_DATA_DIR "/example.org-nsec3-signed.zone");
+    EXPECT_TRUE(loaded_data_->isNSEC3Signed());
+    checkLoadedData();
+
+    InMemoryZoneFinder finder(*loaded_data_, zclass_);
+    EXPECT_TRUE(finder.findNSEC3(Name("example.org"), false).matched);
+}
+
+TEST_F(ZoneDataSnapshotTest, roundTripRRSIGOnly) {
+    // An RdataSet with only RRSIG is also preserved.
+    roundTrip(TEST_DATA_DIR "/example.org-rrsig-follows-nothing.zone");
+    checkLoadedData();
+}
+
+TEST_F(ZoneDataSnapshotTest, loadZoneData) {
+    // loadZoneData() recognizes snapshots and loads them.
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, origin_,
+                              TEST_DATA_DIR "/example.org.zone");
+    EXPECT_FALSE(isZoneDataSnapshot(TEST_DATA_DIR "/example.org.zone"));
+    saveZoneDataSnapshot(*zone_data_, zclass_, snapshot_file);
+    loaded_data_ = loadZoneData(mem_sgmt_, zclass_, origin_, snapshot_file);
+    checkLoadedData();
+}
+
+TEST_F(ZoneDataSnapshotTest, mismatch) {
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, origin_,
+                              TEST_DATA_DIR "/example.org.zone");
+    saveZoneDataSnapshot(*zone_data_, zclass_, snapshot_file);
+
+    // A snapshot of a different zone or class is rejected.
+    EXPECT_THROW(loadZoneDataSnapshot(mem_sgmt_, zclass_, Name("example.com"),
+                                      snapshot_file),
+                 ZoneSnapshotError);
+    EXPECT_THROW(loadZoneDataSnapshot(mem_sgmt_, RRClass::CH(), origin_,
+                                      snapshot_file),
+                 ZoneSnapshotError);
+
+    // Non existent file
+    EXPECT_FALSE(isZoneDataSnapshot(TEST_DATA_BUILDDIR "/nosuchfile"));
+    EXPECT_THROW(loadZoneDataSnapshot(mem_sgmt_, zclass_, origin_,
+                                      TEST_DATA_BUILDDIR "/nosuchfile"),
+                 ZoneSnapshotError);
+}
+
+TEST_F(ZoneDataSnapshotTest, corrupted) {
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, origin_,
+                              TEST_DATA_DIR "/example.org.zone");
+    saveZoneDataSnapshot(*zone_data_, zclass_, snapshot_file);
+
+    // Corrupted data are detected by the checksum.
+    corrupt(100);
+    EXPECT_THROW(loadZoneDataSnapshot(mem_sgmt_, zclass_, origin_,
+                                      snapshot_file),
+                 ZoneSnapshotError);
+    corrupt(100);
+    loaded_data_ = loadZoneDataSnapshot(mem_sgmt_, zclass_, origin_,
+                                        snapshot_file);
+
+    // Unknown version
+    corrupt(8);
+    EXPECT_THROW(loadZoneDataSnapshot(mem_sgmt_, zclass_, origin_,
+                                      snapshot_file),
+                 ZoneSnapshotError);
+    corrupt(8);
+
+    // Different byte order
+    corrupt(12);
+    EXPECT_THROW(loadZoneDataSnapshot(mem_sgmt_, zclass_, origin_,
+                                      snapshot_file),
+                 ZoneSnapshotError);
+    corrupt(12);
+
+    // Different RDATA encoding
+    corrupt(18);
+    EXPECT_THROW(loadZoneDataSnapshot(mem_sgmt_, zclass_, origin_,
+                                      snapshot_file),
+                 ZoneSnapshotError);
+    corrupt(18);
+
+    // Truncated file
+    std::ifstream ifs(snapshot_file, std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(ifs)),
+                              std::istreambuf_iterator<char>());
+    ifs.close();
+    std::ofstream ofs(snapshot_file, std::ios::binary | std::ios::trunc);
+    ofs.write(content.data(), content.size() - 1);
+    ofs.close();
+    EXPECT_TRUE(isZoneDataSnapshot(snapshot_file));
+    EXPECT_THROW(loadZoneDataSnapshot(mem_sgmt_, zclass_, origin_,
+                                      snapshot_file),
+                 ZoneSnapshotError);
+}
+
+TEST_F(ZoneDataSnapshotTest, saveEmptyZone) {
+    zone_data_ = ZoneData::create(mem_sgmt_);
+    EXPECT_THROW(saveZoneDataSnapshot(*zone_data_, zclass_, snapshot_file),
+                 ZoneSnapshotError);
+    EXPECT_FALSE(isZoneDataSnapshot(snapshot_file));
+}
+
+TEST_F(ZoneDataSnapshotTest, saveFail) {
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, origin_,
+                              TEST_DATA_DIR "/example.org.zone");
+    EXPECT_THROW(saveZoneDataSnapshot(*zone_data_, zclass_,
+                                      TEST_DATA_BUILDDIR "/nosuchdir/file"),
+                 ZoneSnapshotError);
+}
+
+// Load a snapshot into a small mapped segment, so it has to grow (and
+// relocate the data) many times while loading.
+#ifdef USE_SHARED_MEMORY
+TEST_F(ZoneDataSnapshotTest, relocate) {
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, origin_,
+                              TEST_DATA_DIR "/example.org-nsec3-signed.zone");
+    saveZoneDataSnapshot(*zone_data_, zclass_, snapshot_file);
+
+    const char* const mapped_file = TEST_DATA_BUILDDIR "/test.mapped";
+    {
+        MemorySegmentMapped segment(mapped_file,
+                                    MemorySegmentMapped::CREATE_ONLY, 4096);
+        ZoneData* data = loadZoneDataSnapshot(segment, zclass_, origin_,
+                                              snapshot_file);
+        std::vector<std::string> expected, actual;
+        dumpTree(zone_data_->getZoneTree(), origin_, zclass_, expected);
+        dumpTree(data->getZoneTree(), origin_, zclass_, actual);
+        EXPECT_EQ(expected, actual);
+        ZoneData::destroy(segment, data, zclass_);
+        EXPECT_TRUE(segment.allMemoryDeallocated());
+    }
+    EXPECT_EQ(0, unlink(mapped_file));
+}
+#endif
+
+}
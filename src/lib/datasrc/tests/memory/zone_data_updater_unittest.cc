@@ -332,6 +332,110 @@ TEST_P(ZoneDataUpdaterTest, manySmallRRsets) {
     }
 }
 
+TEST_P(ZoneDataUpdaterTest, addResult) {
+    const ConstRRsetPtr rrset =
+        textToRRset("www.example.org. 3600 IN A 192.0.2.1");
+    EXPECT_TRUE(updater_->add(rrset, ConstRRsetPtr()));
+    // Adding the same data again doesn't change anything.
+    EXPECT_FALSE(updater_->add(rrset, ConstRRsetPtr()));
+    EXPECT_TRUE(updater_->add(textToRRset("www.example.org. 3600 IN A "
+                                          "192.0.2.2"), ConstRRsetPtr()));
+}
+
+TEST_P(ZoneDataUpdaterTest, remove) {
+    EXPECT_THROW(updater_->remove(ConstRRsetPtr(), ConstRRsetPtr()),
+                 ZoneDataUpdater::NullRRset);
+
+    updater_->add(textToRRset("example.org. 3600 IN NS ns.example.org."),
+                  ConstRRsetPtr());
+    updater_->add(textToRRset("www.example.org. 3600 IN A 192.0.2.1\n"
+                              "www.example.org. 3600 IN A 192.0.2.2"),
+                  textToRRset("www.example.org. 3600 IN RRSIG A 5 3 3600 "
+                              "20150420235959 20051021000000 1 "
+                              "example.org. FAKE"));
+
+    // Removing non existent data doesn't change anything.
+    EXPECT_FALSE(updater_->remove(
+                     textToRRset("www.example.org. 3600 IN A 192.0.2.3"),
+                     ConstRRsetPtr()));
+    EXPECT_FALSE(updater_->remove(
+                     textToRRset("www.example.org. 3600 IN AAAA 2001:db8::1"),
+                     ConstRRsetPtr()));
+    EXPECT_FALSE(updater_->remove(
+                     textToRRset("nowhere.example.org. 3600 IN A 192.0.2.1"),
+                     ConstRRsetPtr()));
+
+    // Remove one of the RDATAs.
+    EXPECT_TRUE(updater_->remove(
+                    textToRRset("www.example.org. 3600 IN A 192.0.2.1"),
+                    ConstRRsetPtr()));
+    ZoneNode* node = getZoneData()->findName(Name("www.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    const RdataSet* rdset = RdataSet::find(node->getData(), RRType::A());
+    ASSERT_NE(static_cast<RdataSet*>(NULL), rdset);
+    EXPECT_EQ(1, rdset->getRdataCount());
+    EXPECT_EQ(1, rdset->getSigRdataCount());
+
+    // Remove the rest.  The node is kept until removeEmptyNodes().
+    EXPECT_TRUE(updater_->remove(
+                    textToRRset("www.example.org. 3600 IN A 192.0.2.2"),
+                    ConstRRsetPtr()));
+    EXPECT_TRUE(updater_->remove(
+                    ConstRRsetPtr(),
+                    textToRRset("www.example.org. 3600 IN RRSIG A 5 3 3600 "
+                                "20150420235959 20051021000000 1 "
+                                "example.org. FAKE")));
+    node = getZoneData()->findName(Name("www.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    EXPECT_TRUE(node->isEmpty());
+    updater_->removeEmptyNodes();
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              getZoneData()->findName(Name("www.example.org")));
+}
+
+TEST_P(ZoneDataUpdaterTest, removeAttributes) {
+    updater_->add(textToRRset("example.org. 3600 IN NS ns.example.org."),
+                  ConstRRsetPtr());
+
+    // Removing the delegation disables the callback.
+    const ConstRRsetPtr ns =
+        textToRRset("child.example.org. 3600 IN NS ns.example.com.");
+    updater_->add(ns, ConstRRsetPtr());
+    updater_->add(textToRRset("child.example.org. 3600 IN DS "
+                              "12892 5 2 5F0EB5C777586DE18DA6B5"),
+                  ConstRRsetPtr());
+    ZoneNode* node = getZoneData()->findName(Name("child.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    EXPECT_TRUE(node->getFlag(ZoneNode::FLAG_CALLBACK));
+    EXPECT_TRUE(updater_->remove(ns, ConstRRsetPtr()));
+    EXPECT_FALSE(node->getFlag(ZoneNode::FLAG_CALLBACK));
+
+    // The wildcard mark is cleared once the wildcard name is gone.
+    const ConstRRsetPtr wild =
+        textToRRset("*.wild.example.org. 3600 IN A 192.0.2.1");
+    updater_->add(wild, ConstRRsetPtr());
+    EXPECT_TRUE(updater_->remove(wild, ConstRRsetPtr()));
+    updater_->removeEmptyNodes();
+    node = getZoneData()->findName(Name("wild.example.org"));
+    EXPECT_TRUE(node == NULL || !node->getFlag(ZoneData::WILDCARD_NODE));
+
+    // Removing the NSEC at the origin makes the zone unsigned.
+    const ConstRRsetPtr nsec =
+        textToRRset("example.org. 3600 IN NSEC child.example.org. NS NSEC");
+    updater_->add(nsec, ConstRRsetPtr());
+    EXPECT_TRUE(getZoneData()->isSigned());
+    EXPECT_TRUE(updater_->remove(nsec, ConstRRsetPtr()));
+    EXPECT_FALSE(getZoneData()->isSigned());
+}
+
+TEST_P(ZoneDataUpdaterTest, removeEmptyNodesWithEmptyOrigin) {
+    const ConstRRsetPtr ns =
+        textToRRset("example.org. 3600 IN NS ns.example.org.");
+    updater_->add(ns, ConstRRsetPtr());
+    updater_->remove(ns, ConstRRsetPtr());
+    EXPECT_THROW(updater_->removeEmptyNodes(), bundy::InvalidOperation);
+}
+
 TEST_P(ZoneDataUpdaterTest, updaterCollision) {
     ZoneData* zone_data = ZoneData::create(*mem_sgmt_,
                                            Name("another.example.com."));
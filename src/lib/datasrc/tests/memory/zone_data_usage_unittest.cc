@@ -0,0 +1,126 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <datasrc/memory/zone_data_usage.h>
+#include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/zone_table.h>
+
+#include <dns/name.h>
+#include <dns/rrclass.h>
+
+#include <datasrc/tests/memory/memory_segment_mock.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/lexical_cast.hpp>
+
+using namespace bundy::dns;
+using namespace bundy::datasrc::memory;
+
+namespace {
+
+class ZoneDataUsageTest : public ::testing::Test {
+protected:
+    ZoneDataUsageTest() : zclass_(RRClass::IN()), zone_data_(NULL) {}
+    void TearDown() {
+        if (zone_data_ != NULL) {
+            ZoneData::destroy(mem_sgmt_, zone_data_, zclass_);
+        }
+        EXPECT_TRUE(mem_sgmt_.allMemoryDeallocated());
+    }
+    // The local segment allocates exactly what is requested, so the
+    // accounting of a zone must match the segment usage.
+    void checkTotal(const ZoneDataUsage& usage) const {
+        EXPECT_EQ(mem_sgmt_.getUsage().in_use, usage.getTotalSize());
+        EXPECT_EQ(sizeof(ZoneNode) * usage.node_count, usage.node_size);
+    }
+    const RRClass zclass_;
+    test::MemorySegmentMock mem_sgmt_;
+    ZoneData* zone_data_;
+};
+
+TEST_F(ZoneDataUsageTest, emptyZone) {
+    zone_data_ = ZoneData::create(mem_sgmt_, Name("example.org"));
+    const ZoneDataUsage usage = getZoneDataUsage(*zone_data_, zclass_);
+    checkTotal(usage);
+    EXPECT_LT(0, usage.node_count);
+    EXPECT_LT(0, usage.label_size);
+    EXPECT_EQ(0, usage.index_size);
+    EXPECT_EQ(0, usage.rdataset_count);
+    EXPECT_EQ(0, usage.rdataset_size);
+    EXPECT_EQ(0, usage.shared_rdata_size);
+    EXPECT_EQ(0, usage.nsec3_size);
+    EXPECT_EQ(sizeof(ZoneData) + sizeof(ZoneTree), usage.other_size);
+}
+
+TEST_F(ZoneDataUsageTest, loadedZone) {
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                              TEST_DATA_DIR "/example.org-nsec3-signed.zone");
+    const ZoneDataUsage usage = getZoneDataUsage(*zone_data_, zclass_);
+    checkTotal(usage);
+    EXPECT_LT(0, usage.rdataset_count);
+    EXPECT_LT(0, usage.rdataset_size);
+    EXPECT_EQ(0, usage.shared_rdata_size);
+    EXPECT_LT(0, usage.nsec3_size);
+}
+
+TEST_F(ZoneDataUsageTest, sharedRdata) {
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                              TEST_DATA_DIR "/example.org-nsec3-signed.zone",
+                              true);
+    const ZoneDataUsage usage = getZoneDataUsage(*zone_data_, zclass_);
+    checkTotal(usage);
+    EXPECT_LT(0, usage.shared_rdata_size);
+}
+
+TEST_F(ZoneDataUsageTest, index) {
+    zone_data_ = ZoneData::create(mem_sgmt_, Name("example.org"));
+    for (size_t i = 0; i < ZoneTree::INDEX_MIN_NODES; ++i) {
+        ZoneNode* node = NULL;
+        zone_data_->insertName(mem_sgmt_,
+                               Name("name" +
+                                    boost::lexical_cast<std::string>(i) +
+                                    ".example.org"),
+                               &node);
+    }
+    zone_data_->buildIndex(mem_sgmt_);
+    const ZoneDataUsage usage = getZoneDataUsage(*zone_data_, zclass_);
+    checkTotal(usage);
+    EXPECT_LT(0, usage.index_size);
+}
+
+TEST_F(ZoneDataUsageTest, zoneTable) {
+    // The table itself (including the placeholder for broken zones) is
+    // accounted for separately from its zones.
+    ZoneTable* table = ZoneTable::create(mem_sgmt_, zclass_);
+    EXPECT_EQ(mem_sgmt_.getUsage().in_use, table->getMemorySize());
+
+    table->addEmptyZone(mem_sgmt_, Name("example.com"));
+    table->addZone(mem_sgmt_, Name("example.org"),
+                   loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                                TEST_DATA_DIR "/example.org.zone"));
+    const ZoneTable::FindResult result =
+        table->findZone(Name("example.org"));
+    ASSERT_NE(static_cast<const ZoneData*>(NULL), result.zone_data);
+    EXPECT_EQ(mem_sgmt_.getUsage().in_use,
+              table->getMemorySize() +
+              getZoneDataUsage(*result.zone_data, zclass_).getTotalSize());
+
+    ZoneTable::destroy(mem_sgmt_, table);
+}
+
+}
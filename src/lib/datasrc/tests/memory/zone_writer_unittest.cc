@@ -20,15 +20,19 @@
 #include <datasrc/memory/zone_data_loader.h>
 #include <datasrc/memory/load_action.h>
 #include <datasrc/memory/zone_table.h>
+#include <datasrc/memory/zone_finder.h>
 #include <datasrc/exceptions.h>
 #include <datasrc/result.h>
 
 #include <util/memory_segment_mapped.h>
 
+#include <testutils/dnsmessage_test.h>
+
 #include <cc/data.h>
 
 #include <dns/rrclass.h>
 #include <dns/name.h>
+#include <dns/rrset.h>
 
 #include <datasrc/tests/memory/memory_segment_mock.h>
 #include <datasrc/tests/memory/zone_table_segment_mock.h>
@@ -40,12 +44,16 @@
 #include <boost/format.hpp>
 
 #include <string>
+#include <vector>
 #include <unistd.h>
 
 using boost::scoped_ptr;
 using boost::bind;
 using bundy::dns::RRClass;
 using bundy::dns::Name;
+using bundy::dns::RRType;
+using bundy::dns::ConstRRsetPtr;
+using bundy::testutils::textToRRset;
 using bundy::datasrc::ZoneLoaderException;
 using namespace bundy::datasrc::memory;
 using namespace bundy::datasrc::memory::test;
@@ -412,4 +420,108 @@ TEST_F(ZoneWriterTest, manyWrites) {
 #endif
 }
 
+TEST_F(ZoneWriterTest, isReplacement) {
+    // It can only be called between load() and install().
+    EXPECT_THROW(writer_->isReplacement(), bundy::InvalidOperation);
+    writer_->load();
+    // Segments other than "local" are never considered replaceable.
+    EXPECT_FALSE(writer_->isReplacement());
+    writer_->install();
+    EXPECT_THROW(writer_->isReplacement(), bundy::InvalidOperation);
+    writer_->cleanup();
+    EXPECT_THROW(writer_->isReplacement(), bundy::InvalidOperation);
+
+    // For a local segment, it's true iff the zone already exists.
+    boost::scoped_ptr<ZoneTableSegment> zt_segment(
+        ZoneTableSegment::create(RRClass::IN(), "local"));
+    const Name origin("example.org");
+    const LoadAction action = boost::bind(loadZoneDataWrapper, _1,
+                                          RRClass::IN(), origin,
+                                          TEST_DATA_DIR "/template.zone");
+    for (int i = 0; i < 2; ++i) {
+        ZoneWriter writer(*zt_segment, action, origin, RRClass::IN(), false);
+        writer.load();
+        EXPECT_EQ(i != 0, writer.isReplacement());
+        writer.install();
+        writer.cleanup();
+    }
+}
+
+// A DiffAction for tests.  It returns the given result and differences.
+bool
+diffActionWrapper(bool result, const std::vector<ConstRRsetPtr>& diffs,
+                  int* call_count, const ZoneData&,
+                  std::vector<ConstRRsetPtr>& diffs_ret)
+{
+    ++*call_count;
+    diffs_ret = diffs;
+    return (result);
+}
+
+TEST_F(ZoneWriterTest, incremental) {
+    boost::scoped_ptr<ZoneTableSegment> zt_segment(
+        ZoneTableSegment::create(RRClass::IN(), "local"));
+    const Name origin("example.org");
+    const LoadAction action = boost::bind(loadZoneDataWrapper, _1,
+                                          RRClass::IN(), origin,
+                                          TEST_DATA_DIR "/template.zone");
+    std::vector<ConstRRsetPtr> diffs;
+    diffs.push_back(textToRRset("example.org. 3600 IN SOA . . 1 0 0 0 0",
+                                RRClass::IN(), origin));
+    diffs.push_back(textToRRset("example.org. 3600 IN SOA . . 2 0 0 0 0",
+                                RRClass::IN(), origin));
+    diffs.push_back(textToRRset("www.example.org. 3600 IN A 192.0.2.1"));
+    int call_count = 0;
+    const DiffAction diff_action = boost::bind(diffActionWrapper, true,
+                                               diffs, &call_count, _1, _2);
+
+    // The zone isn't loaded yet, so the diff action isn't even called.
+    {
+        ZoneWriter writer(*zt_segment, action, origin, RRClass::IN(), false,
+                          diff_action);
+        EXPECT_THROW(writer.isIncremental(), bundy::InvalidOperation);
+        writer.load();
+        EXPECT_FALSE(writer.isIncremental());
+        writer.install();
+        writer.cleanup();
+        EXPECT_EQ(0, call_count);
+    }
+
+    // Now the differences are applied to the loaded zone.
+    {
+        ZoneWriter writer(*zt_segment, action, origin, RRClass::IN(), false,
+                          diff_action);
+        writer.load();
+        EXPECT_EQ(1, call_count);
+        EXPECT_TRUE(writer.isIncremental());
+        EXPECT_FALSE(writer.isReplacement());
+        writer.install();
+        writer.cleanup();
+    }
+    const ZoneTable::FindResult result =
+        zt_segment->getHeader().getTable()->findZone(origin);
+    ASSERT_EQ(bundy::datasrc::result::SUCCESS, result.code);
+    InMemoryZoneFinder finder(*result.zone_data, RRClass::IN());
+    EXPECT_EQ(bundy::datasrc::ZoneFinder::SUCCESS,
+              finder.find(Name("www.example.org"), RRType::A())->code);
+
+    // If the differences aren't available, the zone is fully loaded.
+    {
+        ZoneWriter writer(*zt_segment, action, origin, RRClass::IN(), false,
+                          boost::bind(diffActionWrapper, false, diffs,
+                                      &call_count, _1, _2));
+        writer.load();
+        EXPECT_EQ(2, call_count);
+        EXPECT_FALSE(writer.isIncremental());
+        EXPECT_TRUE(writer.isReplacement());
+        writer.install();
+        writer.cleanup();
+    }
+    InMemoryZoneFinder new_finder(
+        *zt_segment->getHeader().getTable()->findZone(origin).zone_data,
+        RRClass::IN());
+    EXPECT_EQ(bundy::datasrc::ZoneFinder::NXDOMAIN,
+              new_finder.find(Name("www.example.org"), RRType::A())->code);
+}
+
 }
@@ -107,6 +107,12 @@ TEST(SQLite3Open, memoryDB) {
     EXPECT_NO_THROW(SQLite3Accessor accessor(SQLITE_DBFILE_MEMORY, "IN"));
 }
 
+// The WAL mode isn't available for in-memory databases
+TEST(SQLite3Open, memoryDBWithWAL) {
+    EXPECT_THROW(SQLite3Accessor accessor(SQLITE_DBFILE_MEMORY, "IN", true),
+                 SQLite3Error);
+}
+
 // Test fixture for querying the db
 class SQLite3AccessorTest : public ::testing::Test {
 public:
@@ -791,6 +797,36 @@ TEST_F(SQLite3AccessorTest, clone) {
                    "");
 }
 
+// The statements of iterator contexts are reused, but each live context
+// must still have its own.
+TEST_F(SQLite3AccessorTest, concurrentIterators) {
+    const int zone_id = accessor->getZone("example.com.").second;
+    string columns1[DatabaseAccessor::COLUMN_COUNT];
+    string columns2[DatabaseAccessor::COLUMN_COUNT];
+
+    for (int i = 0; i < 2; ++i) {
+        DatabaseAccessor::IteratorContextPtr iterator1 =
+            accessor->getRecords("foo.example.com.", zone_id);
+        ASSERT_TRUE(iterator1->getNext(columns1));
+        DatabaseAccessor::IteratorContextPtr iterator2 =
+            accessor->getRecords("foo.example.com.", zone_id);
+        ASSERT_TRUE(iterator2->getNext(columns2));
+        checkRecordRow(columns1, "CNAME", "3600", "",
+                       "cnametest.example.org.", "");
+        checkRecordRow(columns2, "CNAME", "3600", "",
+                       "cnametest.example.org.", "");
+
+        // The other iterator isn't affected by the end of the first one
+        while (iterator1->getNext(columns1)) {
+            ;
+        }
+        ASSERT_TRUE(iterator2->getNext(columns2));
+        checkRecordRow(columns2, "RRSIG", "3600", "CNAME",
+                       "CNAME 5 3 3600 20100322084538 20100220084538 33495 "
+                       "example.com. FAKEFAKEFAKEFAKE", "");
+    }
+}
+
 //
 // Commonly used data for update tests
 //
@@ -1025,6 +1061,62 @@ TEST_F(SQLite3Update, updateConflict) {
     accessor->commit();
 }
 
+// Same as SQLite3Update, but the accessors are in the WAL mode.
+class SQLite3UpdateWAL : public SQLite3Update {
+protected:
+    SQLite3UpdateWAL() {
+        accessor.reset(new SQLite3Accessor(
+                           TEST_DATA_BUILDDIR "/test.sqlite3.copied", "IN",
+                           true));
+        another_accessor.reset(new SQLite3Accessor(
+                                   TEST_DATA_BUILDDIR "/test.sqlite3.copied",
+                                   "IN", true));
+    }
+};
+
+TEST_F(SQLite3UpdateWAL, commitWhileReading) {
+    // Unlike the commitConflict case, the reader doesn't prevent the commit.
+    iterator = another_accessor->getRecords("foo.example.com.", zone_id);
+    EXPECT_TRUE(iterator->getNext(get_columns));
+
+    zone_id = accessor->startUpdateZone("example.com.", true).second;
+    checkRecords(*accessor, zone_id, "foo.bar.example.com.", empty_stored);
+    EXPECT_NO_THROW(accessor->commit());
+
+    // The reader keeps reading the old version until it's done, and then
+    // sees the new one.
+    EXPECT_TRUE(iterator->getNext(get_columns));
+    iterator.reset();
+    checkRecords(*another_accessor, zone_id, "foo.bar.example.com.",
+                 empty_stored);
+}
+
+TEST_F(SQLite3UpdateWAL, clone) {
+    // A clone destroyed in the middle of a transaction isn't reused; the
+    // transaction is rolled back and the next clone can start a new one.
+    boost::shared_ptr<SQLite3Accessor> cloned =
+        boost::dynamic_pointer_cast<SQLite3Accessor>(accessor->clone());
+    ASSERT_TRUE(cloned);
+    EXPECT_TRUE(cloned->startUpdateZone("example.com.", true).first);
+    cloned.reset();
+
+    cloned = boost::dynamic_pointer_cast<SQLite3Accessor>(accessor->clone());
+    checkRecords(*cloned, zone_id, "foo.bar.example.com.", expected_stored);
+    EXPECT_TRUE(cloned->startUpdateZone("example.com.", true).first);
+    cloned->commit();
+    cloned.reset();
+
+    // The connection of the previous clone is reused (for a clone of a
+    // clone, too); it sees the committed data and isn't in a transaction.
+    cloned = boost::dynamic_pointer_cast<SQLite3Accessor>(
+        boost::dynamic_pointer_cast<SQLite3Accessor>(accessor->clone())->
+        clone());
+    checkRecords(*cloned, zone_id, "foo.bar.example.com.", empty_stored);
+    EXPECT_NO_THROW(cloned->startTransaction());
+    cloned->rollback();
+    checkRecords(*accessor, zone_id, "foo.bar.example.com.", empty_stored);
+}
+
 TEST_F(SQLite3Update, duplicateUpdate) {
     accessor->startUpdateZone("example.com.", false);
     EXPECT_THROW(accessor->startUpdateZone("example.com.", false),
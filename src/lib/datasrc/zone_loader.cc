@@ -31,6 +31,8 @@
 
 #include <string>
 
+#include <unistd.h> // for sysconf()
+
 using bundy::dns::Name;
 using bundy::dns::ConstRRsetPtr;
 using bundy::dns::RRsetCollectionBase;
@@ -67,12 +69,16 @@ ZoneLoader::ZoneLoader(DataSourceClient& destination, const Name& zone_name,
         bundy_throw(bundy::InvalidParameter,
                   "Source and destination class mismatch");
     }
+    checker_.reset(new dns::IncrementalZoneChecker(
+                       zone_name, updater_->getFinder().getClass()));
 }
 
 namespace {
-// Unified callback to install RR and increment RR count at the same time.
+// Unified callback to install RR, pass it to the zone checker and increment
+// RR count at the same time.
 void
-addRR(ZoneUpdater* updater, size_t* rr_count,
+addRR(ZoneUpdater* updater, dns::IncrementalZoneChecker* checker,
+      size_t* rr_count,
       const dns::Name& name, const dns::RRClass& rrclass,
       const dns::RRType& type, const dns::RRTTL& ttl,
       const dns::rdata::RdataPtr& data)
@@ -80,6 +86,7 @@ addRR(ZoneUpdater* updater, size_t* rr_count,
     bundy::dns::BasicRRset rrset(name, rrclass, type, ttl);
     rrset.addRdata(data);
     updater->addRRset(rrset);
+    checker->addRRset(rrset);
     ++*rr_count;
 }
 }
@@ -93,6 +100,8 @@ ZoneLoader::ZoneLoader(DataSourceClient& destination, const Name& zone_name,
         bundy_throw(DataSourceError, "Zone " << zone_name << " not found in "
                   "destination data source, can't fill it with data");
     } else {
+        checker_.reset(new dns::IncrementalZoneChecker(
+                           zone_name, updater_->getFinder().getClass()));
         loader_.reset(new
                       MasterLoader(filename, zone_name,
                                    // TODO: Maybe we should have getClass()
@@ -102,17 +111,25 @@ ZoneLoader::ZoneLoader(DataSourceClient& destination, const Name& zone_name,
                                        updater_->getFinder().getClass(),
                                        &loaded_ok_),
                                    boost::bind(addRR,
-                                               updater_.get(), &rr_count_,
-                                               _1, _2, _3, _4, _5)));
+                                               updater_.get(), checker_.get(),
+                                               &rr_count_,
+                                               _1, _2, _3, _4, _5),
+                                   // Parsing in parallel only pays off if
+                                   // there's more than one processor.
+                                   sysconf(_SC_NPROCESSORS_ONLN) > 1 ?
+                                   MasterLoader::PARALLEL :
+                                   MasterLoader::DEFAULT));
     }
 }
 
 namespace {
 
-// Copy up to limit RRsets from source to destination
+// Copy up to limit RRsets from source to destination, passing them to the
+// zone checker, too
 bool
 copyRRsets(const ZoneUpdaterPtr& destination, const ZoneIteratorPtr& source,
-           size_t limit, size_t& rr_count_)
+           dns::IncrementalZoneChecker& checker, size_t limit,
+           size_t& rr_count_)
 {
     size_t loaded = 0;
     while (loaded < limit) {
@@ -122,6 +139,7 @@ copyRRsets(const ZoneUpdaterPtr& destination, const ZoneIteratorPtr& source,
             return (true);
         } else {
             destination->addRRset(*rrset);
+            checker.addRRset(*rrset);
         }
         ++loaded;
         rr_count_ += rrset->getRdataCount();
@@ -165,18 +183,21 @@ ZoneLoader::loadIncremental(size_t limit) {
             bundy_throw(MasterFileError, "Error while loading master file");
         }
     } else {
-        complete_ = copyRRsets(updater_, iterator_, limit, rr_count_);
+        complete_ = copyRRsets(updater_, iterator_, *checker_, limit,
+                               rr_count_);
     }
 
     if (complete_) {
         // Everything is loaded. Perform some basic sanity checks on the zone.
+        // The checker has collected most of what it needs while loading;
+        // the collection is only consulted for what it couldn't.
         RRsetCollectionBase& collection = updater_->getRRsetCollection();
         const dns::Name& zone_name(updater_->getFinder().getOrigin());
         const dns::RRClass& zone_class(updater_->getFinder().getClass());
         const dns::ZoneCheckerCallbacks
             callbacks(boost::bind(&logError, &zone_name, &zone_class, _1),
                       boost::bind(&logWarning, &zone_name, &zone_class, _1));
-        if (!dns::checkZone(zone_name, zone_class, collection, callbacks)) {
+        if (!checker_->check(collection, callbacks)) {
             // The post-load check failed.
             loaded_ok_ = false;
             bundy_throw(ZoneContentError, "Errors found when validating zone " <<
@@ -18,6 +18,7 @@
 #include <datasrc/exceptions.h>
 
 #include <dns/master_loader.h>
+#include <dns/zone_checker.h>
 
 #include <cstdlib> // For size_t
 #include <boost/shared_ptr.hpp>
@@ -221,6 +222,8 @@ private:
     const ZoneUpdaterPtr updater_;
     /// \brief The master loader (for the master file mode)
     boost::scoped_ptr<bundy::dns::MasterLoader> loader_;
+    /// \brief The zone checker, fed with the RRsets as they are loaded
+    boost::scoped_ptr<bundy::dns::IncrementalZoneChecker> checker_;
     /// \brief Indicator if loading was completed
     bool complete_;
     /// \brief Was the loading successful?
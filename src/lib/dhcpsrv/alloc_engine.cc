@@ -19,9 +19,15 @@
 #include <hooks/server_hooks.h>
 #include <hooks/hooks_manager.h>
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
 #include <vector>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 
 using namespace bundy::asiolink;
 using namespace bundy::hooks;
@@ -48,6 +54,184 @@ struct AllocEngineHooks {
 // module is called.
 AllocEngineHooks Hooks;
 
+// Returns a seed for the random number generators of the allocators.  It's
+// read from /dev/urandom, so servers started at the same moment don't pick
+// the same sequences of addresses; the time and the process ID are only
+// used if that fails.
+uint64_t
+randomSeed() {
+    uint64_t seed = 0;
+    const int fd = open("/dev/urandom", O_RDONLY);
+    if (fd >= 0) {
+        const ssize_t len = read(fd, &seed, sizeof(seed));
+        close(fd);
+        if (len == static_cast<ssize_t>(sizeof(seed))) {
+            return (seed);
+        }
+    }
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return ((static_cast<uint64_t>(now.tv_sec) << 32) ^ now.tv_usec ^
+            (static_cast<uint64_t>(getpid()) << 20));
+}
+
+// Computes the offset of an address from the beginning of a range, in
+// units of 2^shift addresses (shift is non-zero for prefixes).  It returns
+// false if addr is below base or too far from it for the offset to fit in
+// 64 bits.  Both addresses must be of the same family.
+bool
+getAddressOffset(const IOAddress& base, const IOAddress& addr,
+                 uint64_t& offset, unsigned int shift = 0) {
+    const std::vector<uint8_t>& base_vec = base.toBytes();
+    const std::vector<uint8_t>& addr_vec = addr.toBytes();
+    const int len = addr_vec.size();
+
+    // Subtract the base from the address, starting from the least
+    // significant byte.
+    uint8_t diff[V6ADDRESS_LEN];
+    int borrow = 0;
+    for (int i = len - 1; i >= 0; --i) {
+        int byte = addr_vec[i] - base_vec[i] - borrow;
+        borrow = (byte < 0) ? 1 : 0;
+        diff[i] = static_cast<uint8_t>(byte + (borrow << 8));
+    }
+    if (borrow != 0) {
+        return (false);
+    }
+
+    // Split the difference into two 64-bit halves and shift them.
+    uint64_t high = 0;
+    uint64_t low = 0;
+    for (int i = 0; i < len; ++i) {
+        high = (high << 8) | (low >> 56);
+        low = (low << 8) | diff[i];
+    }
+    if (shift >= 64) {
+        low = high >> (shift - 64);
+        high = 0;
+    } else if (shift > 0) {
+        low = (low >> shift) | (high << (64 - shift));
+        high >>= shift;
+    }
+    if (high != 0) {
+        return (false);
+    }
+    offset = low;
+    return (true);
+}
+
+// Returns the address that is the given offset (in units of 2^shift
+// addresses) away from the base.
+IOAddress
+addAddressOffset(const IOAddress& base, uint64_t offset,
+                 unsigned int shift = 0) {
+    const std::vector<uint8_t>& vec = base.toBytes();
+    const int len = vec.size();
+
+    BOOST_STATIC_ASSERT(V4ADDRESS_LEN <= V6ADDRESS_LEN);
+    uint8_t packed[V6ADDRESS_LEN];
+    std::memcpy(packed, &vec[0], len);
+
+    uint64_t high = 0;
+    uint64_t low = offset;
+    if (shift >= 64) {
+        high = low << (shift - 64);
+        low = 0;
+    } else if (shift > 0) {
+        high = low >> (64 - shift);
+        low <<= shift;
+    }
+
+    unsigned int carry = 0;
+    for (int i = len - 1; i >= 0; --i) {
+        const unsigned int sum = packed[i] + (low & 0xff) + carry;
+        packed[i] = static_cast<uint8_t>(sum);
+        carry = sum >> 8;
+        low = (low >> 8) | (high << 56);
+        high >>= 8;
+    }
+
+    return (IOAddress::fromBytes(base.getFamily(), packed));
+}
+
+// The resources (addresses or prefixes) of the pools of a subnet, numbered
+// as if the pools were concatenated.  The number of resources of a pool is
+// capped so the total fits in 64 bits.
+class PoolSpace {
+public:
+    PoolSpace(const bundy::dhcp::PoolCollection& pools,
+              bundy::dhcp::Lease::Type type) :
+        pools_(pools), total_(0)
+    {
+        const uint64_t max_count =
+            std::numeric_limits<uint64_t>::max() / pools.size();
+        for (size_t i = 0; i < pools.size(); ++i) {
+            unsigned int shift = 0;
+            if (type == bundy::dhcp::Lease::TYPE_PD) {
+                bundy::dhcp::Pool6Ptr pool6 =
+                    boost::dynamic_pointer_cast<bundy::dhcp::Pool6>(pools[i]);
+                if (!pool6) {
+                    bundy_throw(bundy::Unexpected, "Wrong type of pool: "
+                                << pools[i]->toText() << " is not Pool6");
+                }
+                shift = 128 - pool6->getLength();
+            }
+            uint64_t count;
+            if (!getAddressOffset(pools[i]->getFirstAddress(),
+                                  pools[i]->getLastAddress(), count, shift) ||
+                count >= max_count) {
+                count = max_count;
+            } else {
+                ++count;
+            }
+            shifts_.push_back(shift);
+            counts_.push_back(count);
+            total_ += count;
+        }
+    }
+
+    uint64_t getTotal() const {
+        return (total_);
+    }
+
+    IOAddress getAddress(uint64_t index) const {
+        size_t i = 0;
+        while (index >= counts_[i]) {
+            index -= counts_[i];
+            ++i;
+        }
+        return (addAddressOffset(pools_[i]->getFirstAddress(), index,
+                                 shifts_[i]));
+    }
+
+private:
+    const bundy::dhcp::PoolCollection& pools_;
+    std::vector<uint64_t> counts_;
+    std::vector<unsigned int> shifts_;
+    uint64_t total_;
+};
+
+uint64_t
+getGcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        const uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return (a);
+}
+
+// Hashes a client identifier with FNV-1a.
+uint64_t
+hashClientId(const std::vector<uint8_t>& id, uint64_t basis) {
+    uint64_t hash = basis;
+    for (size_t i = 0; i < id.size(); ++i) {
+        hash ^= id[i];
+        hash *= 1099511628211ULL;
+    }
+    return (hash);
+}
+
 }; // anonymous namespace
 
 namespace bundy {
@@ -217,36 +401,318 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
     return (next);
 }
 
-AllocEngine::HashedAllocator::HashedAllocator(Lease::Type lease_type)
-    :Allocator(lease_type) {
-    bundy_throw(NotImplemented, "Hashed allocator is not implemented");
+// The bits of the addresses in a pool, in words of 64 bits.  A bit is set
+// when the address is known to be in use.  The bits beyond the end of the
+// pool in the last word are always set, so they are never picked.
+struct AllocEngine::BitmapAllocator::PoolBitmap {
+    PoolBitmap(const Pool& pool, uint64_t size) :
+        pool_id_(pool.getId()), first_(pool.getFirstAddress()),
+        last_(pool.getLastAddress()), size_(size),
+        words_((size + 63) / 64), used_(0), cursor_(0)
+    {
+        reset();
+    }
+
+    // Clears all bits (except the padding at the end).
+    void reset() {
+        std::fill(words_.begin(), words_.end(), 0);
+        if (size_ % 64 != 0) {
+            words_.back() = ~((static_cast<uint64_t>(1) << (size_ % 64)) - 1);
+        }
+        used_ = 0;
+    }
+
+    bool isSet(uint64_t offset) const {
+        return ((words_[offset / 64] >> (offset % 64)) & 1);
+    }
+
+    void set(uint64_t offset) {
+        if (!isSet(offset)) {
+            words_[offset / 64] |= static_cast<uint64_t>(1) << (offset % 64);
+            ++used_;
+        }
+    }
+
+    void clear(uint64_t offset) {
+        if (isSet(offset)) {
+            words_[offset / 64] &= ~(static_cast<uint64_t>(1) << (offset % 64));
+            --used_;
+        }
+    }
+
+    // Finds the first clear bit at or after the cursor and moves the cursor
+    // past it, so the next call returns another address even if this one
+    // doesn't get used.  If there's none up to the end of the pool, the
+    // cursor goes back to the beginning and false is returned.
+    bool find(uint64_t& offset) {
+        if (used_ < size_) {
+            const uint64_t below_cursor =
+                (static_cast<uint64_t>(1) << (cursor_ % 64)) - 1;
+            for (size_t index = cursor_ / 64; index < words_.size(); ++index) {
+                uint64_t word = words_[index];
+                if (index == cursor_ / 64) {
+                    word |= below_cursor;
+                }
+                if (~word != 0) {
+                    offset = index * 64 + __builtin_ctzll(~word);
+                    cursor_ = offset + 1;
+                    return (true);
+                }
+            }
+        }
+        cursor_ = 0;
+        return (false);
+    }
+
+    const uint32_t pool_id_;
+    const IOAddress first_;
+    const IOAddress last_;
+    const uint64_t size_;
+    std::vector<uint64_t> words_;
+    uint64_t used_;
+    uint64_t cursor_;
+};
+
+const uint64_t AllocEngine::BitmapAllocator::MAX_BITMAP_SIZE;
+
+AllocEngine::BitmapAllocator::BitmapAllocator(Lease::Type lease_type)
+    :IterativeAllocator(lease_type) {
 }
 
+AllocEngine::BitmapAllocator::PoolBitmap*
+AllocEngine::BitmapAllocator::getBitmap(const Pool& pool) {
+    std::map<IOAddress, PoolBitmapPtr>::iterator it =
+        bitmaps_.find(pool.getFirstAddress());
+    if (it != bitmaps_.end() && it->second->pool_id_ == pool.getId()) {
+        return (it->second.get());
+    }
+
+    // There is no bitmap for the pool yet, or the one we have is for a pool
+    // that has been replaced by reconfiguration.  Any other bitmap that
+    // overlaps this pool is for an old configuration, too.
+    uint64_t size;
+    if (!getAddressOffset(pool.getFirstAddress(), pool.getLastAddress(),
+                          size) || size >= MAX_BITMAP_SIZE) {
+        return (NULL);
+    }
+    ++size;
+    it = bitmaps_.lower_bound(pool.getFirstAddress());
+    while (it != bitmaps_.end() &&
+           it->first <= pool.getLastAddress()) {
+        bitmaps_.erase(it++);
+    }
+    it = bitmaps_.lower_bound(pool.getFirstAddress());
+    if (it != bitmaps_.begin()) {
+        --it;
+        if (pool.getFirstAddress() <= it->second->last_) {
+            bitmaps_.erase(it);
+        }
+    }
+
+    PoolBitmapPtr bitmap(new PoolBitmap(pool, size));
+    bitmaps_[pool.getFirstAddress()] = bitmap;
+    return (bitmap.get());
+}
+
+AllocEngine::BitmapAllocator::PoolBitmap*
+AllocEngine::BitmapAllocator::findBitmap(const IOAddress& addr) const {
+    std::map<IOAddress, PoolBitmapPtr>::const_iterator it =
+        bitmaps_.upper_bound(addr);
+    if (it == bitmaps_.begin()) {
+        return (NULL);
+    }
+    --it;
+    if (addr <= it->second->last_) {
+        return (it->second.get());
+    }
+    return (NULL);
+}
 
 bundy::asiolink::IOAddress
-AllocEngine::HashedAllocator::pickAddress(const SubnetPtr&,
-                                          const DuidPtr&,
-                                          const IOAddress&) {
-    bundy_throw(NotImplemented, "Hashed allocator is not implemented");
+AllocEngine::BitmapAllocator::pickAddress(const SubnetPtr& subnet,
+                                          const DuidPtr& duid,
+                                          const IOAddress& hint) {
+    // Prefixes are not tracked.
+    if (pool_type_ == Lease::TYPE_PD) {
+        return (IterativeAllocator::pickAddress(subnet, duid, hint));
+    }
+
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+    if (pools.empty()) {
+        bundy_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    // Get the bitmaps of all pools and find the pool the last address
+    // belongs to; we'll start from there.  If any pool is too large for a
+    // bitmap, fall back to the iterative allocation for the whole subnet.
+    const IOAddress last = subnet->getLastAllocated(pool_type_);
+    std::vector<PoolBitmap*> bitmaps;
+    size_t start = 0;
+    for (size_t i = 0; i < pools.size(); ++i) {
+        PoolBitmap* bitmap = getBitmap(*pools[i]);
+        if (bitmap == NULL) {
+            return (IterativeAllocator::pickAddress(subnet, duid, hint));
+        }
+        if (pools[i]->inRange(last)) {
+            start = i;
+        }
+        bitmaps.push_back(bitmap);
+    }
+
+    // Search the pools from where the last search stopped.  A pool's
+    // cursor goes back to its beginning when the end is reached, so two
+    // rounds are enough to find any address not known to be used.
+    for (size_t i = 0; i <= 2 * bitmaps.size(); ++i) {
+        if (i == 2 * bitmaps.size()) {
+            // All addresses seem to be used.  Some leases may have expired
+            // or been removed since we learned about them, so forget what
+            // we know about the subnet and learn it again.
+            for (size_t j = 0; j < bitmaps.size(); ++j) {
+                bitmaps[j]->reset();
+            }
+        }
+        PoolBitmap* bitmap = bitmaps[(start + i) % bitmaps.size()];
+        uint64_t offset;
+        if (bitmap->find(offset)) {
+            const IOAddress next = addAddressOffset(bitmap->first_, offset);
+            subnet->setLastAllocated(pool_type_, next);
+            return (next);
+        }
+    }
+
+    // Not reached: after the reset the starting pool has free addresses.
+    bundy_throw(Unexpected, "Failed to pick an address from a bitmap");
 }
 
-AllocEngine::RandomAllocator::RandomAllocator(Lease::Type lease_type)
-    :Allocator(lease_type) {
-    bundy_throw(NotImplemented, "Random allocator is not implemented");
+void
+AllocEngine::BitmapAllocator::addressUsed(const IOAddress& addr) {
+    PoolBitmap* bitmap = findBitmap(addr);
+    uint64_t offset;
+    if (bitmap != NULL && getAddressOffset(bitmap->first_, addr, offset)) {
+        bitmap->set(offset);
+    }
+}
+
+void
+AllocEngine::BitmapAllocator::addressFreed(const IOAddress& addr) {
+    PoolBitmap* bitmap = findBitmap(addr);
+    uint64_t offset;
+    if (bitmap != NULL && getAddressOffset(bitmap->first_, addr, offset)) {
+        bitmap->clear(offset);
+    }
 }
 
+AllocEngine::ProbingAllocator::ProbingAllocator(Lease::Type lease_type)
+    :Allocator(lease_type), last_addr_("::"), last_used_(false), total_(0),
+     index_(0), step_(0), probes_(0) {
+}
 
 bundy::asiolink::IOAddress
-AllocEngine::RandomAllocator::pickAddress(const SubnetPtr&,
-                                          const DuidPtr&,
-                                          const IOAddress&) {
-    bundy_throw(NotImplemented, "Random allocator is not implemented");
+AllocEngine::ProbingAllocator::pickAddress(const SubnetPtr& subnet,
+                                           const DuidPtr& duid,
+                                           const IOAddress&) {
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+    if (pools.empty()) {
+        bundy_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+    const PoolSpace space(pools, pool_type_);
+
+    std::vector<uint8_t> client;
+    if (duid) {
+        client = duid->getDuid();
+    }
+
+    if (last_used_ && space.getTotal() == total_ &&
+        continueProbing(client == last_client_, probes_)) {
+        // Move to the next resource of the sequence (index_ + step_ modulo
+        // total_, without overflowing).
+        index_ = (index_ >= total_ - step_) ? index_ - (total_ - step_) :
+            index_ + step_;
+        ++probes_;
+    } else {
+        total_ = space.getTotal();
+        uint64_t start;
+        uint64_t step;
+        startProbing(duid, total_, start, step);
+        index_ = start % total_;
+
+        // The sequence visits every resource if the step is coprime to
+        // the total.
+        step_ = step % total_;
+        if (step_ == 0) {
+            step_ = 1;
+        }
+        while (getGcd(step_, total_) != 1) {
+            step_ = (step_ + 1) % total_;
+            if (step_ == 0) {
+                step_ = 1;
+            }
+        }
+        probes_ = 1;
+    }
+
+    last_client_.swap(client);
+    last_addr_ = space.getAddress(index_);
+    last_used_ = false;
+    return (last_addr_);
 }
 
+void
+AllocEngine::ProbingAllocator::addressUsed(const IOAddress& addr) {
+    if (addr == last_addr_) {
+        last_used_ = true;
+    }
+}
+
+AllocEngine::HashedAllocator::HashedAllocator(Lease::Type lease_type)
+    :ProbingAllocator(lease_type), rng_(randomSeed()) {
+}
+
+void
+AllocEngine::HashedAllocator::startProbing(const DuidPtr& duid, uint64_t,
+                                           uint64_t& start, uint64_t& step) {
+    if (duid && !duid->getDuid().empty()) {
+        start = hashClientId(duid->getDuid(), 14695981039346656037ULL);
+        step = hashClientId(duid->getDuid(), start);
+    } else {
+        start = rng_();
+        step = rng_();
+    }
+}
+
+bool
+AllocEngine::HashedAllocator::continueProbing(bool same_client,
+                                              unsigned int) const {
+    return (same_client);
+}
+
+const unsigned int AllocEngine::RandomAllocator::MAX_PROBES;
+
+AllocEngine::RandomAllocator::RandomAllocator(Lease::Type lease_type)
+    :ProbingAllocator(lease_type), rng_(randomSeed()) {
+}
+
+AllocEngine::RandomAllocator::RandomAllocator(Lease::Type lease_type,
+                                              uint64_t seed)
+    :ProbingAllocator(lease_type), rng_(seed) {
+}
+
+void
+AllocEngine::RandomAllocator::startProbing(const DuidPtr&, uint64_t,
+                                           uint64_t& start, uint64_t& step) {
+    start = rng_();
+    step = rng_();
+}
+
+bool
+AllocEngine::RandomAllocator::continueProbing(bool,
+                                              unsigned int probes) const {
+    return (probes < MAX_PROBES);
+}
 
 AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
                          bool ipv6)
-    :attempts_(attempts) {
+    :alloc_type_(engine_type), attempts_(attempts) {
 
     // Choose the basic (normal address) lease type
     Lease::Type basic_type = ipv6 ? Lease::TYPE_NA : Lease::TYPE_V4;
@@ -262,6 +728,9 @@ AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
     case ALLOC_RANDOM:
         allocators_[basic_type] = AllocatorPtr(new RandomAllocator(basic_type));
         break;
+    case ALLOC_BITMAP:
+        allocators_[basic_type] = AllocatorPtr(new BitmapAllocator(basic_type));
+        break;
     default:
         bundy_throw(BadValue, "Invalid/unsupported allocation algorithm");
     }
@@ -282,6 +751,10 @@ AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
             allocators_[Lease::TYPE_TA] = AllocatorPtr(new RandomAllocator(Lease::TYPE_TA));
             allocators_[Lease::TYPE_PD] = AllocatorPtr(new RandomAllocator(Lease::TYPE_PD));
             break;
+        case ALLOC_BITMAP:
+            allocators_[Lease::TYPE_TA] = AllocatorPtr(new BitmapAllocator(Lease::TYPE_TA));
+            allocators_[Lease::TYPE_PD] = AllocatorPtr(new BitmapAllocator(Lease::TYPE_PD));
+            break;
         default:
             bundy_throw(BadValue, "Invalid/unsupported allocation algorithm");
         }
@@ -292,6 +765,21 @@ AllocEngine::AllocEngine(AllocType engine_type, unsigned int attempts,
     hook_index_lease6_select_ = Hooks.hook_index_lease6_select_;
 }
 
+AllocEngine::AllocType
+AllocEngine::allocTypeFromText(const std::string& name) {
+    if (name == "iterative") {
+        return (ALLOC_ITERATIVE);
+    } else if (name == "hashed") {
+        return (ALLOC_HASHED);
+    } else if (name == "random") {
+        return (ALLOC_RANDOM);
+    } else if (name == "bitmap") {
+        return (ALLOC_BITMAP);
+    }
+    bundy_throw(BadValue, "Invalid/unsupported allocation algorithm: "
+              << name);
+}
+
 Lease6Collection
 AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                              const uint32_t iaid, const IOAddress& hint,
@@ -459,6 +947,10 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                     collection.push_back(existing);
                     return (collection);
                 }
+
+                // The candidate is leased to someone else; let the allocator
+                // know so it doesn't pick it again.
+                allocator->addressUsed(candidate);
             }
 
             // Continue trying allocation until we run out of attempts
@@ -625,6 +1117,10 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                                               hostname, callout_handle,
                                               fake_allocation));
                 }
+
+                // The candidate is leased to someone else; let the allocator
+                // know so it doesn't pick it again.
+                allocator->addressUsed(candidate);
             }
 
             // Continue trying allocation until we run out of attempts
@@ -793,6 +1289,7 @@ Lease6Ptr AllocEngine::reuseExpiredLease(Lease6Ptr& expired,
     if (!fake_allocation) {
         // for REQUEST we do update the lease
         LeaseMgrFactory::instance().updateLease6(expired);
+        getAllocator(expired->type_)->addressUsed(expired->addr_);
     }
 
     // We do nothing for SOLICIT. We'll just update database when
@@ -874,6 +1371,7 @@ Lease4Ptr AllocEngine::reuseExpiredLease(Lease4Ptr& expired,
     if (!fake_allocation) {
         // for REQUEST we do update the lease
         LeaseMgrFactory::instance().updateLease4(expired);
+        getAllocator(Lease::TYPE_V4)->addressUsed(expired->addr_);
     }
 
     // We do nothing for SOLICIT. We'll just update database when
@@ -944,6 +1442,8 @@ Lease6Ptr AllocEngine::createLease6(const Subnet6Ptr& subnet,
     if (!fake_allocation) {
         // That is a real (REQUEST) allocation
         bool status = LeaseMgrFactory::instance().addLease(lease);
+        // Whether we got it or lost a race for it, the address is used now.
+        getAllocator(type)->addressUsed(addr);
 
         if (status) {
 
@@ -1041,6 +1541,8 @@ Lease4Ptr AllocEngine::createLease4(const SubnetPtr& subnet,
     if (!fake_allocation) {
         // That is a real (REQUEST) allocation
         bool status = LeaseMgrFactory::instance().addLease(lease);
+        // Whether we got it or lost a race for it, the address is used now.
+        getAllocator(Lease::TYPE_V4)->addressUsed(addr);
         if (status) {
             return (lease);
         } else {
@@ -1088,6 +1590,15 @@ AllocEngine::updateFqdnData(const Lease6Collection& leases,
     return (updated_leases);
 }
 
+void
+AllocEngine::leaseRemoved(Lease::Type type, const IOAddress& addr) {
+    std::map<Lease::Type, AllocatorPtr>::const_iterator alloc =
+        allocators_.find(type);
+    if (alloc != allocators_.end()) {
+        alloc->second->addressFreed(addr);
+    }
+}
+
 AllocEngine::AllocatorPtr AllocEngine::getAllocator(Lease::Type type) {
     std::map<Lease::Type, AllocatorPtr>::const_iterator alloc = allocators_.find(type);
 
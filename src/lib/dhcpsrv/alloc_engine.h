@@ -24,8 +24,10 @@
 
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/random/mersenne_twister.hpp>
 
 #include <map>
+#include <vector>
 
 namespace bundy {
 namespace dhcp {
@@ -87,6 +89,27 @@ protected:
         pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
                     const bundy::asiolink::IOAddress& hint) = 0;
 
+        /// @brief informs the allocator that an address is in use
+        ///
+        /// AllocEngine calls this method when it has allocated a lease for
+        /// the address, or when it has found a valid lease for an address
+        /// returned by pickAddress(). Allocators that don't keep track of
+        /// used addresses ignore it.
+        ///
+        /// @param addr address (or prefix) that is in use
+        virtual void addressUsed(const bundy::asiolink::IOAddress&) {
+        }
+
+        /// @brief informs the allocator that an address is no longer used
+        ///
+        /// AllocEngine calls this method when it is told that a lease has
+        /// been removed (see @ref AllocEngine::leaseRemoved). Allocators
+        /// that don't keep track of used addresses ignore it.
+        ///
+        /// @param addr address (or prefix) that is no longer used
+        virtual void addressFreed(const bundy::asiolink::IOAddress&) {
+        }
+
         /// @brief Default constructor.
         ///
         /// Specifies which type of leases this allocator will assign
@@ -159,50 +182,243 @@ protected:
                        const uint8_t prefix_len);
     };
 
-    /// @brief Address/prefix allocator that gets an address based on a hash
+    /// @brief Address allocator that keeps track of used addresses in bitmaps
+    ///
+    /// This allocator keeps a bitmap for each pool, with one bit for each
+    /// address in the pool. A bit is set when AllocEngine allocates a lease
+    /// for the address or finds a valid lease for it (see addressUsed()), and
+    /// cleared when the lease is removed (see addressFreed()). pickAddress()
+    /// returns the next address whose bit is clear, starting where the
+    /// previous search stopped and skipping 64 used addresses at a time, so
+    /// in a nearly exhausted pool the engine doesn't look up every used
+    /// address in the lease database again for each allocation.
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
-    class HashedAllocator : public Allocator {
+    /// The bitmaps are built when a pool is first used, from the addresses
+    /// the engine finds to be in use. Leases that expire or are removed
+    /// without the engine knowing are noticed when all bits of the pools
+    /// of a subnet are set: the bitmaps are then cleared and the used
+    /// addresses are learned again.
+    ///
+    /// Only pools of at most @ref MAX_BITMAP_SIZE addresses get a bitmap.
+    /// Subnets with larger pools, and prefix pools, are handled the same way
+    /// as by IterativeAllocator.
+    class BitmapAllocator : public IterativeAllocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief The largest pool (in addresses) that gets a bitmap.
+        static const uint64_t MAX_BITMAP_SIZE = 1 << 24;
+
+        /// @brief default constructor
+        ///
         /// @param type - specifies allocation type
-        HashedAllocator(Lease::Type type);
+        BitmapAllocator(Lease::Type type);
+
+        /// @brief returns an address from pools of a subnet that is not
+        /// known to be in use
+        ///
+        /// @param subnet next address will be returned from pool of that subnet
+        /// @param duid Client's DUID (ignored)
+        /// @param hint client's hint (ignored)
+        /// @return the next address not known to be in use
+        virtual bundy::asiolink::IOAddress
+            pickAddress(const SubnetPtr& subnet,
+                        const DuidPtr& duid,
+                        const bundy::asiolink::IOAddress& hint);
+
+        /// @brief marks an address as used in the bitmap of its pool
+        ///
+        /// @param addr address that is in use
+        virtual void addressUsed(const bundy::asiolink::IOAddress& addr);
 
-        /// @brief returns an address based on hash calculated from client's DUID.
+        /// @brief marks an address as free in the bitmap of its pool
         ///
-        /// @todo: Implement this method
+        /// @param addr address that is no longer used
+        virtual void addressFreed(const bundy::asiolink::IOAddress& addr);
+
+    private:
+
+        /// @brief bitmap of the used addresses in a pool
+        struct PoolBitmap;
+
+        /// @brief pointer to a pool bitmap
+        typedef boost::shared_ptr<PoolBitmap> PoolBitmapPtr;
+
+        /// @brief returns the bitmap of a pool, creating it if necessary
+        ///
+        /// @param pool the pool
+        /// @return the bitmap, or NULL if the pool is too large for a bitmap
+        PoolBitmap* getBitmap(const Pool& pool);
+
+        /// @brief returns the bitmap covering an address
+        ///
+        /// @param addr the address
+        /// @return the bitmap, or NULL if there is none for the address
+        PoolBitmap* findBitmap(const bundy::asiolink::IOAddress& addr) const;
+
+        /// @brief bitmaps of the pools, indexed by their first address
+        std::map<bundy::asiolink::IOAddress, PoolBitmapPtr> bitmaps_;
+    };
+
+    /// @brief Base class of the allocators that probe a sequence of addresses
+    ///
+    /// The resources (addresses or prefixes) of all pools of a subnet are
+    /// numbered as if the pools were concatenated. A derived class chooses
+    /// where a sequence starts; the sequence then visits every resource
+    /// once, with a step that is coprime to the number of resources.
+    ///
+    /// The engine tells the allocator when a picked address turns out to be
+    /// used (see addressUsed()). The next pickAddress() call then continues
+    /// the sequence of the previous one, if the derived class agrees (see
+    /// continueProbing()); otherwise it starts a new sequence.
+    ///
+    /// Pools larger than 2^64 / (number of pools) resources are handled as
+    /// if they were that large, so their last resources are never picked.
+    class ProbingAllocator : public Allocator {
+    public:
+
+        /// @brief returns the next address of the probe sequence
         ///
         /// @param subnet an address will be picked from pool of that subnet
-        /// @param duid Client's DUID
-        /// @param hint a hint (last address that was picked)
+        /// @param duid Client's DUID or client identifier (may be NULL)
+        /// @param hint client's hint (ignored)
         /// @return selected address
-        virtual bundy::asiolink::IOAddress pickAddress(const SubnetPtr& subnet,
-                                                     const DuidPtr& duid,
-                                                     const bundy::asiolink::IOAddress& hint);
+        virtual bundy::asiolink::IOAddress
+        pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
+                    const bundy::asiolink::IOAddress& hint);
+
+        /// @brief remembers that the last picked address is used
+        ///
+        /// @param addr address that is in use
+        virtual void addressUsed(const bundy::asiolink::IOAddress& addr);
+
+    protected:
+
+        /// @brief constructor
+        ///
+        /// @param type - specifies allocation type
+        ProbingAllocator(Lease::Type type);
+
+        /// @brief chooses the beginning of a new probe sequence
+        ///
+        /// @param duid Client's DUID or client identifier (may be NULL)
+        /// @param total the number of resources in the pools
+        /// @param[out] start the index of the first resource to pick
+        /// @param[out] step the distance between two picked resources
+        /// (any value; it is made coprime to @c total)
+        virtual void startProbing(const DuidPtr& duid, uint64_t total,
+                                  uint64_t& start, uint64_t& step) = 0;
+
+        /// @brief tells whether a sequence should be continued
+        ///
+        /// This is only called if the last picked address has been found
+        /// used and the number of resources hasn't changed since.
+        ///
+        /// @param same_client whether the client is the same as for the
+        /// last pick
+        /// @param probes the number of addresses picked in the sequence
+        /// @return true to pick the next address of the sequence, false to
+        /// start a new sequence
+        virtual bool continueProbing(bool same_client,
+                                     unsigned int probes) const = 0;
+
+    private:
+
+        /// @brief the last picked address
+        bundy::asiolink::IOAddress last_addr_;
+
+        /// @brief whether the last picked address has been found used
+        bool last_used_;
+
+        /// @brief the client identifier of the last pick
+        std::vector<uint8_t> last_client_;
+
+        /// @brief the number of resources in the pools at the last pick
+        uint64_t total_;
+
+        /// @brief the index of the last picked resource
+        uint64_t index_;
+
+        /// @brief the step of the current sequence
+        uint64_t step_;
+
+        /// @brief the number of addresses picked in the current sequence
+        unsigned int probes_;
+    };
+
+    /// @brief Address/prefix allocator that gets an address based on a hash
+    ///
+    /// The probe sequence starts at a resource derived from a hash of the
+    /// client's DUID (or client identifier), so a returning client gets the
+    /// same address as long as it's free and the pools haven't changed. The
+    /// step of the sequence is derived from another hash of it, so clients
+    /// whose preferred addresses collide don't keep colliding. A client
+    /// that doesn't provide an identifier gets a random sequence.
+    class HashedAllocator : public ProbingAllocator {
+    public:
+
+        /// @brief default constructor
+        /// @param type - specifies allocation type
+        HashedAllocator(Lease::Type type);
+
+    protected:
+
+        /// @brief starts a sequence at the hash of the client identifier
+        virtual void startProbing(const DuidPtr& duid, uint64_t total,
+                                  uint64_t& start, uint64_t& step);
+
+        /// @brief continues the sequence for the same client
+        virtual bool continueProbing(bool same_client,
+                                     unsigned int probes) const;
+
+    private:
+
+        /// @brief the generator for clients without an identifier
+        boost::mt19937_64 rng_;
     };
 
     /// @brief Random allocator that picks address randomly
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
-    class RandomAllocator : public Allocator {
+    /// A probe sequence starts at a random resource with a random step. If
+    /// the picked addresses keep turning out to be used, the sequence is
+    /// abandoned after @ref MAX_PROBES addresses and a new one is started,
+    /// so a run of used addresses doesn't cost more than that many lookups
+    /// in a row.
+    class RandomAllocator : public ProbingAllocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief The maximum number of addresses picked in a sequence.
+        static const unsigned int MAX_PROBES = 8;
+
+        /// @brief default constructor
+        ///
+        /// The random number generator is seeded from /dev/urandom.
+        ///
         /// @param type - specifies allocation type
         RandomAllocator(Lease::Type type);
 
-        /// @brief returns an random address from pool of specified subnet
+        /// @brief constructor with a given seed
         ///
-        /// @todo: Implement this method
+        /// The allocator picks the same addresses every time it's created
+        /// with the same seed, which is useful for tests.
         ///
-        /// @param subnet an address will be picked from pool of that subnet
-        /// @param duid Client's DUID (ignored)
-        /// @param hint the last address that was picked (ignored)
-        /// @return a random address from the pool
-        virtual bundy::asiolink::IOAddress
-        pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
-                    const bundy::asiolink::IOAddress& hint);
+        /// @param type - specifies allocation type
+        /// @param seed - seed of the random number generator
+        RandomAllocator(Lease::Type type, uint64_t seed);
+
+    protected:
+
+        /// @brief starts a sequence at a random resource
+        virtual void startProbing(const DuidPtr& duid, uint64_t total,
+                                  uint64_t& start, uint64_t& step);
+
+        /// @brief continues the sequence for at most MAX_PROBES addresses
+        virtual bool continueProbing(bool same_client,
+                                     unsigned int probes) const;
+
+    private:
+
+        /// @brief the random number generator
+        boost::mt19937_64 rng_;
     };
 
     public:
@@ -211,7 +427,8 @@ protected:
     typedef enum {
         ALLOC_ITERATIVE, // iterative - one address after another
         ALLOC_HASHED,    // hashed - client's DUID/client-id is hashed
-        ALLOC_RANDOM     // random - an address is randomly selected
+        ALLOC_RANDOM,    // random - an address is randomly selected
+        ALLOC_BITMAP     // bitmap - the first address not known to be used
     } AllocType;
 
 
@@ -228,6 +445,21 @@ protected:
     /// @param ipv6 specifies if the engine should work for IPv4 or IPv6
     AllocEngine(AllocType engine_type, unsigned int attempts, bool ipv6 = true);
 
+    /// @brief Converts the name of an allocation algorithm to its type.
+    ///
+    /// The names are the ones used in the server configuration:
+    /// "iterative", "hashed", "random" and "bitmap".
+    ///
+    /// @param name name of the allocation algorithm
+    /// @return the allocation type
+    /// @throw BadValue if the name is not known
+    static AllocType allocTypeFromText(const std::string& name);
+
+    /// @brief Returns the allocation algorithm used by this engine.
+    AllocType getAllocType() const {
+        return (alloc_type_);
+    }
+
     /// @brief Returns IPv4 lease.
     ///
     /// This method finds the appropriate lease for the client using the
@@ -354,6 +586,16 @@ protected:
                     const bundy::hooks::CalloutHandlePtr& callout_handle,
                     Lease6Collection& old_leases);
 
+    /// @brief Informs the engine that a lease has been removed
+    ///
+    /// This method should be called when a lease is removed from the lease
+    /// database other than by the engine itself (e.g. when a client releases
+    /// it), so the allocator can hand out the address again.
+    ///
+    /// @param type type of the lease (V4, IA, TA or PD)
+    /// @param addr address (or prefix) of the removed lease
+    void leaseRemoved(Lease::Type type, const bundy::asiolink::IOAddress& addr);
+
     /// @brief returns allocator for a given pool type
     /// @param type type of pool (V4, IA, TA or PD)
     /// @throw BadValue if allocator for a given type is missing
@@ -524,6 +766,9 @@ private:
     /// For IPv6, there will be 3 allocators: TYPE_NA, TYPE_TA, TYPE_PD
     std::map<Lease::Type, AllocatorPtr> allocators_;
 
+    /// @brief allocation algorithm used by the allocators
+    AllocType alloc_type_;
+
     /// @brief number of attempts before we give up lease allocation (0=unlimited)
     unsigned int attempts_;
 
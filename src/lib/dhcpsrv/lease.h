@@ -141,6 +141,13 @@ struct Lease {
     /// @return true if the lease is expired
     bool expired() const;
 
+    /// @brief returns the time when the lease expires
+    ///
+    /// @return cltt_ + valid_lft_ (as a 64-bit value to avoid overflows)
+    int64_t getExpirationTime() const {
+        return (static_cast<int64_t>(cltt_) + valid_lft_);
+    }
+
     /// @brief Returns true if the other lease has equal FQDN data.
     ///
     /// @param other Lease which FQDN data is to be compared with our lease.
@@ -0,0 +1,646 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcp/duid.h>
+#include <dhcp/hwaddr.h>
+#include <dhcpsrv/csv_lease_file4.h>
+#include <dhcpsrv/csv_lease_file6.h>
+#include <dhcpsrv/lease_file_loader.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace bundy::asiolink;
+using namespace bundy::dhcp;
+using namespace bundy::util::thread;
+
+namespace {
+
+/// @brief The lease file mapped into memory.
+class MappedFile : boost::noncopyable {
+public:
+    /// @brief Constructor, maps the file.
+    ///
+    /// @throw bundy::dhcp::DbOperationError if the file can't be mapped.
+    MappedFile(const std::string& file_name) : data_(NULL), size_(0) {
+        const int fd = open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            bundy_throw(DbOperationError, "failed to open lease file '"
+                        << file_name << "': " << strerror(errno));
+        }
+        struct stat buf;
+        if (fstat(fd, &buf) != 0) {
+            const int error = errno;
+            close(fd);
+            bundy_throw(DbOperationError, "failed to get the size of lease "
+                        "file '" << file_name << "': " << strerror(error));
+        }
+        size_ = buf.st_size;
+        if (size_ > 0) {
+            void* data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                const int error = errno;
+                close(fd);
+                bundy_throw(DbOperationError, "failed to map lease file '"
+                            << file_name << "': " << strerror(error));
+            }
+            data_ = static_cast<const char*>(data);
+            madvise(data, size_, MADV_SEQUENTIAL);
+        }
+        // The mapping remains valid when the file is closed.
+        close(fd);
+    }
+
+    /// @brief Destructor, unmaps the file.
+    ~MappedFile() {
+        if (data_ != NULL) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    const char* begin() const {
+        return (data_);
+    }
+
+    const char* end() const {
+        return (data_ + size_);
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+/// @brief A value of the row, pointing to the mapped file.
+struct Field {
+    const char* data;
+    size_t len;
+};
+
+/// @brief Splits the row into values.
+///
+/// @param begin Beginning of the row.
+/// @param end End of the row, excluding the new line character.
+/// @param [out] fields The values of the row.
+/// @param columns The number of columns of the lease file.
+///
+/// @throw bundy::BadValue if the number of values doesn't match the number
+/// of columns.
+void
+splitRow(const char* begin, const char* end, Field* fields, size_t columns) {
+    size_t count = 0;
+    const char* value = begin;
+    for (const char* c = begin; ; ++c) {
+        if ((c == end) || (*c == ',')) {
+            if (count < columns) {
+                fields[count].data = value;
+                fields[count].len = c - value;
+            }
+            ++count;
+            value = c + 1;
+            if (c == end) {
+                break;
+            }
+        }
+    }
+    if (count != columns) {
+        bundy_throw(bundy::BadValue, "the size of the row '"
+                    << std::string(begin, end) << "' doesn't match the number"
+                    " of columns '" << columns << "'");
+    }
+}
+
+/// @brief Parses a non-negative decimal integer value.
+///
+/// @throw bundy::BadValue if the value is invalid or out of range.
+uint32_t
+parseUint32(const Field& field, const char* name) {
+    if ((field.len == 0) || (field.len > 10)) {
+        bundy_throw(bundy::BadValue, "invalid " << name << " '"
+                    << std::string(field.data, field.len) << "'");
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < field.len; ++i) {
+        const char c = field.data[i];
+        if ((c < '0') || (c > '9')) {
+            bundy_throw(bundy::BadValue, "invalid " << name << " '"
+                        << std::string(field.data, field.len) << "'");
+        }
+        value = value * 10 + (c - '0');
+    }
+    if (value > 0xffffffffULL) {
+        bundy_throw(bundy::BadValue, name << " '"
+                    << std::string(field.data, field.len)
+                    << "' is out of range");
+    }
+    return (static_cast<uint32_t>(value));
+}
+
+/// @brief Parses a boolean value, written as 0 or 1.
+///
+/// @throw bundy::BadValue if the value is invalid.
+bool
+parseBool(const Field& field, const char* name) {
+    if ((field.len != 1) || ((field.data[0] != '0') &&
+                             (field.data[0] != '1'))) {
+        bundy_throw(bundy::BadValue, "invalid " << name << " '"
+                    << std::string(field.data, field.len) << "'");
+    }
+    return (field.data[0] == '1');
+}
+
+/// @brief Returns the value of a hexadecimal digit, or -1 if invalid.
+int
+hexDigit(const char c) {
+    if ((c >= '0') && (c <= '9')) {
+        return (c - '0');
+    } else if ((c >= 'a') && (c <= 'f')) {
+        return (c - 'a' + 10);
+    } else if ((c >= 'A') && (c <= 'F')) {
+        return (c - 'A' + 10);
+    }
+    return (-1);
+}
+
+/// @brief Parses the colon separated hexadecimal bytes.
+///
+/// Each byte is written with one or two digits. An empty value is parsed
+/// as no bytes.
+///
+/// @param field The value.
+/// @param name Name of the value, used in the error messages.
+/// @param [out] buf Buffer the bytes are written to.
+/// @param buf_len Size of the buffer.
+///
+/// @return The number of bytes.
+///
+/// @throw bundy::BadValue if the value is invalid or too long.
+size_t
+parseHex(const Field& field, const char* name, uint8_t* buf, size_t buf_len) {
+    size_t len = 0;
+    size_t pos = 0;
+    while (pos < field.len) {
+        if (len == buf_len) {
+            bundy_throw(bundy::BadValue, name << " '"
+                        << std::string(field.data, field.len)
+                        << "' is too long");
+        }
+        int value = 0;
+        size_t digits = 0;
+        for (; (pos < field.len) && (field.data[pos] != ':'); ++pos) {
+            const int digit = hexDigit(field.data[pos]);
+            if ((digit < 0) || (++digits > 2)) {
+                bundy_throw(bundy::BadValue, "invalid " << name << " '"
+                            << std::string(field.data, field.len) << "'");
+            }
+            value = (value << 4) | digit;
+        }
+        // Two consecutive colons, or a colon at either end, are not allowed.
+        if ((digits == 0) ||
+            ((pos < field.len) && (pos + 1 == field.len))) {
+            bundy_throw(bundy::BadValue, "invalid " << name << " '"
+                        << std::string(field.data, field.len) << "': tokens"
+                        " must be separated with a single colon");
+        }
+        buf[len++] = static_cast<uint8_t>(value);
+        // Skip the colon.
+        ++pos;
+    }
+    return (len);
+}
+
+/// @brief Parses an IPv4 or IPv6 address.
+///
+/// @throw bundy::BadValue if the value is not a valid address of the
+/// specified family.
+IOAddress
+parseAddress(const Field& field, const int family) {
+    char text[INET6_ADDRSTRLEN];
+    uint8_t bytes[16];
+    if (field.len < sizeof(text)) {
+        memcpy(text, field.data, field.len);
+        text[field.len] = '\0';
+    }
+    if ((field.len >= sizeof(text)) || (inet_pton(family, text, bytes) != 1)) {
+        bundy_throw(bundy::BadValue, "invalid address '"
+                    << std::string(field.data, field.len) << "'");
+    }
+    if (family == AF_INET) {
+        uint32_t addr;
+        memcpy(&addr, bytes, sizeof(addr));
+        return (IOAddress(ntohl(addr)));
+    }
+    asio::ip::address_v6::bytes_type bytes6;
+    memcpy(&bytes6[0], bytes, sizeof(bytes));
+    return (IOAddress(asio::ip::address(asio::ip::address_v6(bytes6))));
+}
+
+/// @brief Parses the rows of the DHCPv4 lease file.
+///
+/// The columns are in the order defined by @c CSVLeaseFile4.
+struct Lease4RowParser {
+    typedef CSVLeaseFile4 LeaseFileType;
+    typedef Lease4Ptr LeasePtrType;
+
+    static const size_t COLUMNS = 9;
+
+    static Lease4Ptr parse(const Field* fields) {
+        const IOAddress addr = parseAddress(fields[0], AF_INET);
+
+        uint8_t hwaddr[HWAddr::MAX_HWADDR_LEN];
+        const size_t hwaddr_len = parseHex(fields[1], "hwaddr", hwaddr,
+                                           sizeof(hwaddr));
+        if (hwaddr_len == 0) {
+            bundy_throw(bundy::BadValue, "hardware address in the lease file"
+                        " must not be empty");
+        }
+        // NULL client ids are allowed in DHCPv4.
+        uint8_t client_id[ClientId::MAX_CLIENT_ID_LEN];
+        const size_t client_id_len = parseHex(fields[2], "client_id",
+                                              client_id, sizeof(client_id));
+
+        const uint32_t valid = parseUint32(fields[3], "valid_lifetime");
+        const uint32_t expire = parseUint32(fields[4], "expire");
+        return (Lease4Ptr(new Lease4(addr, hwaddr, hwaddr_len,
+                                     client_id_len > 0 ? client_id : NULL,
+                                     client_id_len, valid,
+                                     0, 0, // t1, t2 = 0
+                                     static_cast<uint32_t>(expire - valid),
+                                     parseUint32(fields[5], "subnet_id"),
+                                     parseBool(fields[6], "fqdn_fwd"),
+                                     parseBool(fields[7], "fqdn_rev"),
+                                     std::string(fields[8].data,
+                                                 fields[8].len))));
+    }
+};
+
+/// @brief Parses the rows of the DHCPv6 lease file.
+///
+/// The columns are in the order defined by @c CSVLeaseFile6.
+struct Lease6RowParser {
+    typedef CSVLeaseFile6 LeaseFileType;
+    typedef Lease6Ptr LeasePtrType;
+
+    static const size_t COLUMNS = 12;
+
+    static Lease6Ptr parse(const Field* fields) {
+        const IOAddress addr = parseAddress(fields[0], AF_INET6);
+
+        uint8_t duid[DUID::MAX_DUID_LEN];
+        const size_t duid_len = parseHex(fields[1], "duid", duid,
+                                         sizeof(duid));
+
+        const uint32_t valid = parseUint32(fields[2], "valid_lifetime");
+        const uint32_t expire = parseUint32(fields[3], "expire");
+        const uint32_t type = parseUint32(fields[6], "lease_type");
+        if (type > Lease::TYPE_PD) {
+            bundy_throw(bundy::BadValue, "invalid lease_type '" << type
+                        << "'");
+        }
+        const uint32_t prefix_len = parseUint32(fields[8], "prefix_len");
+        if (prefix_len > 128) {
+            bundy_throw(bundy::BadValue, "invalid prefix_len '" << prefix_len
+                        << "'");
+        }
+        Lease6Ptr lease(new Lease6(static_cast<Lease::Type>(type), addr,
+                                   DuidPtr(new DUID(duid, duid_len)),
+                                   parseUint32(fields[7], "iaid"),
+                                   parseUint32(fields[5], "pref_lifetime"),
+                                   valid,
+                                   0, 0, // t1, t2 = 0
+                                   parseUint32(fields[4], "subnet_id"),
+                                   static_cast<uint8_t>(prefix_len)));
+        lease->cltt_ = static_cast<uint32_t>(expire - valid);
+        lease->fqdn_fwd_ = parseBool(fields[9], "fqdn_fwd");
+        lease->fqdn_rev_ = parseBool(fields[10], "fqdn_rev");
+        lease->hostname_.assign(fields[11].data, fields[11].len);
+        return (lease);
+    }
+};
+
+/// @brief A chunk of rows of the lease file, parsed by a single thread.
+template<typename RowParser>
+struct Chunk {
+    Chunk(const char* begin, const char* end) :
+        begin_(begin), end_(end), rows_(0), parsed_(false)
+    {}
+
+    /// @brief Parses the rows of the chunk.
+    ///
+    /// It stops on the first invalid row and records the error. The number
+    /// of rows parsed correctly is recorded in @c rows_.
+    void parse() {
+        Field fields[RowParser::COLUMNS];
+        const char* row = begin_;
+        try {
+            while (row != end_) {
+                const char* row_end = static_cast<const char*>(
+                    memchr(row, '\n', end_ - row));
+                const char* next = row_end ? row_end + 1 : end_;
+                if (row_end == NULL) {
+                    row_end = end_;
+                }
+                splitRow(row, row_end, fields, RowParser::COLUMNS);
+                leases_.push_back(RowParser::parse(fields));
+                ++rows_;
+                row = next;
+            }
+        } catch (const std::exception& ex) {
+            error_ = ex.what();
+        }
+    }
+
+    const char* begin_;
+    const char* end_;
+    std::vector<typename RowParser::LeasePtrType> leases_;
+    size_t rows_;
+    std::string error_;
+
+    /// @brief Whether the chunk has been parsed, protected by the mutex of
+    /// the @c ChunkQueue.
+    bool parsed_;
+};
+
+/// @brief Hands the chunks of the lease file to the parser threads.
+///
+/// The chunks are parsed in the order of the file. A parser thread doesn't
+/// start a chunk more than @c window chunks ahead of the first chunk that
+/// hasn't been merged yet, so only a bounded number of parsed leases is
+/// held in memory, whatever the size of the file.
+template<typename RowParser>
+class ChunkQueue : boost::noncopyable {
+public:
+    typedef Chunk<RowParser> ChunkType;
+
+    ChunkQueue(const std::vector<boost::shared_ptr<ChunkType> >& chunks,
+               const size_t window) :
+        chunks_(chunks), window_(window), next_(0), merged_(0),
+        stopped_(false)
+    {}
+
+    /// @brief Main function of a parser thread.
+    void run() {
+        while (true) {
+            ChunkType* chunk = NULL;
+            {
+                Mutex::Locker locker(mutex_);
+                while (!stopped_ && (next_ < chunks_.size()) &&
+                       (next_ >= merged_ + window_)) {
+                    window_cond_.wait(mutex_);
+                }
+                if (stopped_ || (next_ == chunks_.size())) {
+                    return;
+                }
+                chunk = chunks_[next_++].get();
+            }
+            chunk->parse();
+            Mutex::Locker locker(mutex_);
+            chunk->parsed_ = true;
+            // Only the merging thread waits for this condition.
+            parsed_cond_.signal();
+        }
+    }
+
+    /// @brief Waits until the chunk is parsed.
+    void waitParsed(const ChunkType& chunk) {
+        Mutex::Locker locker(mutex_);
+        while (!chunk.parsed_) {
+            parsed_cond_.wait(mutex_);
+        }
+    }
+
+    /// @brief Records that the chunks up to the given one are merged, so
+    /// another chunk may be parsed.
+    void setMerged(const size_t index) {
+        Mutex::Locker locker(mutex_);
+        merged_ = index + 1;
+        window_cond_.signal();
+    }
+
+    /// @brief Makes the parser threads exit without parsing more chunks.
+    ///
+    /// @param threads Number of the parser threads.
+    void stop(const size_t threads) {
+        Mutex::Locker locker(mutex_);
+        stopped_ = true;
+        for (size_t i = 0; i < threads; ++i) {
+            window_cond_.signal();
+        }
+    }
+
+private:
+    const std::vector<boost::shared_ptr<ChunkType> >& chunks_;
+    const size_t window_;
+    Mutex mutex_;
+    CondVar window_cond_;
+    CondVar parsed_cond_;
+    size_t next_;
+    size_t merged_;
+    bool stopped_;
+};
+
+/// @brief Returns the header of the lease file.
+template<typename LeaseFileType>
+std::string
+getHeader() {
+    const LeaseFileType lease_file("");
+    std::string header;
+    for (size_t i = 0; i < lease_file.getColumnCount(); ++i) {
+        if (i > 0) {
+            header += ',';
+        }
+        header += lease_file.getColumnName(i);
+    }
+    return (header);
+}
+
+/// @brief Waits for the parser threads, ignoring their errors.
+void
+waitThreads(std::vector<boost::shared_ptr<Thread> >& threads) {
+    for (size_t i = 0; i < threads.size(); ++i) {
+        try {
+            threads[i]->wait();
+        } catch (...) {
+            // The chunk parser doesn't throw, there is nothing to report.
+        }
+    }
+}
+
+/// @brief Loads the leases from the lease file.
+///
+/// See @c LeaseFileLoader for the description.
+template<typename RowParser>
+void
+loadLeases(const std::string& file_name, const size_t max_threads,
+           const size_t min_chunk_size,
+           const boost::function<void(typename RowParser::LeasePtrType&)>&
+           handler) {
+    const MappedFile file(file_name);
+    if (file.begin() == file.end()) {
+        return;
+    }
+
+    // Check the header, as the values are parsed in the order of the
+    // columns.
+    const std::string header = getHeader<typename RowParser::LeaseFileType>();
+    const char* header_end = static_cast<const char*>(
+        memchr(file.begin(), '\n', file.end() - file.begin()));
+    if ((header_end == NULL) ||
+        (static_cast<size_t>(header_end - file.begin()) != header.size()) ||
+        (memcmp(file.begin(), header.data(), header.size()) != 0)) {
+        bundy_throw(DbOperationError, "invalid header in lease file '"
+                    << file_name << "'");
+    }
+
+    // Split the rows into chunks of at least min_chunk_size bytes, each
+    // ending at the end of a row.
+    const size_t chunk_size = std::max(static_cast<size_t>(1),
+                                       min_chunk_size);
+    typedef Chunk<RowParser> ChunkType;
+    std::vector<boost::shared_ptr<ChunkType> > chunks;
+    for (const char* begin = header_end + 1; begin != file.end(); ) {
+        const char* end = file.end();
+        if (static_cast<size_t>(file.end() - begin) > chunk_size) {
+            const char* last = begin + chunk_size - 1;
+            end = static_cast<const char*>(memchr(last, '\n',
+                                                  file.end() - last));
+            end = end ? end + 1 : file.end();
+        }
+        chunks.push_back(boost::shared_ptr<ChunkType>(new ChunkType(begin,
+                                                                    end)));
+        begin = end;
+    }
+
+    // The chunks are parsed in separate threads and merged in this one, in
+    // the order of the file. Up to twice as many chunks as there are parser
+    // threads may be parsed ahead of the merge, so the threads don't wait
+    // for the merge of every chunk. With a single thread, this thread
+    // parses the chunks itself.
+    const size_t threads = std::min(std::max(static_cast<size_t>(1),
+                                             max_threads) - 1,
+                                    chunks.size());
+    ChunkQueue<RowParser> queue(chunks, threads * 2);
+    std::vector<boost::shared_ptr<Thread> > parsers;
+    try {
+        for (size_t i = 0; i < threads; ++i) {
+            parsers.push_back(boost::shared_ptr<Thread>(
+                new Thread(boost::bind(&ChunkQueue<RowParser>::run,
+                                       &queue))));
+        }
+        size_t line = 1;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            ChunkType& chunk = *chunks[i];
+            if (parsers.empty()) {
+                chunk.parse();
+            } else {
+                queue.waitParsed(chunk);
+            }
+            // Report the first invalid row, with its line number in the
+            // file.
+            line += chunk.rows_;
+            if (!chunk.error_.empty()) {
+                bundy_throw(DbOperationError, "failed to parse the lease in "
+                            "line " << line + 1 << " of lease file '"
+                            << file_name << "': " << chunk.error_);
+            }
+            for (size_t j = 0; j < chunk.leases_.size(); ++j) {
+                handler(chunk.leases_[j]);
+            }
+            // Release the leases of the chunk before more chunks are
+            // parsed.
+            std::vector<typename RowParser::LeasePtrType>().swap(
+                chunk.leases_);
+            queue.setMerged(i);
+        }
+    } catch (...) {
+        queue.stop(parsers.size());
+        waitThreads(parsers);
+        throw;
+    }
+    waitThreads(parsers);
+}
+
+/// @brief Appends the lease to the collection.
+template<typename LeasePtrType>
+void
+appendLease(std::vector<LeasePtrType>& leases, LeasePtrType& lease) {
+    leases.push_back(lease);
+}
+
+} // anonymous namespace
+
+namespace bundy {
+namespace dhcp {
+
+const size_t LeaseFileLoader::MIN_CHUNK_SIZE;
+
+LeaseFileLoader::LeaseFileLoader(size_t max_threads, size_t min_chunk_size)
+    : max_threads_(max_threads), min_chunk_size_(min_chunk_size) {
+    if (max_threads_ == 0) {
+        const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        max_threads_ = processors > 0 ? processors : 1;
+    }
+}
+
+void
+LeaseFileLoader::load(const std::string& file_name,
+                      const Lease4Handler& handler) const {
+    loadLeases<Lease4RowParser>(file_name, max_threads_, min_chunk_size_,
+                                handler);
+}
+
+void
+LeaseFileLoader::load(const std::string& file_name,
+                      const Lease6Handler& handler) const {
+    loadLeases<Lease6RowParser>(file_name, max_threads_, min_chunk_size_,
+                                handler);
+}
+
+void
+LeaseFileLoader::load(const std::string& file_name,
+                      Lease4Collection& leases) const {
+    Lease4Collection loaded;
+    load(file_name, Lease4Handler(boost::bind(&appendLease<Lease4Ptr>,
+                                              boost::ref(loaded), _1)));
+    leases.insert(leases.end(), loaded.begin(), loaded.end());
+}
+
+void
+LeaseFileLoader::load(const std::string& file_name,
+                      Lease6Collection& leases) const {
+    Lease6Collection loaded;
+    load(file_name, Lease6Handler(boost::bind(&appendLease<Lease6Ptr>,
+                                              boost::ref(loaded), _1)));
+    leases.insert(leases.end(), loaded.begin(), loaded.end());
+}
+
+} // end of bundy::dhcp namespace
+} // end of bundy namespace
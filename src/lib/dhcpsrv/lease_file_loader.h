@@ -0,0 +1,130 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LEASE_FILE_LOADER_H
+#define LEASE_FILE_LOADER_H
+
+#include <dhcpsrv/lease.h>
+
+#include <boost/function.hpp>
+
+#include <string>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief Loads all leases from a lease file at once.
+///
+/// This class reads the lease files in the format written by the
+/// @c CSVLeaseFile4 and @c CSVLeaseFile6 classes. Rather than reading the
+/// file row by row, it maps the whole file into memory and splits it into
+/// chunks of rows, which are parsed in separate threads. The values are
+/// parsed in place, without copying them to strings. The leases of a chunk
+/// are passed on once the earlier chunks are done and are released then,
+/// and the threads parse only a few chunks ahead, so the memory used for
+/// the parsed leases doesn't depend on the size of the file. The rows are checked
+/// at least as strictly as by the @c CSVLeaseFile4::next and
+/// @c CSVLeaseFile6::next: in addition, the addresses must belong to the
+/// family of the lease file, the numbers must not be negative and the
+/// hexadecimal values must contain valid digits only.
+///
+/// The leases are passed in the order of the rows in the file, so the
+/// caller can apply them such that the later rows update the leases read
+/// from the earlier rows.
+///
+/// Small files are parsed in a single thread, as starting the threads
+/// would take more time than parsing the rows.
+class LeaseFileLoader {
+public:
+    /// @brief Default minimal size of a chunk parsed in a separate thread.
+    static const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+    /// @brief Function called for each DHCPv4 lease read from the file.
+    typedef boost::function<void(Lease4Ptr&)> Lease4Handler;
+
+    /// @brief Function called for each DHCPv6 lease read from the file.
+    typedef boost::function<void(Lease6Ptr&)> Lease6Handler;
+
+    /// @brief Constructor.
+    ///
+    /// @param max_threads Maximal number of threads parsing the rows,
+    /// including the calling thread. If 0, the number of online processors
+    /// is used.
+    /// @param min_chunk_size Minimal size of a chunk of the file in bytes.
+    LeaseFileLoader(size_t max_threads = 0,
+                    size_t min_chunk_size = MIN_CHUNK_SIZE);
+
+    /// @brief Loads DHCPv4 leases from the lease file.
+    ///
+    /// @param file_name Name of the lease file.
+    /// @param handler Function called in the calling thread for each lease,
+    /// in the order of the rows in the file.
+    ///
+    /// @throw bundy::dhcp::DbOperationError if the file can't be read or
+    /// it contains an invalid row. The handler has been called for the
+    /// leases of the rows preceding the invalid row in such case. The
+    /// exceptions thrown by the handler are propagated.
+    void load(const std::string& file_name,
+              const Lease4Handler& handler) const;
+
+    /// @brief Loads DHCPv6 leases from the lease file.
+    ///
+    /// @param file_name Name of the lease file.
+    /// @param handler Function called in the calling thread for each lease,
+    /// in the order of the rows in the file.
+    ///
+    /// @throw bundy::dhcp::DbOperationError if the file can't be read or
+    /// it contains an invalid row. The handler has been called for the
+    /// leases of the rows preceding the invalid row in such case. The
+    /// exceptions thrown by the handler are propagated.
+    void load(const std::string& file_name,
+              const Lease6Handler& handler) const;
+
+    /// @brief Loads DHCPv4 leases from the lease file.
+    ///
+    /// @param file_name Name of the lease file.
+    /// @param [out] leases Collection the leases are appended to, in the
+    /// order of the rows in the file.
+    ///
+    /// @throw bundy::dhcp::DbOperationError if the file can't be read or
+    /// it contains an invalid row. No leases are appended in such case.
+    void load(const std::string& file_name, Lease4Collection& leases) const;
+
+    /// @brief Loads DHCPv6 leases from the lease file.
+    ///
+    /// @param file_name Name of the lease file.
+    /// @param [out] leases Collection the leases are appended to, in the
+    /// order of the rows in the file.
+    ///
+    /// @throw bundy::dhcp::DbOperationError if the file can't be read or
+    /// it contains an invalid row. No leases are appended in such case.
+    void load(const std::string& file_name, Lease6Collection& leases) const;
+
+    /// @brief Returns the maximal number of threads parsing the rows.
+    size_t getMaxThreads() const {
+        return (max_threads_);
+    }
+
+private:
+    /// @brief Maximal number of threads parsing the rows.
+    size_t max_threads_;
+
+    /// @brief Minimal size of a chunk of the file.
+    size_t min_chunk_size_;
+};
+
+} // end of bundy::dhcp namespace
+} // end of bundy namespace
+
+#endif // LEASE_FILE_LOADER_H
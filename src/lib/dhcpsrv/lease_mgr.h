@@ -298,6 +298,31 @@ public:
     Lease6Ptr getLease6(Lease::Type type, const DUID& duid,
                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns a collection of expired DHCPv4 leases.
+    ///
+    /// The leases are returned in the order of their expiration time,
+    /// the ones which expired first come first.  This is intended for the
+    /// reclamation of expired leases: as a backend is expected to index
+    /// the leases by the expiration time, the cost of a call depends on
+    /// the number of returned leases rather than on the size of the
+    /// database.
+    ///
+    /// @param max_leases Maximum number of leases to be returned.  The
+    /// value of 0 means that all expired leases are returned.
+    ///
+    /// @return Lease collection (may be empty if no lease has expired)
+    virtual Lease4Collection getExpiredLeases4(size_t max_leases) const = 0;
+
+    /// @brief Returns a collection of expired DHCPv6 leases.
+    ///
+    /// See @c getExpiredLeases4 for details.
+    ///
+    /// @param max_leases Maximum number of leases to be returned.  The
+    /// value of 0 means that all expired leases are returned.
+    ///
+    /// @return Lease collection (may be empty if no lease has expired)
+    virtual Lease6Collection getExpiredLeases6(size_t max_leases) const = 0;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @param lease4 The lease to be updated.
@@ -14,20 +14,298 @@
 
 #include <dhcpsrv/cfgmgr.h>
 #include <dhcpsrv/dhcpsrv_log.h>
+#include <dhcpsrv/lease_file_loader.h>
 #include <dhcpsrv/memfile_lease_mgr.h>
 #include <exceptions/exceptions.h>
-
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace bundy::dhcp;
+using namespace bundy::util::thread;
+
+namespace {
+
+/// @brief Checks if the file exists.
+bool
+fileExists(const std::string& file_name) {
+    struct stat buf;
+    return (stat(file_name.c_str(), &buf) == 0);
+}
+
+/// @brief Removes the file, if it exists.
+///
+/// @throw bundy::dhcp::DbOperationError if the file can't be removed.
+void
+removeFile(const std::string& file_name) {
+    if ((unlink(file_name.c_str()) != 0) && (errno != ENOENT)) {
+        bundy_throw(DbOperationError, "failed to remove lease file '"
+                    << file_name << "': " << strerror(errno));
+    }
+}
+
+/// @brief Renames the file, replacing the target file if it exists.
+///
+/// @throw bundy::dhcp::DbOperationError if the file can't be renamed.
+void
+renameFile(const std::string& from, const std::string& to) {
+    if (rename(from.c_str(), to.c_str()) != 0) {
+        bundy_throw(DbOperationError, "failed to rename lease file '"
+                    << from << "' to '" << to << "': " << strerror(errno));
+    }
+}
+
+/// @brief Writes the content of the file to the disk.
+///
+/// @throw bundy::dhcp::DbOperationError if the file can't be synchronized.
+void
+syncFile(const std::string& file_name) {
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    if ((fd < 0) || (fsync(fd) != 0)) {
+        const int error = errno;
+        if (fd >= 0) {
+            close(fd);
+        }
+        bundy_throw(DbOperationError, "failed to synchronize lease file '"
+                    << file_name << "': " << strerror(error));
+    }
+    close(fd);
+}
+
+/// @brief Replaces the previous lease file with the finish file of the LFC.
+///
+/// The input file is removed too, as the leases from it are in the finish
+/// file. This can be safely repeated if it is interrupted, as long as the
+/// finish file exists.
+///
+/// @param lease_file Name of the current lease file.
+void
+lfcReplacePrevious(const std::string& lease_file) {
+    removeFile(Memfile_LeaseMgr::appendSuffix(lease_file,
+                                              Memfile_LeaseMgr::FILE_PREVIOUS));
+    removeFile(Memfile_LeaseMgr::appendSuffix(lease_file,
+                                              Memfile_LeaseMgr::FILE_INPUT));
+    renameFile(Memfile_LeaseMgr::appendSuffix(lease_file,
+                                              Memfile_LeaseMgr::FILE_FINISH),
+               Memfile_LeaseMgr::appendSuffix(lease_file,
+                                              Memfile_LeaseMgr::FILE_PREVIOUS));
+}
+
+/// @brief Cleans up after the LFC which has been interrupted.
+///
+/// If the finish file exists, the LFC is completed. An output file which
+/// may not have been completely written is removed.
+///
+/// @param lease_file Name of the current lease file.
+void
+lfcRecover(const std::string& lease_file) {
+    if (fileExists(Memfile_LeaseMgr::appendSuffix(lease_file,
+                                                  Memfile_LeaseMgr::FILE_FINISH))) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_RECOVER_FINISH)
+            .arg(lease_file);
+        lfcReplacePrevious(lease_file);
+    }
+    const std::string output =
+        Memfile_LeaseMgr::appendSuffix(lease_file, Memfile_LeaseMgr::FILE_OUTPUT);
+    if (fileExists(output)) {
+        LOG_WARN(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_RECOVER_OUTPUT)
+            .arg(output);
+        removeFile(output);
+    }
+}
+
+/// @brief Writes the leases to a new lease file.
+///
+/// This is called by the LFC in a separate thread. The leases are not
+/// modified in the meantime, as the lease manager replaces the stored
+/// leases rather than modifying them.
+///
+/// @param file_name Name of the lease file to be created.
+/// @param leases The leases to be written.
+///
+/// @return The number of leases written.
+template<typename LeaseFileType, typename LeasePtrType>
+size_t
+writeLeaseFile(const std::string& file_name,
+               const std::vector<LeasePtrType>& leases) {
+    LeaseFileType lease_file(file_name);
+    lease_file.recreate();
+    for (typename std::vector<LeasePtrType>::const_iterator lease =
+             leases.begin(); lease != leases.end(); ++lease) {
+        lease_file.append(**lease);
+    }
+    lease_file.close();
+    syncFile(file_name);
+    return (leases.size());
+}
+
+/// @brief Prepares the LFC of the lease file.
+///
+/// The current lease file is moved to the input file and a new current
+/// lease file is created, unless the input file of the previous LFC
+/// still exists. In that case the current file is left as is: its leases
+/// are also held in memory, so they are written by this LFC too, but the
+/// file itself is compacted by the next one.
+///
+/// @param lease_file The current lease file.
+/// @param storage The leases held in memory.
+///
+/// @return Function which writes the leases held in memory to the file
+/// given as an argument.
+template<typename LeaseFileType, typename StorageType>
+boost::function<size_t(const std::string&)>
+lfcSetup(LeaseFileType& lease_file, const StorageType& storage) {
+    const std::string input =
+        Memfile_LeaseMgr::appendSuffix(lease_file.getFilename(),
+                                       Memfile_LeaseMgr::FILE_INPUT);
+    if (!fileExists(input)) {
+        lease_file.close();
+        const int result = rename(lease_file.getFilename().c_str(),
+                                  input.c_str());
+        const int error = errno;
+        // A new lease file is created if the old one has been moved.
+        lease_file.open();
+        if (result != 0) {
+            bundy_throw(DbOperationError, "failed to rename lease file '"
+                        << lease_file.getFilename() << "' to '" << input
+                        << "': " << strerror(error));
+        }
+    }
+
+    typedef typename StorageType::value_type LeasePtrType;
+    const std::vector<LeasePtrType> leases(storage.begin(), storage.end());
+    return (boost::bind(&writeLeaseFile<LeaseFileType, LeasePtrType>, _1,
+                        leases));
+}
+
+/// @brief Copies expired leases from an expiration time index.
+///
+/// @param idx Index of the leases sorted by the expiration time.
+/// @param max_leases Maximum number of leases to be copied, 0 for no limit.
+/// @param [out] collection Collection the copies are appended to.
+template<typename LeaseType, typename IndexType>
+void
+getExpiredLeases(const IndexType& idx, size_t max_leases,
+                 std::vector<boost::shared_ptr<LeaseType> >& collection) {
+    const typename IndexType::const_iterator end =
+        idx.lower_bound(static_cast<int64_t>(time(NULL)));
+    for (typename IndexType::const_iterator lease = idx.begin();
+         lease != end && (max_leases == 0 || collection.size() < max_leases);
+         ++lease) {
+        collection.push_back(boost::shared_ptr<LeaseType>(
+                                 new LeaseType(**lease)));
+    }
+}
+
+}; // anonymous namespace
+
+namespace bundy {
+namespace dhcp {
+
+class Memfile_LeaseMgr::LFCRunner : boost::noncopyable {
+public:
+    /// @brief Constructor, starts the thread writing the leases.
+    ///
+    /// @param lease_file Name of the current lease file.
+    /// @param write Function writing the leases to the given file.
+    LFCRunner(const std::string& lease_file,
+              const boost::function<size_t(const std::string&)>& write) :
+        lease_file_(lease_file), write_(write), leases_(0), done_(false)
+    {
+        thread_.reset(new Thread(boost::bind(&LFCRunner::run, this)));
+    }
+
+    /// @brief Destructor, waits for the thread.
+    ~LFCRunner() {
+        wait();
+    }
+
+    /// @brief Waits for the thread to finish.
+    void wait() {
+        if (thread_) {
+            thread_->wait();
+            thread_.reset();
+        }
+    }
+
+    /// @brief Checks if the thread has finished.
+    bool isDone() const {
+        Mutex::Locker locker(mutex_);
+        return (done_);
+    }
+
+    /// @brief Returns the name of the current lease file.
+    const std::string& getLeaseFile() const {
+        return (lease_file_);
+    }
+
+    /// @brief Returns the number of leases written.
+    size_t getLeasesCount() const {
+        return (leases_);
+    }
+
+    /// @brief Returns the description of the error, empty if none.
+    const std::string& getError() const {
+        return (error_);
+    }
+
+private:
+    /// @brief The body of the thread.
+    ///
+    /// The output file is renamed to the finish file only after it has
+    /// been completely written and synchronized, so the leases can be
+    /// loaded from the remaining files if the server is terminated at
+    /// any time.
+    void run() {
+        try {
+            const std::string output = appendSuffix(lease_file_, FILE_OUTPUT);
+            leases_ = write_(output);
+            renameFile(output, appendSuffix(lease_file_, FILE_FINISH));
+            lfcReplacePrevious(lease_file_);
+        } catch (const std::exception& ex) {
+            error_ = ex.what();
+        }
+        Mutex::Locker locker(mutex_);
+        done_ = true;
+    }
+
+    const std::string lease_file_;
+    const boost::function<size_t(const std::string&)> write_;
+    size_t leases_;
+    std::string error_;
+    bool done_;
+    mutable Mutex mutex_;
+    boost::scoped_ptr<Thread> thread_;
+};
+
+} // end of bundy::dhcp namespace
+} // end of bundy namespace
 
 Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
-    : LeaseMgr(parameters) {
+    : LeaseMgr(parameters), lfc_interval_(0), lfc_next_time_(0) {
+    initLFCInterval();
+
     // Check the universe and use v4 file or v6 file.
     std::string universe = getParameter("universe");
     if (universe == "4") {
         std::string file4 = initLeaseFilePath(V4);
         if (!file4.empty()) {
+            lfcRecover(file4);
             lease_file4_.reset(new CSVLeaseFile4(file4));
             lease_file4_->open();
             load4();
@@ -35,6 +313,7 @@ Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
     } else {
         std::string file6 = initLeaseFilePath(V6);
         if (!file6.empty()) {
+            lfcRecover(file6);
             lease_file6_.reset(new CSVLeaseFile6(file6));
             lease_file6_->open();
             load6();
@@ -51,6 +330,7 @@ Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
 }
 
 Memfile_LeaseMgr::~Memfile_LeaseMgr() {
+    lfcWait();
     if (lease_file4_) {
         lease_file4_->close();
         lease_file4_.reset();
@@ -78,7 +358,10 @@ Memfile_LeaseMgr::addLease(const Lease4Ptr& lease) {
         lease_file4_->append(*lease);
     }
 
-    storage4_.insert(lease);
+    // Store a copy of the lease, so the caller's modifications of the lease
+    // don't affect the stored one.
+    storage4_.insert(Lease4Ptr(new Lease4(*lease)));
+    lfcCheck();
     return (true);
 }
 
@@ -99,7 +382,10 @@ Memfile_LeaseMgr::addLease(const Lease6Ptr& lease) {
         lease_file6_->append(*lease);
     }
 
-    storage6_.insert(lease);
+    // Store a copy of the lease, so the caller's modifications of the lease
+    // don't affect the stored one.
+    storage6_.insert(Lease6Ptr(new Lease6(*lease)));
+    lfcCheck();
     return (true);
 }
 
@@ -288,6 +574,30 @@ Memfile_LeaseMgr::getLeases6(Lease::Type /* not used yet */,
     return (collection);
 }
 
+Lease4Collection
+Memfile_LeaseMgr::getExpiredLeases4(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED4).arg(max_leases);
+
+    // We are going to use index #4 of the multi index container, which
+    // sorts the leases by the expiration time.
+    Lease4Collection collection;
+    getExpiredLeases<Lease4>(storage4_.get<4>(), max_leases, collection);
+    return (collection);
+}
+
+Lease6Collection
+Memfile_LeaseMgr::getExpiredLeases6(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_MEMFILE_GET_EXPIRED6).arg(max_leases);
+
+    // We are going to use index #2 of the multi index container, which
+    // sorts the leases by the expiration time.
+    Lease6Collection collection;
+    getExpiredLeases<Lease6>(storage6_.get<2>(), max_leases, collection);
+    return (collection);
+}
+
 void
 Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
     LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
@@ -306,7 +616,10 @@ Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
         lease_file4_->append(*lease);
     }
 
-    **lease_it = *lease;
+    // Replace the lease, rather than modify it in place, so the container
+    // indexes (e.g. the expiration time) are updated.
+    storage4_.replace(lease_it, Lease4Ptr(new Lease4(*lease)));
+    lfcCheck();
 }
 
 void
@@ -327,7 +640,10 @@ Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
         lease_file6_->append(*lease);
     }
 
-    **lease_it = *lease;
+    // Replace the lease, rather than modify it in place, so the container
+    // indexes (e.g. the expiration time) are updated.
+    storage6_.replace(lease_it, Lease6Ptr(new Lease6(*lease)));
+    lfcCheck();
 }
 
 bool
@@ -351,6 +667,7 @@ Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
                 lease_file4_->append(lease_copy);
             }
             storage4_.erase(l);
+            lfcCheck();
             return (true);
         }
 
@@ -372,6 +689,7 @@ Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
             }
 
             storage6_.erase(l);
+            lfcCheck();
             return (true);
         }
     }
@@ -462,36 +780,50 @@ Memfile_LeaseMgr::load4() {
         return;
     }
 
-    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_RELOAD4)
-        .arg(lease_file4_->getFilename());
-
     // Remove existing leases (if any). We will recreate them based on the
     // data on disk.
     storage4_.clear();
 
-    Lease4Ptr lease;
-    do {
-        /// @todo Currently we stop parsing on first failure. It is possible
-        /// that only one (or a few) leases are bad, so in theory we could
-        /// continue parsing but that would require some error counters to
-        /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file4_->next(lease)) {
-            bundy_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file4_->getReadMsg());
+    // Load the leases from the result of the last LFC and from the input
+    // file of the LFC which hasn't completed (if any) before the leases from
+    // the current file, so the most recent lease records are loaded last.
+    const LFCFileType lfc_files[] = { FILE_PREVIOUS, FILE_INPUT };
+    for (size_t i = 0; i < sizeof(lfc_files) / sizeof(lfc_files[0]); ++i) {
+        const std::string file_name =
+            appendSuffix(lease_file4_->getFilename(), lfc_files[i]);
+        if (fileExists(file_name)) {
+            CSVLeaseFile4 lease_file(file_name);
+            lease_file.open();
+            loadLeaseFile4(lease_file);
+            lease_file.close();
         }
-        // If we got the lease, we update the internal container holding
-        // leases. Otherwise, we reached the end of file and we leave.
-        if (lease) {
-            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL_DATA,
-                      DHCPSRV_MEMFILE_LEASE_LOAD4)
-                .arg(lease->toText());
-            loadLease4(lease);
-        }
-    } while (lease);
+    }
+    loadLeaseFile4(*lease_file4_);
+}
+
+void
+Memfile_LeaseMgr::loadLeaseFile4(CSVLeaseFile4& lease_file) {
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_RELOAD4)
+        .arg(lease_file.getFilename());
+
+    // The rows are parsed in parallel and the leases are applied in the
+    // order of the rows as soon as they are parsed, so the later rows update
+    // the leases from earlier rows.
+    /// @todo Currently we stop parsing on first failure. It is possible
+    /// that only one (or a few) leases are bad, so in theory we could
+    /// continue parsing. That is enhancement for later time.
+    LeaseFileLoader().load(lease_file.getFilename(),
+                           LeaseFileLoader::Lease4Handler(
+                               boost::bind(&Memfile_LeaseMgr::loadLease4,
+                                           this, _1)));
 }
 
 void
 Memfile_LeaseMgr::loadLease4(Lease4Ptr& lease) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL_DATA,
+              DHCPSRV_MEMFILE_LEASE_LOAD4)
+        .arg(lease->toText());
+
     // Check if the lease already exists.
     Lease4Storage::iterator lease_it = storage4_.find(lease->addr_);
     // Lease doesn't exist.
@@ -509,8 +841,9 @@ Memfile_LeaseMgr::loadLease4(Lease4Ptr& lease) {
             storage4_.erase(lease_it);
 
         } else {
-            // Update existing lease.
-            **lease_it = *lease;
+            // Update existing lease. The lease is replaced rather than
+            // modified in place, so the container indexes are updated.
+            storage4_.replace(lease_it, lease);
         }
     }
 }
@@ -523,37 +856,50 @@ Memfile_LeaseMgr::load6() {
         return;
     }
 
-    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_RELOAD6)
-        .arg(lease_file6_->getFilename());
-
     // Remove existing leases (if any). We will recreate them based on the
     // data on disk.
     storage6_.clear();
 
-    Lease6Ptr lease;
-    do {
-        /// @todo Currently we stop parsing on first failure. It is possible
-        /// that only one (or a few) leases are bad, so in theory we could
-        /// continue parsing but that would require some error counters to
-        /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file6_->next(lease)) {
-            bundy_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file6_->getReadMsg());
-        }
-        // If we got the lease, we update the internal container holding
-        // leases. Otherwise, we reached the end of file and we leave.
-        if (lease) {
-            LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL_DATA,
-                      DHCPSRV_MEMFILE_LEASE_LOAD6)
-                .arg(lease->toText());
-
-            loadLease6(lease);
+    // Load the leases from the result of the last LFC and from the input
+    // file of the LFC which hasn't completed (if any) before the leases from
+    // the current file, so the most recent lease records are loaded last.
+    const LFCFileType lfc_files[] = { FILE_PREVIOUS, FILE_INPUT };
+    for (size_t i = 0; i < sizeof(lfc_files) / sizeof(lfc_files[0]); ++i) {
+        const std::string file_name =
+            appendSuffix(lease_file6_->getFilename(), lfc_files[i]);
+        if (fileExists(file_name)) {
+            CSVLeaseFile6 lease_file(file_name);
+            lease_file.open();
+            loadLeaseFile6(lease_file);
+            lease_file.close();
         }
-    } while (lease);
+    }
+    loadLeaseFile6(*lease_file6_);
+}
+
+void
+Memfile_LeaseMgr::loadLeaseFile6(CSVLeaseFile6& lease_file) {
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_RELOAD6)
+        .arg(lease_file.getFilename());
+
+    // The rows are parsed in parallel and the leases are applied in the
+    // order of the rows as soon as they are parsed, so the later rows update
+    // the leases from earlier rows.
+    /// @todo Currently we stop parsing on first failure. It is possible
+    /// that only one (or a few) leases are bad, so in theory we could
+    /// continue parsing. That is enhancement for later time.
+    LeaseFileLoader().load(lease_file.getFilename(),
+                           LeaseFileLoader::Lease6Handler(
+                               boost::bind(&Memfile_LeaseMgr::loadLease6,
+                                           this, _1)));
 }
 
 void
 Memfile_LeaseMgr::loadLease6(Lease6Ptr& lease) {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL_DATA,
+              DHCPSRV_MEMFILE_LEASE_LOAD6)
+        .arg(lease->toText());
+
     // Check if the lease already exists.
     Lease6Storage::iterator lease_it = storage6_.find(lease->addr_);
     // Lease doesn't exist.
@@ -571,10 +917,122 @@ Memfile_LeaseMgr::loadLease6(Lease6Ptr& lease) {
             storage6_.erase(lease_it);
 
         } else {
-            // Update existing lease.
-            **lease_it = *lease;
+            // Update existing lease. The lease is replaced rather than
+            // modified in place, so the container indexes are updated.
+            storage6_.replace(lease_it, lease);
+        }
+    }
+
+}
+
+void
+Memfile_LeaseMgr::initLFCInterval() {
+    std::string lfc_interval;
+    try {
+        lfc_interval = getParameter("lfc-interval");
+    } catch (const Exception& ex) {
+        // The LFC is not run periodically by default.
+        return;
+    }
+    try {
+        const int64_t value = boost::lexical_cast<int64_t>(lfc_interval);
+        if ((value < 0) || (value > std::numeric_limits<uint32_t>::max())) {
+            bundy_throw(BadValue, "out of range");
         }
+        lfc_interval_ = static_cast<uint32_t>(value);
+    } catch (const std::exception& ex) {
+        bundy_throw(BadValue, "invalid value 'lfc-interval="
+                    << lfc_interval << "'");
     }
+    if (lfc_interval_ > 0) {
+        lfc_next_time_ = time(NULL) + lfc_interval_;
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_SETUP)
+            .arg(lfc_interval_);
+    }
+}
+
+std::string
+Memfile_LeaseMgr::appendSuffix(const std::string& file_name,
+                               const LFCFileType& file_type) {
+    switch (file_type) {
+    case FILE_INPUT:
+        return (file_name + ".1");
+    case FILE_PREVIOUS:
+        return (file_name + ".2");
+    case FILE_OUTPUT:
+        return (file_name + ".output");
+    case FILE_FINISH:
+        return (file_name + ".completed");
+    default:
+        return (file_name);
+    }
+}
+
+bool
+Memfile_LeaseMgr::lfcStart() {
+    if (lfc_runner_) {
+        if (!lfc_runner_->isDone()) {
+            return (false);
+        }
+        lfcWait();
+    }
+
+    if (persistLeases(V4)) {
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_START)
+            .arg(lease_file4_->getFilename());
+        lfc_runner_.reset(new LFCRunner(lease_file4_->getFilename(),
+                                        lfcSetup(*lease_file4_, storage4_)));
+    } else if (persistLeases(V6)) {
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_START)
+            .arg(lease_file6_->getFilename());
+        lfc_runner_.reset(new LFCRunner(lease_file6_->getFilename(),
+                                        lfcSetup(*lease_file6_, storage6_)));
+    } else {
+        return (false);
+    }
+    return (true);
+}
 
+bool
+Memfile_LeaseMgr::isLFCRunning() const {
+    return (lfc_runner_ && !lfc_runner_->isDone());
+}
+
+void
+Memfile_LeaseMgr::lfcWait() {
+    if (!lfc_runner_) {
+        return;
+    }
+    lfc_runner_->wait();
+    if (lfc_runner_->getError().empty()) {
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_COMPLETE)
+            .arg(lfc_runner_->getLeaseFile())
+            .arg(lfc_runner_->getLeasesCount());
+    } else {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_FAIL)
+            .arg(lfc_runner_->getLeaseFile())
+            .arg(lfc_runner_->getError());
+    }
+    lfc_runner_.reset();
 }
 
+void
+Memfile_LeaseMgr::lfcCheck() {
+    // Log the result of the LFC as soon as it has finished.
+    if (lfc_runner_ && lfc_runner_->isDone()) {
+        lfcWait();
+    }
+
+    if ((lfc_interval_ == 0) || (time(NULL) < lfc_next_time_)) {
+        return;
+    }
+    lfc_next_time_ = time(NULL) + lfc_interval_;
+    try {
+        lfcStart();
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_FAIL)
+            .arg(persistLeases(V4) ? lease_file4_->getFilename() :
+                 (persistLeases(V6) ? lease_file6_->getFilename() : ""))
+            .arg(ex.what());
+    }
+}
@@ -21,6 +21,7 @@
 #include <dhcpsrv/lease_mgr.h>
 
 #include <boost/multi_index/indexed_by.hpp>
+#include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
@@ -68,6 +69,18 @@ namespace dhcp {
 /// is not specified, the default location in the installation
 /// directory is used: var/bundy/kea-leases4.csv and
 /// var/bundy/kea-leases6.csv.
+///
+/// As the lease file grows with every update of a lease, it is periodically
+/// compacted, i.e. replaced with a file holding a single record for each
+/// lease. This is called the Lease File Compaction (LFC). The LFC is run
+/// every "lfc-interval" seconds (as specified in the database access string)
+/// when the leases are updated; it is disabled if the interval is 0, which is
+/// the default. The LFC rotates the lease file, so the server appends the
+/// subsequent updates to a new file, and writes the leases held in memory in
+/// a separate thread. The files used by the LFC are described in
+/// @c LFCFileType. They are renamed such that the leases can be loaded
+/// from the files at any time, even if the server is terminated in the
+/// middle of the LFC.
 class Memfile_LeaseMgr : public LeaseMgr {
 public:
 
@@ -216,6 +229,28 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns a collection of expired DHCPv4 leases.
+    ///
+    /// The leases are found using the expiration time index of the
+    /// container. This function returns copies of the leases.
+    ///
+    /// @param max_leases Maximum number of leases to be returned, 0 for
+    /// no limit.
+    ///
+    /// @return lease collection ordered by expiration time
+    virtual Lease4Collection getExpiredLeases4(size_t max_leases) const;
+
+    /// @brief Returns a collection of expired DHCPv6 leases.
+    ///
+    /// The leases are found using the expiration time index of the
+    /// container. This function returns copies of the leases.
+    ///
+    /// @param max_leases Maximum number of leases to be returned, 0 for
+    /// no limit.
+    ///
+    /// @return lease collection ordered by expiration time
+    virtual Lease6Collection getExpiredLeases6(size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// @warning This function does not validate the pointer to the lease.
@@ -315,17 +350,91 @@ public:
     /// server shut down.
     bool persistLeases(Universe u) const;
 
+    /// @brief Types of the lease files used by the Lease File Compaction.
+    ///
+    /// The LFC moves the current lease file to the input file (if the input
+    /// file of the previous LFC doesn't exist) and writes the leases to the
+    /// output file. When the output file has been written, it is renamed to
+    /// the finish file, the previous and input files are removed and the
+    /// finish file is renamed to the previous file. The leases are loaded
+    /// from the previous, input and current files, in this order.
+    enum LFCFileType {
+        FILE_CURRENT,  ///< File the leases are being appended to.
+        FILE_INPUT,    ///< Current lease file moved aside by the LFC.
+        FILE_PREVIOUS, ///< The result of the last completed LFC.
+        FILE_OUTPUT,   ///< File being written by the LFC.
+        FILE_FINISH    ///< Output file which has been completely written.
+    };
+
+    /// @brief Appends the LFC suffix to the lease file name.
+    ///
+    /// The suffixes are ".1" for the input file, ".2" for the previous file,
+    /// ".output" for the output file and ".completed" for the finish file.
+    /// The name of the current file is returned unchanged.
+    ///
+    /// @param file_name Name of the lease file.
+    /// @param file_type Type of the file.
+    ///
+    /// @return Name of the file of the specified type.
+    static std::string appendSuffix(const std::string& file_name,
+                                    const LFCFileType& file_type);
+
+    /// @brief Returns the interval between the runs of the LFC.
+    ///
+    /// @return Interval in seconds, 0 if the LFC isn't run periodically.
+    uint32_t getLFCInterval() const {
+        return (lfc_interval_);
+    }
+
+    /// @brief Starts the Lease File Compaction.
+    ///
+    /// This method rotates the lease file and starts writing the leases held
+    /// in memory in a separate thread. It returns immediately. The method is
+    /// called periodically when the leases are updated, if the LFC interval
+    /// is configured, but it can be also called directly.
+    ///
+    /// @throw bundy::dhcp::DbOperationError if the lease file can't be
+    /// rotated.
+    ///
+    /// @return false if the leases are not written to disk or the LFC is
+    /// already running, true otherwise.
+    bool lfcStart();
+
+    /// @brief Checks if the Lease File Compaction is running.
+    ///
+    /// @return true if the LFC has been started and it hasn't finished yet.
+    bool isLFCRunning() const;
+
+    /// @brief Waits for the Lease File Compaction to finish.
+    ///
+    /// It returns immediately if the LFC hasn't been started. The result of
+    /// the LFC is logged.
+    void lfcWait();
+
 protected:
 
-    /// @brief Load all DHCPv4 leases from the file.
+    /// @brief Load all DHCPv4 leases from the files.
     ///
-    /// This method loads all DHCPv4 leases from a file to memory. It removes
-    /// existing leases before reading a file.
+    /// This method loads all DHCPv4 leases to memory from the lease files
+    /// left by the Lease File Compaction (if any) and from the current lease
+    /// file. It removes existing leases before reading the files.
     ///
     /// @throw bundy::DbOperationError If failed to read a lease from the lease
     /// file.
     void load4();
 
+    /// @brief Loads DHCPv4 leases from a single lease file.
+    ///
+    /// The rows of the file are parsed by the @c LeaseFileLoader, possibly
+    /// in multiple threads, and applied in the order of the rows as they
+    /// are parsed.
+    ///
+    /// @param lease_file The opened lease file.
+    ///
+    /// @throw bundy::DbOperationError If failed to read a lease from the lease
+    /// file.
+    void loadLeaseFile4(CSVLeaseFile4& lease_file);
+
     /// @brief Loads a single DHCPv4 lease from the file.
     ///
     /// This method reads a single lease record from the lease file. If the
@@ -339,15 +448,28 @@ protected:
     /// @param lease Pointer to the lease read from the lease file.
     void loadLease4(Lease4Ptr& lease);
 
-    /// @brief Load all DHCPv6 leases from the file.
+    /// @brief Load all DHCPv6 leases from the files.
     ///
-    /// This method loads all DHCPv6 leases from a file to memory. It removes
-    /// existing leases before reading a file.
+    /// This method loads all DHCPv6 leases to memory from the lease files
+    /// left by the Lease File Compaction (if any) and from the current lease
+    /// file. It removes existing leases before reading the files.
     ///
     /// @throw bundy::DbOperationError If failed to read a lease from the lease
     /// file.
     void load6();
 
+    /// @brief Loads DHCPv6 leases from a single lease file.
+    ///
+    /// The rows of the file are parsed by the @c LeaseFileLoader, possibly
+    /// in multiple threads, and applied in the order of the rows as they
+    /// are parsed.
+    ///
+    /// @param lease_file The opened lease file.
+    ///
+    /// @throw bundy::DbOperationError If failed to read a lease from the lease
+    /// file.
+    void loadLeaseFile6(CSVLeaseFile6& lease_file);
+
     /// @brief Loads a single DHCPv6 lease from the file.
     ///
     /// This method reads a single lease record from the lease file. If the
@@ -380,6 +502,19 @@ protected:
     /// argument to this function.
     std::string initLeaseFilePath(Universe u);
 
+    /// @brief Initialize the interval of the Lease File Compaction.
+    ///
+    /// @throw bundy::BadValue if the "lfc-interval" parameter is invalid.
+    void initLFCInterval();
+
+    /// @brief Runs the Lease File Compaction if it is due.
+    ///
+    /// This is called after a lease has been written to the lease file. It
+    /// logs the result of the LFC which has finished, and starts a new one if
+    /// the LFC interval has elapsed. Errors are logged, not thrown, as the
+    /// lease has already been stored.
+    void lfcCheck();
+
     // This is a multi-index container, which holds elements that can
     // be accessed using different search indexes.
     typedef boost::multi_index_container<
@@ -408,6 +543,14 @@ protected:
                     boost::multi_index::member<Lease6, uint32_t, &Lease6::iaid_>,
                     boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
                 >
+            >,
+
+            // Specification of the third index starts here.
+            // This index sorts leases by their expiration time, so the
+            // expired leases can be found without a full scan.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<Lease, int64_t,
+                                                  &Lease::getExpirationTime>
             >
         >
      > Lease6Storage; // Specify the type name of this container.
@@ -478,6 +621,14 @@ protected:
                     // The subnet id is accessed through the subnet_id_ member.
                     boost::multi_index::member<Lease, SubnetID, &Lease::subnet_id_>
                 >
+            >,
+
+            // Specification of the fifth index starts here.
+            // This index sorts leases by their expiration time, so the
+            // expired leases can be found without a full scan.
+            boost::multi_index::ordered_non_unique<
+                boost::multi_index::const_mem_fun<Lease, int64_t,
+                                                  &Lease::getExpirationTime>
             >
         >
     > Lease4Storage; // Specify the type name for this container.
@@ -494,6 +645,18 @@ protected:
     /// @brief Holds the pointer to the DHCPv6 lease file IO.
     boost::shared_ptr<CSVLeaseFile6> lease_file6_;
 
+    /// @brief Writes the leases in the background for the LFC.
+    class LFCRunner;
+
+    /// @brief The LFC which has been started, if any.
+    boost::shared_ptr<LFCRunner> lfc_runner_;
+
+    /// @brief Interval between the runs of the LFC in seconds.
+    uint32_t lfc_interval_;
+
+    /// @brief The time when the LFC is run next.
+    time_t lfc_next_time_;
+
 };
 
 }; // end of bundy::dhcp namespace
@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <time.h>
@@ -92,6 +93,15 @@ TaggedStatement tagged_statements[] = {
      "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, fqdn_fwd, fqdn_rev, hostname "
      "FROM lease4 "
      "WHERE client_id = $1 AND subnet_id = $2"},
+    {PgSqlLeaseMgr::GET_LEASE4_EXPIRE, 2,
+        { 1114, 20 },
+        "get_lease4_expire",
+     "SELECT address, hwaddr, client_id, "
+     "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, fqdn_fwd, fqdn_rev, hostname "
+     "FROM lease4 "
+     "WHERE expire < $1 "
+     "ORDER BY expire "
+     "LIMIT $2"},
     {PgSqlLeaseMgr::GET_LEASE4_HWADDR, 1,
          { 17 },
          "get_lease4_hwaddr",
@@ -130,6 +140,16 @@ TaggedStatement tagged_statements[] = {
      "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
      "FROM lease6 "
      "WHERE lease_type = $1 AND duid = $2 AND iaid = $3 AND subnet_id = $4"},
+    {PgSqlLeaseMgr::GET_LEASE6_EXPIRE, 2,
+        { 1114, 20 },
+        "get_lease6_expire",
+     "SELECT address, duid, valid_lifetime, "
+     "extract(epoch from expire)::bigint, subnet_id, pref_lifetime, "
+     "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
+     "FROM lease6 "
+     "WHERE expire < $1 "
+     "ORDER BY expire "
+     "LIMIT $2"},
     {PgSqlLeaseMgr::GET_VERSION, 0,
         { 0 },
      "get_version",
@@ -174,7 +194,7 @@ namespace dhcp {
 
 /// @brief Auxiliary PostgreSQL exchange class
 class PgSqlLeaseExchange {
-protected:
+public:
 
     /// @brief Converts time_t structure to a text representation in local time.
     ///
@@ -187,7 +207,7 @@ protected:
     ///
     /// @param time_val timestamp to be converted
     /// @return std::string containing the stringified time
-    std::string
+    static std::string
     convertToDatabaseTime(const time_t& time_val) {
         struct tm tinfo;
         char buffer[20];
@@ -196,6 +216,8 @@ protected:
         return (std::string(buffer));
     }
 
+protected:
+
     /// @brief Converts time stamp from the database to a time_t
     ///
     /// @param db_time_val timestamp to be converted.  This value
@@ -1007,6 +1029,55 @@ PgSqlLeaseMgr::getLeases6(Lease::Type lease_type, const DUID& duid,
     return (result);
 }
 
+Lease4Collection
+PgSqlLeaseMgr::getExpiredLeases4(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_EXPIRED4).arg(max_leases);
+
+    // Set up the WHERE and LIMIT clause values
+    BindParams inparams;
+    createExpiredLeasesBind(max_leases, inparams);
+
+    // Get the data
+    Lease4Collection result;
+    getLeaseCollection(GET_LEASE4_EXPIRE, inparams, result);
+
+    return (result);
+}
+
+Lease6Collection
+PgSqlLeaseMgr::getExpiredLeases6(size_t max_leases) const {
+    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+              DHCPSRV_PGSQL_GET_EXPIRED6).arg(max_leases);
+
+    // Set up the WHERE and LIMIT clause values
+    BindParams inparams;
+    createExpiredLeasesBind(max_leases, inparams);
+
+    // Get the data
+    Lease6Collection result;
+    getLeaseCollection(GET_LEASE6_EXPIRE, inparams, result);
+
+    return (result);
+}
+
+void
+PgSqlLeaseMgr::createExpiredLeasesBind(size_t max_leases,
+                                       BindParams& params) {
+    // Leases which expire before the current time
+    params.push_back(PgSqlParam(PgSqlLeaseExchange::
+                                convertToDatabaseTime(time(NULL))));
+
+    // The limit of 0 means all leases.
+    ostringstream tmp;
+    if (max_leases > 0) {
+        tmp << static_cast<uint64_t>(max_leases);
+    } else {
+        tmp << std::numeric_limits<int64_t>::max();
+    }
+    params.push_back(PgSqlParam(tmp.str()));
+}
+
 template <typename LeasePtr>
 void
 PgSqlLeaseMgr::updateLeaseCommon(StatementIndex stindex, BindParams & params,
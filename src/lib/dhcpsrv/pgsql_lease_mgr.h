@@ -71,9 +71,9 @@ struct PgSqlStatementBind {
 class PgSqlLease4Exchange;
 class PgSqlLease6Exchange;
 
-/// Defines PostgreSQL backend version: 1.0
+/// Defines PostgreSQL backend version: 1.1
 const uint32_t PG_CURRENT_VERSION = 1;
-const uint32_t PG_CURRENT_MINOR = 0;
+const uint32_t PG_CURRENT_MINOR = 1;
 
 /// @brief PostgreSQL Lease Manager
 ///
@@ -290,6 +290,34 @@ public:
     virtual Lease6Collection getLeases6(Lease::Type type, const DUID& duid,
                                         uint32_t iaid, SubnetID subnet_id) const;
 
+    /// @brief Returns a collection of expired DHCPv4 leases.
+    ///
+    /// The leases are selected using the index on the "expire" column
+    /// and returned in the order of the expiration time.
+    ///
+    /// @param max_leases Maximum number of leases to be returned, 0 for
+    /// no limit.
+    ///
+    /// @return lease collection (may be empty if no lease has expired)
+    ///
+    /// @throw bundy::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease4Collection getExpiredLeases4(size_t max_leases) const;
+
+    /// @brief Returns a collection of expired DHCPv6 leases.
+    ///
+    /// The leases are selected using the index on the "expire" column
+    /// and returned in the order of the expiration time.
+    ///
+    /// @param max_leases Maximum number of leases to be returned, 0 for
+    /// no limit.
+    ///
+    /// @return lease collection (may be empty if no lease has expired)
+    ///
+    /// @throw bundy::dhcp::DbOperationError An operation on the open database has
+    ///        failed.
+    virtual Lease6Collection getExpiredLeases6(size_t max_leases) const;
+
     /// @brief Updates IPv4 lease.
     ///
     /// Updates the record of the lease in the database (as identified by the
@@ -382,11 +410,13 @@ public:
         GET_LEASE4_ADDR,            // Get lease4 by address
         GET_LEASE4_CLIENTID,        // Get lease4 by client ID
         GET_LEASE4_CLIENTID_SUBID,  // Get lease4 by client ID & subnet ID
+        GET_LEASE4_EXPIRE,          // Get expired lease4
         GET_LEASE4_HWADDR,          // Get lease4 by HW address
         GET_LEASE4_HWADDR_SUBID,    // Get lease4 by HW address & subnet ID
         GET_LEASE6_ADDR,            // Get lease6 by address
         GET_LEASE6_DUID_IAID,       // Get lease6 by DUID and IAID
         GET_LEASE6_DUID_IAID_SUBID, // Get lease6 by DUID, IAID and subnet ID
+        GET_LEASE6_EXPIRE,          // Get expired lease6
         GET_VERSION,                // Obtain version number
         INSERT_LEASE4,              // Add entry to lease4 table
         INSERT_LEASE6,              // Add entry to lease6 table
@@ -524,6 +554,14 @@ private:
                                std::vector<int>& out_lengths,
                                std::vector<int>& out_formats) const;
 
+    /// @brief Set up the parameters of the expired leases queries
+    ///
+    /// @param max_leases Maximum number of leases to be returned, 0 for
+    ///        no limit.
+    /// @param params Parameters to which the current time and the limit of
+    ///        the number of returned leases are appended.
+    static void createExpiredLeasesBind(size_t max_leases, BindParams& params);
+
     /// @brief Get Lease4 Common Code
     ///
     /// This method performs the common actions for the various getLease4()
@@ -64,6 +64,9 @@ public:
     // Expose internal classes for testing purposes
     using AllocEngine::Allocator;
     using AllocEngine::IterativeAllocator;
+    using AllocEngine::BitmapAllocator;
+    using AllocEngine::HashedAllocator;
+    using AllocEngine::RandomAllocator;
     using AllocEngine::getAllocator;
 
     /// @brief IterativeAllocator with internal methods exposed
@@ -470,10 +473,10 @@ public:
 TEST_F(AllocEngine6Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)), NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)), NotImplemented);
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)));
 
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_BITMAP, 100, true)));
     ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100, true)));
 
     // Check that allocator for normal addresses is created
@@ -489,6 +492,24 @@ TEST_F(AllocEngine6Test, constructor) {
     EXPECT_THROW(x->getAllocator(Lease::TYPE_V4), BadValue);
 }
 
+// This test checks that the allocation algorithms can be selected by name
+// and that the engine remembers the one it uses.
+TEST_F(AllocEngine6Test, allocTypeFromText) {
+    EXPECT_EQ(AllocEngine::ALLOC_ITERATIVE,
+              AllocEngine::allocTypeFromText("iterative"));
+    EXPECT_EQ(AllocEngine::ALLOC_HASHED,
+              AllocEngine::allocTypeFromText("hashed"));
+    EXPECT_EQ(AllocEngine::ALLOC_RANDOM,
+              AllocEngine::allocTypeFromText("random"));
+    EXPECT_EQ(AllocEngine::ALLOC_BITMAP,
+              AllocEngine::allocTypeFromText("bitmap"));
+    EXPECT_THROW(AllocEngine::allocTypeFromText("Iterative"), BadValue);
+    EXPECT_THROW(AllocEngine::allocTypeFromText(""), BadValue);
+
+    AllocEngine engine(AllocEngine::ALLOC_BITMAP, 100);
+    EXPECT_EQ(AllocEngine::ALLOC_BITMAP, engine.getAllocType());
+}
+
 // This test checks if the simple allocation (REQUEST) can succeed
 TEST_F(AllocEngine6Test, simpleAlloc6) {
     simpleAlloc6Test(pool_, IOAddress("::"), false);
@@ -800,6 +821,186 @@ TEST_F(AllocEngine6Test, IterativeAllocator_manyPools6) {
     }
 }
 
+// This test verifies that the bitmap allocator walks over all addresses in
+// all pools (including one that crosses a byte boundary) before it picks
+// the same address again, and that it skips the addresses known to be used.
+TEST_F(AllocEngine6Test, BitmapAllocator_manyPools6) {
+    NakedAllocEngine::BitmapAllocator alloc(Lease::TYPE_NA);
+
+    Pool6Ptr pool(new Pool6(Lease::TYPE_NA, IOAddress("2001:db8:1::f0"),
+                            IOAddress("2001:db8:1::1ff")));
+    subnet_->addPool(pool);
+    const size_t total = 17 + 272; // ::10 - ::20 and ::f0 - ::1ff
+
+    std::set<IOAddress> generated_addrs;
+    for (size_t i = 0; i < total; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        generated_addrs.insert(candidate);
+    }
+    EXPECT_EQ(total, generated_addrs.size());
+
+    // Mark all but two addresses as used; only these two should be picked.
+    for (std::set<IOAddress>::const_iterator it = generated_addrs.begin();
+         it != generated_addrs.end(); ++it) {
+        if (it->toText() != "2001:db8:1::15" &&
+            it->toText() != "2001:db8:1::100") {
+            alloc.addressUsed(*it);
+        }
+    }
+    std::set<IOAddress> free_addrs;
+    for (int i = 0; i < 4; ++i) {
+        free_addrs.insert(alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+    }
+    ASSERT_EQ(2, free_addrs.size());
+    EXPECT_EQ(1, free_addrs.count(IOAddress("2001:db8:1::15")));
+    EXPECT_EQ(1, free_addrs.count(IOAddress("2001:db8:1::100")));
+}
+
+// This test verifies that the bitmap allocator falls back to the iterative
+// allocation for pools too large for a bitmap.
+TEST_F(AllocEngine6Test, BitmapAllocatorLargePool) {
+    NakedAllocEngine::BitmapAllocator alloc(Lease::TYPE_NA);
+
+    initSubnet(IOAddress("2001:db8:1::"), IOAddress("2001:db8:1::"),
+               IOAddress("2001:db8:1::ffff:ffff"));
+    EXPECT_EQ("2001:db8:1::",
+              alloc.pickAddress(subnet_, duid_, IOAddress("::")).toText());
+    EXPECT_EQ("2001:db8:1::1",
+              alloc.pickAddress(subnet_, duid_, IOAddress("::")).toText());
+}
+
+// This test verifies that the hashed allocator picks the same address for
+// the same client and walks over all addresses of all pools when the
+// picked addresses are used.
+TEST_F(AllocEngine6Test, HashedAllocator_manyPools6) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_NA);
+
+    Pool6Ptr pool(new Pool6(Lease::TYPE_NA, IOAddress("2001:db8:1::f0"),
+                            IOAddress("2001:db8:1::1ff")));
+    subnet_->addPool(pool);
+    const size_t total = 17 + 272; // ::10 - ::20 and ::f0 - ::1ff
+
+    // The same client gets the same address as long as it isn't used.
+    const IOAddress first = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, first));
+    EXPECT_EQ(first, alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+
+    // Another allocator picks the same address for it too.
+    NakedAllocEngine::HashedAllocator alloc2(Lease::TYPE_NA);
+    EXPECT_EQ(first, alloc2.pickAddress(subnet_, duid_, IOAddress("::")));
+
+    // If every picked address is used, all addresses are picked once.
+    std::set<IOAddress> generated_addrs;
+    for (size_t i = 0; i < total; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        generated_addrs.insert(candidate);
+        alloc.addressUsed(candidate);
+    }
+    EXPECT_EQ(total, generated_addrs.size());
+    EXPECT_EQ(1, generated_addrs.count(first));
+
+    // Different clients are spread over the pools.
+    std::set<IOAddress> client_addrs;
+    for (uint8_t i = 0; i < 16; ++i) {
+        DuidPtr duid(new DUID(vector<uint8_t>(8, i)));
+        client_addrs.insert(alloc.pickAddress(subnet_, duid, IOAddress("::")));
+    }
+    EXPECT_LT(8, client_addrs.size());
+}
+
+// This test verifies that the hashed allocator walks over the prefixes of
+// a prefix delegation pool.
+TEST_F(AllocEngine6Test, HashedAllocatorPrefix) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_PD);
+
+    // 2001:db8:1::/56 pool with /64 prefixes
+    std::set<IOAddress> generated_addrs;
+    for (size_t i = 0; i < 256; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, candidate));
+        EXPECT_TRUE(candidate.toText().find("::") !=
+                    std::string::npos); // the low 64 bits are zero
+        generated_addrs.insert(candidate);
+        alloc.addressUsed(candidate);
+    }
+    EXPECT_EQ(256, generated_addrs.size());
+}
+
+// This test verifies that the random allocator picks addresses within the
+// pools, and that it eventually picks all of them.  The allocators are
+// seeded explicitly so the test picks the same addresses on every run.
+TEST_F(AllocEngine6Test, RandomAllocator_manyPools6) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_NA, 1);
+
+    Pool6Ptr pool(new Pool6(Lease::TYPE_NA, IOAddress("2001:db8:1::f0"),
+                            IOAddress("2001:db8:1::1ff")));
+    subnet_->addPool(pool);
+    const size_t total = 17 + 272; // ::10 - ::20 and ::f0 - ::1ff
+
+    std::set<IOAddress> generated_addrs;
+    for (size_t i = 0; i < total * 20 && generated_addrs.size() < total; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        generated_addrs.insert(candidate);
+        alloc.addressUsed(candidate);
+    }
+    EXPECT_EQ(total, generated_addrs.size());
+
+    // A sequence of used addresses doesn't repeat an address before it's
+    // abandoned.  Fresh allocators are used, so each check covers exactly
+    // one sequence.
+    for (uint64_t seed = 0; seed < 100; ++seed) {
+        NakedAllocEngine::RandomAllocator fresh(Lease::TYPE_NA, seed);
+        std::set<IOAddress> sequence;
+        for (size_t i = 0; i < NakedAllocEngine::RandomAllocator::MAX_PROBES;
+             ++i) {
+            IOAddress candidate = fresh.pickAddress(subnet_, duid_,
+                                                    IOAddress("::"));
+            sequence.insert(candidate);
+            fresh.addressUsed(candidate);
+        }
+        EXPECT_EQ(NakedAllocEngine::RandomAllocator::MAX_PROBES,
+                  sequence.size()) << "seed " << seed;
+    }
+}
+
+// This test checks that the engine with the hashed allocator allocates the
+// address preferred by the client, and another one when it's taken.
+TEST_F(AllocEngine6Test, hashedAlloc6) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_HASHED,
+                                                 100)));
+    ASSERT_TRUE(engine);
+
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_NA);
+    const IOAddress preferred = alloc.pickAddress(subnet_, duid_,
+                                                  IOAddress("::"));
+
+    Lease6Ptr lease;
+    EXPECT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_, IOAddress("::"), Lease::TYPE_NA, false,
+                    false, "", false, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(preferred, lease->addr_);
+    checkLease6(lease, Lease::TYPE_NA, 128);
+
+    // When the preferred address is leased to another client, the client
+    // gets another one.
+    DuidPtr duid(new DUID(vector<uint8_t>(8, 0x43)));
+    Lease6Ptr lease2(new Lease6(Lease::TYPE_NA, preferred, duid, iaid_,
+                                501, 502, 503, 504, subnet_->getID(), 128));
+    ASSERT_TRUE(LeaseMgrFactory::instance().deleteLease(preferred));
+    ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease2));
+    EXPECT_NO_THROW(lease = expectOneLease(engine->allocateLeases6(subnet_,
+                    duid_, iaid_ + 1, IOAddress("::"), Lease::TYPE_NA, false,
+                    false, "", false, CalloutHandlePtr(), old_leases_)));
+    ASSERT_TRUE(lease);
+    EXPECT_NE(preferred, lease->addr_);
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, lease->addr_));
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine6Test, smallPool6) {
     boost::scoped_ptr<AllocEngine> engine;
@@ -992,11 +1193,13 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
 TEST_F(AllocEngine4Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5, false)),
-                 NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5, false)),
-                 NotImplemented);
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5,
+                                            false)));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5,
+                                            false)));
+
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_BITMAP, 100,
+                                            false)));
 
     // Create V4 (ipv6=false) Allocation Engine that will try at most
     // 100 attempts to pick up a lease
@@ -1310,6 +1513,182 @@ TEST_F(AllocEngine4Test, IterativeAllocator_manyPools4) {
 }
 
 
+// This test verifies that the bitmap allocator walks over all addresses in
+// all pools before it picks the same address again.
+TEST_F(AllocEngine4Test, BitmapAllocator_manyPools4) {
+    NakedAllocEngine::BitmapAllocator alloc(Lease::TYPE_V4);
+
+    for (int i = 2; i < 10; ++i) {
+        stringstream min, max;
+
+        min << "192.0.2." << i * 10 + 1;
+        max << "192.0.2." << i * 10 + 9;
+
+        Pool4Ptr pool(new Pool4(IOAddress(min.str()),
+                                IOAddress(max.str())));
+        subnet_->addPool(pool);
+    }
+    const size_t total = 10 + 8 * 9;
+
+    std::set<IOAddress> generated_addrs;
+    for (size_t i = 0; i < total; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, clientid_,
+                                                IOAddress("0.0.0.0"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, candidate));
+        generated_addrs.insert(candidate);
+    }
+    EXPECT_EQ(total, generated_addrs.size());
+}
+
+// This test verifies that the bitmap allocator skips used addresses, picks
+// freed ones again, and starts over when all addresses seem to be used.
+TEST_F(AllocEngine4Test, BitmapAllocatorUsedAddresses) {
+    NakedAllocEngine::BitmapAllocator alloc(Lease::TYPE_V4);
+
+    // The bitmap is created on first use.
+    EXPECT_EQ("192.0.2.100", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+
+    // Only .109 is free.
+    for (int i = 100; i < 109; ++i) {
+        stringstream addr;
+        addr << "192.0.2." << i;
+        alloc.addressUsed(IOAddress(addr.str()));
+    }
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ("192.0.2.109", alloc.pickAddress(subnet_, clientid_,
+                                                   IOAddress("0.0.0.0")).toText());
+    }
+
+    // Addresses out of the pools are ignored.
+    alloc.addressUsed(IOAddress("192.0.2.1"));
+    alloc.addressFreed(IOAddress("10.0.0.1"));
+
+    // A freed address can be picked again.
+    alloc.addressFreed(IOAddress("192.0.2.103"));
+    std::set<IOAddress> free_addrs;
+    for (int i = 0; i < 4; ++i) {
+        free_addrs.insert(alloc.pickAddress(subnet_, clientid_,
+                                            IOAddress("0.0.0.0")));
+    }
+    ASSERT_EQ(2, free_addrs.size());
+    EXPECT_EQ(1, free_addrs.count(IOAddress("192.0.2.103")));
+    EXPECT_EQ(1, free_addrs.count(IOAddress("192.0.2.109")));
+
+    // When every address is marked as used, the allocator forgets and
+    // walks over the pool again.
+    alloc.addressUsed(IOAddress("192.0.2.103"));
+    alloc.addressUsed(IOAddress("192.0.2.109"));
+    std::set<IOAddress> generated_addrs;
+    for (int i = 0; i < 10; ++i) {
+        generated_addrs.insert(alloc.pickAddress(subnet_, clientid_,
+                                                 IOAddress("0.0.0.0")));
+    }
+    EXPECT_EQ(10, generated_addrs.size());
+
+    // A replaced pool gets a new bitmap.
+    subnet_->delPools(Lease::TYPE_V4);
+    subnet_->addPool(Pool4Ptr(new Pool4(IOAddress("192.0.2.100"),
+                                        IOAddress("192.0.2.101"))));
+    generated_addrs.clear();
+    for (int i = 0; i < 4; ++i) {
+        generated_addrs.insert(alloc.pickAddress(subnet_, clientid_,
+                                                 IOAddress("0.0.0.0")));
+    }
+    EXPECT_EQ(2, generated_addrs.size());
+}
+
+// This test checks that the engine with the bitmap allocator finds the only
+// free address in a pool, and hands out an address again after the engine
+// is told its lease was removed.
+TEST_F(AllocEngine4Test, bitmapAllocNearlyFull4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_BITMAP,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    // All addresses but .107 are leased to other clients.
+    uint8_t hwaddr2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe};
+    for (int i = 100; i < 110; ++i) {
+        if (i == 107) {
+            continue;
+        }
+        stringstream addr;
+        addr << "192.0.2." << i;
+        uint8_t clientid2[] = { 8, 7, 6, 5, 4, 3, 2, static_cast<uint8_t>(i) };
+        hwaddr2[5] = i;
+        Lease4Ptr lease(new Lease4(IOAddress(addr.str()), hwaddr2,
+                                   sizeof(hwaddr2), clientid2,
+                                   sizeof(clientid2), 501, 502, 503,
+                                   time(NULL), subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                             IOAddress("0.0.0.0"),
+                                             false, false, "",
+                                             false, CalloutHandlePtr(),
+                                             old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.107", lease->addr_.toText());
+    checkLease4(lease);
+
+    // The pool is now full.
+    uint8_t hwaddr3[] = { 0, 0xfd, 0xfd, 0xfd, 0xfd, 0xfd};
+    HWAddrPtr hwaddr(new HWAddr(hwaddr3, sizeof(hwaddr3), HTYPE_ETHER));
+    EXPECT_FALSE(engine->allocateLease4(subnet_, ClientIdPtr(), hwaddr,
+                                        IOAddress("0.0.0.0"),
+                                        false, false, "",
+                                        false, CalloutHandlePtr(),
+                                        old_lease_));
+
+    // Release .103; the next client should get it.
+    ASSERT_TRUE(LeaseMgrFactory::instance().deleteLease(IOAddress("192.0.2.103")));
+    engine->leaseRemoved(Lease::TYPE_V4, IOAddress("192.0.2.103"));
+    lease = engine->allocateLease4(subnet_, ClientIdPtr(), hwaddr,
+                                   IOAddress("0.0.0.0"),
+                                   false, false, "",
+                                   false, CalloutHandlePtr(),
+                                   old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.103", lease->addr_.toText());
+}
+
+// This test checks that the engine with the random allocator finds the
+// only free address in a pool.
+TEST_F(AllocEngine4Test, randomAllocNearlyFull4) {
+    boost::scoped_ptr<AllocEngine> engine;
+    ASSERT_NO_THROW(engine.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM,
+                                                 100, false)));
+    ASSERT_TRUE(engine);
+
+    // All addresses but .104 are leased to other clients.
+    uint8_t hwaddr2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe};
+    for (int i = 100; i < 110; ++i) {
+        if (i == 104) {
+            continue;
+        }
+        stringstream addr;
+        addr << "192.0.2." << i;
+        uint8_t clientid2[] = { 8, 7, 6, 5, 4, 3, 2, static_cast<uint8_t>(i) };
+        hwaddr2[5] = i;
+        Lease4Ptr lease(new Lease4(IOAddress(addr.str()), hwaddr2,
+                                   sizeof(hwaddr2), clientid2,
+                                   sizeof(clientid2), 501, 502, 503,
+                                   time(NULL), subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    Lease4Ptr lease = engine->allocateLease4(subnet_, clientid_, hwaddr_,
+                                             IOAddress("0.0.0.0"),
+                                             false, false, "",
+                                             false, CalloutHandlePtr(),
+                                             old_lease_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ("192.0.2.104", lease->addr_.toText());
+    checkLease4(lease);
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine4Test, smallPool4) {
     boost::scoped_ptr<AllocEngine> engine;
@@ -1507,6 +1507,88 @@ GenericLeaseMgrTest::testRecreateLease6() {
 }
 
 
+void
+GenericLeaseMgrTest::testGetExpiredLeases4() {
+    // Leases with an even index expired (the higher the index, the
+    // earlier), the other leases are valid.
+    vector<Lease4Ptr> leases = createLeases4();
+    const time_t now = time(NULL);
+    for (int i = 0; i < leases.size(); ++i) {
+        leases[i]->valid_lft_ = 1000;
+        if (i % 2 == 0) {
+            leases[i]->cltt_ = now - 2000 - i * 10;
+        } else {
+            leases[i]->cltt_ = now;
+        }
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+
+    // All expired leases, the earliest first.
+    Lease4Collection expired = lmptr_->getExpiredLeases4(0);
+    ASSERT_EQ(4, expired.size());
+    for (int i = 0; i < expired.size(); ++i) {
+        EXPECT_EQ(leases[6 - i * 2]->addr_, expired[i]->addr_);
+    }
+    detailCompareLease(leases[6], expired[0]);
+
+    // The number of leases can be limited.
+    expired = lmptr_->getExpiredLeases4(2);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(leases[6]->addr_, expired[0]->addr_);
+    EXPECT_EQ(leases[4]->addr_, expired[1]->addr_);
+
+    // A renewed lease is not expired any more, and a deleted lease is
+    // not returned.
+    leases[6]->cltt_ = now;
+    lmptr_->updateLease4(leases[6]);
+    EXPECT_TRUE(lmptr_->deleteLease(leases[4]->addr_));
+    expired = lmptr_->getExpiredLeases4(0);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(leases[2]->addr_, expired[0]->addr_);
+    EXPECT_EQ(leases[0]->addr_, expired[1]->addr_);
+}
+
+void
+GenericLeaseMgrTest::testGetExpiredLeases6() {
+    // Leases with an even index expired (the higher the index, the
+    // earlier), the other leases are valid.
+    vector<Lease6Ptr> leases = createLeases6();
+    const time_t now = time(NULL);
+    for (int i = 0; i < leases.size(); ++i) {
+        leases[i]->valid_lft_ = 1000;
+        if (i % 2 == 0) {
+            leases[i]->cltt_ = now - 2000 - i * 10;
+        } else {
+            leases[i]->cltt_ = now;
+        }
+        ASSERT_TRUE(lmptr_->addLease(leases[i]));
+    }
+
+    // All expired leases, the earliest first.
+    Lease6Collection expired = lmptr_->getExpiredLeases6(0);
+    ASSERT_EQ(4, expired.size());
+    for (int i = 0; i < expired.size(); ++i) {
+        EXPECT_EQ(leases[6 - i * 2]->addr_, expired[i]->addr_);
+    }
+    detailCompareLease(leases[6], expired[0]);
+
+    // The number of leases can be limited.
+    expired = lmptr_->getExpiredLeases6(2);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(leases[6]->addr_, expired[0]->addr_);
+    EXPECT_EQ(leases[4]->addr_, expired[1]->addr_);
+
+    // A renewed lease is not expired any more, and a deleted lease is
+    // not returned.
+    leases[6]->cltt_ = now;
+    lmptr_->updateLease6(leases[6]);
+    EXPECT_TRUE(lmptr_->deleteLease(leases[4]->addr_));
+    expired = lmptr_->getExpiredLeases6(0);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(leases[2]->addr_, expired[0]->addr_);
+    EXPECT_EQ(leases[0]->addr_, expired[1]->addr_);
+}
+
 }; // namespace test
 }; // namespace dhcp
 }; // namespace bundy
@@ -245,6 +245,19 @@ public:
     /// persistent storage has been updated as expected.
     void testRecreateLease6();
 
+    /// @brief Checks that the expired DHCPv4 leases can be retrieved.
+    ///
+    /// This test adds a number of leases to the database, some of them
+    /// expired, and checks that only the expired ones are returned, in the
+    /// order of the expiration time and no more than requested. It also
+    /// checks that updated and deleted leases are taken into account.
+    void testGetExpiredLeases4();
+
+    /// @brief Checks that the expired DHCPv6 leases can be retrieved.
+    ///
+    /// See @c testGetExpiredLeases4 for details.
+    void testGetExpiredLeases6();
+
     /// @brief String forms of IPv4 addresses
     std::vector<std::string>  straddress4_;
 
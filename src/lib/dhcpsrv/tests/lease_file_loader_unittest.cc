@@ -0,0 +1,386 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+#include <asiolink/io_address.h>
+#include <dhcp/duid.h>
+#include <dhcpsrv/csv_lease_file4.h>
+#include <dhcpsrv/csv_lease_file6.h>
+#include <dhcpsrv/lease.h>
+#include <dhcpsrv/lease_file_loader.h>
+#include <dhcpsrv/lease_mgr.h>
+#include <dhcpsrv/tests/lease_file_io.h>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+
+using namespace bundy;
+using namespace bundy::asiolink;
+using namespace bundy::dhcp;
+using namespace bundy::dhcp::test;
+
+namespace {
+
+/// @brief Test fixture class for @c LeaseFileLoader.
+class LeaseFileLoaderTest : public ::testing::Test {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// Initializes IO for lease file used by unit tests.
+    LeaseFileLoaderTest();
+
+    /// @brief Prepends the absolute path to the file specified
+    /// as an argument.
+    ///
+    /// @param filename Name of the file.
+    /// @return Absolute path to the test file.
+    static std::string absolutePath(const std::string& filename);
+
+    /// @brief Creates a DHCPv4 lease file with many leases.
+    ///
+    /// Each address is written twice, and the second row for each address
+    /// differs in the valid lifetime.
+    ///
+    /// @param count Number of addresses.
+    void writeLeases4(const size_t count) const;
+
+    /// @brief Creates a DHCPv6 lease file with many leases.
+    ///
+    /// @param count Number of leases.
+    void writeLeases6(const size_t count) const;
+
+    /// @brief Reads all leases from the file using the @c CSVLeaseFile4.
+    Lease4Collection readLeases4() const;
+
+    /// @brief Reads all leases from the file using the @c CSVLeaseFile6.
+    Lease6Collection readLeases6() const;
+
+    /// @brief Name of the test lease file.
+    std::string filename_;
+
+    /// @brief Object providing access to lease file IO.
+    LeaseFileIO io_;
+
+};
+
+LeaseFileLoaderTest::LeaseFileLoaderTest()
+    : filename_(absolutePath("leases.csv")), io_(filename_) {
+}
+
+std::string
+LeaseFileLoaderTest::absolutePath(const std::string& filename) {
+    std::ostringstream s;
+    s << DHCP_DATA_DIR << "/" << filename;
+    return (s.str());
+}
+
+void
+LeaseFileLoaderTest::writeLeases4(const size_t count) const {
+    std::ostringstream s;
+    s << "address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+        "fqdn_fwd,fqdn_rev,hostname\n";
+    for (size_t round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < count; ++i) {
+            s << "10.0." << (i / 256) << "." << (i % 256) << ","
+              << "00:01:02:03:" << std::hex << (i / 256) << ":" << (i % 256)
+              << std::dec << ","
+              << (i % 2 ? "" : "01:02:03:04") << ","
+              << 100 + round << "," << 1000 + i << ",1,"
+              << (i % 2) << ",1,host" << i << ".example.com\n";
+        }
+    }
+    io_.writeFile(s.str());
+}
+
+void
+LeaseFileLoaderTest::writeLeases6(const size_t count) const {
+    std::ostringstream s;
+    s << "address,duid,valid_lifetime,expire,subnet_id,pref_lifetime,"
+        "lease_type,iaid,prefix_len,fqdn_fwd,fqdn_rev,hostname\n";
+    for (size_t i = 0; i < count; ++i) {
+        s << "2001:db8:1::" << std::hex << i << std::dec << ","
+          << "00:01:02:03:04:05:06:0a:0b:0c:0d:0e:" << std::hex << (i % 256)
+          << std::dec << ","
+          << 200 << "," << 1000 + i << ",8,100," << (i % 3) << ","
+          << i << "," << (i % 3 == 2 ? 64 : 128) << ",0,"
+          << (i % 2) << ",\n";
+    }
+    io_.writeFile(s.str());
+}
+
+Lease4Collection
+LeaseFileLoaderTest::readLeases4() const {
+    Lease4Collection leases;
+    CSVLeaseFile4 lf(filename_);
+    lf.open();
+    Lease4Ptr lease;
+    while (lf.next(lease) && lease) {
+        leases.push_back(lease);
+    }
+    return (leases);
+}
+
+Lease6Collection
+LeaseFileLoaderTest::readLeases6() const {
+    Lease6Collection leases;
+    CSVLeaseFile6 lf(filename_);
+    lf.open();
+    Lease6Ptr lease;
+    while (lf.next(lease) && lease) {
+        leases.push_back(lease);
+    }
+    return (leases);
+}
+
+// This test checks that the DHCPv4 leases are parsed the same way as by
+// the CSVLeaseFile4, in the single and in multiple threads.
+TEST_F(LeaseFileLoaderTest, load4) {
+    writeLeases4(1000);
+    const Lease4Collection expected = readLeases4();
+    ASSERT_EQ(2000, expected.size());
+
+    // Use small chunks so as the file is split between the threads.
+    const size_t threads[] = { 1, 2, 3, 8 };
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i) {
+        SCOPED_TRACE(threads[i]);
+        LeaseFileLoader loader(threads[i], 1);
+        EXPECT_EQ(threads[i], loader.getMaxThreads());
+        Lease4Collection leases;
+        ASSERT_NO_THROW(loader.load(filename_, leases));
+        ASSERT_EQ(expected.size(), leases.size());
+        for (size_t j = 0; j < leases.size(); ++j) {
+            ASSERT_TRUE(*expected[j] == *leases[j]) << "lease " << j;
+        }
+    }
+
+    // The later rows are returned last.
+    Lease4Collection leases;
+    ASSERT_NO_THROW(LeaseFileLoader(4, 1).load(filename_, leases));
+    EXPECT_EQ("10.0.0.0", leases[0]->addr_.toText());
+    EXPECT_EQ(100, leases[0]->valid_lft_);
+    EXPECT_EQ(900, leases[0]->cltt_);
+    EXPECT_FALSE(leases[1]->client_id_);
+    EXPECT_EQ("10.0.0.0", leases[1000]->addr_.toText());
+    EXPECT_EQ(101, leases[1000]->valid_lft_);
+}
+
+// This test checks that the DHCPv6 leases are parsed the same way as by
+// the CSVLeaseFile6, in the single and in multiple threads.
+TEST_F(LeaseFileLoaderTest, load6) {
+    writeLeases6(1000);
+    const Lease6Collection expected = readLeases6();
+    ASSERT_EQ(1000, expected.size());
+
+    const size_t threads[] = { 1, 2, 3, 8 };
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i) {
+        SCOPED_TRACE(threads[i]);
+        Lease6Collection leases;
+        ASSERT_NO_THROW(LeaseFileLoader(threads[i], 1).load(filename_,
+                                                             leases));
+        ASSERT_EQ(expected.size(), leases.size());
+        for (size_t j = 0; j < leases.size(); ++j) {
+            ASSERT_TRUE(*expected[j] == *leases[j]) << "lease " << j;
+        }
+    }
+}
+
+// This test checks that the leases are appended to the collection.
+TEST_F(LeaseFileLoaderTest, append) {
+    writeLeases6(3);
+    Lease6Collection leases;
+    ASSERT_NO_THROW(LeaseFileLoader().load(filename_, leases));
+    ASSERT_NO_THROW(LeaseFileLoader().load(filename_, leases));
+    ASSERT_EQ(6, leases.size());
+    EXPECT_TRUE(*leases[0] == *leases[3]);
+    EXPECT_EQ(Lease::TYPE_PD, leases[2]->type_);
+    EXPECT_EQ(64, leases[2]->prefixlen_);
+}
+
+// This test checks that the last row doesn't have to end with the new line
+// character and that the file with the header only is accepted.
+TEST_F(LeaseFileLoaderTest, noTrailingNewLine) {
+    io_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+                  "fqdn_fwd,fqdn_rev,hostname\n"
+                  "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,"
+                  "host.example.com");
+    Lease4Collection leases;
+    ASSERT_NO_THROW(LeaseFileLoader().load(filename_, leases));
+    ASSERT_EQ(1, leases.size());
+    EXPECT_EQ("host.example.com", leases[0]->hostname_);
+
+    io_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+                  "fqdn_fwd,fqdn_rev,hostname\n");
+    leases.clear();
+    ASSERT_NO_THROW(LeaseFileLoader().load(filename_, leases));
+    EXPECT_TRUE(leases.empty());
+}
+
+// This test checks that invalid rows are rejected and no leases are
+// returned in such case. Some of these rows are accepted by the
+// CSVLeaseFile4, e.g. negative numbers or invalid hexadecimal digits.
+TEST_F(LeaseFileLoaderTest, invalidRow) {
+    const std::string header = "address,hwaddr,client_id,valid_lifetime,"
+        "expire,subnet_id,fqdn_fwd,fqdn_rev,hostname\n";
+    const std::string valid = "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n";
+    const char* invalid[] = {
+        // Empty hardware address.
+        "192.0.2.2,,,200,200,8,1,1,\n",
+        // Invalid address.
+        "192.0.2,06:07:08:09:0a:bc,,200,200,8,1,1,\n",
+        "2001:db8::1,06:07:08:09:0a:bc,,200,200,8,1,1,\n",
+        // Invalid hardware address.
+        "192.0.2.2,06:07::08,,200,200,8,1,1,\n",
+        "192.0.2.2,06:07:08:,,200,200,8,1,1,\n",
+        "192.0.2.2,067:08,,200,200,8,1,1,\n",
+        "192.0.2.2,0g:08,,200,200,8,1,1,\n",
+        // Client identifier too short.
+        "192.0.2.2,06:07,01,200,200,8,1,1,\n",
+        // Invalid numbers.
+        "192.0.2.2,06:07,,-1,200,8,1,1,\n",
+        "192.0.2.2,06:07,,4294967296,200,8,1,1,\n",
+        "192.0.2.2,06:07,,200,,8,1,1,\n",
+        "192.0.2.2,06:07,,200,200,8,2,1,\n",
+        // Wrong number of values.
+        "192.0.2.2,06:07,,200,200,8,1,1\n",
+        "192.0.2.2,06:07,,200,200,8,1,1,,\n",
+        "\n"
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+        SCOPED_TRACE(invalid[i]);
+        io_.writeFile(header + valid + invalid[i] + valid);
+        Lease4Collection leases;
+        try {
+            LeaseFileLoader(2, 1).load(filename_, leases);
+            ADD_FAILURE() << "the row was accepted";
+        } catch (const DbOperationError& ex) {
+            // The error message should point to the invalid row.
+            EXPECT_NE(std::string::npos,
+                      std::string(ex.what()).find("in line 3 of"))
+                << ex.what();
+        }
+        EXPECT_TRUE(leases.empty());
+    }
+}
+
+// This test checks that the address in the DHCPv6 lease file must be an
+// IPv6 address.
+TEST_F(LeaseFileLoaderTest, invalidAddressFamily6) {
+    io_.writeFile("address,duid,valid_lifetime,expire,subnet_id,"
+                  "pref_lifetime,lease_type,iaid,prefix_len,fqdn_fwd,"
+                  "fqdn_rev,hostname\n"
+                  "192.0.2.1,00:01:02:03,200,200,8,100,0,7,128,0,0,\n");
+    Lease6Collection leases;
+    EXPECT_THROW(LeaseFileLoader().load(filename_, leases),
+                 DbOperationError);
+}
+
+// This test checks that the file with a wrong header is rejected.
+TEST_F(LeaseFileLoaderTest, invalidHeader) {
+    io_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+                  "fqdn_fwd,fqdn_rev,hostname\n"
+                  "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n");
+    Lease6Collection leases;
+    EXPECT_THROW(LeaseFileLoader().load(filename_, leases),
+                 DbOperationError);
+
+    io_.writeFile("address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+                  "fqdn_fwd,fqdn_rev");
+    Lease4Collection leases4;
+    EXPECT_THROW(LeaseFileLoader().load(filename_, leases4),
+                 DbOperationError);
+
+    io_.removeFile();
+    EXPECT_THROW(LeaseFileLoader().load(filename_, leases4),
+                 DbOperationError);
+}
+
+/// @brief Collects the leases passed to the handler of the loader.
+///
+/// It throws after the given number of leases, if non-zero.
+class LeaseCollector {
+public:
+    LeaseCollector(const size_t throw_after = 0) :
+        throw_after_(throw_after)
+    {}
+
+    void handle(Lease4Ptr& lease) {
+        leases_.push_back(lease);
+        if (leases_.size() == throw_after_) {
+            bundy_throw(Unexpected, "handler failed");
+        }
+    }
+
+    Lease4Collection leases_;
+
+private:
+    const size_t throw_after_;
+};
+
+// This test checks that the handler is called for each lease, in the order
+// of the rows, while the rows are parsed in multiple threads.
+TEST_F(LeaseFileLoaderTest, handler) {
+    writeLeases4(1000);
+    const Lease4Collection expected = readLeases4();
+
+    const size_t threads[] = { 1, 2, 4 };
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i) {
+        SCOPED_TRACE(threads[i]);
+        LeaseCollector collector;
+        ASSERT_NO_THROW(LeaseFileLoader(threads[i], 64).load(filename_,
+            LeaseFileLoader::Lease4Handler(
+                boost::bind(&LeaseCollector::handle, &collector, _1))));
+        ASSERT_EQ(expected.size(), collector.leases_.size());
+        for (size_t j = 0; j < expected.size(); ++j) {
+            ASSERT_TRUE(*expected[j] == *collector.leases_[j])
+                << "lease " << j;
+        }
+    }
+
+    // The error of the handler stops the loading and is propagated.
+    for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i) {
+        SCOPED_TRACE(threads[i]);
+        LeaseCollector collector(10);
+        EXPECT_THROW(LeaseFileLoader(threads[i], 64).load(filename_,
+            LeaseFileLoader::Lease4Handler(
+                boost::bind(&LeaseCollector::handle, &collector, _1))),
+                     Unexpected);
+        EXPECT_EQ(10, collector.leases_.size());
+    }
+}
+
+// This test checks that the handler is called for the leases preceding
+// an invalid row.
+TEST_F(LeaseFileLoaderTest, handlerInvalidRow) {
+    std::ostringstream file;
+    file << "address,hwaddr,client_id,valid_lifetime,expire,subnet_id,"
+        "fqdn_fwd,fqdn_rev,hostname\n";
+    for (int i = 0; i < 100; ++i) {
+        file << "192.0.2." << i << ",06:07:08:09:0a:bc,,200,200,8,1,1,\n";
+    }
+    file << "192.0.2,06:07:08:09:0a:bc,,200,200,8,1,1,\n";
+    file << "192.0.2.200,06:07:08:09:0a:bc,,200,200,8,1,1,\n";
+    io_.writeFile(file.str());
+
+    LeaseCollector collector;
+    EXPECT_THROW(LeaseFileLoader(4, 1).load(filename_,
+        LeaseFileLoader::Lease4Handler(
+            boost::bind(&LeaseCollector::handle, &collector, _1))),
+                 DbOperationError);
+    ASSERT_EQ(100, collector.leases_.size());
+    EXPECT_EQ("192.0.2.99", collector.leases_[99]->addr_.toText());
+}
+
+} // end of anonymous namespace
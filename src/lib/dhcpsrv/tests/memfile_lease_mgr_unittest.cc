@@ -25,6 +25,7 @@
 #include <dhcpsrv/tests/generic_lease_mgr_unittest.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -115,6 +116,17 @@ public:
         lmptr_ = &(LeaseMgrFactory::instance());
     }
 
+    /// @brief Returns the number of lease records in the lease file.
+    ///
+    /// @param io Object providing access to the lease file.
+    ///
+    /// @return Number of lines in the file, excluding the header.
+    static size_t countLeaseRecords(const LeaseFileIO& io) {
+        const std::string contents = io.readFile();
+        const size_t lines = std::count(contents.begin(), contents.end(), '\n');
+        return (lines > 0 ? lines - 1 : 0);
+    }
+
     /// @brief Object providing access to v4 lease IO.
     LeaseFileIO io4_;
 
@@ -404,6 +416,240 @@ TEST_F(MemfileLeaseMgrTest, testRecreateLease6) {
     testRecreateLease6();
 }
 
+/// @brief Expired DHCPv4 leases tests
+///
+/// Checks that the expired leases can be retrieved in the order of
+/// their expiration time.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases4) {
+    startBackend(V4);
+    testGetExpiredLeases4();
+}
+
+/// @brief Expired DHCPv6 leases tests
+///
+/// Checks that the expired leases can be retrieved in the order of
+/// their expiration time.
+TEST_F(MemfileLeaseMgrTest, getExpiredLeases6) {
+    startBackend(V6);
+    testGetExpiredLeases6();
+}
+
+// Checks that the names of the files used by the lease file compaction
+// are created correctly.
+TEST_F(MemfileLeaseMgrTest, appendSuffix) {
+    const std::string name("leasefile4_0.csv");
+    EXPECT_EQ(name, Memfile_LeaseMgr::appendSuffix(
+                  name, Memfile_LeaseMgr::FILE_CURRENT));
+    EXPECT_EQ(name + ".1", Memfile_LeaseMgr::appendSuffix(
+                  name, Memfile_LeaseMgr::FILE_INPUT));
+    EXPECT_EQ(name + ".2", Memfile_LeaseMgr::appendSuffix(
+                  name, Memfile_LeaseMgr::FILE_PREVIOUS));
+    EXPECT_EQ(name + ".output", Memfile_LeaseMgr::appendSuffix(
+                  name, Memfile_LeaseMgr::FILE_OUTPUT));
+    EXPECT_EQ(name + ".completed", Memfile_LeaseMgr::appendSuffix(
+                  name, Memfile_LeaseMgr::FILE_FINISH));
+}
+
+// Checks that the interval of the lease file compaction is parsed.
+TEST_F(MemfileLeaseMgrTest, lfcInterval) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["persist"] = "false";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr;
+
+    // The compaction isn't run periodically by default.
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)));
+    EXPECT_EQ(0, lease_mgr->getLFCInterval());
+
+    pmap["lfc-interval"] = "3600";
+    ASSERT_NO_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)));
+    EXPECT_EQ(3600, lease_mgr->getLFCInterval());
+
+    pmap["lfc-interval"] = "-1";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), bundy::BadValue);
+    pmap["lfc-interval"] = "bogus";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), bundy::BadValue);
+}
+
+// Checks that the compaction can't be run if the leases are not written
+// to disk.
+TEST_F(MemfileLeaseMgrTest, lfcNoStorage) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["persist"] = "false";
+    Memfile_LeaseMgr lease_mgr(pmap);
+    EXPECT_FALSE(lease_mgr.lfcStart());
+    EXPECT_FALSE(lease_mgr.isLFCRunning());
+}
+
+// Checks that the DHCPv4 lease file is compacted and that the leases are
+// loaded from the compacted file and the new lease file.
+TEST_F(MemfileLeaseMgrTest, lfcCompaction4) {
+    LeaseFileIO input(Memfile_LeaseMgr::appendSuffix(
+                          io4_.testfile_, Memfile_LeaseMgr::FILE_INPUT));
+    LeaseFileIO previous(Memfile_LeaseMgr::appendSuffix(
+                             io4_.testfile_, Memfile_LeaseMgr::FILE_PREVIOUS));
+    startBackend(V4);
+    Memfile_LeaseMgr* lease_mgr = dynamic_cast<Memfile_LeaseMgr*>(lmptr_);
+    ASSERT_TRUE(lease_mgr);
+    vector<Lease4Ptr> leases4 = createLeases4();
+
+    // Add 3 leases, update the first one twice and delete the second one.
+    // That's 6 records in the lease file.
+    ASSERT_TRUE(lmptr_->addLease(leases4[1]));
+    ASSERT_TRUE(lmptr_->addLease(leases4[2]));
+    ASSERT_TRUE(lmptr_->addLease(leases4[3]));
+    leases4[1]->valid_lft_ += 100;
+    ASSERT_NO_THROW(lmptr_->updateLease4(leases4[1]));
+    leases4[1]->valid_lft_ += 100;
+    ASSERT_NO_THROW(lmptr_->updateLease4(leases4[1]));
+    ASSERT_TRUE(lmptr_->deleteLease(leases4[2]->addr_));
+    EXPECT_EQ(6, countLeaseRecords(io4_));
+
+    // Compact the lease file. It is moved aside, so a new lease is written
+    // to a new lease file.
+    ASSERT_TRUE(lease_mgr->lfcStart());
+    EXPECT_FALSE(io4_.readFile().empty());
+    EXPECT_EQ(0, countLeaseRecords(io4_));
+    ASSERT_TRUE(lmptr_->addLease(leases4[4]));
+    EXPECT_EQ(1, countLeaseRecords(io4_));
+
+    // When the compaction has completed, the compacted file holds the two
+    // leases which existed when it was started.
+    lease_mgr->lfcWait();
+    EXPECT_FALSE(lease_mgr->isLFCRunning());
+    EXPECT_FALSE(input.exists());
+    EXPECT_EQ(2, countLeaseRecords(previous));
+
+    // All leases are loaded from the files.
+    reopen(V4);
+    Lease4Ptr lease = lmptr_->getLease4(leases4[1]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases4[1], lease);
+    EXPECT_FALSE(lmptr_->getLease4(leases4[2]->addr_));
+    lease = lmptr_->getLease4(leases4[3]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases4[3], lease);
+    lease = lmptr_->getLease4(leases4[4]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases4[4], lease);
+}
+
+// Checks that the DHCPv6 lease file is compacted and that the leases are
+// loaded from the compacted file and the new lease file.
+TEST_F(MemfileLeaseMgrTest, lfcCompaction6) {
+    LeaseFileIO input(Memfile_LeaseMgr::appendSuffix(
+                          io6_.testfile_, Memfile_LeaseMgr::FILE_INPUT));
+    LeaseFileIO previous(Memfile_LeaseMgr::appendSuffix(
+                             io6_.testfile_, Memfile_LeaseMgr::FILE_PREVIOUS));
+    startBackend(V6);
+    Memfile_LeaseMgr* lease_mgr = dynamic_cast<Memfile_LeaseMgr*>(lmptr_);
+    ASSERT_TRUE(lease_mgr);
+    vector<Lease6Ptr> leases6 = createLeases6();
+
+    ASSERT_TRUE(lmptr_->addLease(leases6[1]));
+    ASSERT_TRUE(lmptr_->addLease(leases6[2]));
+    leases6[1]->valid_lft_ += 100;
+    ASSERT_NO_THROW(lmptr_->updateLease6(leases6[1]));
+    ASSERT_TRUE(lmptr_->deleteLease(leases6[2]->addr_));
+    EXPECT_EQ(4, countLeaseRecords(io6_));
+
+    ASSERT_TRUE(lease_mgr->lfcStart());
+    ASSERT_TRUE(lmptr_->addLease(leases6[3]));
+    lease_mgr->lfcWait();
+    EXPECT_FALSE(input.exists());
+    EXPECT_EQ(1, countLeaseRecords(previous));
+    EXPECT_EQ(1, countLeaseRecords(io6_));
+
+    reopen(V6);
+    Lease6Ptr lease = lmptr_->getLease6(leasetype6_[1], leases6[1]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases6[1], lease);
+    EXPECT_FALSE(lmptr_->getLease6(leasetype6_[2], leases6[2]->addr_));
+    lease = lmptr_->getLease6(leasetype6_[3], leases6[3]->addr_);
+    ASSERT_TRUE(lease);
+    detailCompareLease(leases6[3], lease);
+}
+
+// Checks that the compaction which has been interrupted after the compacted
+// file has been written is completed at startup.
+TEST_F(MemfileLeaseMgrTest, lfcRecoverFinish) {
+    LeaseFileIO input(Memfile_LeaseMgr::appendSuffix(
+                          io4_.testfile_, Memfile_LeaseMgr::FILE_INPUT));
+    LeaseFileIO previous(Memfile_LeaseMgr::appendSuffix(
+                             io4_.testfile_, Memfile_LeaseMgr::FILE_PREVIOUS));
+    LeaseFileIO finish(Memfile_LeaseMgr::appendSuffix(
+                           io4_.testfile_, Memfile_LeaseMgr::FILE_FINISH));
+    const std::string header("address,hwaddr,client_id,valid_lifetime,expire,"
+                             "subnet_id,fqdn_fwd,fqdn_rev,hostname\n");
+    previous.writeFile(header +
+                       "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n"
+                       "192.0.2.2,06:07:08:09:0a:bd,,200,200,8,1,1,\n");
+    input.writeFile(header +
+                    "192.0.2.1,06:07:08:09:0a:bc,,300,300,8,1,1,\n"
+                    "192.0.2.2,06:07:08:09:0a:bd,,0,200,8,1,1,\n");
+    // The compacted file holds the leases from the previous and input files.
+    finish.writeFile(header +
+                     "192.0.2.1,06:07:08:09:0a:bc,,300,300,8,1,1,\n");
+    io4_.writeFile(header +
+                   "192.0.2.3,06:07:08:09:0a:be,,200,200,8,1,1,\n");
+
+    startBackend(V4);
+    EXPECT_FALSE(finish.exists());
+    EXPECT_FALSE(input.exists());
+    EXPECT_EQ(1, countLeaseRecords(previous));
+
+    Lease4Ptr lease = lmptr_->getLease4(IOAddress("192.0.2.1"));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(300, lease->valid_lft_);
+    EXPECT_FALSE(lmptr_->getLease4(IOAddress("192.0.2.2")));
+    EXPECT_TRUE(lmptr_->getLease4(IOAddress("192.0.2.3")));
+}
+
+// Checks that the output file of the compaction which has been interrupted
+// before the file has been written is removed at startup, and that the
+// leases are loaded from the remaining files.
+TEST_F(MemfileLeaseMgrTest, lfcRecoverOutput) {
+    LeaseFileIO input(Memfile_LeaseMgr::appendSuffix(
+                          io6_.testfile_, Memfile_LeaseMgr::FILE_INPUT));
+    LeaseFileIO previous(Memfile_LeaseMgr::appendSuffix(
+                             io6_.testfile_, Memfile_LeaseMgr::FILE_PREVIOUS));
+    LeaseFileIO output(Memfile_LeaseMgr::appendSuffix(
+                           io6_.testfile_, Memfile_LeaseMgr::FILE_OUTPUT));
+    const std::string header("address,duid,valid_lifetime,expire,subnet_id,"
+                             "pref_lifetime,lease_type,iaid,prefix_len,"
+                             "fqdn_fwd,fqdn_rev,hostname\n");
+    previous.writeFile(header +
+                       "2001:db8:1::1,00:01:02:03:04:05,200,200,8,100,0,7,"
+                       "128,0,0,\n");
+    input.writeFile(header +
+                    "2001:db8:1::1,00:01:02:03:04:05,300,300,8,100,0,7,"
+                    "128,0,0,\n"
+                    "2001:db8:1::2,00:01:02:03:04:06,200,200,8,100,0,7,"
+                    "128,0,0,\n");
+    // Partially written file.
+    output.writeFile(header + "2001:db8:1::1,00:01:02");
+
+    startBackend(V6);
+    EXPECT_FALSE(output.exists());
+    EXPECT_TRUE(input.exists());
+    EXPECT_TRUE(previous.exists());
+
+    Lease6Ptr lease = lmptr_->getLease6(Lease::TYPE_NA,
+                                        IOAddress("2001:db8:1::1"));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(300, lease->valid_lft_);
+    EXPECT_TRUE(lmptr_->getLease6(Lease::TYPE_NA, IOAddress("2001:db8:1::2")));
+
+    // The compaction writes all the leases, and removes the input file.
+    Memfile_LeaseMgr* lease_mgr = dynamic_cast<Memfile_LeaseMgr*>(lmptr_);
+    ASSERT_TRUE(lease_mgr);
+    ASSERT_TRUE(lease_mgr->lfcStart());
+    lease_mgr->lfcWait();
+    EXPECT_FALSE(input.exists());
+    EXPECT_EQ(2, countLeaseRecords(previous));
+}
+
 // The following tests are not applicable for memfile. When adding
 // new tests to the list here, make sure to provide brief explanation
 // why they are not applicable:
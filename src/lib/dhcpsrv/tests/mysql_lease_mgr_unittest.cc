@@ -506,4 +506,20 @@ TEST_F(MySqlLeaseMgrTest, testRecreateLease6) {
     testRecreateLease6();
 }
 
+/// @brief Expired DHCPv4 leases tests
+///
+/// Checks that the expired leases can be retrieved in the order of
+/// their expiration time.
+TEST_F(MySqlLeaseMgrTest, getExpiredLeases4) {
+    testGetExpiredLeases4();
+}
+
+/// @brief Expired DHCPv6 leases tests
+///
+/// Checks that the expired leases can be retrieved in the order of
+/// their expiration time.
+TEST_F(MySqlLeaseMgrTest, getExpiredLeases6) {
+    testGetExpiredLeases6();
+}
+
 }; // Of anonymous namespace
@@ -456,4 +456,20 @@ TEST_F(PgSqlLeaseMgrTest, updateLease6) {
     testUpdateLease6();
 }
 
+/// @brief Expired DHCPv4 leases tests
+///
+/// Checks that the expired leases can be retrieved in the order of
+/// their expiration time.
+TEST_F(PgSqlLeaseMgrTest, getExpiredLeases4) {
+    testGetExpiredLeases4();
+}
+
+/// @brief Expired DHCPv6 leases tests
+///
+/// Checks that the expired leases can be retrieved in the order of
+/// their expiration time.
+TEST_F(PgSqlLeaseMgrTest, getExpiredLeases6) {
+    testGetExpiredLeases6();
+}
+
 };
@@ -59,6 +59,8 @@ const char* create_statement[] = {
 
     "CREATE INDEX lease4_by_client_id_subnet_id ON lease4 (client_id, subnet_id)",
 
+    "CREATE INDEX lease4_by_expire ON lease4 (expire)",
+
     "CREATE TABLE lease6 ("
         "address VARCHAR(39) PRIMARY KEY NOT NULL,"
         "duid VARBINARY(128),"
@@ -76,6 +78,8 @@ const char* create_statement[] = {
 
     "CREATE INDEX lease6_by_iaid_subnet_id_duid ON lease6 (iaid, subnet_id, duid)",
 
+    "CREATE INDEX lease6_by_expire ON lease6 (expire)",
+
     "CREATE TABLE lease6_types ("
         "lease_type TINYINT PRIMARY KEY NOT NULL,"
         "name VARCHAR(5)"
@@ -90,7 +94,7 @@ const char* create_statement[] = {
         "minor INT"
         ")",
 
-    "INSERT INTO schema_version VALUES (1, 0)",
+    "INSERT INTO schema_version VALUES (1, 1)",
     "COMMIT",
 
     NULL
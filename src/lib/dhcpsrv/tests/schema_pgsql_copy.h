@@ -55,6 +55,8 @@ const char* create_statement[] = {
     "hostname VARCHAR(255)"
     ")",
 
+    "CREATE INDEX lease4_by_expire ON lease4 (expire)",
+
     "CREATE TABLE lease6 ("
     "address VARCHAR(39) PRIMARY KEY NOT NULL,"
     "duid BYTEA,"
@@ -70,6 +72,8 @@ const char* create_statement[] = {
     "hostname VARCHAR(255)"
     ")",
 
+    "CREATE INDEX lease6_by_expire ON lease6 (expire)",
+
     "CREATE TABLE lease6_types ("
     "lease_type SMALLINT PRIMARY KEY NOT NULL,"
     "name VARCHAR(5)"
@@ -84,7 +88,7 @@ const char* create_statement[] = {
         "minor INT"
         ")",
 
-    "INSERT INTO schema_version VALUES (1, 0)",
+    "INSERT INTO schema_version VALUES (1, 1)",
     "COMMIT",
 
     NULL
@@ -0,0 +1,271 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <dns/name.h>
+#include <dns/name_internal.h>
+#include <dns/labelsequence.h>
+
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace bundy::bench;
+using namespace bundy::dns;
+using namespace bundy::dns::name::internal;
+
+namespace {
+// The original byte-by-byte implementation of the case-insensitive
+// comparison and hash, for reference.
+bool
+equalsByteWise(const LabelSequence& seq1, const LabelSequence& seq2) {
+    size_t len1, len2;
+    const uint8_t* data1 = seq1.getData(&len1);
+    const uint8_t* data2 = seq2.getData(&len2);
+    if (len1 != len2) {
+        return (false);
+    }
+    for (size_t i = 0; i < len1; ++i) {
+        if (maptolower[data1[i]] != maptolower[data2[i]]) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+size_t
+hashByteWise(const LabelSequence& seq) {
+    size_t length;
+    const uint8_t* s = seq.getData(&length);
+    if (length > 16) {
+        length = 16;
+    }
+    size_t hash_val = 0;
+    while (length > 0) {
+        boost::hash_combine(hash_val, maptolower[*s]);
+        ++s;
+        --length;
+    }
+    return (hash_val);
+}
+
+// Common base of the benchmarks: it holds label sequences of the given
+// names, and another set of the same names with different cases (as would
+// happen between a query name and the name stored in a zone).
+class LabelSequenceBenchMarkBase {
+protected:
+    LabelSequenceBenchMarkBase(const vector<Name>& names,
+                               const vector<Name>& other_names,
+                               bool byte_wise) :
+        byte_wise_(byte_wise), result_(0)
+    {
+        for (size_t i = 0; i < names.size(); ++i) {
+            sequences_.push_back(LabelSequence(names[i]));
+            other_sequences_.push_back(LabelSequence(other_names[i]));
+        }
+    }
+    vector<LabelSequence> sequences_;
+    vector<LabelSequence> other_sequences_;
+    const bool byte_wise_;
+    // Accumulate the results so the compiler cannot skip the calls.
+    size_t result_;
+};
+
+// Case-insensitive equality of each name with its counterpart.  This is
+// the typical comparison done in the name compression of MessageRenderer
+// once the hash matches.
+class EqualsBenchMark : public LabelSequenceBenchMarkBase {
+public:
+    EqualsBenchMark(const vector<Name>& names,
+                    const vector<Name>& other_names, bool byte_wise) :
+        LabelSequenceBenchMarkBase(names, other_names, byte_wise)
+    {}
+    unsigned int run() {
+        for (size_t i = 0; i < sequences_.size(); ++i) {
+            result_ += byte_wise_ ?
+                equalsByteWise(sequences_[i], other_sequences_[i]) :
+                sequences_[i].equals(other_sequences_[i], false);
+        }
+        return (sequences_.size());
+    }
+};
+
+// Case-insensitive comparison of every pair of names, as done in the
+// DomainTree search.
+class CompareBenchMark : public LabelSequenceBenchMarkBase {
+public:
+    CompareBenchMark(const vector<Name>& names,
+                     const vector<Name>& other_names) :
+        LabelSequenceBenchMarkBase(names, other_names, false)
+    {}
+    unsigned int run() {
+        for (size_t i = 0; i < sequences_.size(); ++i) {
+            for (size_t j = 0; j < other_sequences_.size(); ++j) {
+                result_ += sequences_[i].compare(other_sequences_[j],
+                                                 false).getOrder();
+            }
+        }
+        return (sequences_.size() * other_sequences_.size());
+    }
+};
+
+// Case-insensitive hash of each name.
+class HashBenchMark : public LabelSequenceBenchMarkBase {
+public:
+    HashBenchMark(const vector<Name>& names,
+                  const vector<Name>& other_names, bool byte_wise) :
+        LabelSequenceBenchMarkBase(names, other_names, byte_wise)
+    {}
+    unsigned int run() {
+        for (size_t i = 0; i < sequences_.size(); ++i) {
+            result_ += byte_wise_ ? hashByteWise(sequences_[i]) :
+                sequences_[i].getHash(false);
+        }
+        return (sequences_.size());
+    }
+};
+
+//
+// Builtin benchmark data.
+//
+// Names in a referral response from a root server for "www.example.com"
+// (see message_renderer_bench.cc).
+const char* const root_to_com_names[] = {
+    "www.example.com", "com",
+    "a.gtld-servers.net", "b.gtld-servers.net", "c.gtld-servers.net",
+    "d.gtld-servers.net", "e.gtld-servers.net", "f.gtld-servers.net",
+    "g.gtld-servers.net", "h.gtld-servers.net", "i.gtld-servers.net",
+    "j.gtld-servers.net", "k.gtld-servers.net", "l.gtld-servers.net",
+    "m.gtld-servers.net",
+    NULL
+};
+
+// NSEC3 owner names of a signed zone (taken from RFC 5155, Appendix A).
+// These have long labels, and are compared heavily in the NSEC3 tree of
+// in-memory zones.
+const char* const nsec3_names[] = {
+    "0p9mhaveqvm6t7vbl5lop2u3t2rp3tom.example",
+    "2t7b4g4vsa5smi47k61mv5bv1a22bojr.example",
+    "2vptu5timamqttgl4luu9kg21e0aor3s.example",
+    "35mthgpgcu1qg68fab165klnsnk3dpvl.example",
+    "b4um86eghhds6nea196smvmlo4ors995.example",
+    "gjeqe526plbf1g8mklp59enfd789njgi.example",
+    "k8udemvp1j2f7eg6jebps17vp3n8i58h.example",
+    "q04jkcevqvmu85r014c7dkba38o0ji5r.example",
+    "r53bq7cc2uvmubfu5ocmm6pers9tk9en.example",
+    "t644ebqk9bibcna874givr6joj62mlhv.example",
+    NULL
+};
+
+// Long host names, e.g., of a content delivery network.
+const char* const long_names[] = {
+    "e1234.dscb.akamaiedge-staging.net.edgekey.example.com",
+    "static-content-delivery-frontend-cluster01.cdn.example.com",
+    "static-content-delivery-frontend-cluster02.cdn.example.com",
+    "ec2-198-51-100-17.ap-northeast-1.compute.amazonaws.example",
+    "ec2-203-0-113-254.ap-northeast-1.compute.amazonaws.example",
+    "a-very-long-label-of-sixty-three-octets-which-is-the-maximum-le.com",
+    NULL
+};
+
+const char* const impl_names[] = { "portable", "SSE2", "AVX2" };
+
+void
+usage() {
+    cerr << "Usage: labelsequence_bench [-n iterations]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 100000;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+
+    typedef pair<const char* const*, string> DataSpec;
+    vector<DataSpec> spec_list;
+    spec_list.push_back(DataSpec(root_to_com_names, "(root referral)"));
+    spec_list.push_back(DataSpec(nsec3_names, "(NSEC3 names)"));
+    spec_list.push_back(DataSpec(long_names, "(long names)"));
+
+    const CaseImpl default_impl = getCaseImpl();
+    for (vector<DataSpec>::const_iterator it = spec_list.begin();
+         it != spec_list.end();
+         ++it) {
+        vector<Name> names;
+        vector<Name> upper_names;
+        for (size_t i = 0; it->first[i] != NULL; ++i) {
+            string upper(it->first[i]);
+            transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+            names.push_back(Name(it->first[i]));
+            upper_names.push_back(Name(upper));
+        }
+
+        cout << "Benchmark for byte-wise equals " << it->second << endl;
+        BenchMark<EqualsBenchMark>(iteration,
+                                   EqualsBenchMark(names, upper_names, true));
+        cout << "Benchmark for byte-wise getHash " << it->second << endl;
+        BenchMark<HashBenchMark>(iteration,
+                                 HashBenchMark(names, upper_names, true));
+        cout << "Benchmark for getHash " << it->second << endl;
+        BenchMark<HashBenchMark>(iteration,
+                                 HashBenchMark(names, upper_names, false));
+
+        for (int impl = CASE_IMPL_PORTABLE; impl <= CASE_IMPL_AVX2; ++impl) {
+            if (!setCaseImpl(static_cast<CaseImpl>(impl))) {
+                cout << "(" << impl_names[impl] << " is not available)"
+                     << endl;
+                continue;
+            }
+            cout << "Benchmark for " << impl_names[impl] << " equals "
+                 << it->second << endl;
+            BenchMark<EqualsBenchMark>(iteration,
+                                       EqualsBenchMark(names, upper_names,
+                                                       false));
+            cout << "Benchmark for " << impl_names[impl] << " compare "
+                 << it->second << endl;
+            BenchMark<CompareBenchMark>(iteration,
+                                        CompareBenchMark(names, upper_names));
+        }
+        setCaseImpl(default_impl);
+    }
+
+    return (0);
+}
@@ -126,13 +126,14 @@ toWireCommon(Output& output, const uint8_t version,
         extrcode_flags |= EXTFLAG_DO;
     }
 
-    // Construct an RRset corresponding to the EDNS.
-    // We don't support any options for now, so the OPT RR can be empty.
-    RRsetPtr edns_rrset(new RRset(Name::ROOT_NAME(), RRClass(udp_size),
-                                  RRType::OPT(), RRTTL(extrcode_flags)));
-    edns_rrset->addRdata(ConstRdataPtr(new generic::OPT()));
-
-    edns_rrset->toWire(output);
+    // Render the OPT RR field by field; this is done for most responses,
+    // and constructing an RRset for it would require a few allocations.
+    // We don't support any options for now, so the OPT RR is empty.
+    Name::ROOT_NAME().toWire(output);
+    RRType::OPT().toWire(output);
+    RRClass(udp_size).toWire(output);
+    RRTTL(extrcode_flags).toWire(output);
+    output.writeUint16(0);      // RDLEN
 
     return (1);
 }
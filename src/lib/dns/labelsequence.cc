@@ -18,8 +18,6 @@
 #include <dns/name_internal.h>
 #include <exceptions/exceptions.h>
 
-#include <boost/functional/hash.hpp>
-
 #include <cstring>
 
 namespace bundy {
@@ -161,15 +159,7 @@ LabelSequence::equals(const LabelSequence& other, bool case_sensitive) const {
     // As long as the data was originally validated as (part of) a name,
     // label length must never be a capital ascii character, so we can
     // simply compare them after converting to lower characters.
-    for (size_t i = 0; i < len; ++i) {
-        const uint8_t ch = data[i];
-        const uint8_t other_ch = other_data[i];
-        if (bundy::dns::name::internal::maptolower[ch] !=
-            bundy::dns::name::internal::maptolower[other_ch]) {
-            return (false);
-        }
-    }
-    return (true);
+    return (bundy::dns::name::internal::equalsLower(data, other_data, len));
 }
 
 NameComparisonResult
@@ -200,31 +190,23 @@ LabelSequence::compare(const LabelSequence& other,
         assert(count1 <= Name::MAX_LABELLEN && count2 <= Name::MAX_LABELLEN);
 
         const int cdiff = static_cast<int>(count1) - static_cast<int>(count2);
-        unsigned int count = (cdiff < 0) ? count1 : count2;
-
-        while (count > 0) {
-            const uint8_t label1 = data_[pos1];
-            const uint8_t label2 = other.data_[pos2];
-            int chdiff;
-
-            if (case_sensitive) {
-                chdiff = static_cast<int>(label1) - static_cast<int>(label2);
-            } else {
-                chdiff = static_cast<int>(
-                    bundy::dns::name::internal::maptolower[label1]) -
-                    static_cast<int>(
-                        bundy::dns::name::internal::maptolower[label2]);
-            }
+        const unsigned int count = (cdiff < 0) ? count1 : count2;
 
-            if (chdiff != 0) {
-                return (NameComparisonResult(
-                            chdiff, nlabels,
-                            nlabels == 0 ? NameComparisonResult::NONE :
-                            NameComparisonResult::COMMONANCESTOR));
+        int chdiff = 0;
+        if (case_sensitive) {
+            for (unsigned int i = 0; i < count && chdiff == 0; ++i) {
+                chdiff = static_cast<int>(data_[pos1 + i]) -
+                    static_cast<int>(other.data_[pos2 + i]);
             }
-            --count;
-            ++pos1;
-            ++pos2;
+        } else {
+            chdiff = bundy::dns::name::internal::compareLower(
+                &data_[pos1], &other.data_[pos2], count);
+        }
+        if (chdiff != 0) {
+            return (NameComparisonResult(
+                        chdiff, nlabels,
+                        nlabels == 0 ? NameComparisonResult::NONE :
+                        NameComparisonResult::COMMONANCESTOR));
         }
         if (cdiff != 0) {
             return (NameComparisonResult(
@@ -273,18 +255,7 @@ size_t
 LabelSequence::getHash(bool case_sensitive) const {
     size_t length;
     const uint8_t* s = getData(&length);
-    if (length > 16) {
-        length = 16;
-    }
-
-    size_t hash_val = 0;
-    while (length > 0) {
-        const uint8_t c = *s++;
-        boost::hash_combine(hash_val, case_sensitive ? c :
-                            bundy::dns::name::internal::maptolower[c]);
-        --length;
-    }
-    return (hash_val);
+    return (bundy::dns::name::internal::hashData(s, length, case_sensitive));
 }
 
 std::string
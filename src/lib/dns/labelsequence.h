@@ -372,7 +372,8 @@ public:
     /// This method is intended to provide a lightweight way to store a
     /// relatively small number of label sequences in a hash table.
     /// For this reason it only takes into account data up to 16 octets
-    /// (16 was derived from BIND 9's implementation).  Also, the function does
+    /// (16 was derived from BIND 9's implementation) and the total length.
+    /// The hash value may differ between platforms.  Also, the function does
     /// not provide any unpredictability; a specific sequence will always have
     /// the same hash value.  It should therefore not be used in the context
     /// where an untrusted third party can mount a denial of service attack by
@@ -394,6 +394,8 @@ public:
     String() {}
     virtual ~String() {}      // see the base class for the destructor
     virtual void handle(MasterLexer& lexer) const;
+private:
+    void handleMapped(MasterLexer& lexer) const;
 };
 
 class QString : public State {
@@ -514,6 +516,12 @@ State::start(MasterLexer& lexer, MasterLexer::Options options) {
 
 void
 String::handle(MasterLexer& lexer) const {
+    InputSource& source = *getLexerImpl(lexer)->source_;
+    if (source.isMapped()) {
+        handleMapped(lexer);
+        return;
+    }
+
     std::vector<char>& data = getLexerImpl(lexer)->data_;
     data.clear();
 
@@ -536,6 +544,44 @@ String::handle(MasterLexer& lexer) const {
     }
 }
 
+// If the source is in memory, the string is taken from the source as is:
+// String::handle() stores all characters of the token verbatim, so the token
+// is always a contiguous part of the source (a comment can only follow it).
+// Most characters are skipped without looking at them one by one, and the
+// token refers to the source data instead of a copy, unless it's at the very
+// end of the source, where it can't be nul-terminated.
+void
+String::handleMapped(MasterLexer& lexer) const {
+    InputSource& source = *getLexerImpl(lexer)->source_;
+    std::vector<char>& data = getLexerImpl(lexer)->data_;
+    MasterToken& token = getLexerImpl(lexer)->token_;
+    const char* const beg = source.getCurrentData();
+    size_t len = 0;
+
+    bool escaped = false;
+    while (true) {
+        if (!escaped) {
+            len += source.skipStringChars();
+        }
+        const int c = getLexerImpl(lexer)->skipComment(source.getChar(),
+                                                       escaped);
+
+        if (getLexerImpl(lexer)->isTokenEnd(c, escaped)) {
+            source.ungetChar();
+            if (source.terminateString(beg, len)) {
+                token = MasterToken(beg, len);
+            } else {
+                data.assign(beg, beg + len);
+                data.push_back('\0');
+                token = MasterToken(&data.at(0), len);
+            }
+            return;
+        }
+        escaped = (c == '\\' && !escaped);
+        ++len;
+    }
+}
+
 void
 QString::handle(MasterLexer& lexer) const {
     MasterToken& token = getLexerImpl(lexer)->token_;
@@ -21,6 +21,18 @@
 #include <cerrno>
 #include <cstring>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// SSE2 is part of the base x86-64 architecture (and is enabled by the
+// compiler for 32-bit x86 only if the target supports it).
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define INPUTSOURCE_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
 namespace bundy {
 namespace dns {
 namespace master_lexer_internal {
@@ -94,6 +106,10 @@ InputSource::InputSource(std::istream& input_stream) :
     saved_line_(line_),
     buffer_pos_(0),
     total_pos_(0),
+    map_size_(0),
+    map_(NULL),
+    terminated_(NULL),
+    terminated_char_(0),
     name_(createStreamName(input_stream)),
     input_(input_stream),
     input_size_(getStreamSize(input_))
@@ -118,6 +134,32 @@ openFileStream(std::ifstream& file_stream, const char* filename) {
 
     return (file_stream);
 }
+
+// Map the given file into memory if it's a non-empty regular file, and
+// return the address of the mapping (NULL if it can't be mapped).  The
+// mapping is private and writable, so terminateString() can modify it
+// without modifying the file.  Any error results in NULL; the file is then
+// opened as a stream, which reports the error if it's really unusable.
+char*
+mapFile(const char* filename, size_t& size) {
+    const int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        return (NULL);
+    }
+    struct stat st;
+    void* addr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd, 0);
+        if (addr != MAP_FAILED) {
+            size = st.st_size;
+            // This is only a hint, so we ignore any failure.
+            madvise(addr, size, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    return (addr == MAP_FAILED ? NULL : static_cast<char*>(addr));
+}
 }
 
 InputSource::InputSource(const char* filename) :
@@ -126,13 +168,21 @@ InputSource::InputSource(const char* filename) :
     saved_line_(line_),
     buffer_pos_(0),
     total_pos_(0),
+    map_size_(0),
+    map_(mapFile(filename, map_size_)),
+    terminated_(NULL),
+    terminated_char_(0),
     name_(filename),
-    input_(openFileStream(file_stream_, filename)),
-    input_size_(getStreamSize(input_))
+    input_(map_ != NULL ? file_stream_ :
+           openFileStream(file_stream_, filename)),
+    input_size_(map_ != NULL ? map_size_ : getStreamSize(input_))
 {}
 
 InputSource::~InputSource()
 {
+    if (map_ != NULL) {
+        munmap(map_, map_size_);
+    }
     if (file_stream_.is_open()) {
         file_stream_.close();
     }
@@ -140,6 +190,20 @@ InputSource::~InputSource()
 
 int
 InputSource::getChar() {
+    if (map_ != NULL) {
+        if (total_pos_ == map_size_) {
+            at_eof_ = true;
+            return (END_OF_STREAM);
+        }
+        const int c = map_[total_pos_];
+        ++buffer_pos_;
+        ++total_pos_;
+        if (c == '\n') {
+            ++line_;
+        }
+        return (c);
+    }
+
     if (buffer_pos_ == buffer_.size()) {
         // We may have reached EOF at the last call to
         // getChar(). at_eof_ will be set then. We then simply return
@@ -185,7 +249,9 @@ InputSource::ungetChar() {
     } else {
         --buffer_pos_;
         --total_pos_;
-        if (buffer_[buffer_pos_] == '\n') {
+        const char c = (map_ != NULL) ? map_[total_pos_] :
+            buffer_[buffer_pos_];
+        if (c == '\n') {
             --line_;
         }
     }
@@ -207,6 +273,11 @@ InputSource::saveLine() {
 
 void
 InputSource::compact() {
+    if (map_ != NULL) {
+        // Everything stays in the mapping; we just forget what was read.
+        buffer_pos_ = 0;
+        return;
+    }
     if (buffer_pos_ == buffer_.size()) {
         buffer_.clear();
     } else {
@@ -218,10 +289,75 @@ InputSource::compact() {
 
 void
 InputSource::mark() {
+    if (terminated_ != NULL) {
+        *terminated_ = terminated_char_;
+        terminated_ = NULL;
+    }
     saveLine();
     compact();
 }
 
+namespace {
+// Return true if c may need special handling in a string token (see
+// skipStringChars()).  The lexer ignores the highest bit of characters
+// when checking for separators, so we also stop at any character with the
+// highest bit set.
+inline bool
+isSpecialChar(char c) {
+    const unsigned char uc = c;
+    return (uc <= ')' || uc >= 0x80 || uc == ';' || uc == '\\');
+}
+}
+
+size_t
+InputSource::skipStringChars() {
+    assert(map_ != NULL);
+    const char* const beg = map_ + total_pos_;
+    const char* const end = map_ + map_size_;
+    const char* p = beg;
+#ifdef INPUTSOURCE_USE_SSE2
+    // All separators, and the control characters, are ')' or smaller.
+    // Characters with the highest bit set are negative as signed values,
+    // so a signed comparison finds both.
+    const __m128i max_plain = _mm_set1_epi8(')' + 1);
+    const __m128i semicolon = _mm_set1_epi8(';');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; p + 16 <= end; p += 16) {
+        const __m128i val =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i special =
+            _mm_or_si128(_mm_cmplt_epi8(val, max_plain),
+                         _mm_or_si128(_mm_cmpeq_epi8(val, semicolon),
+                                      _mm_cmpeq_epi8(val, backslash)));
+        const int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            p += __builtin_ctz(mask);
+            break;
+        }
+    }
+#endif
+    while (p < end && !isSpecialChar(*p)) {
+        ++p;
+    }
+    const size_t count = p - beg;
+    buffer_pos_ += count;
+    total_pos_ += count;
+    return (count);
+}
+
+bool
+InputSource::terminateString(const char* beg, size_t len) {
+    assert(map_ != NULL && terminated_ == NULL);
+    assert(beg >= map_ && beg + len <= map_ + map_size_);
+    if (beg + len == map_ + map_size_) {
+        return (false);
+    }
+    terminated_ = map_ + (beg + len - map_);
+    terminated_char_ = *terminated_;
+    *terminated_ = '\0';
+    return (true);
+}
+
 } // namespace master_lexer_internal
 } // namespace dns
 } // namespace bundy
@@ -70,8 +70,12 @@ public:
     /// detected.
     explicit InputSource(std::istream& input_stream);
 
-    /// \brief Constructor which takes a filename to read from. The
-    /// associated file stream is managed internally.
+    /// \brief Constructor which takes a filename to read from.
+    ///
+    /// If the file is a non-empty regular file, it's mapped into memory
+    /// (privately, so the file itself is never modified) and read from
+    /// there; otherwise an associated file stream is managed internally.
+    /// See \c isMapped().
     ///
     /// \throws OpenError when opening the input file fails or the size of
     /// the file cannot be detected.
@@ -143,8 +147,65 @@ public:
     void compact();
 
     /// Calls \c saveLine() and \c compact() in sequence.
+    ///
+    /// It also undoes the effect of the last \c terminateString(), if any.
     void mark();
 
+    /// \brief Returns if the whole source is available in memory.
+    ///
+    /// If it is, \c getCurrentData(), \c skipStringChars() and
+    /// \c terminateString() can be used to scan the source without
+    /// copying its data.
+    ///
+    /// \throw None
+    bool isMapped() const {
+        return (map_ != NULL);
+    }
+
+    /// \brief Returns a pointer to the character that the next call to
+    /// \c getChar() will return.
+    ///
+    /// This must only be called if \c isMapped() is true.  The pointer
+    /// refers to the end of the data (which is not necessarily readable)
+    /// if the end of the source is reached.
+    ///
+    /// \throw None
+    const char* getCurrentData() const {
+        return (map_ + total_pos_);
+    }
+
+    /// \brief Skips characters that can be part of a string token
+    /// without further checks.
+    ///
+    /// This is a faster equivalent of calling \c getChar() as long as it
+    /// returns a character that is not a separator of a string, the start
+    /// of a comment or an escape (a backslash).  It may stop earlier,
+    /// at some other characters (such as those with the highest bit set),
+    /// so the caller has to examine the next character with \c getChar()
+    /// as usual.  The characters skipped are never a newline.
+    ///
+    /// This must only be called if \c isMapped() is true.
+    ///
+    /// \throw None
+    /// \return The number of characters skipped.
+    size_t skipStringChars();
+
+    /// \brief Makes a string in the source nul-terminated.
+    ///
+    /// This overwrites the character after the string of \c len characters
+    /// starting at \c beg with a nul character, so the string can be used
+    /// as a C string without copying it.  The original character is
+    /// restored by the next call to \c mark().  If the string ends at the
+    /// end of the source, this isn't possible, and false is returned.
+    ///
+    /// This must only be called if \c isMapped() is true, and \c beg must
+    /// have been returned by \c getCurrentData() after the last call to
+    /// \c mark().
+    ///
+    /// \throw None
+    /// \return true if the string was terminated.
+    bool terminateString(const char* beg, size_t len);
+
     /// \brief Returns a single character from the input source. If end
     /// of file is reached, \c END_OF_STREAM is returned.
     ///
@@ -176,6 +237,14 @@ private:
     size_t buffer_pos_;
     size_t total_pos_;
 
+    // The contents of the file if it's mapped (NULL otherwise).  Then
+    // total_pos_ is the offset of the next character in it, and buffer_pos_
+    // the number of characters read since the last compact().
+    size_t map_size_;
+    char* map_;
+    char* terminated_;          // position of a nul set by terminateString()
+    char terminated_char_;      // the original character at that position
+
     const std::string name_;
     std::ifstream file_stream_;
     std::istream& input_;
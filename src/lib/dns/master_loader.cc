@@ -21,16 +21,28 @@
 #include <dns/rrtype.h>
 #include <dns/rdata.h>
 
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
+#include <boost/function.hpp>
 #include <boost/algorithm/string/predicate.hpp> // for iequals
+#include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
 #include <string>
 #include <memory>
 #include <vector>
 
 #include <cstdio> // for sscanf()
+#include <strings.h> // for strncasecmp()
+#include <unistd.h> // for sysconf()
 
 using std::string;
 using std::auto_ptr;
@@ -38,6 +50,9 @@ using std::vector;
 using std::pair;
 using boost::algorithm::iequals;
 using boost::shared_ptr;
+using bundy::util::thread::CondVar;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
 
 namespace bundy {
 namespace dns {
@@ -54,6 +69,388 @@ public:
     {}
 };
 
+// The message of the error for an RR whose TTL can't be determined.
+const char* const NO_TTL_ERROR = "no TTL specified; load rejected";
+
+// An item recorded by the parser of a chunk in the parallel mode: a parsed
+// RR, a $TTL directive, or an issue to be reported to the callbacks.
+struct ParsedItem {
+    enum Type {
+        RR,
+        DEFAULT_TTL,
+        WARNING,
+        ERROR
+    };
+
+    ParsedItem(Type type, size_t source, size_t line) :
+        type_(type), source_(source), line_(line), rrtype_(0),
+        explicit_ttl_(false), ttl_(0), generated_(false), at_eof_(false)
+    {}
+
+    Type type_;
+    size_t source_;             // index to ParsedChunk::sources_
+    size_t line_;               // for RR, the line of the lexer after the RR
+    shared_ptr<Name> name_;     // (RR) owner name
+    RRType rrtype_;             // (RR)
+    rdata::RdataPtr rdata_;     // (RR)
+    bool explicit_ttl_;         // (RR) true if the RR has the TTL field
+    RRTTL ttl_;                 // (RR with explicit TTL, DEFAULT_TTL)
+    bool generated_;            // (RR) generated by $GENERATE
+    bool at_eof_;               // (RR) the RR ends at the end of file
+    string reason_;             // (WARNING, ERROR)
+};
+
+// A part of the top level input, which is a sequence of complete lines,
+// and the results of parsing it in the parallel mode.
+struct ParsedChunk {
+    ParsedChunk(const char* data, size_t size, size_t line,
+                const string& source, const Name& origin) :
+        data_(data), size_(size), line_(line), source_(source),
+        origin_(origin), done_(false)
+    {}
+
+    // Record an RR.  The source and line are those given by the lexer of
+    // the parser of the chunk, and ttl is NULL unless the TTL is explicitly
+    // specified for the RR.
+    ParsedItem& addRR(const shared_ptr<Name>& name, const RRType& rrtype,
+                      const rdata::RdataPtr& rdata, const RRTTL* ttl,
+                      const string& source_name, size_t line)
+    {
+        const size_t source = getSource(source_name, line);
+        items_.push_back(ParsedItem(ParsedItem::RR, source, line));
+        ParsedItem& item = items_.back();
+        item.name_ = name;
+        item.rrtype_ = rrtype;
+        item.rdata_ = rdata;
+        if (ttl != NULL) {
+            item.explicit_ttl_ = true;
+            item.ttl_ = *ttl;
+        }
+        return (item);
+    }
+
+    void addDefaultTTL(const RRTTL& ttl, const string& source_name,
+                       size_t line)
+    {
+        const size_t source = getSource(source_name, line);
+        items_.push_back(ParsedItem(ParsedItem::DEFAULT_TTL, source, line));
+        items_.back().ttl_ = ttl;
+    }
+
+    // Used as the callbacks of the parser.
+    void addIssue(ParsedItem::Type type, const string& source_name,
+                  size_t line, const string& reason)
+    {
+        const size_t source = getSource(source_name, line);
+        items_.push_back(ParsedItem(type, source, line));
+        items_.back().reason_ = reason;
+    }
+
+    // Return the index of the given source name in sources_, converting
+    // the name and line of the chunk as a source to those in the top level
+    // input.  Included files are not converted.
+    size_t getSource(const string& source_name, size_t& line) {
+        const string* name = &source_name;
+        if (source_name == chunk_source_) {
+            name = &source_;
+            line += line_ - 1;
+        }
+        if (sources_.empty() || sources_.back() != *name) {
+            sources_.push_back(*name);
+        }
+        return (sources_.size() - 1);
+    }
+
+    const char* const data_;
+    const size_t size_;
+    const size_t line_;         // The number of the first line in the input
+    const string source_;       // The name of the top level input
+    const Name origin_;         // The origin at the beginning of the chunk
+    string chunk_source_;       // The name of the chunk given by the parser
+    vector<string> sources_;
+    vector<ParsedItem> items_;
+    string failure_;            // what() of an unexpected exception
+    bool done_;                 // Parsing completed (protected by the mutex
+                                // of ParallelLoad)
+};
+
+// The state of a load in the parallel mode.
+//
+// The whole top level input is read into memory and split into chunks at
+// the beginning of lines with an owner name, so the only context needed
+// to parse a chunk is the origin, which is tracked while splitting.  The
+// chunks are parsed by worker threads, at most a few chunks ahead of the
+// one being consumed, so the memory used for the results stays small.
+// The TTL of an RR that doesn't specify one depends on the preceding RRs,
+// so it's determined when the results are consumed in the original order
+// (see MasterLoaderImpl::loadParallel()).
+class ParallelLoad : boost::noncopyable {
+public:
+    typedef boost::function<void(ParsedChunk&)> ChunkParser;
+
+    ParallelLoad(std::istream& input, const string& source_name,
+                 const Name& origin, const ChunkParser& parser);
+    ~ParallelLoad();
+
+    // Return the next item in the input, waiting for it to be parsed if
+    // needed, or NULL at the end of the input.  The item (and its source
+    // name) is valid until the next call.
+    const ParsedItem* getNextItem();
+
+    const string& getSourceName(const ParsedItem& item) const {
+        return (chunks_[current_]->sources_[item.source_]);
+    }
+
+    // Skip the rest of the RRs generated by the same $GENERATE as the given
+    // item, which must be the one returned by the last getNextItem().
+    void skipGenerated(const ParsedItem& item) {
+        const vector<ParsedItem>& items = chunks_[current_]->items_;
+        while (current_item_ < items.size() &&
+               items[current_item_].generated_ &&
+               items[current_item_].source_ == item.source_ &&
+               items[current_item_].line_ == item.line_) {
+            ++current_item_;
+        }
+    }
+
+    // The size of the chunks consumed so far.
+    size_t getPosition() const {
+        return (position_);
+    }
+
+private:
+    void split(const string& source_name, const Name& origin);
+    size_t skipLine(size_t pos, size_t& line) const;
+    void run();
+    void stop();
+
+    string data_;
+    const ChunkParser parser_;
+    vector<shared_ptr<ParsedChunk> > chunks_;
+    size_t current_;            // The chunk being consumed
+    size_t current_item_;       // The next item in the current chunk
+    size_t position_;
+    size_t window_;             // How many chunks can be parsed ahead
+    vector<shared_ptr<Thread> > threads_;
+
+    // The following are protected by mutex_.
+    Mutex mutex_;
+    CondVar parsed_cond_;       // A chunk was parsed
+    CondVar consumed_cond_;     // A chunk was consumed (or stopping_ is set)
+    size_t next_;               // The next chunk to be parsed
+    bool stopping_;
+};
+
+// Chunks are at least about this size, unless the input is smaller.  This
+// should be large enough to make the per-chunk overhead negligible.
+const size_t CHUNK_SIZE = 256 * 1024;
+
+// Read all (remaining) data of the stream.
+void
+readInput(std::istream& input, const string& source_name, string& data) {
+    char buffer[64 * 1024];
+    while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+        data.append(buffer, input.gcount());
+    }
+    if (input.bad()) {
+        bundy_throw(MasterLexer::ReadError,
+                    "Error reading from the input stream: " << source_name);
+    }
+}
+
+ParallelLoad::ParallelLoad(std::istream& input, const string& source_name,
+                           const Name& origin, const ChunkParser& parser) :
+    parser_(parser), current_(0), current_item_(0), position_(0),
+    window_(0), next_(0), stopping_(false)
+{
+    readInput(input, source_name, data_);
+    split(source_name, origin);
+
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t thread_count =
+        std::min(static_cast<size_t>(cpus > 0 ? cpus : 1), chunks_.size());
+    window_ = thread_count * 2;
+    try {
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads_.push_back(shared_ptr<Thread>(
+                new Thread(boost::bind(&ParallelLoad::run, this))));
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+ParallelLoad::~ParallelLoad() {
+    stop();
+}
+
+void
+ParallelLoad::stop() {
+    {
+        Mutex::Locker locker(mutex_);
+        stopping_ = true;
+        for (size_t i = 0; i < threads_.size(); ++i) {
+            consumed_cond_.signal();
+        }
+    }
+    // The threads finish the chunk they are parsing, if any.
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        threads_[i]->wait();
+    }
+    threads_.clear();
+}
+
+// Return the position just after the line starting at pos, including
+// any following lines joined by parentheses.  This follows the rules
+// of MasterLexer for quoted strings, escapes and comments.
+size_t
+ParallelLoad::skipLine(size_t pos, size_t& line) const {
+    const size_t size = data_.size();
+    size_t paren_count = 0;
+    bool quoted = false;
+    while (pos < size) {
+        const char c = data_[pos++];
+        if (c == '\n') {
+            ++line;
+            quoted = false;     // this is an unbalanced quote
+            if (paren_count == 0) {
+                break;
+            }
+        } else if (quoted) {
+            if (c == '"') {
+                quoted = false;
+            } else if (c == '\\' && pos < size) {
+                // An escaped character, which can be a newline in a quoted
+                // string.
+                if (data_[pos++] == '\n') {
+                    ++line;
+                }
+            }
+        } else if (c == '\\') {
+            // An escaped character; a newline still terminates the token.
+            if (pos < size && data_[pos] != '\n') {
+                ++pos;
+            }
+        } else if (c == ';') {
+            while (pos < size && data_[pos] != '\n') {
+                ++pos;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == '(') {
+            ++paren_count;
+        } else if (c == ')' && paren_count > 0) {
+            --paren_count;
+        }
+    }
+    return (pos);
+}
+
+void
+ParallelLoad::split(const string& source_name, const Name& origin) {
+    Name current_origin(origin);
+    Name chunk_origin(origin);
+    size_t chunk_begin = 0;
+    size_t chunk_line = 1;
+    size_t pos = 0;
+    size_t line = 1;
+    while (pos < data_.size()) {
+        const char c = data_[pos];
+        // Only a line starting with an owner name can start a new chunk;
+        // others depend on the previous lines.
+        if (pos - chunk_begin >= CHUNK_SIZE && c != ' ' && c != '\t' &&
+            c != '\r' && c != '\n' && c != ';' && c != '$' && c != '(' &&
+            c != ')' && c != '"') {
+            chunks_.push_back(shared_ptr<ParsedChunk>(
+                new ParsedChunk(data_.data() + chunk_begin, pos - chunk_begin,
+                                chunk_line, source_name, chunk_origin)));
+            chunk_begin = pos;
+            chunk_line = line;
+            chunk_origin = current_origin;
+        }
+        const size_t line_begin = pos;
+        pos = skipLine(pos, line);
+
+        // Follow $ORIGIN.  Errors are ignored here; the parser of the chunk
+        // will report them (and leave the origin unchanged).
+        if (c == '$' && pos - line_begin > 7 &&
+            strncasecmp(&data_[line_begin], "$ORIGIN", 7) == 0 &&
+            (data_[line_begin + 7] == ' ' || data_[line_begin + 7] == '\t')) {
+            std::istringstream directive(data_.substr(line_begin + 7,
+                                                      pos - line_begin - 7));
+            MasterLexer lexer;
+            lexer.pushSource(directive);
+            try {
+                const MasterToken& name_tok =
+                    lexer.getNextToken(MasterToken::QSTRING);
+                const MasterToken::StringRegion&
+                    name_string(name_tok.getStringRegion());
+                current_origin = Name(name_string.beg, name_string.len,
+                                      &current_origin);
+            } catch (const bundy::Exception&) {
+            }
+        }
+    }
+    if (pos > chunk_begin) {
+        chunks_.push_back(shared_ptr<ParsedChunk>(
+            new ParsedChunk(data_.data() + chunk_begin, pos - chunk_begin,
+                            chunk_line, source_name, chunk_origin)));
+    }
+}
+
+void
+ParallelLoad::run() {
+    while (true) {
+        ParsedChunk* chunk;
+        {
+            Mutex::Locker locker(mutex_);
+            while (!stopping_ && next_ < chunks_.size() &&
+                   next_ >= current_ + window_) {
+                consumed_cond_.wait(mutex_);
+            }
+            if (stopping_ || next_ == chunks_.size()) {
+                return;
+            }
+            chunk = chunks_[next_++].get();
+        }
+        parser_(*chunk);
+        {
+            Mutex::Locker locker(mutex_);
+            chunk->done_ = true;
+            parsed_cond_.signal();
+        }
+    }
+}
+
+const ParsedItem*
+ParallelLoad::getNextItem() {
+    while (current_ < chunks_.size()) {
+        ParsedChunk& chunk = *chunks_[current_];
+        if (current_item_ == 0) {
+            Mutex::Locker locker(mutex_);
+            while (!chunk.done_) {
+                parsed_cond_.wait(mutex_);
+            }
+        }
+        if (current_item_ < chunk.items_.size()) {
+            return (&chunk.items_[current_item_++]);
+        }
+        if (!chunk.failure_.empty()) {
+            bundy_throw(bundy::Unexpected, chunk.failure_);
+        }
+
+        // Release the consumed chunk and let the next one be parsed.
+        position_ += chunk.size_;
+        current_item_ = 0;
+        Mutex::Locker locker(mutex_);
+        chunks_[current_].reset();
+        ++current_;
+        consumed_cond_.signal();
+    }
+    return (NULL);
+}
+
 } // end unnamed namespace
 
 /// \brief Private implementation class for the \c MasterLoader
@@ -102,12 +499,61 @@ public:
         ok_(true),
         many_errors_((options & MANY_ERRORS) != 0),
         previous_name_(false),
+        input_stream_(NULL),
+        parsed_chunk_(NULL),
         complete_(false),
         seen_error_(false),
         warn_rfc1035_ttl_(true),
         rr_count_(0)
     {}
 
+    /// \brief Constructor for the parser of a chunk in the parallel mode.
+    ///
+    /// The parser records the parsed RRs, $TTL directives and issues in
+    /// the chunk instead of passing them to the callbacks.
+    ///
+    /// \param input The stream of the data of the chunk.
+    /// \param zone_origin The origin of zone.
+    /// \param zone_class The class of zone.
+    /// \param options Options for the parsing, except PARALLEL.
+    /// \param chunk The chunk to parse.
+    MasterLoaderImpl(std::istream& input,
+                     const Name& zone_origin,
+                     const RRClass& zone_class,
+                     MasterLoader::Options options,
+                     ParsedChunk& chunk) :
+        lexer_(),
+        zone_origin_(zone_origin),
+        active_origin_(chunk.origin_),
+        zone_class_(zone_class),
+        callbacks_(boost::bind(&ParsedChunk::addIssue, &chunk,
+                               ParsedItem::ERROR, _1, _2, _3),
+                   boost::bind(&ParsedChunk::addIssue, &chunk,
+                               ParsedItem::WARNING, _1, _2, _3)),
+        add_callback_(),
+        options_(options),
+        master_file_(),
+        initialized_(false),
+        ok_(true),
+        many_errors_((options & MANY_ERRORS) != 0),
+        previous_name_(false),
+        input_stream_(NULL),
+        parsed_chunk_(&chunk),
+        complete_(false),
+        seen_error_(false),
+        warn_rfc1035_ttl_(true),
+        rr_count_(0)
+    {
+        pushStreamSource(input);
+        chunk.chunk_source_ = lexer_.getSourceName();
+    }
+
+    /// \brief Parse a chunk of the input in the parallel mode.
+    ///
+    /// This is run in the worker threads of \c ParallelLoad.
+    static void parseChunk(const Name& zone_origin, const RRClass& zone_class,
+                           MasterLoader::Options options, ParsedChunk& chunk);
+
     /// \brief Wrapper around \c MasterLexer::pushSource() (file version)
     ///
     /// This method is used as a wrapper around the lexer's
@@ -143,6 +589,7 @@ public:
     /// \param stream The input stream to use as a new source.
     void pushStreamSource(std::istream& stream) {
         lexer_.pushSource(stream);
+        input_stream_ = &stream;
         initialized_ = true;
     }
 
@@ -157,9 +604,15 @@ public:
 
     /// \brief Return the line number being parsed in the pushed input
     /// sources. See \c MasterLexer::getPosition().
-    size_t getPosition() const { return (lexer_.getPosition()); }
+    size_t getPosition() const {
+        return (parallel_load_ ? parallel_load_->getPosition() :
+                lexer_.getPosition());
+    }
 
 private:
+    /// \brief Implementation of \c loadIncremental() in the parallel mode.
+    bool loadParallel(size_t count_limit);
+
     /// \brief Report an error using the callbacks that were supplied
     /// during \c MasterLoader construction. Note that this method also
     /// throws \c MasterLoaderError exception if necessary, so the
@@ -356,15 +809,11 @@ private:
     ///
     /// \param ttl the TTL to check. If it is larger than the maximum
     /// allowed, it is set to 0.
-    /// \param post_parsing should be true iff this method is called
-    /// after parsing the entire RR and the lexer is positioned at the
-    /// next line. It's just for calculating the accurate source line
-    /// when callback is necessary.
-    void limitTTL(RRTTL& ttl, bool post_parsing) {
+    /// \param source_name The source name of the TTL for the callback.
+    /// \param source_line The source line of the TTL for the callback.
+    void limitTTL(RRTTL& ttl, const string& source_name, size_t source_line) {
         if (ttl > RRTTL::MAX_TTL()) {
-            const size_t src_line = lexer_.getSourceLine() -
-                (post_parsing ? 1 : 0);
-            callbacks_.warning(lexer_.getSourceName(), src_line,
+            callbacks_.warning(source_name, source_line,
                                "TTL " + ttl.toText() + " > MAXTTL, "
                                "setting to 0 per RFC2181");
             ttl = RRTTL(0);
@@ -375,10 +824,12 @@ private:
     ///
     /// This should be from either $TTL or SOA minimum TTL (it's the
     /// caller's responsibility; this method doesn't care about where it
-    /// comes from). See \c limitTTL() for parameter post_parsing.
-    void setDefaultTTL(const RRTTL& ttl, bool post_parsing) {
+    /// comes from). See \c limitTTL() for the other parameters.
+    void setDefaultTTL(const RRTTL& ttl, const string& source_name,
+                       size_t source_line)
+    {
         assignTTL(default_ttl_, ttl);
-        limitTTL(*default_ttl_, post_parsing);
+        limitTTL(*default_ttl_, source_name, source_line);
     }
 
     /// \brief Try to set/reset the current TTL from candidate TTL text.
@@ -397,57 +848,106 @@ private:
         RRTTL* rrttl = RRTTL::createFromText(ttl_txt);
         if (rrttl) {
             current_ttl_.reset(rrttl);
-            limitTTL(*current_ttl_, false);
+            limitTTL(*current_ttl_, lexer_.getSourceName(),
+                     lexer_.getSourceLine());
             return (true);
         }
         return (false);
     }
 
-    /// \brief Determine the TTL of the current RR based on the given
-    /// parsing context.
+    /// \brief Determine the TTL of an RR based on the given parsing
+    /// context.
     ///
     /// \c explicit_ttl is true iff the TTL is explicitly specified for that RR
     /// (in which case current_ttl_ is set to that TTL).
-    /// \c rrtype is the type of the current RR, and \c rdata is its RDATA.  They
+    /// \c rrtype is the type of the RR, and \c rdata is its RDATA.  They
     /// only matter if the type is SOA and no available TTL is known.  In this
     /// case the minimum TTL of the SOA will be used as the TTL of that SOA
-    /// and the default TTL for subsequent RRs.
-    const RRTTL& getCurrentTTL(bool explicit_ttl, const RRType& rrtype,
-                               const rdata::ConstRdataPtr& rdata) {
-        // We've completed parsing the full of RR, and the lexer is already
-        // positioned at the next line.  If we need to call callback,
-        // we need to adjust the line number.
-        const size_t current_line = lexer_.getSourceLine() - 1;
-
+    /// and the default TTL for subsequent RRs.  \c source_name and
+    /// \c source_line specify the RR for callbacks.
+    ///
+    /// \return The TTL, or NULL if no TTL is known.
+    const RRTTL* determineTTL(bool explicit_ttl, const RRType& rrtype,
+                              const rdata::ConstRdataPtr& rdata,
+                              const string& source_name, size_t source_line)
+    {
         if (!current_ttl_ && !default_ttl_) {
             if (rrtype == RRType::SOA()) {
-                callbacks_.warning(lexer_.getSourceName(), current_line,
+                callbacks_.warning(source_name, source_line,
                                    "no TTL specified; "
                                    "using SOA MINTTL instead");
                 const uint32_t ttl_val =
                     dynamic_cast<const rdata::generic::SOA&>(*rdata).
                     getMinimum();
-                setDefaultTTL(RRTTL(ttl_val), true);
+                setDefaultTTL(RRTTL(ttl_val), source_name, source_line);
                 assignTTL(current_ttl_, *default_ttl_);
             } else {
-                // On catching the exception we'll try to reach EOL again,
-                // so we need to unget it now.
-                lexer_.ungetToken();
-                throw InternalException(__FILE__, __LINE__,
-                                        "no TTL specified; load rejected");
+                return (NULL);
             }
         } else if (!explicit_ttl && default_ttl_) {
             assignTTL(current_ttl_, *default_ttl_);
         } else if (!explicit_ttl && warn_rfc1035_ttl_) {
             // Omitted (class and) TTL values are default to the last
             // explicitly stated values (RFC 1035, Sec. 5.1).
-            callbacks_.warning(lexer_.getSourceName(), current_line,
+            callbacks_.warning(source_name, source_line,
                                "using RFC1035 TTL semantics; default to the "
                                "last explicitly stated TTL");
             warn_rfc1035_ttl_ = false; // we only warn about this once
         }
         assert(current_ttl_);
-        return (*current_ttl_);
+        return (current_ttl_.get());
+    }
+
+    /// \brief Determine the TTL of the current RR based on the given
+    /// parsing context.
+    ///
+    /// See \c determineTTL().  This version throws if no TTL is known.
+    const RRTTL& getCurrentTTL(bool explicit_ttl, const RRType& rrtype,
+                               const rdata::ConstRdataPtr& rdata) {
+        // We've completed parsing the full of RR, and the lexer is already
+        // positioned at the next line.  If we need to call callback,
+        // we need to adjust the line number.
+        const RRTTL* ttl = determineTTL(explicit_ttl, rrtype, rdata,
+                                        lexer_.getSourceName(),
+                                        lexer_.getSourceLine() - 1);
+        if (ttl == NULL) {
+            // On catching the exception we'll try to reach EOL again,
+            // so we need to unget it now.
+            lexer_.ungetToken();
+            throw InternalException(__FILE__, __LINE__, NO_TTL_ERROR);
+        }
+        return (*ttl);
+    }
+
+    /// \brief Pass a parsed RR to the add callback.
+    ///
+    /// When parsing a chunk in the parallel mode, the RR is recorded in the
+    /// chunk instead; its TTL is determined when the chunk is consumed.
+    ///
+    /// \param generated true if the RR is generated by $GENERATE, in which
+    /// case the lexer is positioned before the end of the line.
+    void addRR(bool explicit_ttl, const RRType& rrtype,
+               const rdata::RdataPtr& rdata, bool generated = false)
+    {
+        if (parsed_chunk_ != NULL) {
+            ParsedItem& item =
+                parsed_chunk_->addRR(last_name_, rrtype, rdata,
+                                     explicit_ttl ? current_ttl_.get() : NULL,
+                                     lexer_.getSourceName(),
+                                     lexer_.getSourceLine());
+            item.generated_ = generated;
+            if (!explicit_ttl && !generated) {
+                // Whether the RR ends at EOF matters if it turns out to have
+                // no TTL (see loadParallel()).  The last token is the end of
+                // line or file, so it can be safely read again.
+                lexer_.ungetToken();
+                item.at_eof_ = (lexer_.getNextToken().getType() ==
+                                MasterToken::END_OF_FILE);
+            }
+        } else {
+            add_callback_(*last_name_, zone_class_, rrtype,
+                          getCurrentTTL(explicit_ttl, rrtype, rdata), rdata);
+        }
     }
 
     /// \brief Handle a $DIRECTIVE
@@ -464,7 +964,13 @@ private:
             doGenerate();
             eatUntilEOL(true);
         } else if (iequals(directive, "TTL")) {
-            setDefaultTTL(RRTTL(getString()), false);
+            setDefaultTTL(RRTTL(getString()), lexer_.getSourceName(),
+                          lexer_.getSourceLine());
+            if (parsed_chunk_ != NULL) {
+                parsed_chunk_->addDefaultTTL(*default_ttl_,
+                                             lexer_.getSourceName(),
+                                             lexer_.getSourceLine());
+            }
             eatUntilEOL(true);
         } else {
             bundy_throw(InternalException, "Unknown directive '" <<
@@ -543,6 +1049,11 @@ private:
     vector<IncludeInfo> include_info_;
     bool previous_name_; // True if there was a previous name in this file
                          // (false at the beginning or after an $INCLUDE line)
+    std::istream* input_stream_; // The top level stream, if any
+    ParsedChunk* parsed_chunk_; // Non NULL iff parsing a chunk in the
+                                // parallel mode
+    boost::scoped_ptr<ParallelLoad> parallel_load_; // Non NULL iff loading
+                                                    // in the parallel mode
 
 public:
     bool complete_;             // All work done.
@@ -849,9 +1360,7 @@ MasterLoader::MasterLoaderImpl::doGenerate() {
         // Rdata. The errors should have been reported by callbacks_
         // already. We need to decide if we want to continue or not.
         if (rdata) {
-            add_callback_(*last_name_, zone_class_, rrtype,
-                          getCurrentTTL(explicit_ttl, rrtype, rdata),
-                          rdata);
+            addRR(explicit_ttl, rrtype, rdata, true);
             // Good, we added another one
             ++rr_count_;
         } else {
@@ -955,6 +1464,9 @@ MasterLoader::MasterLoaderImpl::loadIncremental(size_t count_limit) {
     if (!initialized_) {
         pushSource(master_file_, active_origin_);
     }
+    if ((options_ & PARALLEL) != 0) {
+        return (loadParallel(count_limit));
+    }
     size_t count = 0;
     while (ok_ && count < count_limit) {
         try {
@@ -981,9 +1493,7 @@ MasterLoader::MasterLoaderImpl::loadIncremental(size_t count_limit) {
             // callbacks_ already. We need to decide if we want to continue
             // or not.
             if (rdata) {
-                add_callback_(*last_name_, zone_class_, rrtype,
-                              getCurrentTTL(explicit_ttl, rrtype, rdata),
-                              rdata);
+                addRR(explicit_ttl, rrtype, rdata);
                 // Good, we loaded another one
                 ++count;
                 ++rr_count_;
@@ -1019,6 +1529,106 @@ MasterLoader::MasterLoaderImpl::loadIncremental(size_t count_limit) {
     return (!ok_);
 }
 
+void
+MasterLoader::MasterLoaderImpl::parseChunk(const Name& zone_origin,
+                                           const RRClass& zone_class,
+                                           MasterLoader::Options options,
+                                           ParsedChunk& chunk)
+{
+    std::istringstream input(string(chunk.data_, chunk.size_));
+    try {
+        MasterLoaderImpl parser(input, zone_origin, zone_class,
+                                static_cast<MasterLoader::Options>(
+                                    options & ~PARALLEL),
+                                chunk);
+        parser.loadIncremental(std::numeric_limits<size_t>::max());
+    } catch (const MasterLoaderError&) {
+        // The error has been recorded, and the rest of the chunk is to be
+        // skipped anyway.
+    } catch (const std::exception& ex) {
+        chunk.failure_ = ex.what();
+    }
+}
+
+bool
+MasterLoader::MasterLoaderImpl::loadParallel(size_t count_limit) {
+    if (!ok_) {
+        return (true);          // the top level file couldn't be opened
+    }
+    if (!parallel_load_) {
+        std::ifstream file_stream;
+        std::istream* input = input_stream_;
+        if (input == NULL) {
+            file_stream.open(master_file_.c_str());
+            input = &file_stream;
+        }
+        try {
+            parallel_load_.reset(new ParallelLoad(
+                *input, lexer_.getSourceName(), active_origin_,
+                boost::bind(&MasterLoaderImpl::parseChunk, zone_origin_,
+                            zone_class_, options_, _1)));
+        } catch (const MasterLexer::ReadError& e) {
+            reportError(lexer_.getSourceName(), lexer_.getSourceLine(),
+                        e.what());
+            ok_ = false;
+            return (true);
+        }
+    }
+
+    // Pass the parsed items to the callbacks, doing what we do right after
+    // parsing an RR or a $TTL in the sequential mode.
+    size_t count = 0;
+    while (ok_ && count < count_limit) {
+        const ParsedItem* item = parallel_load_->getNextItem();
+        if (item == NULL) {
+            return (true);      // we are done
+        }
+        const string& source = parallel_load_->getSourceName(*item);
+        switch (item->type_) {
+        case ParsedItem::RR: {
+            if (item->explicit_ttl_) {
+                assignTTL(current_ttl_, item->ttl_);
+            }
+            const RRTTL* ttl = determineTTL(item->explicit_ttl_,
+                                            item->rrtype_, item->rdata_,
+                                            source, item->line_ - 1);
+            if (ttl == NULL) {
+                // The sequential mode would unget the last token of the RR
+                // (see getCurrentTTL()), report the error, and skip to the
+                // end of line.
+                if (item->generated_ || item->at_eof_) {
+                    reportError(source, item->line_, NO_TTL_ERROR);
+                } else {
+                    reportError(source, item->line_ - 1, NO_TTL_ERROR);
+                }
+                if (item->generated_) {
+                    parallel_load_->skipGenerated(*item);
+                } else if (item->at_eof_) {
+                    callbacks_.warning(source, item->line_,
+                                       "File does not end with newline");
+                }
+                break;
+            }
+            add_callback_(*item->name_, zone_class_, item->rrtype_, *ttl,
+                          item->rdata_);
+            ++count;
+            ++rr_count_;
+            break;
+        }
+        case ParsedItem::DEFAULT_TTL:
+            assignTTL(default_ttl_, item->ttl_);
+            break;
+        case ParsedItem::WARNING:
+            callbacks_.warning(source, item->line_, item->reason_);
+            break;
+        case ParsedItem::ERROR:
+            reportError(source, item->line_, item->reason_);
+            break;
+        }
+    }
+    return (!ok_);
+}
+
 MasterLoader::MasterLoader(const char* master_file,
                            const Name& zone_origin,
                            const RRClass& zone_class,
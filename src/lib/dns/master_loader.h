@@ -46,8 +46,10 @@ public:
     /// \brief Options how the parsing should work.
     enum Options {
         DEFAULT = 0,       ///< Nothing special.
-        MANY_ERRORS = 1    ///< Lenient mode (see documentation of MasterLoader
+        MANY_ERRORS = 1,   ///< Lenient mode (see documentation of MasterLoader
                            ///  constructor).
+        PARALLEL = 2       ///< Parse the input in multiple threads (see
+                           ///  documentation of MasterLoader constructor).
     };
 
     /// \brief Constructor
@@ -76,6 +78,13 @@ public:
     ///     the Options values or DEFAULT. If the MANY_ERRORS option is
     ///     included, the parser tries to continue past errors. If it
     ///     is not included, it stops at first encountered error.
+    ///     If the PARALLEL option is included, the input is read into
+    ///     memory at once, and parts of it are parsed in as many threads
+    ///     as there are processors.  The callbacks are still called in
+    ///     the thread calling load() or loadIncremental(), with the same
+    ///     RRs and issues in the same order as without the option; only
+    ///     the position (see getPosition()) advances in larger steps, and
+    ///     the size (see getSize()) doesn't include $INCLUDEd files.
     /// \throw std::bad_alloc when there's not enough memory.
     /// \throw bundy::InvalidParameter if add_callback is empty.
     MasterLoader(const char* master_file,
@@ -22,11 +22,13 @@
 
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <exceptions/exceptions.h>
 
 #include <util/buffer.h>
+#include <util/thread_arena.h>
 
 #include <dns/edns.h>
 #include <dns/exceptions.h>
@@ -680,7 +682,11 @@ MessageImpl::parseQuestion(InputBuffer& buffer) {
         // optimized algorithm that requires the question section contain
         // exactly one RR.
 
-        questions_.push_back(QuestionPtr(new Question(name, rrclass, rrtype)));
+        // This is done for every incoming query, so the question is
+        // allocated from the per-thread arena.
+        questions_.push_back(boost::allocate_shared<Question>(
+                                 ArenaAllocator<Question>(), name, rrclass,
+                                 rrtype));
         ++added;
     }
 
@@ -1036,6 +1042,14 @@ template <typename T>
 struct SectionIteratorImpl {
     SectionIteratorImpl(const typename vector<T>::const_iterator& it) :
         it_(it) {}
+    // Iterators are created for every query (e.g., for the question), so
+    // we avoid the global allocator.
+    static void* operator new(size_t size) {
+        return (ThreadArena::allocate(size));
+    }
+    static void operator delete(void* ptr, size_t size) {
+        ThreadArena::deallocate(ptr, size);
+    }
     typename vector<T>::const_iterator it_;
 };
 
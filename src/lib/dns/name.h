@@ -21,6 +21,7 @@
 #include <vector>
 
 #include <dns/exceptions.h>
+#include <util/thread_arena.h>
 
 namespace bundy {
 namespace util {
@@ -239,10 +240,14 @@ class Name {
     ///
     //@{
 private:
+    // Names are constructed and destroyed many times for every query, so
+    // their data is allocated from the per-thread arena.
+
     /// \brief Name data string
-    typedef std::basic_string<uint8_t> NameString;
+    typedef std::basic_string<uint8_t, std::char_traits<uint8_t>,
+                              util::ArenaAllocator<uint8_t> > NameString;
     /// \brief Name offsets type
-    typedef std::vector<uint8_t> NameOffsets;
+    typedef std::vector<uint8_t, util::ArenaAllocator<uint8_t> > NameOffsets;
 
     /// The default constructor
     ///
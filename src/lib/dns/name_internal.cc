@@ -0,0 +1,350 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dns/name_internal.h>
+
+#include <cstring>
+
+#include <stdint.h>
+
+// SSE2 is part of the base x86-64 architecture (and is enabled by the
+// compiler for 32-bit x86 only if the target supports it).  AVX2 code is
+// compiled with a function attribute and only used if the CPU supports it,
+// which requires a reasonably recent GCC or clang.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define NAME_USE_SSE2 1
+#include <emmintrin.h>
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define NAME_USE_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+namespace bundy {
+namespace dns {
+namespace name {
+namespace internal {
+
+namespace {
+
+//
+// Portable variant: compare 8 octets at a time as 64-bit integers ("SIMD
+// within a register").
+//
+
+const uint64_t ONES64 = 0x0101010101010101ULL;
+
+inline uint64_t
+load64(const uint8_t* data) {
+    uint64_t val;
+    std::memcpy(&val, data, sizeof(val));
+    return (val);
+}
+
+// Convert the upper case letters in the 8 octets to lower case.  For each
+// octet, the addition to its lower 7 bits sets the highest bit iff it's
+// 'A' or larger and 'Z' or smaller, respectively; the addition never
+// carries to the next octet.  Octets with the highest bit set are not
+// letters and are kept intact.
+inline uint64_t
+lower64(uint64_t val) {
+    const uint64_t heptets = val & (0x7f * ONES64);
+    const uint64_t ge_a = heptets + (0x80 - 'A') * ONES64;
+    const uint64_t gt_z = heptets + (0x80 - 'Z' - 1) * ONES64;
+    const uint64_t upper = (ge_a ^ gt_z) & ~val & (0x80 * ONES64);
+    return (val | (upper >> 2));
+}
+
+inline int
+compareTail(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        const int diff = static_cast<int>(maptolower[data1[i]]) -
+            static_cast<int>(maptolower[data2[i]]);
+        if (diff != 0) {
+            return (diff);
+        }
+    }
+    return (0);
+}
+
+int
+comparePortable(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        if (lower64(load64(data1 + i)) != lower64(load64(data2 + i))) {
+            // Locate the differing octet; it must be in this block.
+            return (compareTail(data1 + i, data2 + i, 8));
+        }
+    }
+    return (compareTail(data1 + i, data2 + i, len - i));
+}
+
+bool
+equalsPortable(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        if (lower64(load64(data1 + i)) != lower64(load64(data2 + i))) {
+            return (false);
+        }
+    }
+    return (compareTail(data1 + i, data2 + i, len - i) == 0);
+}
+
+#ifdef NAME_USE_SSE2
+//
+// SSE2 variant: 16 octets at a time, the rest is handled by the portable
+// code.
+//
+
+inline __m128i
+lower128(__m128i val) {
+    // After the addition 'A'..'Z' are the 26 smallest signed values.
+    const __m128i shifted = _mm_add_epi8(val, _mm_set1_epi8(0x80 - 'A'));
+    const __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+    return (_mm_or_si128(val, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+}
+
+// Return a bit mask of the octets that are equal ignoring case.
+inline int
+equalMask128(const uint8_t* data1, const uint8_t* data2) {
+    const __m128i val1 =
+        lower128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data1)));
+    const __m128i val2 =
+        lower128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data2)));
+    return (_mm_movemask_epi8(_mm_cmpeq_epi8(val1, val2)));
+}
+
+int
+compareSSE2(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        const int mask = equalMask128(data1 + i, data2 + i);
+        if (mask != 0xffff) {
+            const int pos = __builtin_ctz(~mask);
+            return (static_cast<int>(maptolower[data1[i + pos]]) -
+                    static_cast<int>(maptolower[data2[i + pos]]));
+        }
+    }
+    return (comparePortable(data1 + i, data2 + i, len - i));
+}
+
+bool
+equalsSSE2(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        if (equalMask128(data1 + i, data2 + i) != 0xffff) {
+            return (false);
+        }
+    }
+    return (equalsPortable(data1 + i, data2 + i, len - i));
+}
+#endif
+
+#ifdef NAME_USE_AVX2
+//
+// AVX2 variant: 32 octets at a time, the rest is handled by the SSE2 code.
+//
+
+__attribute__((target("avx2"))) inline __m256i
+lower256(__m256i val) {
+    const __m256i shifted =
+        _mm256_add_epi8(val, _mm256_set1_epi8(0x80 - 'A'));
+    const __m256i upper =
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+    return (_mm256_or_si256(val,
+                            _mm256_and_si256(upper, _mm256_set1_epi8(0x20))));
+}
+
+__attribute__((target("avx2"))) inline unsigned int
+equalMask256(const uint8_t* data1, const uint8_t* data2) {
+    const __m256i val1 = lower256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data1)));
+    const __m256i val2 = lower256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data2)));
+    return (_mm256_movemask_epi8(_mm256_cmpeq_epi8(val1, val2)));
+}
+
+__attribute__((target("avx2"))) int
+compareAVX2(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    if (len < 32) {
+        return (compareSSE2(data1, data2, len));
+    }
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        const unsigned int mask = equalMask256(data1 + i, data2 + i);
+        if (mask != 0xffffffffU) {
+            const int pos = __builtin_ctz(~mask);
+            return (static_cast<int>(maptolower[data1[i + pos]]) -
+                    static_cast<int>(maptolower[data2[i + pos]]));
+        }
+    }
+    // Avoid the penalty of mixing AVX and legacy SSE instructions in the
+    // rest; the compiler doesn't always do this for us.
+    _mm256_zeroupper();
+    return (compareSSE2(data1 + i, data2 + i, len - i));
+}
+
+__attribute__((target("avx2"))) bool
+equalsAVX2(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    if (len < 32) {
+        return (equalsSSE2(data1, data2, len));
+    }
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        if (equalMask256(data1 + i, data2 + i) != 0xffffffffU) {
+            return (false);
+        }
+    }
+    _mm256_zeroupper();
+    return (equalsSSE2(data1 + i, data2 + i, len - i));
+}
+#endif
+
+struct CaseFunctions {
+    CaseImpl impl;
+    bool (*equals)(const uint8_t*, const uint8_t*, size_t);
+    int (*compare)(const uint8_t*, const uint8_t*, size_t);
+};
+
+const CaseFunctions portable_functions = {
+    CASE_IMPL_PORTABLE, equalsPortable, comparePortable
+};
+#ifdef NAME_USE_SSE2
+const CaseFunctions sse2_functions = {
+    CASE_IMPL_SSE2, equalsSSE2, compareSSE2
+};
+#endif
+#ifdef NAME_USE_AVX2
+const CaseFunctions avx2_functions = {
+    CASE_IMPL_AVX2, equalsAVX2, compareAVX2
+};
+#endif
+
+// The functions in use.  This is statically initialized with the best
+// variant that doesn't need CPU detection, so it's usable by other static
+// initializers; AVX2 is enabled by the dynamic initializer below.
+#ifdef NAME_USE_SSE2
+const CaseFunctions* current_functions = &sse2_functions;
+#else
+const CaseFunctions* current_functions = &portable_functions;
+#endif
+
+bool
+isAvailable(CaseImpl impl) {
+    switch (impl) {
+    case CASE_IMPL_PORTABLE:
+        return (true);
+    case CASE_IMPL_SSE2:
+#ifdef NAME_USE_SSE2
+        return (true);
+#else
+        return (false);
+#endif
+    case CASE_IMPL_AVX2:
+#ifdef NAME_USE_AVX2
+        // This can be called from a static initializer, before the CPU
+        // information is set up by the runtime.
+        __builtin_cpu_init();
+        return (__builtin_cpu_supports("avx2"));
+#else
+        return (false);
+#endif
+    }
+    return (false);
+}
+
+struct CaseImplInitializer {
+    CaseImplInitializer() {
+        setCaseImpl(CASE_IMPL_AVX2);
+    }
+};
+const CaseImplInitializer initializer;
+
+// Final mixing of MurmurHash3 (64-bit).
+inline uint64_t
+mix64(uint64_t val) {
+    val ^= val >> 33;
+    val *= 0xff51afd7ed558ccdULL;
+    val ^= val >> 33;
+    val *= 0xc4ceb9fe1a85ec53ULL;
+    val ^= val >> 33;
+    return (val);
+}
+
+} // unnamed namespace
+
+bool
+equalsLower(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    return (current_functions->equals(data1, data2, len));
+}
+
+int
+compareLower(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    return (current_functions->compare(data1, data2, len));
+}
+
+size_t
+hashData(const uint8_t* data, size_t len, bool case_sensitive) {
+    // Names are short, so a couple of 64-bit words are faster than any
+    // vector instructions (which would need the data to be copied anyway,
+    // as we cannot read beyond its end).
+    uint8_t buf[16] = { 0 };
+    std::memcpy(buf, data, len < sizeof(buf) ? len : sizeof(buf));
+    uint64_t word1 = load64(buf);
+    uint64_t word2 = load64(buf + 8);
+    if (!case_sensitive) {
+        word1 = lower64(word1);
+        word2 = lower64(word2);
+    }
+    uint64_t hash = mix64(len ^ word1);
+    hash = mix64(hash ^ word2);
+    return (static_cast<size_t>(hash));
+}
+
+CaseImpl
+getCaseImpl() {
+    return (current_functions->impl);
+}
+
+bool
+setCaseImpl(CaseImpl impl) {
+    if (!isAvailable(impl)) {
+        return (false);
+    }
+    switch (impl) {
+    case CASE_IMPL_PORTABLE:
+        current_functions = &portable_functions;
+        break;
+#ifdef NAME_USE_SSE2
+    case CASE_IMPL_SSE2:
+        current_functions = &sse2_functions;
+        break;
+#endif
+#ifdef NAME_USE_AVX2
+    case CASE_IMPL_AVX2:
+        current_functions = &avx2_functions;
+        break;
+#endif
+    default:
+        return (false);
+    }
+    return (true);
+}
+
+} // end of internal
+} // end of name
+} // end of dns
+} // end of bundy
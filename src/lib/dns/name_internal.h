@@ -15,6 +15,10 @@
 #ifndef NAME_INTERNAL_H
 #define NAME_INTERNAL_H 1
 
+#include <cstddef>
+
+#include <stdint.h>
+
 // This is effectively a "private" namespace for the Name class implementation,
 // but exposed publicly so the definitions in it can be shared with other
 // modules of the library (as of its introduction, used by LabelSequence and
@@ -32,6 +36,43 @@ namespace dns {
 namespace name {
 namespace internal {
 extern const uint8_t maptolower[];
+
+// Case-insensitive operations on wire-format name data, used in the hot
+// paths of LabelSequence (and through it, DomainTree lookups and name
+// compression in MessageRenderer).  "Case-insensitive" is in the sense of
+// maptolower: only ASCII upper case letters are converted.
+//
+// The comparisons are implemented in a few variants using different
+// instruction sets; the fastest one supported by the running CPU is chosen
+// at startup.
+
+// Return true iff the len octets at data1 and data2 are equal ignoring case.
+bool equalsLower(const uint8_t* data1, const uint8_t* data2, size_t len);
+
+// Compare the len octets at data1 and data2 ignoring case, and return
+// the difference of the first differing octets (converted to lower case),
+// or 0 if they are all equal.
+int compareLower(const uint8_t* data1, const uint8_t* data2, size_t len);
+
+// Return a hash value of the first (up to) 16 octets of the len octets at
+// data, converted to lower case unless case_sensitive is true.
+size_t hashData(const uint8_t* data, size_t len, bool case_sensitive);
+
+// The variants of the above operations.  Only the first one is always
+// available; SSE2 and AVX2 depend on the architecture and the CPU.
+enum CaseImpl {
+    CASE_IMPL_PORTABLE,         // processes 8 octets at a time in a register
+    CASE_IMPL_SSE2,
+    CASE_IMPL_AVX2
+};
+
+// Return the variant currently in use.
+CaseImpl getCaseImpl();
+
+// Switch to the given variant if it's available, and return true;
+// otherwise return false.  This is intended for tests and benchmarks,
+// and isn't thread safe.
+bool setCaseImpl(CaseImpl impl);
 } // end of internal
 } // end of name
 } // end of dns
@@ -22,6 +22,8 @@
 
 #include <boost/noncopyable.hpp>
 
+#include <pthread.h>
+
 #include <exceptions/exceptions.h>
 
 #include <util/buffer.h>
@@ -43,6 +45,134 @@ using namespace bundy::dns::rdata;
 
 namespace {
 
+// Per-thread cache of calculated hash values.
+//
+// Once we hash the names of a query, most of the names we'll hash for the
+// next queries are the same closest enclosers (in particular, the zone
+// origin), and with a high number of iterations this is expensive.  So we
+// remember recent results per thread (so no lock is needed), separately
+// for a few sets of hash parameters (normally one per NSEC3-signed zone).
+// The cache is direct mapped on the (lower-cased) owner name, so a flood of
+// random names only ever costs a single slot lookup per hash and can't grow
+// the cache.
+//
+// Names longer than MAX_CACHED_NAME_LEN are not cached; they are rarely
+// closest enclosers and that keeps the cache compact.  (Salts longer than
+// MAX_CACHED_SALT_LEN can't appear in NSEC3 RDATA, but could be given to
+// the constructor; hashes for them aren't cached either.)
+const size_t MAX_CACHED_NAME_LEN = 64;
+const size_t MAX_CACHED_SALT_LEN = 255;
+const size_t CACHE_ENTRIES = 256;  // per parameter set; must be power of 2
+const size_t CACHE_PARAM_SETS = 4;
+
+struct HashCacheEntry {
+    uint8_t name_len;           // 0 means the entry is unused
+    uint8_t name[MAX_CACHED_NAME_LEN];
+    uint8_t digest[SHA1_HASHSIZE];
+};
+
+struct HashCacheSet {
+    uint32_t last_used;         // 0 means the set is unused
+    uint8_t algorithm;
+    uint16_t iterations;
+    uint8_t salt_length;
+    uint8_t salt[MAX_CACHED_SALT_LEN];
+    HashCacheEntry entries[CACHE_ENTRIES];
+};
+
+struct HashCache {
+    uint32_t clock;
+    HashCacheSet sets[CACHE_PARAM_SETS];
+};
+
+pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+pthread_key_t cache_key;
+bool cache_key_created = false;
+
+void
+releaseCache(void* arg) {
+    std::free(arg);
+}
+
+void
+createCacheKey() {
+    cache_key_created = (pthread_key_create(&cache_key, releaseCache) == 0);
+}
+
+// Return the cache of the calling thread, creating it if needed.  As it's
+// only a cache, this returns NULL on any failure and the caller then simply
+// calculates the hash.
+HashCache*
+getHashCache() {
+    pthread_once(&cache_key_once, createCacheKey);
+    if (!cache_key_created) {
+        return (NULL);
+    }
+    HashCache* cache = static_cast<HashCache*>(pthread_getspecific(cache_key));
+    if (cache == NULL) {
+        cache = static_cast<HashCache*>(std::calloc(1, sizeof(HashCache)));
+        if (cache != NULL && pthread_setspecific(cache_key, cache) != 0) {
+            std::free(cache);
+            cache = NULL;
+        }
+    }
+    return (cache);
+}
+
+// Find the set for the given parameters in the cache, replacing the least
+// recently used one if there's none.
+HashCacheSet*
+getHashCacheSet(HashCache* cache, uint8_t algorithm, uint16_t iterations,
+                const uint8_t* salt, size_t salt_length)
+{
+    if (++cache->clock == 0) {
+        // Wrapped around (after 4G lookups); just make all sets look
+        // equally old rather than ever using 0 for a valid set.
+        for (size_t i = 0; i < CACHE_PARAM_SETS; ++i) {
+            if (cache->sets[i].last_used != 0) {
+                cache->sets[i].last_used = 1;
+            }
+        }
+        cache->clock = 2;
+    }
+
+    HashCacheSet* victim = &cache->sets[0];
+    for (size_t i = 0; i < CACHE_PARAM_SETS; ++i) {
+        HashCacheSet* set = &cache->sets[i];
+        if (set->last_used != 0 && set->algorithm == algorithm &&
+            set->iterations == iterations &&
+            set->salt_length == salt_length &&
+            (salt_length == 0 ||
+             std::memcmp(set->salt, salt, salt_length) == 0)) {
+            set->last_used = cache->clock;
+            return (set);
+        }
+        if (set->last_used < victim->last_used) {
+            victim = set;
+        }
+    }
+
+    std::memset(victim->entries, 0, sizeof(victim->entries));
+    victim->algorithm = algorithm;
+    victim->iterations = iterations;
+    victim->salt_length = salt_length;
+    if (salt_length > 0) {
+        std::memcpy(victim->salt, salt, salt_length);
+    }
+    victim->last_used = cache->clock;
+    return (victim);
+}
+
+// FNV-1a over the (lower-cased) wire-format name, to pick a cache slot.
+inline size_t
+getCacheSlot(const uint8_t* name, size_t length) {
+    uint32_t h = 2166136261U;
+    for (size_t i = 0; i < length; ++i) {
+        h = (h ^ name[i]) * 16777619U;
+    }
+    return (h & (CACHE_ENTRIES - 1));
+}
+
 /// \brief A derived class of \c NSEC3Hash that implements the standard hash
 /// calculation specified in RFC5155.
 ///
@@ -146,6 +276,22 @@ NSEC3HashRFC5155::calculateForWiredata(const uint8_t* data,
     uint8_t* const digest = &digest_[0];
     assert(digest_.size() == SHA1_HASHSIZE);
 
+    HashCacheEntry* entry = NULL;
+    if (length <= MAX_CACHED_NAME_LEN &&
+        salt_length_ <= MAX_CACHED_SALT_LEN) {
+        HashCache* cache = getHashCache();
+        if (cache != NULL) {
+            HashCacheSet* set = getHashCacheSet(cache, algorithm_, iterations_,
+                                                salt_data_, salt_length_);
+            entry = &set->entries[getCacheSlot(name_buf, length)];
+            if (entry->name_len == length &&
+                std::memcmp(entry->name, name_buf, length) == 0) {
+                std::memcpy(digest, entry->digest, SHA1_HASHSIZE);
+                return (encodeBase32Hex(digest_));
+            }
+        }
+    }
+
     iterateSHA1(&sha1_ctx_, name_buf, length,
                 salt_data_, salt_length_, digest);
     for (unsigned int n = 0; n < iterations_; ++n) {
@@ -153,6 +299,12 @@ NSEC3HashRFC5155::calculateForWiredata(const uint8_t* data,
                     salt_data_, salt_length_, digest);
     }
 
+    if (entry != NULL) {
+        entry->name_len = length;
+        std::memcpy(entry->name, name_buf, length);
+        std::memcpy(entry->digest, digest, SHA1_HASHSIZE);
+    }
+
     return (encodeBase32Hex(digest_));
 }
 
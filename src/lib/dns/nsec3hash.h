@@ -263,6 +263,12 @@ public:
 /// convenience of special applications that want to customize the creator
 /// behavior for a particular type of parameters while preserving the default
 /// behavior for others.
+///
+/// The \c NSEC3Hash objects created by this class remember the hash values
+/// of recently used names in a small per-thread cache shared by all of them
+/// (for each set of hash parameters), as the same names, such as the zone
+/// origin, are hashed again and again for the closest encloser proofs of
+/// different queries.  This is transparent to the application.
 class DefaultNSEC3HashCreator : public NSEC3HashCreator {
 public:
     virtual NSEC3Hash* create(const rdata::generic::NSEC3PARAM& param) const;
@@ -18,12 +18,14 @@
 
 #include <dns/labelsequence.h>
 #include <dns/name.h>
+#include <dns/name_internal.h>
 #include <exceptions/exceptions.h>
 
 #include <gtest/gtest.h>
 
 #include <boost/functional/hash.hpp>
 
+#include <cctype>
 #include <string>
 #include <vector>
 #include <utility>
@@ -711,6 +713,95 @@ TEST_F(LabelSequenceTest, getHash) {
     hashDistributionCheck(ca_servers);
 }
 
+// Reference implementation of the case-insensitive comparison, octet by
+// octet.
+int
+compareLowerReference(const uint8_t* data1, const uint8_t* data2, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        const int diff = tolower(data1[i]) - tolower(data2[i]);
+        if (diff != 0) {
+            return (diff);
+        }
+    }
+    return (0);
+}
+
+// Check all variants of the case-insensitive operations give the same
+// result as the reference for various lengths and positions of difference,
+// including non-letters around the letter ranges and non-ASCII octets.
+TEST_F(LabelSequenceTest, caseImplementations) {
+    using namespace bundy::dns::name::internal;
+    const CaseImpl orig_impl = getCaseImpl();
+    const CaseImpl impls[] = {
+        CASE_IMPL_PORTABLE, CASE_IMPL_SSE2, CASE_IMPL_AVX2
+    };
+    const uint8_t chars[] = {
+        'a', 'A', 'z', 'Z', '@', '`', '[', '{', '0', '-', 0xc1, 0xe1, 0x00
+    };
+    const size_t nchars = sizeof(chars) / sizeof(chars[0]);
+    for (size_t impl = 0; impl < sizeof(impls) / sizeof(impls[0]); ++impl) {
+        if (!setCaseImpl(impls[impl])) {
+            continue;           // not supported on this system
+        }
+        EXPECT_EQ(impls[impl], getCaseImpl());
+        for (size_t len = 0; len <= 80; ++len) {
+            vector<uint8_t> data1(len + 1), data2(len + 1);
+            for (size_t i = 0; i < len; ++i) {
+                data1[i] = 'a' + i % 26;
+                data2[i] = 'A' + i % 26;
+            }
+            EXPECT_TRUE(equalsLower(&data1[0], &data2[0], len));
+            EXPECT_EQ(0, compareLower(&data1[0], &data2[0], len));
+            for (size_t pos = 0; pos < len; ++pos) {
+                for (size_t c1 = 0; c1 < nchars; ++c1) {
+                    for (size_t c2 = 0; c2 < nchars; ++c2) {
+                        vector<uint8_t> d1(data1), d2(data2);
+                        d1[pos] = chars[c1];
+                        d2[pos] = chars[c2];
+                        const int expected =
+                            compareLowerReference(&d1[0], &d2[0], len);
+                        EXPECT_EQ(expected,
+                                  compareLower(&d1[0], &d2[0], len));
+                        EXPECT_EQ(expected == 0,
+                                  equalsLower(&d1[0], &d2[0], len));
+                    }
+                }
+            }
+        }
+    }
+    EXPECT_TRUE(setCaseImpl(orig_impl));
+
+    // hashData() ignores the case only if requested, and only looks at
+    // the first 16 octets and the length.
+    const uint8_t lower[] = "abcdefghijklmnopqrstuvwxyz";
+    const uint8_t upper[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const uint8_t mixed[] = "abcdefghijklmnopQRSTUVWXYZ";
+    EXPECT_EQ(hashData(lower, 26, false), hashData(upper, 26, false));
+    EXPECT_NE(hashData(lower, 26, true), hashData(upper, 26, true));
+    EXPECT_EQ(hashData(lower, 26, true), hashData(mixed, 26, true));
+    EXPECT_NE(hashData(lower, 26, false), hashData(lower, 25, false));
+}
+
+// Long labels are compared the same way as short ones.
+TEST_F(LabelSequenceTest, compareLongLabels) {
+    const string prefix(62, 'x');
+    const Name n1(prefix + "a." + prefix + "x.example");
+    const Name n2(prefix + "B." + prefix + "X.EXAMPLE");
+    const LabelSequence ls1(n1), ls2(n2);
+    NameComparisonResult result = ls1.compare(ls2);
+    EXPECT_EQ(NameComparisonResult::COMMONANCESTOR, result.getRelation());
+    EXPECT_EQ('a' - 'b', result.getOrder());
+    EXPECT_EQ(3, result.getCommonLabels());
+    EXPECT_FALSE(ls1.equals(ls2));
+
+    const Name n3(prefix + "A." + prefix + "X.EXAMPLE");
+    const LabelSequence ls3(n3);
+    EXPECT_EQ(NameComparisonResult::EQUAL, ls1.compare(ls3).getRelation());
+    EXPECT_TRUE(ls1.equals(ls3));
+    EXPECT_FALSE(ls1.equals(ls3, true));
+    EXPECT_EQ(ls1.getHash(false), ls3.getHash(false));
+}
+
 // test operator<<.  We simply confirm it appends the result of toText().
 TEST_F(LabelSequenceTest, LeftShiftOperator) {
     ostringstream oss;
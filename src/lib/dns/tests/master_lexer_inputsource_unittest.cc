@@ -18,11 +18,13 @@
 
 #include <gtest/gtest.h>
 
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 
 #include <string.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace bundy::dns;
@@ -371,4 +373,80 @@ TEST_F(InputSourceTest, getPosition) {
     EXPECT_EQ(0, InputSource(TEST_DATA_SRCDIR "/masterload.txt").getPosition());
 }
 
+TEST_F(InputSourceTest, mapped) {
+    // A stream is never mapped, a regular file is.
+    EXPECT_FALSE(source_.isMapped());
+    InputSource source(TEST_DATA_SRCDIR "/masterload.txt");
+    ASSERT_TRUE(source.isMapped());
+
+    // Nothing is skipped at the start of a comment.
+    EXPECT_EQ(0, source.skipStringChars());
+    EXPECT_EQ(';', source.getChar());
+    while (source.getCurrentLine() < 3) {
+        source.getChar();
+    }
+
+    // Skip "example.com." and make it a C string.
+    source.mark();
+    const char* beg = source.getCurrentData();
+    EXPECT_EQ(12, source.skipStringChars());
+    EXPECT_EQ(36 + 12, source.getPosition());
+    EXPECT_EQ(3, source.getCurrentLine());
+    EXPECT_TRUE(source.terminateString(beg, 12));
+    EXPECT_EQ(string("example.com."), beg);
+
+    // It's restored by mark(), and we can continue.
+    source.mark();
+    EXPECT_EQ(' ', source.getChar());
+    beg = source.getCurrentData();
+    EXPECT_EQ(4, source.skipStringChars());
+    EXPECT_EQ(0, strncmp("3600", beg, 4));
+
+    // The skipped characters can be ungotten like others.
+    source.ungetAll();
+    EXPECT_EQ(' ', source.getChar());
+
+    // A string at the end of the source can't be terminated.
+    while (source.getChar() != InputSource::END_OF_STREAM) {
+        ;
+    }
+    source.ungetChar();
+    source.ungetChar();
+    source.mark();
+    beg = source.getCurrentData();
+    EXPECT_EQ(0, source.skipStringChars()); // at the final newline
+    EXPECT_FALSE(source.terminateString(beg, 1));
+}
+
+TEST_F(InputSourceTest, skipStringChars) {
+    // Separators, comments, escapes and characters with the highest bit
+    // set stop skipping, both in and after the first 16 characters.
+    const char* const data = "0123456789abcdef0123456789\\x\x80y\"z;w(v)";
+    const char* const filename = TEST_DATA_BUILDDIR "/inputsource_skip.txt";
+    {
+        std::ofstream ofs(filename);
+        ofs << data;
+    }
+    InputSource source(filename);
+    ASSERT_TRUE(source.isMapped());
+
+    EXPECT_EQ(26, source.skipStringChars());
+    EXPECT_EQ('\\', source.getChar());
+    EXPECT_EQ(1, source.skipStringChars());
+    EXPECT_EQ('\x80', static_cast<char>(source.getChar()));
+    EXPECT_EQ(1, source.skipStringChars());
+    EXPECT_EQ('"', source.getChar());
+    EXPECT_EQ(1, source.skipStringChars());
+    EXPECT_EQ(';', source.getChar());
+    EXPECT_EQ(1, source.skipStringChars());
+    EXPECT_EQ('(', source.getChar());
+    EXPECT_EQ(1, source.skipStringChars());
+    EXPECT_EQ(')', source.getChar());
+    EXPECT_EQ(0, source.skipStringChars());
+    EXPECT_EQ(InputSource::END_OF_STREAM, source.getChar());
+    EXPECT_EQ(strlen(data), source.getPosition());
+
+    unlink(filename);
+}
+
 } // end namespace
@@ -24,8 +24,12 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/bind.hpp>
 
+#include <fstream>
 #include <string>
 #include <sstream>
+#include <vector>
+
+#include <unistd.h>
 
 using namespace bundy::dns;
 using std::string;
@@ -500,6 +504,63 @@ TEST_F(MasterLexerTest, getNextTokenNumber) {
     eofCheck(lexer, MasterToken::NUMBER);
 }
 
+// Tokens from a file that is mapped into memory are the same as those from
+// a stream with the same content.
+TEST_F(MasterLexerTest, mappedFile) {
+    const char* const data =
+        "example.org. 3600 IN SOA ns.example.org. root.example.org. (\n"
+        "  1 2 3 4 5 ) ; comment\n"
+        "a-long-name-that-is-longer-than-16-characters.example.org.;c\n"
+        "esc\\ aped\\;name \"quoted string\" \xe0\x80high\xc3\xa4-bit\r\n"
+        "\tstring-at-the-end";
+    const char* const filename = TEST_DATA_BUILDDIR "/lexer_mapped.txt";
+    {
+        std::ofstream ofs(filename);
+        ofs << data;
+    }
+    ss << data;
+    MasterLexer lexer2;
+    ASSERT_TRUE(lexer.pushSource(filename));
+    lexer2.pushSource(ss);
+
+    const MasterLexer::Options options[] = {
+        MasterLexer::INITIAL_WS, MasterLexer::QSTRING, MasterLexer::NUMBER
+    };
+    size_t count = 0;
+    while (true) {
+        const MasterLexer::Options option = options[count++ % 3];
+        const MasterToken& token = lexer.getNextToken(option);
+        const MasterToken& token2 = lexer2.getNextToken(option);
+        ASSERT_EQ(token2.getType(), token.getType());
+        EXPECT_EQ(lexer2.getSourceLine(), lexer.getSourceLine());
+        EXPECT_EQ(lexer2.getPosition(), lexer.getPosition());
+        if (token.getType() == MasterToken::STRING ||
+            token.getType() == MasterToken::QSTRING) {
+            EXPECT_EQ(token2.getString(), token.getString());
+            // The string is nul-terminated in either case.
+            const MasterToken::StringRegion& region = token.getStringRegion();
+            EXPECT_EQ('\0', region.beg[region.len]);
+        } else if (token.getType() == MasterToken::NUMBER) {
+            EXPECT_EQ(token2.getNumber(), token.getNumber());
+        } else if (token.getType() == MasterToken::END_OF_FILE) {
+            break;
+        }
+
+        // Ungetting and getting the token again gives the same result.
+        if (count % 4 == 0) {
+            lexer.ungetToken();
+            const MasterToken& again = lexer.getNextToken(option);
+            ASSERT_EQ(token2.getType(), again.getType());
+            if (again.getType() == MasterToken::STRING) {
+                EXPECT_EQ(token2.getString(), again.getString());
+            }
+        }
+    }
+    EXPECT_LT(20, count);
+
+    unlink(filename);
+}
+
 TEST_F(MasterLexerTest, getNextTokenErrors) {
     // Check miscellaneous error cases
 
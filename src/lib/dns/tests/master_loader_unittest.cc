@@ -1444,4 +1444,121 @@ TEST_F(MasterLoaderTest, numericOwnerName) {
     checkRR("1.example.org", RRType::A(), "192.0.2.1");
 }
 
+// Build a zone large enough to be split into several chunks in the parallel
+// mode, with constructs that depend on the preceding lines.
+string
+makeLargeZone() {
+    stringstream ss;
+    ss << "example.org. IN SOA ns1 admin ( 1234 3600 1800\n"
+          "                                2419200 7200 ) ; no TTL\n";
+    for (int i = 0; i < 10000; ++i) {
+        if (i % 1000 == 0) {
+            ss << "$ORIGIN sub" << i / 1000 << ".example.org.\n";
+        }
+        if (i % 1500 == 0) {
+            ss << "$TTL " << 100 + i << "\n";
+        }
+        ss << "host" << i << " A 192.0.2." << i % 256 << "\n";
+        ss << "\t300 TXT \"a ( quoted ; string\" ; comment with (\n";
+        if (i % 700 == 0) {
+            ss << "mx" << i << " MX ( 10 ; in parentheses\n"
+                  "  mail" << i << " )\n";
+        }
+        if (i % 5000 == 4999) {
+            ss << "broken" << i << " A 192.0.2.300\n";
+        }
+        if (i % 5000 == 0) {
+            ss << "$GENERATE 1-3 gen" << i << "-$ A 192.0.2.$\n";
+        }
+        if (i % 9000 == 0) {
+            ss << "$INCLUDE " TEST_DATA_SRCDIR "/example.org\n";
+        }
+    }
+    ss << "last 3600 A 192.0.2.1";  // no newline at the end
+    return (ss.str());
+}
+
+// The parallel mode produces the same RRs and issues as the sequential one.
+TEST_F(MasterLoaderTest, parallel) {
+    stringstream ss(makeLargeZone());
+    setLoader(ss, Name("example.org."), RRClass::IN(),
+              MasterLoader::MANY_ERRORS);
+    loader_->load();
+    EXPECT_FALSE(loader_->loadedSucessfully());
+    const list<RRsetPtr> rrsets(rrsets_);
+    const vector<string> errors(errors_);
+    const vector<string> warnings(warnings_);
+    clear();
+
+    // Use the same stream, as its address is in the source name.
+    ss.clear();
+    ss.seekg(0);
+    setLoader(ss, Name("example.org."), RRClass::IN(),
+              static_cast<MasterLoader::Options>(MasterLoader::MANY_ERRORS |
+                                                 MasterLoader::PARALLEL));
+    EXPECT_EQ(0, loader_->getPosition());
+    loader_->load();
+    EXPECT_FALSE(loader_->loadedSucessfully());
+    EXPECT_EQ(loader_->getSize(), loader_->getPosition());
+
+    EXPECT_TRUE(errors == errors_);
+    EXPECT_TRUE(warnings == warnings_);
+    ASSERT_EQ(rrsets.size(), rrsets_.size());
+    list<RRsetPtr>::const_iterator it = rrsets.begin();
+    for (; it != rrsets.end(); ++it) {
+        EXPECT_EQ((*it)->toText(), rrsets_.front()->toText());
+        rrsets_.pop_front();
+    }
+}
+
+// Incremental load in the parallel mode.
+TEST_F(MasterLoaderTest, parallelIncremental) {
+    stringstream ss(makeLargeZone());
+    setLoader(ss, Name("example.org."), RRClass::IN(),
+              static_cast<MasterLoader::Options>(MasterLoader::MANY_ERRORS |
+                                                 MasterLoader::PARALLEL));
+    size_t count = 0;
+    size_t position = 0;
+    while (!loader_->loadIncremental(1000)) {
+        EXPECT_EQ(1000 * ++count, rrsets_.size());
+        EXPECT_LE(position, loader_->getPosition());
+        position = loader_->getPosition();
+    }
+    EXPECT_LT(1000 * count, rrsets_.size());
+    EXPECT_EQ(loader_->getSize(), loader_->getPosition());
+    EXPECT_THROW(loader_->loadIncremental(1), bundy::InvalidOperation);
+    rrsets_.clear();
+}
+
+// Without MANY_ERRORS the parallel load stops at the first error, like the
+// sequential one.
+TEST_F(MasterLoaderTest, parallelError) {
+    stringstream ss(makeLargeZone());
+    setLoader(ss, Name("example.org."), RRClass::IN(), MasterLoader::DEFAULT);
+    EXPECT_THROW(loader_->load(), MasterLoaderError);
+    ASSERT_EQ(1, errors_.size());
+    const string error(errors_.at(0));
+    const size_t rr_count = rrsets_.size();
+    clear();
+
+    ss.clear();
+    ss.seekg(0);
+    setLoader(ss, Name("example.org."), RRClass::IN(), MasterLoader::PARALLEL);
+    EXPECT_THROW(loader_->load(), MasterLoaderError);
+    EXPECT_FALSE(loader_->loadedSucessfully());
+    ASSERT_EQ(1, errors_.size());
+    EXPECT_EQ(error, errors_.at(0));
+    EXPECT_EQ(rr_count, rrsets_.size());
+    rrsets_.clear();
+
+    // A missing file is reported like in the sequential mode.
+    clear();
+    setLoader(TEST_DATA_SRCDIR "/no-such-file", Name("example.org."),
+              RRClass::IN(), static_cast<MasterLoader::Options>(
+                  MasterLoader::MANY_ERRORS | MasterLoader::PARALLEL));
+    loader_->load();
+    EXPECT_FALSE(loader_->loadedSucessfully());
+    EXPECT_EQ(1, errors_.size());
+}
+
 }
@@ -138,6 +138,38 @@ TEST_F(NSEC3HashTest, calculate) {
               ->calculate(LabelSequence(Name("example.org"))));
 }
 
+// Hash values are cached internally (per thread and per set of parameters).
+// Using more sets of parameters than the cache holds, alternating between
+// them, and names too long to be cached shouldn't change any result.
+TEST_F(NSEC3HashTest, calculateCached) {
+    // Hash of "example" with salt aabbccdd and 0 to 5 iterations.
+    // (expected values generated by Python's hashlib)
+    const char* const expected[] = {
+        "DD2IF2E68KDCCF63182EE63STUSDMJIC",
+        "ULDDQUEHRJ5JPF50GA76VGQR1OQ40133",
+        "3SIEVVGGN53864UIQCFM3VAKF9PJ20FS",
+        "3T7VU994TKTRQUE1PHI07CQMIA6NGQ34",
+        "CA6A9CT513D4H3A0D60U9MSLFH1GORH4",
+        "MKV9DI9TKM9E2LO6D46JUNC7FRO5GNAC"
+    };
+    const size_t n_params = sizeof(expected) / sizeof(expected[0]);
+    const uint8_t salt[] = {0xaa, 0xbb, 0xcc, 0xdd};
+    const Name long_name(string(60, 'a') + ".example");
+
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < n_params; ++i) {
+            NSEC3HashPtr hash(NSEC3Hash::create(1, i, salt, sizeof(salt)));
+            EXPECT_EQ(expected[i], hash->calculate(Name("example")));
+            EXPECT_EQ(expected[i], hash->calculate(Name("EXAMPLE")));
+            EXPECT_EQ(expected[i],
+                      hash->calculate(LabelSequence(Name("example"))));
+        }
+        calculateCheck(*test_hash);
+        EXPECT_EQ("HE1BA74KDM92VC99E852255SJ8FL12AI",
+                  test_hash->calculate(long_name));
+    }
+}
+
 // Common checks for match cases
 template <typename RDATAType>
 void
@@ -349,4 +349,110 @@ TEST_F(ZoneCheckerTest, checkNSWithDNAME) {
     checkIssues();
 }
 
+
+// Pass the RRsets of the given collection to the incremental checker,
+// those at the zone apex first (like in a usual zone file).
+void
+feedChecker(IncrementalZoneChecker& checker, RRsetCollection& rrsets,
+            const Name& zone_name)
+{
+    for (RRsetCollection::Iterator it = rrsets.begin(); it != rrsets.end();
+         ++it) {
+        if ((*it).getName() == zone_name) {
+            checker.addRRset(*it);
+        }
+    }
+    for (RRsetCollection::Iterator it = rrsets.begin(); it != rrsets.end();
+         ++it) {
+        if ((*it).getName() != zone_name) {
+            checker.addRRset(*it);
+        }
+    }
+}
+
+TEST_F(ZoneCheckerTest, incrementalGood) {
+    // The apex RRsets come first in the fixture, so everything the checks
+    // need is collected, and the (empty) collection isn't consulted.
+    const RRsetCollection empty_rrsets;
+    IncrementalZoneChecker checker(zname_, zclass_);
+    checker.addRRset(*rrsets_->find(zname_, zclass_, RRType::SOA()));
+    checker.addRRset(*rrsets_->find(zname_, zclass_, RRType::NS()));
+    checker.addRRset(*rrsets_->find(Name("ns.example.com"), zclass_,
+                                    RRType::A()));
+    // RRsets of other classes or of irrelevant names or types are ignored.
+    RRsetPtr other(new RRset(Name("ns.example.com"), RRClass::CH(),
+                             RRType::CNAME(), RRTTL(60)));
+    other->addRdata(generic::CNAME("cname.example.com."));
+    checker.addRRset(*other);
+    other.reset(new RRset(Name("www.example.com"), zclass_, RRType::CNAME(),
+                          RRTTL(60)));
+    other->addRdata(generic::CNAME("cname.example.com."));
+    checker.addRRset(*other);
+    EXPECT_TRUE(checker.check(empty_rrsets, callbacks_));
+    checkIssues();
+}
+
+TEST_F(ZoneCheckerTest, incrementalErrors) {
+    const RRsetCollection empty_rrsets;
+
+    // Duplicate SOA and a CNAME at the NS name; both are found from the
+    // collected data, and the RDATA of the separately added SOAs are merged.
+    RRsetPtr cname(new RRset(Name("ns.example.com"), zclass_, RRType::CNAME(),
+                             RRTTL(60)));
+    cname->addRdata(generic::CNAME("cname.example.com."));
+    rrsets_->addRRset(cname);
+    IncrementalZoneChecker checker(zname_, zclass_);
+    feedChecker(checker, *rrsets_, zname_);
+    soa_->addRdata(generic::SOA(soa_txt));
+    checker.addRRset(*soa_);
+    EXPECT_FALSE(checker.check(empty_rrsets, callbacks_));
+    expected_errors_.push_back("zone example.com/IN: has 2 SOA records");
+    expected_errors_.push_back("zone example.com/IN: NS 'ns.example.com' is "
+                               "a CNAME (illegal per RFC2181)");
+    checkIssues();
+
+    // An NS name below a DNAME, which is collected as an intermediate name.
+    rrsets_->removeRRset(zname_, zclass_, RRType::NS());
+    ns_->addRdata(generic::NS("ns.child.example.com."));
+    rrsets_->addRRset(ns_);
+    RRsetPtr dname(new RRset(Name("child.example.com"), zclass_,
+                             RRType::DNAME(), RRTTL(60)));
+    dname->addRdata(generic::DNAME("example.org."));
+    rrsets_->addRRset(dname);
+    IncrementalZoneChecker checker2(zname_, zclass_);
+    feedChecker(checker2, *rrsets_, zname_);
+    EXPECT_FALSE(checker2.check(empty_rrsets, callbacks_));
+    expected_errors_.push_back("zone example.com/IN: NS 'ns.child.example.com'"
+                               " is below a DNAME 'child.example.com'");
+    checkIssues();
+
+    // No RRsets at all.  The apex is always answered from the collected
+    // data.
+    IncrementalZoneChecker checker3(zname_, zclass_);
+    EXPECT_FALSE(checker3.check(*rrsets_, callbacks_));
+    expected_errors_.push_back("zone example.com/IN: has 0 SOA records");
+    expected_errors_.push_back("zone example.com/IN: has no NS records");
+    checkIssues();
+}
+
+TEST_F(ZoneCheckerTest, incrementalLateNS) {
+    // The address of the NS name comes before the apex NS.  It can't be
+    // known whether the checker missed RRsets of the NS name, so the
+    // collection is consulted for them.
+    IncrementalZoneChecker checker(zname_, zclass_);
+    checker.addRRset(*rrsets_->find(Name("ns.example.com"), zclass_,
+                                    RRType::A()));
+    checker.addRRset(*rrsets_->find(zname_, zclass_, RRType::SOA()));
+    checker.addRRset(*rrsets_->find(zname_, zclass_, RRType::NS()));
+    EXPECT_TRUE(checker.check(*rrsets_, callbacks_));
+    checkIssues();
+
+    // So, with an empty collection, the NS name has no address.  The apex
+    // RRsets are still known.
+    const RRsetCollection empty_rrsets;
+    EXPECT_TRUE(checker.check(empty_rrsets, callbacks_));
+    expected_warns_.push_back("zone example.com/IN: NS has no address");
+    checkIssues();
+}
+
 }
@@ -21,9 +21,12 @@
 #include <dns/rrset.h>
 #include <dns/rrset_collection_base.h>
 
+#include <exceptions/exceptions.h>
+
 #include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <map>
 #include <string>
 
 using boost::lexical_cast;
@@ -192,5 +195,168 @@ checkZone(const Name& zone_name, const RRClass& zone_class,
     return (!had_error);
 }
 
+namespace {
+// The RR types that checkZone() looks up.
+bool
+isCheckedType(const RRType& type) {
+    return (type == RRType::SOA() || type == RRType::NS() ||
+            type == RRType::DNAME() || type == RRType::CNAME() ||
+            type == RRType::A() || type == RRType::AAAA());
+}
+}
+
+struct IncrementalZoneChecker::CheckerImpl {
+    CheckerImpl(const Name& zone_name, const RRClass& zone_class) :
+        zone_name_(zone_name), zone_class_(zone_class),
+        past_apex_(false), complete_(true)
+    {
+        names_[zone_name];
+    }
+
+    // Start collecting RRsets at the given NS name and its ancestors
+    // (if it's in the zone).
+    void trackNSName(const Name& ns_name);
+
+    // Return the collected RRset data for the name, or NULL if it isn't
+    // (reliably) known.
+    typedef std::map<RRType, RRsetPtr> NodeRRsets;
+    const NodeRRsets* getNode(const Name& name) const;
+
+    class Collection;
+
+    const Name zone_name_;
+    const RRClass zone_class_;
+    // The names we collect RRsets for.  Name comparison is case
+    // insensitive, so this works as expected for names in mixed case.
+    std::map<Name, NodeRRsets> names_;
+    // Set once a non-apex RRset is seen.  Since then, any newly tracked
+    // name could have been missed.
+    bool past_apex_;
+    // Whether we have seen all RRsets of all tracked names.
+    bool complete_;
+};
+
+void
+IncrementalZoneChecker::CheckerImpl::trackNSName(const Name& ns_name) {
+    if (ns_name.compare(zone_name_).getRelation() !=
+        NameComparisonResult::SUBDOMAIN) {
+        return;                 // out of zone or the apex (always tracked)
+    }
+
+    // findZoneCut() looks at all names between the origin and the NS name.
+    const unsigned int origin_count = zone_name_.getLabelCount();
+    const unsigned int target_count = ns_name.getLabelCount();
+    for (unsigned int l = origin_count + 1; l <= target_count; ++l) {
+        const Name& mid_name = (l == target_count) ? ns_name :
+            ns_name.split(target_count - l);
+        if (names_.insert(std::make_pair(mid_name, NodeRRsets())).second &&
+            past_apex_) {
+            complete_ = false;
+        }
+    }
+}
+
+const IncrementalZoneChecker::CheckerImpl::NodeRRsets*
+IncrementalZoneChecker::CheckerImpl::getNode(const Name& name) const {
+    if (!complete_ && name != zone_name_) {
+        return (NULL);
+    }
+    const std::map<Name, NodeRRsets>::const_iterator it = names_.find(name);
+    return (it != names_.end() ? &it->second : NULL);
+}
+
+// RRset collection that answers from the data collected by
+// IncrementalZoneChecker, and falls back to the real collection for
+// anything else.  checkZone() only needs find().
+class IncrementalZoneChecker::CheckerImpl::Collection :
+    public RRsetCollectionBase
+{
+public:
+    Collection(const CheckerImpl& impl,
+               const RRsetCollectionBase& zone_rrsets) :
+        impl_(impl), zone_rrsets_(zone_rrsets)
+    {}
+
+    virtual ConstRRsetPtr find(const Name& name, const RRClass& rrclass,
+                               const RRType& rrtype) const
+    {
+        if (rrclass == impl_.zone_class_ && isCheckedType(rrtype)) {
+            const NodeRRsets* node = impl_.getNode(name);
+            if (node != NULL) {
+                const NodeRRsets::const_iterator it = node->find(rrtype);
+                return (it != node->end() ? it->second : ConstRRsetPtr());
+            }
+        }
+        return (zone_rrsets_.find(name, rrclass, rrtype));
+    }
+
+protected:
+    virtual IterPtr getBeginning() {
+        bundy_throw(NotImplemented, "Not needed for zone checks");
+    }
+    virtual IterPtr getEnd() {
+        bundy_throw(NotImplemented, "Not needed for zone checks");
+    }
+
+private:
+    const CheckerImpl& impl_;
+    const RRsetCollectionBase& zone_rrsets_;
+};
+
+IncrementalZoneChecker::IncrementalZoneChecker(const Name& zone_name,
+                                               const RRClass& zone_class) :
+    impl_(new CheckerImpl(zone_name, zone_class))
+{}
+
+IncrementalZoneChecker::~IncrementalZoneChecker() {
+    delete impl_;
+}
+
+void
+IncrementalZoneChecker::addRRset(const AbstractRRset& rrset) {
+    if (rrset.getClass() != impl_->zone_class_) {
+        return;
+    }
+
+    const bool at_apex = (rrset.getName() == impl_->zone_name_);
+    if (!at_apex) {
+        impl_->past_apex_ = true;
+    }
+    if (!isCheckedType(rrset.getType())) {
+        return;
+    }
+    const std::map<Name, CheckerImpl::NodeRRsets>::iterator node =
+        impl_->names_.find(rrset.getName());
+    if (node == impl_->names_.end()) {
+        return;
+    }
+
+    RRsetPtr& collected = node->second[rrset.getType()];
+    if (!collected) {
+        collected.reset(new BasicRRset(rrset.getName(), rrset.getClass(),
+                                       rrset.getType(), rrset.getTTL()));
+    }
+    for (RdataIteratorPtr rit = rrset.getRdataIterator(); !rit->isLast();
+         rit->next()) {
+        collected->addRdata(rit->getCurrent());
+        if (at_apex && rrset.getType() == RRType::NS()) {
+            const rdata::generic::NS* ns_data =
+                dynamic_cast<const rdata::generic::NS*>(&rit->getCurrent());
+            if (ns_data != NULL) { // if it's bogus, check() will complain
+                impl_->trackNSName(ns_data->getNSName());
+            }
+        }
+    }
+}
+
+bool
+IncrementalZoneChecker::check(const RRsetCollectionBase& zone_rrsets,
+                              const ZoneCheckerCallbacks& callbacks) const
+{
+    const CheckerImpl::Collection collected(*impl_, zone_rrsets);
+    return (checkZone(impl_->zone_name_, impl_->zone_class_, collected,
+                      callbacks));
+}
+
 } // end namespace dns
 } // end namespace bundy
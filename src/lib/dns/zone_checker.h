@@ -18,6 +18,7 @@
 #include <dns/dns_fwd.h>
 
 #include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
 
 #include <string>
 
@@ -153,6 +154,70 @@ checkZone(const Name& zone_name, const RRClass& zone_class,
           const RRsetCollectionBase& zone_rrsets,
           const ZoneCheckerCallbacks& callbacks);
 
+/// \brief Zone checker that collects the data it needs during a load.
+///
+/// \c checkZone() looks up the apex SOA and NS and some RRsets for each
+/// in-zone NS name in the RRset collection of the zone after the zone is
+/// loaded.  If the collection is backed by a database (e.g., the one of
+/// a \c ZoneUpdater), each lookup is a query to the database.
+///
+/// This class performs the same checks as \c checkZone(), but the
+/// relevant RRsets are remembered as they are passed to \c addRRset()
+/// while the zone is being loaded, so \c check() can usually be answered
+/// without looking into the zone at all.  It only keeps RRsets of the
+/// types used by the checks, and only at the zone apex and at the in-zone
+/// NS names and their ancestors, so the amount of memory it uses doesn't
+/// depend on the size of the zone.
+///
+/// The RRsets at the NS names can only be collected if the apex NS RRset
+/// appears before any other non-apex RRset, which is normally the case for
+/// zone files.  Otherwise \c check() looks up the RRsets at the NS names
+/// in the passed collection just like \c checkZone().  Either way, the
+/// result of \c check() is the same as that of \c checkZone() for the
+/// same zone content, provided every RRset of the zone was passed to
+/// \c addRRset() exactly once.
+class IncrementalZoneChecker : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc Memory allocation failure
+    ///
+    /// \param zone_name The name of the zone to be checked
+    /// \param zone_class The RR class of the zone to be checked
+    IncrementalZoneChecker(const Name& zone_name, const RRClass& zone_class);
+
+    /// \brief Destructor.
+    ~IncrementalZoneChecker();
+
+    /// \brief Inform the checker of an RRset added to the zone.
+    ///
+    /// RRsets of a different RR class than the zone's are ignored.  The
+    /// same RRset type of the same name can be passed more than once, in
+    /// which case the RDATA are merged.
+    ///
+    /// \throw std::bad_alloc Memory allocation failure
+    ///
+    /// \param rrset An RRset added to the zone.
+    void addRRset(const AbstractRRset& rrset);
+
+    /// \brief Perform the checks of \c checkZone().
+    ///
+    /// See \c checkZone() for the checks, the return value and the
+    /// exceptions.
+    ///
+    /// \param zone_rrsets The collection of RRsets of the zone, used for
+    /// the data that couldn't be collected by \c addRRset().
+    /// \param callbacks Callback object used to report errors and issues
+    ///
+    /// \return \c true if no critical errors are found; \c false otherwise.
+    bool check(const RRsetCollectionBase& zone_rrsets,
+               const ZoneCheckerCallbacks& callbacks) const;
+
+private:
+    struct CheckerImpl;
+    CheckerImpl* impl_;
+};
+
 } // namespace dns
 } // namespace bundy
 #endif  // ZONE_CHECKER_H
@@ -108,6 +108,28 @@ The tuples contain (name, segment_type, segment_state):\n\
 If segment_state is SEGMENT_UNUSED, None is returned for the segment_type.\n\
 ";
 
+const char* const ConfigurableClientList_get_memory_usage_doc = "\
+get_memory_usage() -> dict\n\
+\n\
+This method returns the memory usage of the in-memory cache of the data\n\
+sources.  The returned dict is keyed by the names of the data sources\n\
+whose cache is in use, and each value is a dict of the following items\n\
+(all sizes are in bytes):\n\
+  segment-type        The type of the memory segment.\n\
+  segment-size        The size of the memory segment.\n\
+  segment-in-use      The size of memory in use in the segment.\n\
+  segment-peak-in-use The largest segment-in-use so far.\n\
+  zone-table-size     The size of the zone table itself.\n\
+  overhead            The part of segment-in-use not accounted for by\n\
+                      the zone table and the zones.\n\
+  zones               A dict of the configured zones to the dicts of\n\
+                      their usage, such as node-size, rdataset-size and\n\
+                      total-size.\n\
+\n\
+This walks through all data of the cache, so it can take a while for\n\
+large zones.\n\
+";
+
 const char* const ConfigurableClientList_find_doc = "\
 find(zone, want_exact_match=False, want_finder=True) -> datasrc_client,\
 zone_finder, exact_match\n\
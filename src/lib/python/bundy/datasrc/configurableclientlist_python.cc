@@ -20,6 +20,7 @@
 // http://docs.python.org/py3k/extending/extending.html#a-simple-example
 #include <Python.h>
 
+#include <map>
 #include <string>
 #include <stdexcept>
 
@@ -247,6 +248,54 @@ ConfigurableClientList_getStatus(PyObject* po_self, PyObject*) {
     }
 }
 
+// Convert the memory usage data returned by getMemoryUsage(), which only
+// consist of maps, integers and strings, to the corresponding Python
+// objects.
+PyObject*
+createUsageObject(const bundy::data::ConstElementPtr& element) {
+    switch (element->getType()) {
+    case bundy::data::Element::map: {
+        PyObjectContainer dict(PyDict_New());
+        typedef map<string, bundy::data::ConstElementPtr> ElementMap;
+        const ElementMap& elements = element->mapValue();
+        for (ElementMap::const_iterator it = elements.begin();
+             it != elements.end();
+             ++it) {
+            PyObjectContainer value(createUsageObject(it->second));
+            if (PyDict_SetItemString(dict.get(), it->first.c_str(),
+                                     value.get()) == -1) {
+                bundy_throw(PyCPPWrapperException,
+                            "Failed to build memory usage data");
+            }
+        }
+        return (dict.release());
+    }
+    case bundy::data::Element::integer:
+        return (Py_BuildValue("L", element->intValue()));
+    case bundy::data::Element::string:
+        return (Py_BuildValue("s", element->stringValue().c_str()));
+    default:
+        bundy_throw(PyCPPWrapperException,
+                    "Unexpected type in memory usage data");
+    }
+}
+
+PyObject*
+ConfigurableClientList_getMemoryUsage(PyObject* po_self, PyObject*) {
+    s_ConfigurableClientList* self =
+        static_cast<s_ConfigurableClientList*>(po_self);
+    try {
+        return (createUsageObject(self->cppobj->getMemoryUsage()));
+    } catch (const std::exception& exc) {
+        PyErr_SetString(getDataSourceException("Error"), exc.what());
+        return (NULL);
+    } catch (...) {
+        PyErr_SetString(getDataSourceException("Error"),
+                        "Unknown C++ exception");
+        return (NULL);
+    }
+}
+
 PyObject*
 ConfigurableClientList_find(PyObject* po_self, PyObject* args) {
     s_ConfigurableClientList* self =
@@ -350,6 +399,8 @@ PyMethodDef ConfigurableClientList_methods[] = {
       METH_VARARGS, ConfigurableClientList_get_cached_zone_writer_doc },
     { "get_status", ConfigurableClientList_getStatus,
       METH_NOARGS, ConfigurableClientList_get_status_doc },
+    { "get_memory_usage", ConfigurableClientList_getMemoryUsage,
+      METH_NOARGS, ConfigurableClientList_get_memory_usage_doc },
     { "find", ConfigurableClientList_find,
       METH_VARARGS, ConfigurableClientList_find_doc },
     { NULL, NULL, 0, NULL }
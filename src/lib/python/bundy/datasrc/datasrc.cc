@@ -22,6 +22,7 @@
 #include <datasrc/database.h>
 #include <datasrc/sqlite3_accessor.h>
 #include <datasrc/zone_loader.h>
+#include <datasrc/memory/zone_data_snapshot.h>
 
 #include <log/message_initializer.h>
 
@@ -39,6 +40,8 @@
 
 #include <util/python/pycppwrapper_util.h>
 #include <dns/python/pydnspp_common.h>
+#include <dns/python/name_python.h>
+#include <dns/python/rrclass_python.h>
 
 #include <stdexcept>
 #include <string>
@@ -300,6 +303,52 @@ PyObject* po_MasterFileError;
 PyObject* po_NotImplemented;
 PyObject* po_OutOfZone;
 
+PyObject*
+writeZoneSnapshot(PyObject*, PyObject* args) {
+    PyObject* po_client;
+    PyObject* po_rrclass;
+    PyObject* po_name;
+    const char* filename;
+    if (!PyArg_ParseTuple(args, "O!O!O!s", &datasourceclient_type, &po_client,
+                          &rrclass_type, &po_rrclass, &name_type, &po_name,
+                          &filename)) {
+        return (NULL);
+    }
+    try {
+        bundy::datasrc::memory::saveZoneDataSnapshot(
+            PyDataSourceClient_ToDataSourceClient(po_client),
+            PyRRClass_ToRRClass(po_rrclass), PyName_ToName(po_name),
+            filename);
+        Py_RETURN_NONE;
+    } catch (const std::exception& exc) {
+        PyErr_SetString(getDataSourceException("Error"), exc.what());
+        return (NULL);
+    } catch (...) {
+        PyErr_SetString(getDataSourceException("Error"),
+                        "Unexpected exception");
+        return (NULL);
+    }
+}
+
+PyMethodDef methods[] = {
+    { "write_zone_snapshot", writeZoneSnapshot, METH_VARARGS,
+      "write_zone_snapshot(client, rrclass, zone_name, filename) -> None\n\n"
+      "Write a snapshot of a zone in the given data source client to a file.\n"
+      "The snapshot can be used as the zone file of a MasterFiles data\n"
+      "source, and is loaded into memory much faster than a master file.\n"
+      "The zone is validated the same way as it is when loaded into memory\n"
+      "directly.\n\n"
+      "Exceptions:\n"
+      "  bundy.datasrc.Error The zone doesn't exist or is invalid, or the\n"
+      "                      file can't be written\n\n"
+      "Parameters:\n"
+      "  client     The DataSourceClient to get the zone from\n"
+      "  rrclass    The RRClass of the zone\n"
+      "  zone_name  The name of the zone\n"
+      "  filename   The name of the snapshot file\n" },
+    { NULL, NULL, 0, NULL }
+};
+
 PyModuleDef iscDataSrc = {
     { PyObject_HEAD_INIT(NULL) NULL, 0, NULL},
     "datasrc",
@@ -307,7 +356,7 @@ PyModuleDef iscDataSrc = {
     "These bindings are close match to the C++ API, but they are not complete "
     "(some parts are not needed) and some are done in more python-like ways.",
     -1,
-    NULL,
+    methods,
     NULL,
     NULL,
     NULL,
@@ -358,6 +358,26 @@ class ClientListTest(unittest.TestCase):
                                bundy.datasrc.ConfigurableClientList.SEGMENT_INUSE),
                               status[0])
 
+    def test_get_memory_usage(self):
+        """
+        Test getting memory usage of the cache.
+        """
+
+        self.clist = bundy.datasrc.ConfigurableClientList(bundy.dns.RRClass.IN)
+        self.assertEqual({}, self.clist.get_memory_usage())
+
+        self.configure_helper()
+
+        usage = self.clist.get_memory_usage()
+        self.assertEqual(['MasterFiles'], list(usage.keys()))
+        self.assertEqual('local', usage['MasterFiles']['segment-type'])
+        self.assertLess(0, usage['MasterFiles']['segment-in-use'])
+        zone_usage = usage['MasterFiles']['zones']['example.com.']
+        self.assertLess(0, zone_usage['total-size'])
+        self.assertEqual(usage['MasterFiles']['segment-in-use'],
+                         usage['MasterFiles']['zone-table-size'] +
+                         zone_usage['total-size'])
+
     @unittest.skipIf(os.environ['HAVE_SHARED_MEMORY'] != 'yes',
                      'shared memory is not available')
     def test_get_status_unused(self):
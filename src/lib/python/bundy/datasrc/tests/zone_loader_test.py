@@ -249,6 +249,38 @@ class ZoneLoaderTests(unittest.TestCase):
                           self.client, bundy.dns.Name("bind."),
                           self.source_client)
 
+    def test_write_zone_snapshot(self):
+        snapshot_file = TESTDATA_WRITE_PATH + '/example.com.snapshot'
+        bundy.datasrc.write_zone_snapshot(self.client, bundy.dns.RRClass.IN,
+                                          self.test_name, snapshot_file)
+
+        # The snapshot can be used as the zone file of MasterFiles
+        clist = bundy.datasrc.ConfigurableClientList(bundy.dns.RRClass.IN)
+        clist.configure('[{"type": "MasterFiles", "cache-enable": true, ' +
+                        '"params": {"example.com": "' + snapshot_file +
+                        '"}}]', True)
+        client = clist.find(self.test_name, True, False)[0]
+        result, finder = client.find_zone(self.test_name)
+        self.assertEqual(client.SUCCESS, result)
+        result, rrset, _ = finder.find(self.test_name, bundy.dns.RRType.SOA)
+        self.assertEqual(finder.SUCCESS, result)
+        self.assertEqual(ORIG_SOA_TXT, rrset.to_text())
+        os.unlink(snapshot_file)
+
+    def test_write_zone_snapshot_fail(self):
+        self.assertRaises(TypeError, bundy.datasrc.write_zone_snapshot,
+                          self.client, self.test_name, 'file')
+        # No such zone
+        self.assertRaises(bundy.datasrc.Error,
+                          bundy.datasrc.write_zone_snapshot, self.client,
+                          bundy.dns.RRClass.IN, bundy.dns.Name('example.org'),
+                          TESTDATA_WRITE_PATH + '/example.org.snapshot')
+        # Unwritable file
+        self.assertRaises(bundy.datasrc.Error,
+                          bundy.datasrc.write_zone_snapshot, self.client,
+                          bundy.dns.RRClass.IN, self.test_name,
+                          TESTDATA_WRITE_PATH + '/nosuchdir/snapshot')
+
     def test_exception(self):
         # Just check if masterfileerror is subclass of datasrc.Error
         self.assertTrue(issubclass(bundy.datasrc.MasterFileError,
@@ -18,6 +18,7 @@
 #include <boost/shared_ptr.hpp>
 #include <dns/tsigkey.h>
 #include <config/ccsession.h>
+#include <util/threads/sync.h>
 
 /**
  * \file keyring.h
@@ -35,7 +36,9 @@
  * If you want to keep a key (or session) for longer time or your application
  * is multithreaded, you might want to have a copy of the shared pointer to
  * hold a reference. Otherwise an update might replace the keyring and delete
- * the keys in the old one.
+ * the keys in the old one. The keyring is replaced in the thread that
+ * receives the configuration updates, so other threads need to hold
+ * bundy::server_common::keyring_mutex while making the copy.
  *
  * Also note that, while the interface doesn't prevent application from
  * modifying the keyring, it is not a good idea to do so. As mentioned above,
@@ -57,6 +60,16 @@ namespace server_common {
  */
 extern boost::shared_ptr<dns::TSIGKeyRing> keyring;
 
+/**
+ * \brief Mutex protecting the key ring pointer
+ *
+ * The key ring pointer is replaced or reset with this mutex held. Threads
+ * other than the one receiving the configuration updates must hold it while
+ * copying the pointer. The key ring itself is never modified once it is
+ * published, so the copy can be used without the lock.
+ */
+extern util::thread::Mutex keyring_mutex;
+
 /**
  * \brief Load the key ring for the first time
  *
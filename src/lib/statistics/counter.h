@@ -76,6 +76,26 @@ public:
         }
         return (counters_.at(type));
     }
+
+    /// \brief Add the values of another counter to this one.
+    ///
+    /// Each item of \a other is added to the corresponding item of this
+    /// counter.  This is useful to combine counters that are maintained
+    /// separately, e.g., per thread.
+    ///
+    /// \param other %Counter to be added to this one
+    ///
+    /// \throw bundy::InvalidParameter \a other has a different number of
+    /// items
+    void add(const Counter& other) {
+        if (other.counters_.size() != counters_.size()) {
+            bundy_throw(bundy::InvalidParameter,
+                        "Counters to be added must have the same size");
+        }
+        for (size_t i = 0; i < counters_.size(); ++i) {
+            counters_[i] += other.counters_[i];
+        }
+    }
 };
 
 }   // namespace statistics
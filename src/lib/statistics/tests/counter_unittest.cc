@@ -80,6 +80,27 @@ TEST_F(CounterTest, incrementCounterItem) {
     EXPECT_EQ(counter.get(ITEM1), 4294967308LL); // 4294967306 + 2
 }
 
+TEST_F(CounterTest, addCounter) {
+    Counter other(NUMBER_OF_ITEMS);
+    counter.inc(ITEM1);
+    other.inc(ITEM1);
+    other.inc(ITEM3);
+    other.inc(ITEM3);
+    counter.add(other);
+    // Check if the counters have the sum of the two
+    EXPECT_EQ(counter.get(ITEM1), 2);
+    EXPECT_EQ(counter.get(ITEM2), 0);
+    EXPECT_EQ(counter.get(ITEM3), 2);
+    // The added one shouldn't be changed
+    EXPECT_EQ(other.get(ITEM1), 1);
+    EXPECT_EQ(other.get(ITEM3), 2);
+
+    // Adding a counter of different size will cause an
+    // bundy::InvalidParameter exception
+    Counter bad(NUMBER_OF_ITEMS + 1);
+    EXPECT_THROW(counter.add(bad), bundy::InvalidParameter);
+}
+
 TEST_F(CounterTest, invalidCounterItem) {
     // Incrementing out-of-bound counter will cause an bundy::OutOfRange
     // exception
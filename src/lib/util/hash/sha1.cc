@@ -52,6 +52,8 @@
  */
 #include <util/hash/sha1.h>
 
+#include <string.h>
+
 namespace bundy {
 namespace util {
 namespace hash {
@@ -171,17 +173,30 @@ SHA1Input(SHA1Context *context, const uint8_t *message_array, unsigned length) {
          return (context->Corrupted);
     }
 
-    while(length-- && !context->Corrupted) {
-        context->Message_Block[context->Message_Block_Index++] =
-                                                    (*message_array & 0xFF);
-
-        if (!SHA1AddLength(context, 8) &&
-            (context->Message_Block_Index == SHA1_BLOCKSIZE))
-        {
+    /*
+     * Copy as much of the message as fits in the current block at a
+     * time rather than byte by byte; this is the hot path of iterated
+     * hashes such as NSEC3.
+     */
+    while (length > 0) {
+        unsigned chunk = SHA1_BLOCKSIZE - context->Message_Block_Index;
+        if (chunk > length) {
+            chunk = length;
+        }
+        memcpy(&context->Message_Block[context->Message_Block_Index],
+               message_array, chunk);
+        context->Message_Block_Index += chunk;
+        message_array += chunk;
+        length -= chunk;
+
+        if (SHA1AddLength(context, chunk * 8)) {
+            /* message too long */
+            context->Corrupted = SHA_STATEERROR;
+            return (SHA_STATEERROR);
+        }
+        if (context->Message_Block_Index == SHA1_BLOCKSIZE) {
             SHA1ProcessMessageBlock(context);
         }
-
-        message_array++;
     }
 
     return (SHA_SUCCESS);
@@ -61,6 +61,26 @@ public:
 /// MemorySegmentLocal should be used in code.
 class MemorySegment {
 public:
+    /// \brief Memory usage of a segment.
+    ///
+    /// All values are in bytes.  \c in_use is the memory used for the
+    /// allocated blocks, including any overhead of the implementation for
+    /// each block if it's known, so it can be larger than the sum of the
+    /// sizes passed to \c allocate().  \c size is the total size of the
+    /// segment, and the difference from \c in_use is available for further
+    /// allocations without growing the segment.  \c peak_in_use is the
+    /// largest \c in_use seen since the segment object was constructed.
+    struct Usage {
+        Usage(size_t size_param, size_t in_use_param,
+              size_t peak_in_use_param) :
+            size(size_param), in_use(in_use_param),
+            peak_in_use(peak_in_use_param)
+        {}
+        size_t size;
+        size_t in_use;
+        size_t peak_in_use;
+    };
+
     /// \brief Destructor
     virtual ~MemorySegment() {}
 
@@ -159,6 +179,14 @@ public:
     /// deallocated, <code>false</code> otherwise.
     virtual bool allMemoryDeallocated() const = 0;
 
+    /// \brief Return the memory usage of the segment.
+    ///
+    /// This is intended for diagnosis and capacity planning; how precise
+    /// the values are depends on the implementation.
+    ///
+    /// \throw None
+    virtual Usage getUsage() const = 0;
+
     /// \brief Associate specified address in the segment with a given name.
     ///
     /// This method establishes an association between the given name and
@@ -15,17 +15,155 @@
 #include "memory_segment_local.h"
 #include <exceptions/exceptions.h>
 
+#include <stdint.h>
+#include <stdlib.h>
+
 namespace bundy {
 namespace util {
 
+const size_t MemorySegmentLocal::MAX_SMALL_SIZE;
+const size_t MemorySegmentLocal::SMALL_ALIGNMENT;
+const size_t MemorySegmentLocal::SLAB_SIZE;
+
+namespace detail {
+// The header at the beginning of each slab.  The blocks follow it; those
+// that have never been allocated are at the end of the slab, beginning at
+// unused_offset, and the freed ones are chained in free_list (the pointer
+// to the next free block is stored in the block itself).
+struct LocalSegmentSlab {
+    LocalSegmentSlab* prev;
+    LocalSegmentSlab* next;
+    void* free_list;
+    size_t unused_offset;
+    size_t used_count;
+    size_t block_count;
+};
+} // namespace detail
+
+namespace {
+
+typedef MemorySegmentLocal MSL;
+typedef detail::LocalSegmentSlab Slab;
+
+const size_t SLAB_HEADER_SIZE =
+    (sizeof(Slab) + MSL::SMALL_ALIGNMENT - 1) &
+    ~(MSL::SMALL_ALIGNMENT - 1);
+
+inline size_t
+getClassIndex(size_t size) {
+    return (size == 0 ? 0 : (size - 1) / MSL::SMALL_ALIGNMENT);
+}
+
+inline size_t
+getBlockSize(size_t class_index) {
+    return ((class_index + 1) * MSL::SMALL_ALIGNMENT);
+}
+
+inline Slab*
+getSlab(void* ptr) {
+    return (reinterpret_cast<Slab*>(
+                reinterpret_cast<uintptr_t>(ptr) & ~(MSL::SLAB_SIZE - 1)));
+}
+
+inline void
+linkSlab(Slab*& head, Slab* slab) {
+    slab->prev = NULL;
+    slab->next = head;
+    if (head != NULL) {
+        head->prev = slab;
+    }
+    head = slab;
+}
+
+inline void
+unlinkSlab(Slab*& head, Slab* slab) {
+    if (slab->prev != NULL) {
+        slab->prev->next = slab->next;
+    } else {
+        head = slab->next;
+    }
+    if (slab->next != NULL) {
+        slab->next->prev = slab->prev;
+    }
+}
+
+} // unnamed namespace
+
+MemorySegmentLocal::MemorySegmentLocal() :
+    slab_count_(0), large_allocated_size_(0),
+    allocated_size_(0), peak_allocated_size_(0)
+{
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        partial_slabs_[i] = NULL;
+        full_slabs_[i] = NULL;
+    }
+}
+
+MemorySegmentLocal::~MemorySegmentLocal() {
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        while (partial_slabs_[i] != NULL) {
+            Slab* slab = partial_slabs_[i];
+            partial_slabs_[i] = slab->next;
+            free(slab);
+        }
+        while (full_slabs_[i] != NULL) {
+            Slab* slab = full_slabs_[i];
+            full_slabs_[i] = slab->next;
+            free(slab);
+        }
+    }
+}
+
 void*
 MemorySegmentLocal::allocate(size_t size) {
-    void* ptr = malloc(size);
-    if (ptr == NULL) {
-        throw std::bad_alloc();
+    void* ptr;
+    if (size <= MAX_SMALL_SIZE) {
+        ptr = allocateSmall(getClassIndex(size));
+    } else {
+        ptr = malloc(size);
+        if (ptr == NULL) {
+            throw std::bad_alloc();
+        }
+        large_allocated_size_ += size;
     }
 
     allocated_size_ += size;
+    if (allocated_size_ > peak_allocated_size_) {
+        peak_allocated_size_ = allocated_size_;
+    }
+    return (ptr);
+}
+
+void*
+MemorySegmentLocal::allocateSmall(size_t class_index) {
+    const size_t block_size = getBlockSize(class_index);
+    Slab* slab = partial_slabs_[class_index];
+    if (slab == NULL) {
+        void* mem;
+        if (posix_memalign(&mem, SLAB_SIZE, SLAB_SIZE) != 0) {
+            throw std::bad_alloc();
+        }
+        slab = static_cast<Slab*>(mem);
+        slab->free_list = NULL;
+        slab->unused_offset = SLAB_HEADER_SIZE;
+        slab->used_count = 0;
+        slab->block_count = (SLAB_SIZE - SLAB_HEADER_SIZE) / block_size;
+        linkSlab(partial_slabs_[class_index], slab);
+        ++slab_count_;
+    }
+
+    void* ptr;
+    if (slab->free_list != NULL) {
+        ptr = slab->free_list;
+        slab->free_list = *static_cast<void**>(ptr);
+    } else {
+        ptr = reinterpret_cast<uint8_t*>(slab) + slab->unused_offset;
+        slab->unused_offset += block_size;
+    }
+    if (++slab->used_count == slab->block_count) {
+        unlinkSlab(partial_slabs_[class_index], slab);
+        linkSlab(full_slabs_[class_index], slab);
+    }
     return (ptr);
 }
 
@@ -43,7 +181,37 @@ MemorySegmentLocal::deallocate(void* ptr, size_t size) {
     }
 
     allocated_size_ -= size;
-    free(ptr);
+    if (size <= MAX_SMALL_SIZE) {
+        deallocateSmall(ptr, getClassIndex(size));
+    } else {
+        large_allocated_size_ -= size;
+        free(ptr);
+    }
+}
+
+void
+MemorySegmentLocal::deallocateSmall(void* ptr, size_t class_index) {
+    Slab* slab = getSlab(ptr);
+    if (slab->used_count == slab->block_count) {
+        unlinkSlab(full_slabs_[class_index], slab);
+        linkSlab(partial_slabs_[class_index], slab);
+    }
+    *static_cast<void**>(ptr) = slab->free_list;
+    slab->free_list = ptr;
+
+    // Return an empty slab to the system unless it's the only one left
+    // for the class, in which case it's kept for the next allocation.
+    if (--slab->used_count == 0 &&
+        (slab->prev != NULL || slab->next != NULL)) {
+        unlinkSlab(partial_slabs_[class_index], slab);
+        releaseSlab(slab);
+    }
+}
+
+void
+MemorySegmentLocal::releaseSlab(Slab* slab) {
+    free(slab);
+    --slab_count_;
 }
 
 bool
@@ -51,6 +219,12 @@ MemorySegmentLocal::allMemoryDeallocated() const {
     return (allocated_size_ == 0 && named_addrs_.empty());
 }
 
+MemorySegment::Usage
+MemorySegmentLocal::getUsage() const {
+    return (Usage(slab_count_ * SLAB_SIZE + large_allocated_size_,
+                  allocated_size_, peak_allocated_size_));
+}
+
 MemorySegment::NamedAddressResult
 MemorySegmentLocal::getNamedAddressImpl(const char* name) const {
     std::map<std::string, void*>::const_iterator found =
@@ -17,30 +17,51 @@
 
 #include <util/memory_segment.h>
 
+#include <boost/noncopyable.hpp>
+
 #include <string>
 #include <map>
 
 namespace bundy {
 namespace util {
+namespace detail {
+// The header of a slab of small blocks; defined in the implementation.
+struct LocalSegmentSlab;
+}
 
-/// \brief malloc/free based Memory Segment class
+/// \brief Process-local Memory Segment class
 ///
-/// This class specifies a concrete implementation for a malloc/free
-/// based MemorySegment. Please see the MemorySegment class
+/// This class specifies a concrete implementation of MemorySegment for
+/// memory local to the process.  Please see the MemorySegment class
 /// documentation for usage.
-class MemorySegmentLocal : public MemorySegment {
+///
+/// Small blocks, which are what the in-memory data source mostly allocates
+/// (tree nodes, \c RdataSet objects, label sequences), are carved out of
+/// fixed-size slabs, each of which only holds blocks of one size class.
+/// A freed block is reused for the next allocation of its size class, and
+/// a slab that becomes empty is returned to the system (except the last
+/// one of each class, which is kept to avoid thrashing), so repeatedly
+/// loading and destroying zones doesn't fragment the heap.  Larger blocks
+/// are directly allocated with malloc().  All slabs are released at once
+/// when the segment is destroyed.
+class MemorySegmentLocal : public MemorySegment, boost::noncopyable {
 public:
     /// \brief Constructor
     ///
     /// Creates a local memory segment object
-    MemorySegmentLocal() : allocated_size_(0) {
-    }
+    MemorySegmentLocal();
 
     /// \brief Destructor
-    virtual ~MemorySegmentLocal() {}
+    ///
+    /// Any slab still held by the segment is released, so no block
+    /// allocated from the segment may be used after its destruction.
+    virtual ~MemorySegmentLocal();
 
-    /// \brief Allocate/acquire a segment of memory. The source of the
-    /// memory is libc's malloc().
+    /// \brief Allocate/acquire a segment of memory.
+    ///
+    /// A block of up to \c MAX_SMALL_SIZE bytes is taken from a slab of
+    /// the corresponding size class; a larger one is allocated with libc's
+    /// malloc().  Either is aligned at least at \c SMALL_ALIGNMENT bytes.
     ///
     /// Throws <code>std::bad_alloc</code> if the implementation cannot
     /// allocate the requested storage.
@@ -52,7 +73,9 @@ public:
     /// \brief Free/release a segment of memory.
     ///
     /// This method may throw <code>bundy::OutOfRange</code> if \c size is
-    /// not equal to the originally allocated size.
+    /// larger than the total allocated size.  As \c size determines the
+    /// size class the block is returned to, it must be exactly the size
+    /// passed to \c allocate().
     ///
     /// \param ptr Pointer to the block of memory to free/release. This
     /// should be equal to a value returned by <code>allocate()</code>.
@@ -66,6 +89,14 @@ public:
     /// deallocated, <code>false</code> otherwise.
     virtual bool allMemoryDeallocated() const;
 
+    /// \brief Local segment version of getUsage.
+    ///
+    /// \c in_use is the sum of the currently allocated sizes.  \c size is
+    /// the total size of the slabs plus the size of the blocks allocated
+    /// directly with malloc(); the overhead of malloc() itself isn't
+    /// known.
+    virtual Usage getUsage() const;
+
     /// \brief Local segment version of getNamedAddress.
     ///
     /// There's a small chance this method could throw std::bad_alloc.
@@ -89,11 +120,35 @@ public:
     /// It should be considered a fatal error.
     virtual bool clearNamedAddressImpl(const char* name);
 
+    /// \brief Blocks larger than this are allocated with malloc().
+    static const size_t MAX_SMALL_SIZE = 256;
+
+    /// \brief The granularity (and alignment) of the size classes.
+    static const size_t SMALL_ALIGNMENT = 8;
+
+    /// \brief The size of a slab, which is also its alignment.
+    static const size_t SLAB_SIZE = 16384;
+
 private:
+    typedef detail::LocalSegmentSlab Slab;
+    static const size_t NUM_SIZE_CLASSES = MAX_SMALL_SIZE / SMALL_ALIGNMENT;
+
+    void* allocateSmall(size_t class_index);
+    void deallocateSmall(void* ptr, size_t class_index);
+    void releaseSlab(Slab* slab);
+
+    // Slabs of each size class that have room for more blocks, and those
+    // that are full.  The first partial slab is used for allocation.
+    Slab* partial_slabs_[NUM_SIZE_CLASSES];
+    Slab* full_slabs_[NUM_SIZE_CLASSES];
+    size_t slab_count_;
+    size_t large_allocated_size_;
+
     // allocated_size_ can underflow, wrap around to max size_t (which
     // is unsigned). But because we only do a check against 0 and not a
     // relation comparison, this is okay.
     size_t allocated_size_;
+    size_t peak_allocated_size_;
 
     std::map<std::string, void*> named_addrs_;
 };
@@ -29,6 +29,7 @@
 #include <new>
 
 #include <stdint.h>
+#include <sys/mman.h>
 
 // boost::interprocess namespace is big and can cause unexpected import
 // (e.g., it has "read_only"), so it's safer to be specific for shortcuts.
@@ -76,7 +77,7 @@ struct MemorySegmentMapped::Impl {
     // to detect possible conflict with other readers or writers using
     // file lock.
     Impl(const std::string& filename, create_only_t, size_t initial_size) :
-        read_only_(false), filename_(filename)
+        read_only_(false), filename_(filename), peak_in_use_(0)
     {
         try {
             // First, try opening it in boost create_only mode; it fails if
@@ -117,6 +118,7 @@ struct MemorySegmentMapped::Impl {
         read_only_(false), filename_(filename),
         base_sgmt_(new BaseSegment(open_or_create, filename.c_str(),
                                    initial_size)),
+        peak_in_use_(0),
         lock_(new boost::interprocess::file_lock(filename.c_str()))
     {
         checkWriter();
@@ -129,6 +131,7 @@ struct MemorySegmentMapped::Impl {
         base_sgmt_(read_only_ ?
                    new BaseSegment(open_read_only, filename.c_str()) :
                    new BaseSegment(open_only, filename.c_str())),
+        peak_in_use_(0),
         lock_(new boost::interprocess::file_lock(filename.c_str()))
     {
         if (read_only_) {
@@ -213,6 +216,19 @@ struct MemorySegmentMapped::Impl {
     // actual Boost implementation of mapped segment.
     boost::scoped_ptr<BaseSegment> base_sgmt_;
 
+    // the largest used size of the segment seen in this process.
+    size_t peak_in_use_;
+
+    // update peak_in_use_ with the current used size, and return the latter.
+    size_t updatePeakInUse() {
+        const size_t in_use =
+            base_sgmt_->get_size() - base_sgmt_->get_free_memory();
+        if (in_use > peak_in_use_) {
+            peak_in_use_ = in_use;
+        }
+        return (in_use);
+    }
+
 private:
     // helper methods and member to detect any reader-writer conflict at
     // the time of construction using an advisory file lock.  The lock will
@@ -296,6 +312,7 @@ MemorySegmentMapped::allocate(size_t size) {
     if (impl_->base_sgmt_->get_free_memory() >= size) {
         void* ptr = impl_->base_sgmt_->allocate(size, std::nothrow);
         if (ptr) {
+            impl_->updatePeakInUse();
             return (ptr);
         }
     }
@@ -446,6 +463,12 @@ MemorySegmentMapped::getSize() const {
     return (impl_->base_sgmt_->get_size());
 }
 
+MemorySegment::Usage
+MemorySegmentMapped::getUsage() const {
+    const size_t in_use = impl_->updatePeakInUse();
+    return (Usage(impl_->base_sgmt_->get_size(), in_use, impl_->peak_in_use_));
+}
+
 size_t
 MemorySegmentMapped::getCheckSum() const {
     const size_t pagesize =
@@ -462,5 +485,19 @@ MemorySegmentMapped::getCheckSum() const {
     return (sum);
 }
 
+void
+MemorySegmentMapped::prefault() const {
+    // Start reading the file ahead; this is merely advice, so we ignore
+    // errors.
+    void* const addr = impl_->base_sgmt_->get_address();
+    const size_t size = impl_->base_sgmt_->get_size();
+    posix_madvise(addr, size, POSIX_MADV_WILLNEED);
+
+    // And make sure all pages are mapped.  The result doesn't matter, but
+    // it's stored so the compiler doesn't skip the memory access.
+    const volatile size_t sum = getCheckSum();
+    static_cast<void>(sum);
+}
+
 } // namespace util
 } // namespace bundy
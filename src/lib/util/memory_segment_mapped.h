@@ -184,6 +184,15 @@ public:
 
     virtual bool allMemoryDeallocated() const;
 
+    /// \brief Mapped segment version of getUsage.
+    ///
+    /// \c size is the size of the mapped file (see \c getSize()), and
+    /// \c in_use is the part of it that isn't free, including the internal
+    /// bookkeeping data of the segment.  \c peak_in_use is only tracked in
+    /// this process, so it doesn't cover allocations made by other
+    /// processes that previously opened the same file.
+    virtual Usage getUsage() const;
+
     /// \brief Mapped segment version of setNamedAddress.
     ///
     /// This implementation detects if \c addr is invalid (see the base class
@@ -253,6 +262,19 @@ public:
     /// \throw None
     size_t getCheckSum() const;
 
+    /// \brief Bring all pages of the segment into memory.
+    ///
+    /// This method tells the kernel that the whole segment will be needed
+    /// soon, so it can read the file ahead, and then touches every page
+    /// so they are mapped in this process.  An application that opens a
+    /// new version of a large segment to replace one in use can call this
+    /// before the switch, so the users of the segment don't suffer from
+    /// page faults right after it.  Note that this reads the entire file,
+    /// so it can take long for a large segment.
+    ///
+    /// \throw None
+    void prefault() const;
+
 private:
     struct Impl;
     Impl* impl_;
@@ -18,7 +18,12 @@
 #include <exceptions/exceptions.h>
 #include <gtest/gtest.h>
 #include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 #include <limits.h>
+#include <stdint.h>
+#include <string.h>
 
 using namespace std;
 using namespace bundy::util;
@@ -108,6 +113,75 @@ TEST(MemorySegmentLocal, TestNullDeallocate) {
     EXPECT_TRUE(segment->allMemoryDeallocated());
 }
 
+TEST(MemorySegmentLocal, getUsage) {
+    auto_ptr<MemorySegment> segment(new MemorySegmentLocal());
+
+    MemorySegment::Usage usage = segment->getUsage();
+    EXPECT_EQ(0, usage.size);
+    EXPECT_EQ(0, usage.in_use);
+    EXPECT_EQ(0, usage.peak_in_use);
+
+    void* ptr1 = segment->allocate(1024);
+    void* ptr2 = segment->allocate(512);
+    usage = segment->getUsage();
+    EXPECT_EQ(1536, usage.size);
+    EXPECT_EQ(1536, usage.in_use);
+    EXPECT_EQ(1536, usage.peak_in_use);
+
+    // The peak stays after deallocation.
+    segment->deallocate(ptr1, 1024);
+    usage = segment->getUsage();
+    EXPECT_EQ(512, usage.in_use);
+    EXPECT_EQ(1536, usage.peak_in_use);
+
+    segment->deallocate(ptr2, 512);
+    EXPECT_EQ(0, segment->getUsage().in_use);
+    EXPECT_EQ(1536, segment->getUsage().peak_in_use);
+}
+
+TEST(MemorySegmentLocal, smallBlocks) {
+    MemorySegmentLocal segment;
+
+    // Allocate enough blocks of each small size to fill more than one
+    // slab, and check they are aligned and don't overlap.
+    vector<pair<uint8_t*, size_t> > blocks;
+    set<size_t> classes;
+    for (size_t size = 1; size <= MemorySegmentLocal::MAX_SMALL_SIZE;
+         size += 7) {
+        classes.insert((size - 1) / MemorySegmentLocal::SMALL_ALIGNMENT);
+        const size_t count = MemorySegmentLocal::SLAB_SIZE / size + 1;
+        for (size_t i = 0; i < count; ++i) {
+            uint8_t* ptr = static_cast<uint8_t*>(segment.allocate(size));
+            EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) %
+                      MemorySegmentLocal::SMALL_ALIGNMENT);
+            memset(ptr, size & 0xff, size);
+            blocks.push_back(make_pair(ptr, size));
+        }
+    }
+    MemorySegment::Usage usage = segment.getUsage();
+    EXPECT_GT(usage.size, usage.in_use);
+    EXPECT_EQ(0, usage.size % MemorySegmentLocal::SLAB_SIZE);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        for (size_t j = 0; j < blocks[i].second; ++j) {
+            ASSERT_EQ(blocks[i].second & 0xff, blocks[i].first[j]);
+        }
+    }
+
+    // A freed block is reused for the next allocation of the same size.
+    segment.deallocate(blocks.back().first, blocks.back().second);
+    EXPECT_EQ(blocks.back().first, segment.allocate(blocks.back().second));
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        segment.deallocate(blocks[i].first, blocks[i].second);
+    }
+    EXPECT_TRUE(segment.allMemoryDeallocated());
+
+    // Empty slabs are released except one for each size class used.
+    EXPECT_EQ(classes.size() * MemorySegmentLocal::SLAB_SIZE,
+              segment.getUsage().size);
+    EXPECT_EQ(0, segment.getUsage().in_use);
+}
+
 TEST(MemorySegmentLocal, namedAddress) {
     MemorySegmentLocal segment;
     bundy::util::test::checkSegmentNamedAddress(segment, true);
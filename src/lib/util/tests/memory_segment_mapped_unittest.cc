@@ -549,6 +549,42 @@ TEST_F(MemorySegmentMappedTest, getCheckSum) {
     EXPECT_EQ(old_cksum + 1, segment_->getCheckSum());
 }
 
+TEST_F(MemorySegmentMappedTest, getUsage) {
+    const MemorySegment::Usage usage = segment_->getUsage();
+    EXPECT_EQ(segment_->getSize(), usage.size);
+    // The segment's own bookkeeping data are always in use.
+    EXPECT_LT(0, usage.in_use);
+    EXPECT_GT(usage.size, usage.in_use);
+    EXPECT_EQ(usage.in_use, usage.peak_in_use);
+
+    // An allocation increases the used size by at least its size.
+    void* ptr = segment_->allocate(1024);
+    MemorySegment::Usage new_usage = segment_->getUsage();
+    EXPECT_EQ(usage.size, new_usage.size);
+    EXPECT_LE(usage.in_use + 1024, new_usage.in_use);
+    EXPECT_EQ(new_usage.in_use, new_usage.peak_in_use);
+
+    // And deallocation decreases it, but the peak stays.
+    segment_->deallocate(ptr, 1024);
+    const size_t peak = new_usage.peak_in_use;
+    new_usage = segment_->getUsage();
+    EXPECT_EQ(usage.in_use, new_usage.in_use);
+    EXPECT_EQ(peak, new_usage.peak_in_use);
+}
+
+TEST_F(MemorySegmentMappedTest, prefault) {
+    // There's no portable way to check the pages are in memory; we only
+    // check it works for both modes and doesn't change the segment.
+    const size_t old_cksum = segment_->getCheckSum();
+    segment_->prefault();
+    EXPECT_EQ(old_cksum, segment_->getCheckSum());
+
+    segment_.reset();
+    const MemorySegmentMapped segment_ro(mapped_file);
+    segment_ro.prefault();
+    EXPECT_EQ(old_cksum, segment_ro.getCheckSum());
+}
+
 // Mode of opening segments in the tests below.
 enum TestOpenMode {
     READER = 0,
@@ -14,6 +14,8 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include <util/hash/sha1.h>
 
@@ -103,6 +105,42 @@ TEST_F(Sha1Test, Test4) {
     }
 }
 
+// The input may be given in pieces that don't match the block boundaries;
+// the result must be the same as giving it at once.
+TEST_F(Sha1Test, unalignedInput) {
+    vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = i & 0xff;
+    }
+
+    // (generated by Python's hashlib)
+    uint8_t expected[SHA1_HASHSIZE] = {
+        0xaf, 0x0b, 0x19, 0x1c, 0x2d, 0xe4, 0x6f, 0xe1, 0x3f, 0xe0,
+        0x90, 0x8f, 0x5a, 0x6a, 0x4e, 0x90, 0xe0, 0xca, 0xfc, 0x46
+    };
+
+    SHA1Context sha;
+    uint8_t digest[SHA1_HASHSIZE];
+    EXPECT_EQ(0, SHA1Reset(&sha));
+    EXPECT_EQ(0, SHA1Input(&sha, &data[0], data.size()));
+    EXPECT_EQ(0, SHA1Result(&sha, digest));
+    for (int i = 0; i < SHA1_HASHSIZE; i++) {
+        EXPECT_EQ(expected[i], digest[i]);
+    }
+
+    EXPECT_EQ(0, SHA1Reset(&sha));
+    size_t pos = 0;
+    for (size_t len = 1; pos < data.size(); ++len) {
+        const size_t chunk = std::min(len, data.size() - pos);
+        EXPECT_EQ(0, SHA1Input(&sha, &data[pos], chunk));
+        pos += chunk;
+    }
+    EXPECT_EQ(0, SHA1Result(&sha, digest));
+    for (int i = 0; i < SHA1_HASHSIZE; i++) {
+        EXPECT_EQ(expected[i], digest[i]);
+    }
+}
+
 } // namespace hash
 } // namespace util
 } // namespace bundy
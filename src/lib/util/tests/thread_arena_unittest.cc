@@ -0,0 +1,140 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <util/thread_arena.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <stdint.h>
+
+using namespace bundy::util;
+
+namespace {
+
+TEST(ThreadArenaTest, reuse) {
+    // A released block is reused for the next allocation of a similar size.
+    void* ptr = ThreadArena::allocate(40);
+    ASSERT_NE(static_cast<void*>(NULL), ptr);
+    std::memset(ptr, 0xff, 40);
+    ThreadArena::deallocate(ptr, 40);
+    EXPECT_EQ(ptr, ThreadArena::allocate(33));
+    ThreadArena::deallocate(ptr, 33);
+
+    // But not for a different size class.
+    void* ptr2 = ThreadArena::allocate(8);
+    EXPECT_NE(ptr, ptr2);
+    ThreadArena::deallocate(ptr2, 8);
+}
+
+TEST(ThreadArenaTest, alignment) {
+    for (size_t size = 0; size <= ThreadArena::MAX_BLOCK_SIZE + 1; ++size) {
+        void* ptr = ThreadArena::allocate(size);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % sizeof(double));
+        ThreadArena::deallocate(ptr, size);
+    }
+}
+
+TEST(ThreadArenaTest, large) {
+    const size_t size = ThreadArena::MAX_BLOCK_SIZE * 4;
+    void* ptr = ThreadArena::allocate(size);
+    std::memset(ptr, 0, size);
+    ThreadArena::deallocate(ptr, size);
+
+    // Releasing NULL is a no-op.
+    ThreadArena::deallocate(NULL, 0);
+}
+
+TEST(ThreadArenaTest, allocator) {
+    std::vector<int, ArenaAllocator<int> > ints;
+    for (int i = 0; i < 1000; ++i) {
+        ints.push_back(i);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(i, ints[i]);
+    }
+
+    typedef std::basic_string<char, std::char_traits<char>,
+        ArenaAllocator<char> > ArenaString;
+    const ArenaString str("a string that is longer than the short buffer");
+    EXPECT_EQ(ArenaString("a string that is longer than the short buffer"),
+              str);
+
+    EXPECT_TRUE(ArenaAllocator<int>() == ArenaAllocator<char>());
+    EXPECT_FALSE(ArenaAllocator<int>() != ArenaAllocator<char>());
+}
+
+TEST(ThreadArenaTest, allocateShared) {
+    boost::shared_ptr<std::string> ptr =
+        boost::allocate_shared<std::string>(ArenaAllocator<std::string>(),
+                                            "test");
+    EXPECT_EQ("test", *ptr);
+    boost::shared_ptr<std::string> ptr2 = ptr;
+    ptr.reset();
+    EXPECT_EQ("test", *ptr2);
+}
+
+void*
+allocateBlocks(void* arg) {
+    std::vector<void*>* blocks = static_cast<std::vector<void*>*>(arg);
+    for (size_t i = 0; i < blocks->size(); ++i) {
+        (*blocks)[i] = ThreadArena::allocate(64);
+    }
+    return (NULL);
+}
+
+void*
+releaseBlocks(void* arg) {
+    std::vector<void*>* blocks = static_cast<std::vector<void*>*>(arg);
+    for (size_t i = 0; i < blocks->size(); ++i) {
+        ThreadArena::deallocate((*blocks)[i], 64);
+    }
+    // Keep some blocks in the free lists of this thread on its termination.
+    for (size_t i = 0; i < 10; ++i) {
+        ThreadArena::deallocate(ThreadArena::allocate(i * 50), i * 50);
+    }
+    return (NULL);
+}
+
+// Blocks can be released by other threads (including ones that never
+// allocated from the arena), and free lists of terminated threads are
+// released.  The latter can only be checked with tools like valgrind.
+TEST(ThreadArenaTest, threads) {
+    std::vector<void*> blocks(2000);
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, allocateBlocks, &blocks));
+    ASSERT_EQ(0, pthread_join(thread, NULL));
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        ASSERT_NE(static_cast<void*>(NULL), blocks[i]);
+    }
+
+    ASSERT_EQ(0, pthread_create(&thread, NULL, releaseBlocks, &blocks));
+    ASSERT_EQ(0, pthread_join(thread, NULL));
+
+    // And the other way round.
+    allocateBlocks(&blocks);
+    ASSERT_EQ(0, pthread_create(&thread, NULL, releaseBlocks, &blocks));
+    ASSERT_EQ(0, pthread_join(thread, NULL));
+}
+
+}
@@ -0,0 +1,145 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <util/thread_arena.h>
+
+#include <cstdlib>
+
+#include <pthread.h>
+
+namespace bundy {
+namespace util {
+
+namespace {
+
+// Blocks are rounded up to a multiple of this, which is also the alignment
+// guaranteed by malloc() on the platforms we care about.
+const size_t GRANULARITY = 16;
+const size_t NUM_CLASSES = ThreadArena::MAX_BLOCK_SIZE / GRANULARITY;
+
+// The maximum number of free blocks kept per size class and thread.  This
+// is far more than a single query needs, and prevents a thread that only
+// releases blocks allocated by others from accumulating them forever.
+const size_t MAX_FREE_BLOCKS = 1024;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct FreeLists {
+    FreeBlock* heads[NUM_CLASSES];
+    size_t counts[NUM_CLASSES];
+};
+
+pthread_once_t key_once = PTHREAD_ONCE_INIT;
+pthread_key_t key;
+bool key_created = false;
+
+// Called on termination of a thread that used the arena.
+void
+releaseLists(void* arg) {
+    FreeLists* lists = static_cast<FreeLists*>(arg);
+    for (size_t i = 0; i < NUM_CLASSES; ++i) {
+        FreeBlock* block = lists->heads[i];
+        while (block != NULL) {
+            FreeBlock* next = block->next;
+            std::free(block);
+            block = next;
+        }
+    }
+    std::free(lists);
+}
+
+void
+createKey() {
+    key_created = (pthread_key_create(&key, releaseLists) == 0);
+}
+
+// Return the free lists of the calling thread, creating them if needed.
+// If anything fails we return NULL and the caller falls back to malloc(),
+// so the arena is just a cache and never a reason for the failure of an
+// allocation.
+FreeLists*
+getLists() {
+    pthread_once(&key_once, createKey);
+    if (!key_created) {
+        return (NULL);
+    }
+    FreeLists* lists = static_cast<FreeLists*>(pthread_getspecific(key));
+    if (lists == NULL) {
+        lists = static_cast<FreeLists*>(std::calloc(1, sizeof(FreeLists)));
+        if (lists != NULL && pthread_setspecific(key, lists) != 0) {
+            std::free(lists);
+            lists = NULL;
+        }
+    }
+    return (lists);
+}
+
+inline size_t
+getClass(size_t size) {
+    return (size == 0 ? 0 : (size - 1) / GRANULARITY);
+}
+
+}
+
+void*
+ThreadArena::allocate(size_t size) {
+    if (size > MAX_BLOCK_SIZE) {
+        return (::operator new(size));
+    }
+    const size_t cls = getClass(size);
+    FreeLists* lists = getLists();
+    if (lists != NULL && lists->heads[cls] != NULL) {
+        FreeBlock* block = lists->heads[cls];
+        lists->heads[cls] = block->next;
+        --lists->counts[cls];
+        return (block);
+    }
+    void* ptr = std::malloc((cls + 1) * GRANULARITY);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return (ptr);
+}
+
+void
+ThreadArena::deallocate(void* ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (size > MAX_BLOCK_SIZE) {
+        ::operator delete(ptr);
+        return;
+    }
+    const size_t cls = getClass(size);
+    // The lists can be missing if the thread never allocated from the arena
+    // or if it is terminating (and they have already been released); we
+    // don't create them here, so the latter doesn't leak.  key_created can
+    // only be false here if key creation failed, as the block must have come
+    // from allocate().
+    FreeLists* lists = key_created ?
+        static_cast<FreeLists*>(pthread_getspecific(key)) : NULL;
+    if (lists == NULL || lists->counts[cls] >= MAX_FREE_BLOCKS) {
+        std::free(ptr);
+        return;
+    }
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = lists->heads[cls];
+    lists->heads[cls] = block;
+    ++lists->counts[cls];
+}
+
+} // namespace util
+} // namespace bundy
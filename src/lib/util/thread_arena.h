@@ -0,0 +1,135 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef THREAD_ARENA_H
+#define THREAD_ARENA_H 1
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace bundy {
+namespace util {
+
+/// \brief Per-thread cache of small memory blocks.
+///
+/// This class provides memory for small, short-lived objects that are
+/// created and destroyed many times for each query, such as \c Name
+/// objects and the RRsets and result contexts returned by in-memory zone
+/// finders.  Each thread keeps lists of free blocks of a few size classes;
+/// a block released by \c deallocate() is put in the list of the calling
+/// thread and is reused by the next \c allocate() of a similar size in that
+/// thread, so in the steady state no call to the global allocator (and no
+/// lock in it) is needed.
+///
+/// A block can be released by a thread other than the one that allocated
+/// it; it then simply moves to the list of the releasing thread.  The
+/// number of cached blocks per size class is limited, and the cached blocks
+/// are returned to the system when the thread terminates.
+///
+/// Requests larger than \c MAX_BLOCK_SIZE are passed to the global
+/// operator new and delete.
+class ThreadArena {
+public:
+    /// \brief The largest size of blocks cached in the arena.
+    static const size_t MAX_BLOCK_SIZE = 512;
+
+    /// \brief Allocate a block of memory.
+    ///
+    /// \throw std::bad_alloc Memory allocation failure
+    /// \param size The size of the block in bytes.
+    /// \return The allocated block, aligned for any type.
+    static void* allocate(size_t size);
+
+    /// \brief Release a block of memory.
+    ///
+    /// \throw None
+    /// \param ptr The block returned by \c allocate().  It can be NULL, in
+    /// which case this method does nothing.
+    /// \param size The size passed to \c allocate() for the block.
+    static void deallocate(void* ptr, size_t size);
+
+private:
+    ThreadArena();              // only static methods
+};
+
+/// \brief Standard allocator using \c ThreadArena.
+///
+/// This can be used for standard containers, or with
+/// \c boost::allocate_shared() so that the object and the reference
+/// counter of a \c boost::shared_ptr are stored in a single block taken
+/// from the arena.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind {
+        typedef ArenaAllocator<U> other;
+    };
+
+    ArenaAllocator() {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    pointer address(reference x) const { return (&x); }
+    const_pointer address(const_reference x) const { return (&x); }
+
+    pointer allocate(size_type n, const void* = NULL) {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        return (static_cast<pointer>(ThreadArena::allocate(n * sizeof(T))));
+    }
+    void deallocate(pointer p, size_type n) {
+        ThreadArena::deallocate(p, n * sizeof(T));
+    }
+
+    size_type max_size() const {
+        return (std::numeric_limits<size_type>::max() / sizeof(T));
+    }
+
+    void construct(pointer p, const T& val) { new(p) T(val); }
+    void destroy(pointer p) { p->~T(); }
+};
+
+// All instances share the same arena, so memory allocated by one of them
+// can be released by any other.
+template <typename T, typename U>
+inline bool
+operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&) {
+    return (true);
+}
+
+template <typename T, typename U>
+inline bool
+operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&) {
+    return (false);
+}
+
+} // namespace util
+} // namespace bundy
+
+#endif // THREAD_ARENA_H
+
+// Local Variables:
+// mode: c++
+// End:
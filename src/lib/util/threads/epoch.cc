@@ -0,0 +1,246 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "config.h"
+
+#include "epoch.h"
+#include "sync.h"
+
+#include <exceptions/exceptions.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+namespace bundy {
+namespace util {
+namespace thread {
+
+namespace {
+
+// Per-thread state of readers.  Each one is accessed by its owner thread
+// and by writers waiting for readers; it's padded so that the epochs of
+// different threads don't share a cache line.
+struct Slot {
+    Slot() : epoch(0), depth(0), owned(true) {}
+
+    // The global epoch at the time the owner entered the outermost critical
+    // section; 0 if it's not in a critical section.
+    volatile uint32_t epoch;
+    // Nesting level of critical sections; only used by the owner thread.
+    size_t depth;
+    // false once the owner thread has terminated; the slot can then be
+    // reused by a new thread.
+    volatile bool owned;
+
+    char padding[64];
+};
+
+// Called on termination of a thread that used the manager.
+void
+releaseSlot(void* slot) {
+    static_cast<Slot*>(slot)->owned = false;
+}
+
+// Check if the reader in the given epoch may have entered the critical
+// section before the global epoch was increased to target.  Epochs wrap
+// around, so we compare them in the serial number arithmetic.
+inline bool
+isOlderEpoch(uint32_t epoch, uint32_t target) {
+    return (epoch != 0 && static_cast<int32_t>(epoch - target) < 0);
+}
+
+}
+
+class EpochManager::Impl {
+public:
+    Impl() : global_epoch_(1), exclusive_(false) {
+        const int result = pthread_key_create(&key_, releaseSlot);
+        if (result != 0) {
+            bundy_throw(bundy::InvalidOperation, std::strerror(result));
+        }
+    }
+
+    ~Impl() {
+        pthread_key_delete(key_);
+        for (std::vector<Slot*>::iterator it = slots_.begin();
+             it != slots_.end(); ++it) {
+            delete *it;
+        }
+    }
+
+    Slot* getSlot() const {
+        return (static_cast<Slot*>(pthread_getspecific(key_)));
+    }
+
+    // Assign a slot to the calling thread, reusing one of a terminated
+    // thread if any.
+    Slot* registerThread() {
+        Mutex::Locker locker(slots_mutex_);
+        Slot* slot = NULL;
+        for (std::vector<Slot*>::iterator it = slots_.begin();
+             it != slots_.end(); ++it) {
+            if (!(*it)->owned) {
+                slot = *it;
+                slot->owned = true;
+                break;
+            }
+        }
+        if (slot == NULL) {
+            slots_.reserve(slots_.size() + 1);
+            slot = new Slot;
+            slots_.push_back(slot);
+        }
+        const int result = pthread_setspecific(key_, slot);
+        if (result != 0) {
+            slot->owned = false;
+            bundy_throw(bundy::InvalidOperation, std::strerror(result));
+        }
+        return (slot);
+    }
+
+    // Wait until all readers that may have entered a critical section
+    // before the global epoch became target leave it.  If target is 0,
+    // wait for all readers.
+    void waitForReaders(uint32_t target) {
+        // We don't hold the lock while waiting, as it would block new
+        // threads entering their first critical section, one of which might
+        // be needed to make the current readers leave.  Slots are never
+        // removed, and a thread that gets a new slot after we take the copy
+        // can only see the current state of the data (or the exclusive flag).
+        std::vector<Slot*> slots;
+        {
+            Mutex::Locker locker(slots_mutex_);
+            slots = slots_;
+        }
+        for (std::vector<Slot*>::const_iterator it = slots.begin();
+             it != slots.end(); ++it) {
+            while (target == 0 ? (*it)->epoch != 0 :
+                   isOlderEpoch((*it)->epoch, target)) {
+                sched_yield();
+            }
+        }
+    }
+
+    pthread_key_t key_;
+    Mutex slots_mutex_;         // protects slots_
+    std::vector<Slot*> slots_;
+    volatile uint32_t global_epoch_;
+    volatile bool exclusive_;   // true while an exclusive section exists
+    Mutex exclusive_mutex_;     // held throughout an exclusive section
+    boost::scoped_ptr<Mutex::Locker> exclusive_locker_;
+};
+
+EpochManager::EpochManager() :
+    impl_(new Impl)
+{}
+
+EpochManager::~EpochManager() {
+    delete impl_;
+}
+
+void
+EpochManager::barrier() {
+    __sync_synchronize();
+}
+
+void
+EpochManager::enter() {
+    Slot* slot = impl_->getSlot();
+    if (slot == NULL) {
+        slot = impl_->registerThread();
+    }
+    if (slot->depth++ > 0) {
+        return;                 // nested; we're already in
+    }
+
+    while (true) {
+        // The epoch must be visible to writers before we read the exclusive
+        // flag or any protected data.  0 is reserved for "not in a critical
+        // section", which the global epoch can transiently be on wraparound.
+        const uint32_t epoch = impl_->global_epoch_;
+        slot->epoch = epoch != 0 ? epoch : 1;
+        barrier();
+        if (!impl_->exclusive_) {
+            return;
+        }
+
+        // A writer is in an exclusive section.  Step back and wait for it
+        // to complete.
+        slot->epoch = 0;
+        barrier();
+        Mutex::Locker locker(impl_->exclusive_mutex_);
+    }
+}
+
+void
+EpochManager::leave() {
+    Slot* slot = impl_->getSlot();
+    if (--slot->depth > 0) {
+        return;
+    }
+    // Make sure all reads of protected data are done before we leave.
+    barrier();
+    slot->epoch = 0;
+}
+
+bool
+EpochManager::inReader() const {
+    const Slot* slot = impl_->getSlot();
+    return (slot != NULL && slot->depth > 0);
+}
+
+void
+EpochManager::synchronize() {
+    if (inReader()) {
+        bundy_throw(bundy::InvalidOperation,
+                    "EpochManager::synchronize() called by a reader");
+    }
+    // __sync builtins imply a full barrier, so the new epoch is visible only
+    // after any preceding update of the data.
+    uint32_t target = __sync_add_and_fetch(&impl_->global_epoch_, 1);
+    if (target == 0) {
+        target = __sync_add_and_fetch(&impl_->global_epoch_, 1);
+    }
+    impl_->waitForReaders(target);
+}
+
+void
+EpochManager::lockExclusive() {
+    if (inReader()) {
+        bundy_throw(bundy::InvalidOperation,
+                    "EpochManager exclusive section requested by a reader");
+    }
+    impl_->exclusive_locker_.reset(
+        new Mutex::Locker(impl_->exclusive_mutex_));
+    impl_->exclusive_ = true;
+    barrier();
+    impl_->waitForReaders(0);
+}
+
+void
+EpochManager::unlockExclusive() {
+    barrier();
+    impl_->exclusive_ = false;
+    impl_->exclusive_locker_.reset();
+}
+
+} // namespace thread
+} // namespace util
+} // namespace bundy
@@ -0,0 +1,157 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef BUNDY_THREAD_EPOCH_H
+#define BUNDY_THREAD_EPOCH_H
+
+#include <boost/noncopyable.hpp>
+
+namespace bundy {
+namespace util {
+namespace thread {
+
+/// \brief Epoch based synchronization of lock-free readers and writers.
+///
+/// This class implements a simple form of read-copy-update (RCU): readers
+/// of some shared data enter a "read-side critical section" by creating an
+/// \c EpochManager::Reader object, which doesn't involve any lock or
+/// any write to memory shared with other readers, so any number of threads
+/// can read the data concurrently without contending with each other.
+///
+/// Writers have two ways of updating the data:
+/// - If an update can be made visible to readers with a single pointer
+///   store (e.g., replacing the data of a node in a tree that readers only
+///   traverse), the writer prepares the new data, calls \c barrier(),
+///   replaces the pointer, and then calls \c synchronize().  It blocks until
+///   all readers that were in a critical section at the time of the call
+///   have left it.  After that, nobody can hold a reference to the old data,
+///   so it can be released.  Readers are never blocked in this case.
+/// - Other updates are done in an exclusive section, created by an
+///   \c EpochManager::Exclusive object.  It waits until all current readers
+///   leave, and while it exists, new readers block at the entrance of their
+///   critical section.  This should only be used for short operations.
+///
+/// Read-side critical sections can be nested in the same thread.  A thread
+/// in a read-side critical section must not create an \c Exclusive object
+/// or call \c synchronize() (it would wait for itself).  Writers that
+/// modify the same data must be serialized by other means (e.g., a mutex)
+/// unless they only use \c Exclusive.
+///
+/// Each thread that ever enters a read-side critical section is assigned
+/// a small internal state, which is released when the thread terminates.
+/// The manager must outlive any read-side critical section and
+/// exclusive section using it.
+class EpochManager : boost::noncopyable {
+public:
+    /// \brief A read-side critical section.
+    ///
+    /// The critical section begins on construction and ends on
+    /// destruction.  Data protected by the manager can be used while the
+    /// object exists.
+    class Reader : boost::noncopyable {
+    public:
+        /// \brief Enter a read-side critical section.
+        ///
+        /// This normally doesn't block; it does only while an exclusive
+        /// section is in progress.
+        ///
+        /// \throw std::bad_alloc Memory allocation failure (only possible
+        ///     on the first use by a thread)
+        explicit Reader(EpochManager& manager) : manager_(manager) {
+            manager_.enter();
+        }
+
+        /// \brief Leave the read-side critical section.
+        ~Reader() {
+            manager_.leave();
+        }
+    private:
+        EpochManager& manager_;
+    };
+
+    /// \brief An exclusive section for writers.
+    ///
+    /// On construction it waits until no thread is in a read-side critical
+    /// section, and prevents other threads from entering one until it's
+    /// destroyed.  Only one exclusive section can exist at a time.
+    class Exclusive : boost::noncopyable {
+    public:
+        /// \brief Enter an exclusive section.
+        ///
+        /// \throw bundy::InvalidOperation The calling thread is in
+        ///     a read-side critical section.
+        explicit Exclusive(EpochManager& manager) : manager_(manager) {
+            manager_.lockExclusive();
+        }
+
+        /// \brief Leave the exclusive section.
+        ~Exclusive() {
+            manager_.unlockExclusive();
+        }
+    private:
+        EpochManager& manager_;
+    };
+
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc Memory allocation failure
+    /// \throw bundy::InvalidOperation Failure of creating internal
+    ///     thread-specific data.
+    EpochManager();
+
+    /// \brief Destructor.
+    ~EpochManager();
+
+    /// \brief Wait for all current readers to leave.
+    ///
+    /// It blocks until all threads that are in a read-side critical section
+    /// at the time of the call have left it.  Readers entering a critical
+    /// section after the call don't delay the return.
+    ///
+    /// \throw bundy::InvalidOperation The calling thread is in a read-side
+    ///     critical section.
+    void synchronize();
+
+    /// \brief Check if the calling thread is in a read-side critical section.
+    ///
+    /// This is mainly for debugging and tests.
+    ///
+    /// \throw None
+    bool inReader() const;
+
+    /// \brief Full memory barrier.
+    ///
+    /// Writers should call this between preparing new data and publishing
+    /// the pointer to it, so readers always see initialized data.
+    static void barrier();
+
+private:
+    void enter();
+    void leave();
+    void lockExclusive();
+    void unlockExclusive();
+
+    class Impl;
+    Impl* impl_;
+};
+
+} // namespace thread
+} // namespace util
+} // namespace bundy
+
+#endif // BUNDY_THREAD_EPOCH_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,184 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <exceptions/exceptions.h>
+
+#include <util/threads/epoch.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <unistd.h>
+
+using namespace bundy::util::thread;
+
+namespace {
+
+class EpochManagerTest : public ::testing::Test {
+public:
+    EpochManagerTest() : reader_in_(false), reader_release_(false),
+                         done_(false)
+    {}
+
+    // Enter a read-side critical section and stay there until
+    // reader_release_ is set.
+    void reader() {
+        EpochManager::Reader reader(manager_);
+        {
+            Mutex::Locker locker(mutex_);
+            reader_in_ = true;
+            cond_.signal();
+            while (!reader_release_) {
+                cond_.wait(mutex_);
+            }
+        }
+    }
+
+    // Start reader() in a separate thread and wait until it's in the
+    // critical section.
+    void startReader() {
+        reader_thread_.reset(
+            new Thread(boost::bind(&EpochManagerTest::reader, this)));
+        Mutex::Locker locker(mutex_);
+        while (!reader_in_) {
+            cond_.wait(mutex_);
+        }
+    }
+
+    void releaseReader() {
+        {
+            Mutex::Locker locker(mutex_);
+            reader_release_ = true;
+            cond_.signal();
+        }
+        reader_thread_->wait();
+    }
+
+    void setDone() {
+        Mutex::Locker locker(mutex_);
+        done_ = true;
+    }
+
+    bool isDone() {
+        Mutex::Locker locker(mutex_);
+        return (done_);
+    }
+
+    void synchronizer() {
+        manager_.synchronize();
+        setDone();
+    }
+
+    void exclusiveWriter() {
+        EpochManager::Exclusive exclusive(manager_);
+        setDone();
+    }
+
+    void shortReader() {
+        EpochManager::Reader reader(manager_);
+        setDone();
+    }
+
+protected:
+    EpochManager manager_;
+    Mutex mutex_;
+    CondVar cond_;
+    bool reader_in_;
+    bool reader_release_;
+    bool done_;
+    boost::scoped_ptr<Thread> reader_thread_;
+};
+
+TEST_F(EpochManagerTest, nestedReaders) {
+    EXPECT_FALSE(manager_.inReader());
+    {
+        EpochManager::Reader reader1(manager_);
+        EXPECT_TRUE(manager_.inReader());
+        {
+            EpochManager::Reader reader2(manager_);
+            EXPECT_TRUE(manager_.inReader());
+        }
+        EXPECT_TRUE(manager_.inReader());
+    }
+    EXPECT_FALSE(manager_.inReader());
+
+    // Without readers, these return immediately.
+    manager_.synchronize();
+    EpochManager::Exclusive exclusive(manager_);
+}
+
+TEST_F(EpochManagerTest, writerInReader) {
+    EpochManager::Reader reader(manager_);
+    EXPECT_THROW(manager_.synchronize(), bundy::InvalidOperation);
+    EXPECT_THROW(EpochManager::Exclusive exclusive(manager_),
+                 bundy::InvalidOperation);
+}
+
+// synchronize() waits for the existing reader to leave.
+TEST_F(EpochManagerTest, synchronize) {
+    startReader();
+    Thread writer(boost::bind(&EpochManagerTest::synchronizer, this));
+    // We can't be sure the writer has really waited; give it some time
+    // to (incorrectly) complete.
+    usleep(100000);
+    EXPECT_FALSE(isDone());
+    // Other readers can come and go in the meantime.
+    {
+        EpochManager::Reader reader(manager_);
+    }
+    releaseReader();
+    writer.wait();
+    EXPECT_TRUE(isDone());
+}
+
+// The exclusive section waits for the existing reader, and blocks new ones.
+TEST_F(EpochManagerTest, exclusive) {
+    startReader();
+    boost::scoped_ptr<Thread> writer(
+        new Thread(boost::bind(&EpochManagerTest::exclusiveWriter, this)));
+    usleep(100000);
+    EXPECT_FALSE(isDone());
+    releaseReader();
+    writer->wait();
+    EXPECT_TRUE(isDone());
+
+    done_ = false;
+    boost::scoped_ptr<EpochManager::Exclusive> exclusive(
+        new EpochManager::Exclusive(manager_));
+    Thread new_reader(boost::bind(&EpochManagerTest::shortReader, this));
+    usleep(100000);
+    EXPECT_FALSE(isDone());
+    exclusive.reset();
+    new_reader.wait();
+    EXPECT_TRUE(isDone());
+}
+
+// Slots of terminated threads are reused; this is mainly for checking it
+// doesn't break anything (and for memory checkers).
+TEST_F(EpochManagerTest, manyThreads) {
+    for (int i = 0; i < 10; ++i) {
+        Thread thread(boost::bind(&EpochManagerTest::shortReader, this));
+        thread.wait();
+    }
+    manager_.synchronize();
+    EXPECT_TRUE(isDone());
+}
+
+}